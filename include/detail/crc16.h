@@ -15,6 +15,9 @@
 namespace hiredis {
 namespace happ {
 HIREDIS_HAPP_API uint16_t crc16(const char *buf, size_t len);
+
+// slot of a key, only the hash tag in {} is used if there is one, or -1 if the key is empty
+HIREDIS_HAPP_API int hash_slot(const char *key, size_t key_len);
 }
 }  // namespace hiredis
 
@@ -0,0 +1,90 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_CIRCUIT_BREAKER_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_CIRCUIT_BREAKER_H
+
+#pragma once
+
+#include <stdint.h>
+
+#include "hiredis_happ_config.h"
+
+namespace hiredis {
+namespace happ {
+
+/**
+ * @brief circuit breaker of one redis node
+ * @note closed: all requests are allowed, and the breaker opens when the error rate in current window is too high
+ *       open: all requests fail immediately until open_msec passed
+ *       half open: only half_open_probes requests are allowed, the breaker closes after all of them succeed and opens
+ *       again if any of them fails
+ */
+class circuit_breaker {
+ public:
+  typedef uint64_t tick_t;  // milliseconds
+
+  struct state {
+    enum type { CLOSED = 0, OPEN, HALF_OPEN };
+  };
+
+  struct HIREDIS_HAPP_API_HEAD_ONLY config_t {
+    uint32_t error_rate_percent;  // open the breaker when failures * 100 >= requests * error_rate_percent
+    uint32_t min_requests;        // minimum requests in a window before the breaker can be opened
+    tick_t window_msec;           // length of statistic window
+    tick_t open_msec;             // how long to keep open before probing
+    uint32_t half_open_probes;    // concurrent probes in half open state, 0 means disable the breaker
+  };
+
+ public:
+  HIREDIS_HAPP_API circuit_breaker();
+
+  /**
+   * @brief check if a request can be sent now
+   * @param is_probe set to true if the request is admitted as a probe of half open state, or false
+   * @note a probe is reserved in half open state if it returns true, so on_success or on_failure should be called
+   *       later
+   */
+  HIREDIS_HAPP_API bool allow(tick_t now, const config_t &conf, bool *is_probe = nullptr);
+
+  /**
+   * @brief record a successful reply
+   * @param is_probe if the request is admitted as a probe by allow(), only replies of probes close a half open breaker
+   */
+  HIREDIS_HAPP_API void on_success(tick_t now, const config_t &conf, bool is_probe);
+
+  /**
+   * @brief record a failed reply or a network error
+   * @param is_probe if the request is admitted as a probe by allow(), or the failure is not of a request, such as a
+   *        connect failure. Only these failures open a half open breaker again.
+   */
+  HIREDIS_HAPP_API void on_failure(tick_t now, const config_t &conf, bool is_probe);
+
+  HIREDIS_HAPP_API void reset();
+
+  HIREDIS_HAPP_API state::type get_state() const;
+
+  HIREDIS_HAPP_API uint32_t get_requests() const;
+
+  HIREDIS_HAPP_API uint32_t get_failures() const;
+
+  static HIREDIS_HAPP_API void default_config(config_t &conf);
+
+ private:
+  void roll_window(tick_t now, const config_t &conf);
+  void open(tick_t now, const config_t &conf);
+
+ private:
+  state::type state_;
+  tick_t window_begin_;
+  uint32_t requests_;
+  uint32_t failures_;
+  tick_t deadline_;  // open: when to probe; half open: when to give up unfinished probes
+  uint32_t probes_inflight_;
+  uint32_t probes_success_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_CIRCUIT_BREAKER_H
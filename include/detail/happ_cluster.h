@@ -13,7 +13,16 @@
 
 #include "hiredis_happ_config.h"
 
+#include "happ_circuit_breaker.h"
+#include "happ_cmd_pool.h"
 #include "happ_connection.h"
+#include "happ_metrics.h"
+#include "happ_node_registry.h"
+#include "happ_reply_arena.h"
+#include "happ_reply_stream.h"
+#include "happ_slot_map.h"
+#include "happ_submit_queue.h"
+#include "happ_timer.h"
 
 namespace hiredis {
 namespace happ {
@@ -27,15 +36,24 @@ class cluster {
 
   struct HIREDIS_HAPP_API_HEAD_ONLY slot_t {
     int index;
+    std::vector<connection::key_t> hosts;  // master first
+  };
+
+  // continuous slots served by the same hosts, the master is the first one
+  struct HIREDIS_HAPP_API_HEAD_ONLY slot_range_t {
+    int start;
+    int end;  // included
     std::vector<connection::key_t> hosts;
   };
 
   typedef connection connection_t;
-  typedef HIREDIS_HAPP_MAP(std::string, std::unique_ptr<connection_t>) connection_map_t;
+  typedef HIREDIS_HAPP_MAP(connection::node_id_t, std::unique_ptr<connection_t>) connection_map_t;
 
   typedef std::function<void(cluster *, connection_t *)> onconnect_fn_t;
   typedef std::function<void(cluster *, connection_t *, const struct redisAsyncContext *, int status)> onconnected_fn_t;
   typedef std::function<void(cluster *, connection_t *, const struct redisAsyncContext *, int)> ondisconnected_fn_t;
+  typedef std::function<void(cluster *)> onslotsupdated_fn_t;
+  typedef std::function<bool(cluster *, const connection::key_t &)> connection_filter_fn_t;
   typedef std::function<void(const char *)> log_fn_t;
 
   struct config_t {
@@ -51,25 +69,38 @@ class cluster {
     time_t keepalive_interval_sec;
 
     size_t cmd_buffer_size;
+    size_t reply_arena_chunk_size;
+    bool reply_stream;
+
+    time_t hedge_min_delay_usec;
+    time_t hedge_max_delay_usec;
+    int hedge_percentile;
+
+    circuit_breaker::config_t breaker;
+
+    bool metrics_latency;
+  };
+
+  struct hedge_stats_t {
+    uint64_t requests;      // cmds sent by exec_hedged
+    uint64_t hedge_sent;    // secondary cmds sent to replicas
+    uint64_t primary_wins;  // the master answered first
+    uint64_t hedge_wins;    // the replica answered first
+    uint64_t discarded;     // replies which arrived after the winner
   };
 
   struct timer_t {
     time_t last_update_sec;
     time_t last_update_usec;
 
-    struct delay_t {
-      time_t sec;
-      time_t usec;
-      cmd_t *cmd;
-    };
-    std::list<delay_t> timer_pending;
-
-    struct conn_timetout_t {
-      std::string name;
-      uint64_t sequence;
-      time_t timeout;
-    };
-    std::list<conn_timetout_t> timer_conns;
+    // retry cmds, timer_node::data is the cmd_t
+    timer_wheel timer_pending;
+
+    // connecting timeout, timer_node::data is the connection_t
+    timer_wheel timer_conns;
+
+    // hedged reads, timer_node::data is the hedge state
+    timer_wheel timer_hedges;
   };
 
  private:
@@ -117,6 +148,28 @@ class cluster {
   HIREDIS_HAPP_API cmd_t *exec(const char *key, size_t ks, cmd_t::callback_fn_t cbk, void *priv_data, int argc,
                                const char **argv, const size_t *argvlen);
 
+  /**
+   * @breif send a request to redis server without copying large arguments
+   * @param key the key used to calculate slot id
+   * @param ks  key size
+   * @param cbk callback
+   * @param priv_data private data passed to callback
+   * @param argc argument count
+   * @param argv pointer of every argument
+   * @param argvlen size of every argument
+   * @param release_fn called with release_data when argv is not used any more, can be nullptr
+   * @param release_data data passed to release_fn
+   *
+   * @note large arguments must be kept valid until release_fn is called, and release_fn is always called even
+   * if this function failed
+   *
+   * @see cmd_exec::vformat_reference
+   * @return command wrapper of this message, nullptr if failed
+   */
+  HIREDIS_HAPP_API cmd_t *exec_reference(const char *key, size_t ks, cmd_t::callback_fn_t cbk, void *priv_data,
+                                         int argc, const char **argv, const size_t *argvlen,
+                                         cmd_t::release_fn_t release_fn, void *release_data);
+
   /**
    * @breif send a request to redis server
    * @param key the key used to calculate slot id
@@ -157,6 +210,90 @@ class cluster {
   HIREDIS_HAPP_API cmd_t *exec(const char *key, size_t ks, cmd_t::callback_fn_t cbk, void *priv_data, const char *fmt,
                                va_list ap);
 
+  /**
+   * @breif send a request to redis server with a callable callback
+   * @param key the key used to calculate slot id
+   * @param ks  key size
+   * @param fn callable object called as fn(cmd_t *cmd, redisAsyncContext *c, void *reply), usually a lambda.
+   *        it's moved into the cmd if it's not larger than HIREDIS_HAPP_CMD_CALLABLE_INLINE_SIZE, or allocated on
+   *        heap, and it's destroyed after it's called
+   * @param argc argument count
+   * @param argv pointer of every argument
+   * @param argvlen size of every argument
+   *
+   * @note buffer() of the cmd is used by fn, and private_data() is nullptr
+   * @see exec
+   * @return command wrapper of this message, nullptr if failed
+   */
+  template <typename F, typename = typename std::enable_if<detail::is_cmd_callable<F>::value>::type>
+  cmd_t *exec(const char *key, size_t ks, F &&fn, int argc, const char **argv, const size_t *argvlen) {
+    return exec_callable(key, ks, create_callable_cmd(std::forward<F>(fn)), argc, argv, argvlen);
+  }
+
+  /**
+   * @breif send a request to redis server with a callable callback
+   * @param key the key used to calculate slot id
+   * @param ks  key size
+   * @param fn callable object called as fn(cmd_t *cmd, redisAsyncContext *c, void *reply)
+   * @param fmt format string
+   * @param ... format data
+   *
+   * @see exec
+   * @return command wrapper of this message, nullptr if failed
+   */
+  template <typename F, typename = typename std::enable_if<detail::is_cmd_callable<F>::value>::type>
+  cmd_t *exec(const char *key, size_t ks, F &&fn, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    cmd_t *ret = exec_callable(key, ks, create_callable_cmd(std::forward<F>(fn)), fmt, ap);
+    va_end(ap);
+    return ret;
+  }
+
+  /**
+   * @breif send a request to redis server, arguments are encoded without parsing any format string
+   * @param key the key used to calculate slot id
+   * @param ks  key size
+   * @param cbk callback
+   * @param priv_data private data passed to callback
+   * @param cmd command name encoded at compile time, such as hiredis::happ::cmd_literal("HSET"), or a prepared_cmd
+   * @param args string-like values, integers or floating point numbers, they are placeholder values for prepared_cmd
+   *
+   * @see cmd_exec::format_args
+   * @return command wrapper of this message, nullptr if failed
+   */
+  template <typename T, typename... Args, typename = typename std::enable_if<detail::is_cmd_template<T>::value>::type>
+  cmd_t *exec(const char *key, size_t ks, cmd_t::callback_fn_t cbk, void *priv_data, const T &cmd, Args &&...args) {
+    cmd_t *ret = create_cmd(cbk, priv_data);
+    if (nullptr == ret) {
+      return nullptr;
+    }
+    return exec_encoded(key, ks, ret, ret->format_args(cmd, std::forward<Args>(args)...));
+  }
+
+  /**
+   * @breif send a request to redis server with a callable callback, arguments are encoded without parsing any
+   * format string
+   * @param key the key used to calculate slot id
+   * @param ks  key size
+   * @param fn callable object called as fn(cmd_t *cmd, redisAsyncContext *c, void *reply)
+   * @param cmd command name encoded at compile time, such as hiredis::happ::cmd_literal("HSET"), or a prepared_cmd
+   * @param args string-like values, integers or floating point numbers, they are placeholder values for prepared_cmd
+   *
+   * @see cmd_exec::format_args
+   * @return command wrapper of this message, nullptr if failed
+   */
+  template <typename F, typename T, typename... Args,
+            typename = typename std::enable_if<detail::is_cmd_callable<F>::value &&
+                                               detail::is_cmd_template<T>::value>::type>
+  cmd_t *exec(const char *key, size_t ks, F &&fn, const T &cmd, Args &&...args) {
+    cmd_t *ret = create_callable_cmd(std::forward<F>(fn));
+    if (nullptr == ret) {
+      return nullptr;
+    }
+    return exec_encoded(key, ks, ret, ret->format_args(cmd, std::forward<Args>(args)...));
+  }
+
   /**
    * @breif send a request to redis server
    * @param key the key used to calculate slot id
@@ -203,6 +340,82 @@ class cluster {
    */
   HIREDIS_HAPP_API cmd_t *retry(cmd_t *cmd, connection_t *conn = nullptr);
 
+  /**
+   * @breif send a read request to the master of the slot, and send the same request to a replica if the master
+   *        has not answered after the hedge delay. The first successful reply will be passed to callback and the
+   *        other one will be discarded.
+   * @param key the key used to calculate slot id
+   * @param ks  key size
+   * @param cbk callback
+   * @param priv_data private data passed to callback
+   * @param argc argument count
+   * @param argv pointer of every argument
+   * @param argvlen size of every argument
+   *
+   * @note only read-only commands can be hedged, replicas must accept READONLY.
+   * @note hedge timer is driven by proc(), so the precision of hedge delay depends on how often proc() is called
+   * @note the late reply is dropped in callback, both cmds are still removed from their connections in order
+   * @see set_hedge_delay
+   * @return command wrapper of the primary message, nullptr if failed
+   */
+  HIREDIS_HAPP_API cmd_t *exec_hedged(const char *key, size_t ks, cmd_t::callback_fn_t cbk, void *priv_data, int argc,
+                                      const char **argv, const size_t *argvlen);
+
+  /**
+   * @breif send a read request with hedging
+   * @param key the key used to calculate slot id
+   * @param ks  key size
+   * @param cbk callback
+   * @param priv_data private data passed to callback
+   * @param fmt format string
+   * @param ... format data
+   *
+   * @see exec_hedged
+   * @return command wrapper of the primary message, nullptr if failed
+   */
+  HIREDIS_HAPP_API cmd_t *exec_hedged(const char *key, size_t ks, cmd_t::callback_fn_t cbk, void *priv_data,
+                                      const char *fmt, ...);
+
+  /**
+   * @breif send a read request with hedging
+   * @param key the key used to calculate slot id
+   * @param ks  key size
+   * @param cmd cmd wrapper
+   *
+   * @note cmds with stream visitor or callable callback are sent by exec without hedging
+   * @see exec_hedged
+   * @return command wrapper of the primary message, nullptr if failed
+   */
+  HIREDIS_HAPP_API cmd_t *exec_hedged(const char *key, size_t ks, cmd_t *cmd);
+
+  /**
+   * @breif send a request to every master of the cluster
+   * @param cbk callback, called once for every cmd sent to a master
+   * @param priv_data private data passed to callback
+   * @param argc argument count
+   * @param argv pointer of every argument
+   * @param argvlen size of every argument
+   *
+   * @note the command is formatted once, and all cmds share the same immutable content, it's freed after the last
+   *       reply. cmds of broadcast are never retried or redirected.
+   * @note slots must be loaded, or it fails with REDIS_HAPP_SLOT_UNAVAILABLE
+   * @return count of cmds sent, or error code if nothing is sent
+   */
+  HIREDIS_HAPP_API int exec_broadcast(cmd_t::callback_fn_t cbk, void *priv_data, int argc, const char **argv,
+                                      const size_t *argvlen);
+
+  /**
+   * @breif send a request to every master of the cluster
+   * @param cbk callback, called once for every cmd sent to a master
+   * @param priv_data private data passed to callback
+   * @param fmt format string
+   * @param ... format data
+   *
+   * @see exec_broadcast
+   * @return count of cmds sent, or error code if nothing is sent
+   */
+  HIREDIS_HAPP_API int exec_broadcast(cmd_t::callback_fn_t cbk, void *priv_data, const char *fmt, ...);
+
   HIREDIS_HAPP_API bool reload_slots();
 
   HIREDIS_HAPP_API const connection::key_t *get_slot_master(int index);
@@ -211,10 +424,44 @@ class cluster {
    * @breif get slot info of a key
    * @param key the key used to calculate slot id
    * @param ks  key size
-   * @return slot info of this key
+   * @return slot info of this key, it's refreshed by the next call for the same slot
+   * @note it must only be called by the thread which runs the event loop, other threads should use get_slot_map()
    */
   HIREDIS_HAPP_API const slot_t *get_slot_by_key(const char *key, size_t ks) const;
 
+  /**
+   * @breif parse the slot and address of a MOVED or ASK error reply
+   * @param msg text after "MOVED " or "ASK ", such as "3999 127.0.0.1:6381"
+   * @param slot_index slot in the reply
+   * @param ip ip in the reply, empty if the address has no ip
+   * @param port port in the reply
+   * @return true if the address is valid, slot_index must be checked by caller
+   */
+  static HIREDIS_HAPP_API bool parse_redirect(const char *msg, int &slot_index, std::string &ip, uint16_t &port);
+
+  /**
+   * @breif get the latest immutable snapshot of all slots, it can be called by any thread without locks
+   * @note a full reload of slots publishes a new snapshot immediately, and slots changed by MOVED replies or
+   *       disconnections are published by the next proc()
+   * @note the snapshot is kept alive by the returned reference, which must be released before the cluster is destroyed
+   * @return reference of the snapshot, it's empty before slots are loaded
+   */
+  HIREDIS_HAPP_API slot_map_ref get_slot_map() const;
+
+  /**
+   * @breif get all slots as ranges of continuous slots with the same hosts
+   * @param out ranges are appended into it
+   * @return count of ranges appended
+   */
+  HIREDIS_HAPP_API size_t get_slot_ranges(std::vector<slot_range_t> &out) const;
+
+  /**
+   * @breif replace all slots with ranges loaded by other clusters, just like CLUSTER SLOTS is replied
+   * @note cmds waiting for slots are sent after it, and the callback set by set_on_slots_updated is not called
+   * @return 0 or error code
+   */
+  HIREDIS_HAPP_API int update_slots(const std::vector<slot_range_t> &ranges);
+
   HIREDIS_HAPP_API const connection_t *get_connection(const std::string &key) const;
   HIREDIS_HAPP_API connection_t *get_connection(const std::string &key);
 
@@ -226,14 +473,60 @@ class cluster {
 
   HIREDIS_HAPP_API size_t get_connection_size() const;
 
+  /**
+   * @breif get all nodes known by this cluster
+   * @note node ids in slots, connections and circuit breakers are all interned here
+   */
+  HIREDIS_HAPP_API const node_registry &get_node_registry() const;
+
   HIREDIS_HAPP_API onconnect_fn_t set_on_connect(onconnect_fn_t cbk);
   HIREDIS_HAPP_API onconnected_fn_t set_on_connected(onconnected_fn_t cbk);
   HIREDIS_HAPP_API ondisconnected_fn_t set_on_disconnected(ondisconnected_fn_t cbk);
 
+  /**
+   * @breif set callback which is called after all slots are loaded by CLUSTER SLOTS
+   * @return old callback
+   */
+  HIREDIS_HAPP_API onslotsupdated_fn_t set_on_slots_updated(onslotsupdated_fn_t cbk);
+
+  /**
+   * @breif set filter of nodes which this cluster can connect to
+   * @note connections to nodes refused by it are never made, cmds of their slots fail with REDIS_HAPP_SLOT_UNAVAILABLE
+   *       and requests without slot are sent to nodes accepted by it
+   * @return old filter
+   */
+  HIREDIS_HAPP_API connection_filter_fn_t set_connection_filter(connection_filter_fn_t cbk);
+
   HIREDIS_HAPP_API void set_cmd_buffer_size(size_t s);
 
   HIREDIS_HAPP_API size_t get_cmd_buffer_size() const;
 
+  /**
+   * @breif build replies of new connections in a bump arena instead of one malloc per element
+   * @param chunk_size size of the first chunk of arena, 0 to disable it(default)
+   * @note replies must not be used after the callback returns, and it only works with hiredis 1.0 or upper
+   * @see reply_arena
+   */
+  HIREDIS_HAPP_API void set_reply_arena_chunk_size(size_t chunk_size);
+
+  HIREDIS_HAPP_API size_t get_reply_arena_chunk_size() const;
+
+  /**
+   * @breif let new connections deliver elements of replies to the stream visitor of cmds as they are parsed
+   * @param enable true to enable it, it's disabled by default
+   * @note reply arena is not used when it's enabled, and it only works with hiredis 1.0 or upper
+   * @see reply_stream, cmd_exec::set_stream_visitor
+   */
+  HIREDIS_HAPP_API void set_reply_stream(bool enable);
+
+  HIREDIS_HAPP_API bool is_reply_stream_enabled() const;
+
+  /**
+   * @breif get the slab pool of cmds, it can be used to get stats or trim idle memory
+   */
+  HIREDIS_HAPP_API cmd_pool *get_cmd_pool();
+  HIREDIS_HAPP_API const cmd_pool *get_cmd_pool() const;
+
   HIREDIS_HAPP_API bool is_timer_available() const;
 
   HIREDIS_HAPP_API bool is_timer_active() const;
@@ -242,10 +535,73 @@ class cluster {
 
   HIREDIS_HAPP_API void set_timeout(time_t sec);
 
+  /**
+   * @breif set the range of hedge delay
+   * @param min_usec minimum delay in microseconds
+   * @param max_usec maximum delay in microseconds, it's also used before there are enough latency samples
+   * @param percentile latency percentile of the master replies used as hedge delay
+   */
+  HIREDIS_HAPP_API void set_hedge_delay(time_t min_usec, time_t max_usec,
+                                        int percentile = HIREDIS_HAPP_HEDGE_PERCENTILE);
+
+  /**
+   * @breif get current hedge delay in microseconds
+   */
+  HIREDIS_HAPP_API time_t get_hedge_delay() const;
+
+  HIREDIS_HAPP_API const hedge_stats_t &get_hedge_stats() const;
+
+  /**
+   * @breif set configure of circuit breakers, it's shared by all nodes
+   * @note circuit breakers are disabled by default, pass circuit_breaker::default_config() or a config with
+   *       half_open_probes > 0 to enable them. They only work when timer is active.
+   */
+  HIREDIS_HAPP_API void set_circuit_breaker(const circuit_breaker::config_t &conf);
+
+  HIREDIS_HAPP_API const circuit_breaker::config_t &get_circuit_breaker_config() const;
+
+  /**
+   * @breif get circuit breaker of a node
+   * @param key connection name(ip:port)
+   * @return circuit breaker of the node, nullptr if there is no request sent to this node
+   */
+  HIREDIS_HAPP_API const circuit_breaker *get_circuit_breaker(const std::string &key) const;
+
+  /**
+   * @breif record latency of every node into metrics, it's disabled by default
+   * @note it reads the steady clock once when a cmd is sent and once when its reply is received
+   */
+  HIREDIS_HAPP_API void set_latency_metrics(bool enable);
+
+  HIREDIS_HAPP_API bool is_latency_metrics_enabled() const;
+
+  HIREDIS_HAPP_API const metrics &get_metrics() const;
+
+  /**
+   * @breif copy counters, gauges and metrics of all nodes
+   * @note it must be called by the thread which runs the event loop, post() a task to export it to other threads
+   */
+  HIREDIS_HAPP_API void snapshot_metrics(metrics::snapshot_t &out) const;
+
+  HIREDIS_HAPP_API void reset_metrics();
+
   HIREDIS_HAPP_API void add_timer_cmd(cmd_t *cmd);
 
   HIREDIS_HAPP_API int proc(time_t sec, time_t usec);
 
+  /**
+   * @breif post a task to the thread which runs the event loop, it can be called by any thread
+   * @note tasks are run in batches by proc() or when the wakeup eventfd or function of get_submit_queue() fires,
+   *       exec() and other functions of this object should only be called in tasks by other threads
+   * @return 0 or error code
+   */
+  template <typename F>
+  int post(F &&fn) {
+    return submit_queue_.post(std::forward<F>(fn));
+  }
+
+  HIREDIS_HAPP_API submit_queue &get_submit_queue();
+
   HIREDIS_HAPP_API void set_log_writer(log_fn_t info_fn, log_fn_t debug_fn, size_t max_size = 65536);
 
   HIREDIS_HAPP_API const timer_t &get_timer_actions() const;
@@ -253,6 +609,24 @@ class cluster {
  private:
   HIREDIS_HAPP_API cmd_t *create_cmd(cmd_t::callback_fn_t cbk, void *pridata);
   HIREDIS_HAPP_API void destroy_cmd(cmd_t *c);
+
+  template <typename F>
+  cmd_t *create_callable_cmd(F &&fn) {
+    holder_t h;
+    h.clu = this;
+    return cmd_t::create_callable(cmd_pool_, h, std::forward<F>(fn));
+  }
+
+  // format and send a cmd created by create_callable_cmd
+  HIREDIS_HAPP_API cmd_t *exec_callable(const char *key, size_t ks, cmd_t *cmd, int argc, const char **argv,
+                                        const size_t *argvlen);
+  HIREDIS_HAPP_API cmd_t *exec_callable(const char *key, size_t ks, cmd_t *cmd, const char *fmt, va_list ap);
+
+  // send a cmd formatted by format_args, len is its result
+  HIREDIS_HAPP_API cmd_t *exec_encoded(const char *key, size_t ks, cmd_t *cmd, int64_t len);
+
+  // send cmd and cmds sharing its content to every master
+  HIREDIS_HAPP_API int broadcast_cmd(cmd_t *cmd);
   HIREDIS_HAPP_API int call_cmd(cmd_t *c, int err, redisAsyncContext *context, void *reply);
 
   static void on_reply_wrapper(redisAsyncContext *c, void *r, void *privdata);
@@ -263,7 +637,33 @@ class cluster {
 
   static void on_reply_auth(cmd_exec *cmd, redisAsyncContext *c, void *r, void *privdata);
 
-  void remove_connection_key(const std::string &name);
+  struct hedge_t;
+  static void on_reply_hedge(cmd_exec *cmd, redisAsyncContext *c, void *r, void *privdata);
+  void send_hedge(hedge_t *hedge);
+  void destroy_hedge(hedge_t *hedge);
+  void add_hedge_sample(time_t latency_usec);
+
+  connection_t *get_connection_by_id(connection::node_id_t id);
+  connection_t *get_or_make_connection(const connection::key_t &key);
+  bool accept_node(const connection::key_t &key);
+
+  bool allow_request(connection_t *conn, bool &is_probe);
+  void on_node_success(connection_t *conn, bool is_probe);
+  void on_node_failure(connection_t *conn, bool is_probe);
+
+  // send cmd again at once or by the retry timer, it's not counted as a retry
+  cmd_t *reschedule(cmd_t *cmd, connection_t *conn);
+
+  // count a reply received by conn and its latency
+  void add_node_reply(connection_t *conn, cmd_t *cmd);
+
+  void remove_connection_key(connection::node_id_t id);
+
+  // slots are all set, send cmds waiting for them
+  void finish_slot_update();
+
+  // publish slots_ as a new snapshot for other threads
+  void publish_slot_map();
 
  private:
   void log_debug(const char *fmt, ...);
@@ -276,14 +676,30 @@ class cluster {
   // authorization information
   connection::auth_info_t auth_;
 
+  // allocator of cmds
+  cmd_pool *cmd_pool_;
+
   // slot information
   struct slot_status {
     enum type { INVALID = 0, UPDATING, OK };
   };
-  slot_t slots_[HIREDIS_HAPP_SLOT_NUMBER];
+  // hosts are ids in nodes_, so comparing and swapping hosts never touch strings
+  struct slot_entry_t {
+    int index;
+    std::vector<connection::node_id_t> hosts;  // master first
+  };
+  slot_entry_t slots_[HIREDIS_HAPP_SLOT_NUMBER];
+  // slots returned by get_slot_by_key(), with the addresses of hosts
+  mutable HIREDIS_HAPP_MAP(int, slot_t) slot_views_;
   slot_status::type slot_flag_;
   // retry cmd queue after slots_ reloaded
   std::list<cmd_t *> slot_pending_;
+  // snapshots of slots_ for other threads, slots_ is only used by the loop thread
+  slot_map_holder slot_map_;
+  bool slot_map_dirty_;
+
+  // all nodes, ids of them are kept when connections are released or the cluster is reset
+  node_registry nodes_;
 
   // connection pool
   connection_map_t connections_;
@@ -291,11 +707,33 @@ class cluster {
   // timer
   timer_t timer_actions_;
 
+  // tasks posted by other threads
+  submit_queue submit_queue_;
+
+  // hedged reads
+  struct hedge_set_t {
+    hedge_stats_t stats;
+    std::vector<time_t> samples;  // latency of master replies in microseconds
+    size_t sample_next;
+    size_t sample_count;
+    time_t delay_usec;
+    HIREDIS_HAPP_MAP(connection::node_id_t, uint64_t) readonly_conns;  // node id -> sequence which READONLY is sent
+  };
+  hedge_set_t hedge_;
+
+  // circuit breakers, node id -> breaker. they are kept when connections are released
+  HIREDIS_HAPP_MAP(connection::node_id_t, circuit_breaker) breakers_;
+
+  // counters and latency, they are kept when the cluster is reset
+  metrics metrics_;
+
   // callbacks_
   struct callback_set_t {
     onconnect_fn_t on_connect;
     onconnected_fn_t on_connected;
     ondisconnected_fn_t on_disconnected;
+    onslotsupdated_fn_t on_slots_updated;
+    connection_filter_fn_t connection_filter;
   };
   callback_set_t callbacks_;
 };
@@ -7,15 +7,50 @@
 
 #pragma once
 
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include <ostream>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 #include "hiredis_happ_config.h"
 
+#include "happ_prepared_cmd.h"
+#include "happ_timer.h"
+
 namespace hiredis {
 namespace happ {
 class cluster;
 class raw;
 class connection;
+class cmd_pool;
+class metrics;
+
+struct HIREDIS_HAPP_API_HEAD_ONLY cmd_segment {
+  const char *data;
+  size_t len;
+};
+
+/**
+ * @brief command whose large arguments are referenced instead of copied
+ * @note memory layout: [cmd_scatter][cmd_segment * segment_count][owned bytes]
+ *       segments[0] is always owned and contains "*N\r\n$LEN\r\nCMD\r\n" with a tailing \0, so pick_cmd still works.
+ *       Other segments are RESP headers, small arguments and trailers copied into owned bytes, or large arguments
+ *       referenced from the caller.
+ */
+struct HIREDIS_HAPP_API_HEAD_ONLY cmd_scatter {
+  typedef void (*release_fn_t)(void *);
+
+  release_fn_t release_fn;  // called when the referenced arguments are not used any more
+  void *release_data;
+  size_t total_len;  // length of the whole command
+  size_t segment_count;
+  cmd_segment *segments;
+};
 
 union HIREDIS_HAPP_API_HEAD_ONLY holder_t {
   cluster *clu;
@@ -23,25 +58,173 @@ union HIREDIS_HAPP_API_HEAD_ONLY holder_t {
 };
 
 struct HIREDIS_HAPP_API_HEAD_ONLY cmd_content {
+  struct storage {
+    enum type {
+      SDS = 0,  // content.redis_sds, raw_len is 0
+      HEAP,     // content.raw allocated by hiredis
+      INLINE,   // content.raw points to the inline buffer of cmd_exec
+      SCATTER,  // content.scatter, raw_len is the length of segments[0]
+      SHARED,   // content.raw points to an immutable reference-counted buffer shared by cmds
+    };
+  };
+
   size_t raw_len;
   union {
     char *raw;
     sds redis_sds;
+    cmd_scatter *scatter;
   } content;
+  storage::type kind;
+};
+
+namespace detail {
+inline constexpr size_t resp_count_digits(size_t v) {
+  size_t ret = 1;
+  while (v >= 10) {
+    v /= 10;
+    ++ret;
+  }
+  return ret;
+}
+
+// $[LENGTH]\r\n[CONTENT]\r\n
+inline constexpr size_t resp_bulk_len(size_t len) { return 1 + resp_count_digits(len) + 2 + len + 2; }
+
+inline char *resp_write_header(char *out, char prefix, size_t v) {
+  *out++ = prefix;
+  size_t digits = resp_count_digits(v);
+  for (size_t i = digits; i > 0; --i) {
+    out[i - 1] = static_cast<char>('0' + v % 10);
+    v /= 10;
+  }
+  out += digits;
+  *out++ = '\r';
+  *out++ = '\n';
+  return out;
+}
+
+// argument of variadic format, numbers are encoded into buf
+struct cmd_arg {
+  const char *data;
+  size_t len;
+  char buf[32];
 };
 
+template <typename F>
+struct cmd_callable;
+}  // namespace detail
+
+/**
+ * @brief command name encoded as RESP bulk string at compile time
+ * @note usage: static constexpr hiredis::happ::cmd_literal hset("HSET"); or pass hiredis::happ::cmd_literal("HSET")
+ *       to exec directly
+ */
+template <size_t N>
+struct cmd_literal {
+  static_assert(N > 1, "command name can not be empty");
+
+  char data[N + 24];  // $[LENGTH]\r\n[NAME]\r\n
+  size_t len;
+
+  constexpr cmd_literal(const char (&name)[N]) : data{}, len(0) {
+    size_t name_len = N - 1;
+    size_t digits = detail::resp_count_digits(name_len);
+    data[len++] = '$';
+    for (size_t i = digits; i > 0; --i) {
+      data[len + i - 1] = static_cast<char>('0' + name_len % 10);
+      name_len /= 10;
+    }
+    len += digits;
+    data[len++] = '\r';
+    data[len++] = '\n';
+    for (size_t i = 0; i + 1 < N; ++i) {
+      data[len++] = name[i];
+    }
+    data[len++] = '\r';
+    data[len++] = '\n';
+  }
+};
+
+template <size_t N>
+cmd_literal(const char (&)[N]) -> cmd_literal<N>;
+
 class cmd_exec {
  public:
   typedef void (*callback_fn_t)(cmd_exec *, struct redisAsyncContext *, void *, void *);
+  typedef cmd_scatter::release_fn_t release_fn_t;
+  typedef void (*stream_fn_t)(cmd_exec *, const redisReply *element, size_t index, void *);
 
   HIREDIS_HAPP_API int64_t vformat(int argc, const char **argv, const size_t *argvlen);
 
+  /**
+   * @brief format command without copying large arguments
+   * @param argc argument count
+   * @param argv pointer of every argument
+   * @param argvlen size of every argument
+   * @param release_fn called with release_data when argv is not used any more, can be nullptr
+   * @param release_data data passed to release_fn
+   * @note arguments not shorter than HIREDIS_HAPP_CMD_REFERENCE_SIZE(except the command name) are referenced, so
+   *       they must be kept valid until release_fn is called. release_fn is called when this command is destroyed
+   *       or formatted again, and it's called immediately if there is no large argument or format failed.
+   *       Pub/sub commands like SUBSCRIBE are always copied, because hiredis reads their channels.
+   * @return length of the whole command, or error code
+   */
+  HIREDIS_HAPP_API int64_t vformat_reference(int argc, const char **argv, const size_t *argvlen,
+                                             release_fn_t release_fn, void *release_data);
+
   HIREDIS_HAPP_API int format(const char *fmt, ...);
 
+  /**
+   * @brief format command from typed arguments without parsing any format string
+   * @param cmd command name encoded at compile time
+   * @param args arguments, string-like values(std::string_view, std::string, const char *) are copied as they are,
+   *        integers and floating point numbers are encoded as decimal strings
+   * @return length of the whole command, or error code
+   */
+  template <size_t N, typename... Args>
+  int64_t format_args(const cmd_literal<N> &cmd, Args &&...args);
+
+  /**
+   * @brief format a prepared command, only placeholders are encoded and constant segments are copied
+   * @param cmd prepared command
+   * @param args values of placeholders, in the same types as format_args of cmd_literal
+   * @return length of the whole command, or error code. REDIS_HAPP_PARAM if the count of args is not the count of
+   *         placeholders
+   */
+  template <typename... Args>
+  int64_t format_args(const prepared_cmd &cmd, Args &&...args);
+
+  /**
+   * @brief format a prepared command
+   * @param cmd prepared command
+   * @param argc count of placeholder values, must be cmd.get_placeholder_count()
+   * @param argv every placeholder value
+   * @param argvlen size of every value, nullptr means all values are strings ended with \0
+   * @return length of the whole command, or error code
+   */
+  HIREDIS_HAPP_API int64_t format_prepared(const prepared_cmd &cmd, int argc, const char **argv,
+                                           const size_t *argvlen);
+
   HIREDIS_HAPP_API int vformat(const char *fmt, va_list ap);
 
   HIREDIS_HAPP_API int vformat(const sds *src);
 
+  /**
+   * @brief send the same bytes as src without copying them, used by fan-out and hedged cmds
+   * @param src cmd already formatted
+   * @note the content of src is moved into an immutable reference-counted buffer first if it's not shared yet, so
+   *       referenced arguments of src are released at that time. The buffer is freed after the last cmd using it is
+   *       destroyed or formatted again. Commands in the inline buffer are copied, it's cheaper than a reference.
+   * @return length of the whole command, or error code
+   */
+  HIREDIS_HAPP_API int64_t share_content(cmd_exec *src);
+
+  /**
+   * @brief get how many cmds are using the content of this cmd
+   * @return 0 if not formatted, 1 if the content is owned only by this cmd
+   */
+  HIREDIS_HAPP_API size_t get_content_ref_count() const;
+
   HIREDIS_HAPP_API int call_reply(int rcode, redisAsyncContext *context, void *reply);
 
   HIREDIS_HAPP_API int result() const;
@@ -60,6 +243,11 @@ class cmd_exec {
 
   static HIREDIS_HAPP_API void dump(std::ostream &out, redisReply *reply, int ident = 0);
 
+  /**
+   * @brief get capacity of the inline buffer, commands not longer than it will be formatted without any allocation
+   */
+  static HIREDIS_HAPP_API size_t get_inline_capacity();
+
   HIREDIS_HAPP_API holder_t get_holder() const;
 
   HIREDIS_HAPP_API callback_fn_t get_callback_fn() const;
@@ -68,6 +256,24 @@ class cmd_exec {
 
   HIREDIS_HAPP_API int get_error_code() const;
 
+  /**
+   * @brief deliver elements of the reply to fn as soon as they are parsed, instead of building the whole reply
+   * @param fn called with (this, element, index in its parent, private_data()) for every streamed element, nullptr to
+   *        disable streaming
+   * @param depth elements at this depth are streamed, 1 means elements of the top level array(HGETALL, LRANGE),
+   *        2 means elements of arrays in the top level array(the key list of SCAN)
+   * @note it only works on connections with reply_stream attached, or the whole reply is built as usual. When it
+   *       works, the aggregate holding the streamed elements in the final reply keeps its elements count but its
+   *       element is nullptr, and elements must not be used after fn returns
+   * @note elements may be delivered again if the cmd is retried, and fn must not release the connection or the cmd
+   * @see reply_stream
+   */
+  HIREDIS_HAPP_API void set_stream_visitor(stream_fn_t fn, size_t depth = 1);
+
+  HIREDIS_HAPP_API stream_fn_t get_stream_fn() const;
+
+  HIREDIS_HAPP_API size_t get_stream_depth() const;
+
   /**
    * @brief create raw_cmd_content_ object(This function is public only for unit test, please don't
    * use it directly)
@@ -76,10 +282,21 @@ class cmd_exec {
    * @param pridata private data
    * @param buff_len alloacte some memory inner raw_cmd_content_(this can be used to store some more
    * data for later usage)
+   * @note HIREDIS_HAPP_CMD_INLINE_SIZE bytes are also allocated in the same block to store small commands
    * @return address of raw_cmd_content_ object if success
    */
   static HIREDIS_HAPP_API cmd_exec *create(holder_t holder_, callback_fn_t cbk, void *pridata, size_t buffer_len);
 
+  /**
+   * @brief create raw_cmd_content_ object from a pool(This function is public only for unit test, please don't
+   * use it directly)
+   * @param pool pool to allocate from, malloc will be used if it's nullptr
+   * @see create
+   * @return address of raw_cmd_content_ object if success
+   */
+  static HIREDIS_HAPP_API cmd_exec *create(cmd_pool *pool, holder_t holder_, callback_fn_t cbk, void *pridata,
+                                           size_t buffer_len);
+
   /**
    * @brief destroy raw_cmd_content_ object(This function is public only for unit test, please don't
    * use it directly)
@@ -87,15 +304,49 @@ class cmd_exec {
    */
   static HIREDIS_HAPP_API void destroy(cmd_exec *c);
 
+  /**
+   * @brief create raw_cmd_content_ object whose callback is a callable object(This function is public only for unit
+   * test, please don't use it directly)
+   * @param pool pool to allocate from, malloc will be used if it's nullptr
+   * @param holder_ owner of this
+   * @param fn callable object called as fn(cmd_exec *, redisAsyncContext *, void *reply), it's moved into buffer()
+   *        if it's not larger than HIREDIS_HAPP_CMD_CALLABLE_INLINE_SIZE, or allocated on heap
+   * @note fn is destroyed after it's called or when the cmd is destroyed, buffer() is used by fn and private_data() is
+   *       nullptr
+   * @return address of raw_cmd_content_ object if success
+   */
+  template <typename F>
+  static cmd_exec *create_callable(cmd_pool *pool, holder_t holder_, F &&fn);
+
  private:
+  char *inline_buffer();
+
+  // release old content and get a buffer of len bytes(and a tailing \0) to write the new command into
+  HIREDIS_HAPP_API char *reserve_content(size_t len);
+
+  // write a prepared command with encoded placeholder values
+  HIREDIS_HAPP_API int64_t write_prepared(const prepared_cmd &cmd, size_t argc, const detail::cmd_arg *args);
+
+  // append segments after segments[0] of scatter content into sds
+  bool append_scatter_tail(sds *out) const;
+
   friend class cluster;
   friend class raw;
   friend class connection;
 
+  template <typename F>
+  friend struct detail::cmd_callable;
+
+  typedef void (*callable_destroy_fn_t)(void *);
+
   holder_t holder_;  // holder_
   cmd_content raw_cmd_content_;
   size_t ttl_;              // left retry times(just like network ttl_)
   callback_fn_t callback_;  // user callback_ function
+  size_t buffer_len_;       // size of buffer()
+
+  // destroys the callable in buffer() if it's not called, such as cmds of subscribe and monitor which have no reply
+  callable_destroy_fn_t callable_destroy_;
 
   // ========= exec data =========
   int error_code_;  // error code, just like redisAsyncContext::error_code_
@@ -104,7 +355,193 @@ class cmd_exec {
   } engine_;
 
   void *private_data_;  // user pri data
+
+  stream_fn_t stream_fn_;  // visitor of streamed elements, nullptr if not streaming
+  size_t stream_depth_;    // depth of streamed elements
+
+  timer_node timer_;  // retry timer
+
+  cmd_pool *pool_;  // pool which this is allocated from, nullptr if allocated by malloc
+
+  metrics *metrics_;  // finished cmds are counted into it, nullptr if it's not sent by a cluster
+  time_t sent_usec_;  // when it's written into a connection last time, 0 if latency is not recorded
+
+  bool breaker_probe_;  // it's sent as a probe of a half open circuit breaker last time
 };
+
+namespace detail {
+template <typename F>
+struct cmd_callable {
+  typedef typename std::decay<F>::type value_type;
+
+  static constexpr bool is_inline = sizeof(value_type) <= HIREDIS_HAPP_CMD_CALLABLE_INLINE_SIZE &&
+                                    alignof(value_type) <= alignof(void *);
+
+  static constexpr size_t storage_size() { return is_inline ? sizeof(value_type) : sizeof(value_type *); }
+
+  static bool construct(void *storage, F &&fn) {
+    if (is_inline) {
+      new (storage) value_type(std::forward<F>(fn));
+      return true;
+    }
+
+    value_type *ret = new (std::nothrow) value_type(std::forward<F>(fn));
+    *reinterpret_cast<value_type **>(storage) = ret;
+    return nullptr != ret;
+  }
+
+  static value_type *get(void *storage) {
+    return is_inline ? reinterpret_cast<value_type *>(storage) : *reinterpret_cast<value_type **>(storage);
+  }
+
+  static void destroy(void *storage) {
+    if (is_inline) {
+      get(storage)->~value_type();
+    } else {
+      delete get(storage);
+    }
+  }
+
+  // callback is called only once, so fn can be destroyed here
+  static void invoke(cmd_exec *cmd, redisAsyncContext *c, void *reply, void *) {
+    void *storage = cmd->buffer();
+    cmd->callable_destroy_ = nullptr;
+    (*get(storage))(cmd, c, reply);
+    destroy(storage);
+  }
+};
+
+// callables which can be passed to exec of cluster and raw, function pointers and cmds are excluded
+template <typename F>
+struct is_cmd_callable
+    : std::integral_constant<bool, !std::is_convertible<F, cmd_exec::callback_fn_t>::value &&
+                                       !std::is_pointer<typename std::decay<F>::type>::value> {};
+
+// commands which can be formatted by cmd_exec::format_args
+template <typename T>
+struct is_cmd_template : std::false_type {};
+
+template <size_t N>
+struct is_cmd_template<cmd_literal<N> > : std::true_type {};
+
+template <>
+struct is_cmd_template<prepared_cmd> : std::true_type {};
+}  // namespace detail
+
+template <typename F>
+cmd_exec *cmd_exec::create_callable(cmd_pool *pool, holder_t holder_, F &&fn) {
+  typedef detail::cmd_callable<F> callable_t;
+
+  cmd_exec *ret = create(pool, holder_, callable_t::invoke, nullptr, callable_t::storage_size());
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  if (!callable_t::construct(ret->buffer(), std::forward<F>(fn))) {
+    // callback must not be called without fn
+    ret->callback_ = nullptr;
+    destroy(ret);
+    return nullptr;
+  }
+
+  ret->callable_destroy_ = callable_t::destroy;
+  return ret;
+}
+namespace detail {
+inline void cmd_encode_arg(cmd_arg &out, std::string_view value) {
+  out.data = value.data();
+  out.len = value.size();
+}
+
+// bool and char are not encoded as numbers, pass them as strings explicitly
+template <typename T>
+inline typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value &&
+                               !std::is_same<T, char>::value>::type
+cmd_encode_arg(cmd_arg &out, T value) {
+  typedef typename std::make_unsigned<T>::type unsigned_t;
+  bool negative = value < 0;
+  unsigned_t v = static_cast<unsigned_t>(value);
+  if (negative) {
+    v = static_cast<unsigned_t>(0 - v);
+  }
+
+  char *end = out.buf + sizeof(out.buf);
+  char *pos = end;
+  do {
+    *--pos = static_cast<char>('0' + v % 10);
+    v /= 10;
+  } while (v > 0);
+  if (negative) {
+    *--pos = '-';
+  }
+
+  out.data = pos;
+  out.len = static_cast<size_t>(end - pos);
+}
+
+template <typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type cmd_encode_arg(cmd_arg &out, T value) {
+  double v = static_cast<double>(value);
+  out.data = out.buf;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  // shortest representation which can be parsed back to the same value
+  std::to_chars_result res = std::to_chars(out.buf, out.buf + sizeof(out.buf), v);
+  out.len = std::errc() == res.ec ? static_cast<size_t>(res.ptr - out.buf) : 0;
+#else
+  // shortest of 15 and 17 significant digits which can be parsed back to the same value
+  int len = snprintf(out.buf, sizeof(out.buf), "%.15g", v);
+  if (len > 0 && strtod(out.buf, nullptr) != v) {
+    len = snprintf(out.buf, sizeof(out.buf), "%.17g", v);
+  }
+  out.len = len > 0 ? static_cast<size_t>(len) : 0;
+#endif
+}
+}  // namespace detail
+
+template <size_t N, typename... Args>
+int64_t cmd_exec::format_args(const cmd_literal<N> &cmd, Args &&...args) {
+  constexpr size_t argc = 1 + sizeof...(Args);
+  detail::cmd_arg encoded[sizeof...(Args) > 0 ? sizeof...(Args) : 1];
+  size_t index = 0;
+  (void)index;
+  (detail::cmd_encode_arg(encoded[index++], std::forward<Args>(args)), ...);
+
+  size_t total = 1 + detail::resp_count_digits(argc) + 2 + cmd.len;
+  for (size_t i = 0; i < sizeof...(Args); ++i) {
+    total += detail::resp_bulk_len(encoded[i].len);
+  }
+
+  char *pos = reserve_content(total);
+  if (nullptr == pos) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  pos = detail::resp_write_header(pos, '*', argc);
+  memcpy(pos, cmd.data, cmd.len);
+  pos += cmd.len;
+  for (size_t i = 0; i < sizeof...(Args); ++i) {
+    pos = detail::resp_write_header(pos, '$', encoded[i].len);
+    if (encoded[i].len > 0) {
+      memcpy(pos, encoded[i].data, encoded[i].len);
+      pos += encoded[i].len;
+    }
+    *pos++ = '\r';
+    *pos++ = '\n';
+  }
+  *pos = '\0';
+
+  return static_cast<int64_t>(total);
+}
+
+template <typename... Args>
+int64_t cmd_exec::format_args(const prepared_cmd &cmd, Args &&...args) {
+  detail::cmd_arg encoded[sizeof...(Args) > 0 ? sizeof...(Args) : 1];
+  size_t index = 0;
+  (void)index;
+  (detail::cmd_encode_arg(encoded[index++], std::forward<Args>(args)), ...);
+
+  return write_prepared(cmd, sizeof...(Args), encoded);
+}
 }  // namespace happ
 }  // namespace hiredis
 
@@ -0,0 +1,114 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_CMD_POOL_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_CMD_POOL_H
+
+#pragma once
+
+#include <cstddef>
+
+#include "hiredis_happ_config.h"
+
+namespace hiredis {
+namespace happ {
+
+/**
+ * @brief slab allocator of cmd_exec, every cluster or raw owns one
+ * @note blocks are grouped by power-of-two size classes, and every class allocate blocks from slabs of about
+ *       HIREDIS_HAPP_CMD_POOL_SLAB_SIZE bytes. Freed blocks are recycled by the free list of their slab, and a slab
+ *       is released when it's fully free and the idle memory exceeds the high water.
+ * @note it's not thread-safe, just like cluster and raw
+ */
+class cmd_pool {
+ public:
+  enum {
+    MIN_CLASS_SHIFT = 6,   // 64 bytes
+    MAX_CLASS_SHIFT = 16,  // 64 KB, larger blocks use malloc directly
+    CLASS_COUNT = MAX_CLASS_SHIFT - MIN_CLASS_SHIFT + 1,
+  };
+
+  struct HIREDIS_HAPP_API_HEAD_ONLY stats_t {
+    size_t slab_count;       // slabs allocated from system
+    size_t slab_bytes;       // bytes of all slabs
+    size_t idle_slab_bytes;  // bytes of fully free slabs
+    size_t block_in_use;     // blocks allocated and not deallocated
+    size_t malloc_in_use;    // blocks too large for slab and allocated by malloc
+  };
+
+ private:
+  struct slab_t;
+  struct block_header_t;
+  struct size_class_t {
+    size_t block_size;
+    size_t block_count;
+    slab_t *partial;  // slabs which have some free blocks
+    slab_t *empty;    // slabs which are fully free
+  };
+
+  cmd_pool(const cmd_pool &);
+  cmd_pool &operator=(const cmd_pool &);
+
+  cmd_pool();
+  ~cmd_pool();
+
+ public:
+  static HIREDIS_HAPP_API cmd_pool *create();
+
+  /**
+   * @brief release the pool owned by cluster or raw
+   * @note blocks still in use will be returned to pool later, so the pool will be destroyed after all of them
+   *       are deallocated
+   */
+  static HIREDIS_HAPP_API void release(cmd_pool *pool);
+
+  /**
+   * @brief allocate a block
+   * @param size bytes needed
+   * @return address of the block, nullptr if failed
+   */
+  HIREDIS_HAPP_API void *allocate(size_t size);
+
+  /**
+   * @brief deallocate a block allocated by allocate
+   * @note the pool may be destroyed in this call if it's already released
+   */
+  HIREDIS_HAPP_API void deallocate(void *ptr);
+
+  /**
+   * @brief release all fully free slabs to system
+   * @return bytes released
+   */
+  HIREDIS_HAPP_API size_t trim();
+
+  /**
+   * @brief set high water of idle slabs
+   * @param bytes fully free slabs above this will be released
+   */
+  HIREDIS_HAPP_API void set_idle_high_water(size_t bytes);
+
+  HIREDIS_HAPP_API size_t get_idle_high_water() const;
+
+  HIREDIS_HAPP_API const stats_t &get_stats() const;
+
+ private:
+  static size_t get_class_index(size_t size);
+  slab_t *alloc_slab(size_t class_index);
+  void free_slab(slab_t *slab);
+  void trim_to(size_t bytes);
+  bool is_releasable() const;
+
+  static void slab_list_push(slab_t *&head, slab_t *slab);
+  static void slab_list_remove(slab_t *&head, slab_t *slab);
+
+ private:
+  size_class_t classes_[CLASS_COUNT];
+  size_t idle_high_water_;
+  bool released_;
+  stats_t stats_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_CMD_POOL_H
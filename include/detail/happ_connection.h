@@ -12,6 +12,7 @@
 #include "hiredis_happ_config.h"
 
 #include "happ_cmd.h"
+#include "happ_timer.h"
 
 namespace hiredis {
 namespace happ {
@@ -27,10 +28,14 @@ class connection {
     enum type { DISCONNECTED = 0, CONNECTING, CONNECTED };
   };
 
+  // interned id of a node, 0 means the key is not interned by a node_registry
+  typedef uint32_t node_id_t;
+
   struct HIREDIS_HAPP_API_HEAD_ONLY key_t {
     std::string name;
     uint16_t port;
     std::string ip;
+    node_id_t id = 0;
   };
 
   typedef std::function<const std::string &(connection *, const std::string &)> auth_fn_t;
@@ -116,6 +121,11 @@ class connection {
    */
   HIREDIS_HAPP_API cmd_exec *pop_reply(cmd_exec *c);
 
+  /**
+   * @brief get count of cmds waiting for replies
+   */
+  HIREDIS_HAPP_API size_t get_pending_count() const;
+
   HIREDIS_HAPP_API redisAsyncContext *get_context() const;
 
   HIREDIS_HAPP_API void release(bool close_fd);
@@ -126,6 +136,14 @@ class connection {
 
   HIREDIS_HAPP_API status::type get_status() const;
 
+  /**
+   * @brief get timer node used for connecting timeout, it will be removed from timer wheel after connected or
+   * disconnected
+   */
+  HIREDIS_HAPP_API timer_node &get_connect_timer();
+
+  HIREDIS_HAPP_API const timer_node &get_connect_timer() const;
+
  private:
 #if defined(HIREDIS_HAPP_UNIT_TEST_HACK)
   friend struct connection_unit_test_access;
@@ -151,6 +169,8 @@ class connection {
   // cmds inner this connection
   std::list<cmd_exec *> reply_list_;
   status::type conn_status_;
+
+  timer_node connect_timer_;
 };
 }  // namespace happ
 }  // namespace hiredis
@@ -0,0 +1,333 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_COROUTINE_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_COROUTINE_H
+
+#pragma once
+
+#include "hiredis_happ_config.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_COROUTINE)
+
+#  include <coroutine>
+#  include <cstddef>
+#  include <exception>
+#  include <new>
+#  include <string_view>
+#  include <type_traits>
+#  include <utility>
+
+#  include "happ_cluster.h"
+#  include "happ_raw.h"
+#  include "happ_reply_decoder.h"
+
+namespace hiredis {
+namespace happ {
+namespace detail {
+/**
+ * @brief free lists of coroutine frames of every thread, frames are grouped by size in 64 bytes
+ * @note frames larger than the biggest size class are allocated by operator new
+ */
+class co_frame_pool {
+ public:
+  static void *allocate(size_t size) {
+    size_t index = get_size_class(size);
+    if (index >= SIZE_CLASS_COUNT) {
+      return ::operator new(size);
+    }
+
+    local_t &pool = get_local();
+    block_t *block = pool.free_blocks[index];
+    if (nullptr == block) {
+      return ::operator new((index + 1) * SIZE_CLASS_STEP);
+    }
+
+    pool.free_blocks[index] = block->next;
+    --pool.free_counts[index];
+    return block;
+  }
+
+  static void deallocate(void *p, size_t size) {
+    if (nullptr == p) {
+      return;
+    }
+
+    size_t index = get_size_class(size);
+    if (index >= SIZE_CLASS_COUNT) {
+      ::operator delete(p);
+      return;
+    }
+
+    local_t &pool = get_local();
+    if (pool.free_counts[index] >= HIREDIS_HAPP_COROUTINE_FRAME_POOL_SIZE) {
+      ::operator delete(p);
+      return;
+    }
+
+    block_t *block = reinterpret_cast<block_t *>(p);
+    block->next = pool.free_blocks[index];
+    pool.free_blocks[index] = block;
+    ++pool.free_counts[index];
+  }
+
+  // count of free frames kept by this thread
+  static size_t get_cached_count() {
+    local_t &pool = get_local();
+    size_t ret = 0;
+    for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+      ret += pool.free_counts[i];
+    }
+    return ret;
+  }
+
+ private:
+  static constexpr size_t SIZE_CLASS_STEP = 64;
+  static constexpr size_t SIZE_CLASS_COUNT = 32;
+
+  struct block_t {
+    block_t *next;
+  };
+
+  struct local_t {
+    block_t *free_blocks[SIZE_CLASS_COUNT];
+    size_t free_counts[SIZE_CLASS_COUNT];
+
+    local_t() {
+      for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+        free_blocks[i] = nullptr;
+        free_counts[i] = 0;
+      }
+    }
+
+    ~local_t() {
+      for (size_t i = 0; i < SIZE_CLASS_COUNT; ++i) {
+        while (nullptr != free_blocks[i]) {
+          block_t *next = free_blocks[i]->next;
+          ::operator delete(free_blocks[i]);
+          free_blocks[i] = next;
+        }
+      }
+    }
+  };
+
+  static size_t get_size_class(size_t size) { return 0 == size ? 0 : (size - 1) / SIZE_CLASS_STEP; }
+
+  static local_t &get_local() {
+    static thread_local local_t ret;
+    return ret;
+  }
+};
+}  // namespace detail
+
+/**
+ * @brief raw result of co_await co_exec(...), use co_exec<T>(...) to get a decoded value instead
+ * @note the reply and the cmd are owned by hiredis and the cluster or raw, they are only valid until the coroutine
+ *       suspends again or returns, copy what is needed before next co_await
+ */
+class co_reply {
+ public:
+  co_reply() : result_(error_code::REDIS_HAPP_UNKNOWD), reply_(nullptr), cmd_(nullptr) {}
+  co_reply(int result, redisReply *reply, cmd_exec *cmd) : result_(result), reply_(reply), cmd_(cmd) {}
+
+  // error code of the cmd, REDIS_HAPP_OK if a reply is received
+  inline int result() const { return result_; }
+
+  // true if a reply is received and it's not an error reply
+  inline bool is_ok() const {
+    return error_code::REDIS_HAPP_OK == result_ && nullptr != reply_ && REDIS_REPLY_ERROR != reply_->type;
+  }
+
+  inline redisReply *reply() const { return reply_; }
+  inline cmd_exec *cmd() const { return cmd_; }
+
+  // REDIS_REPLY_* of the reply, 0 if there is no reply
+  inline int type() const { return nullptr == reply_ ? 0 : reply_->type; }
+
+  inline long long integer() const { return nullptr == reply_ ? 0 : reply_->integer; }
+
+  // content of string, status, error and verbatim replies
+  inline std::string_view str() const {
+    if (nullptr == reply_ || nullptr == reply_->str) {
+      return std::string_view();
+    }
+    return std::string_view(reply_->str, reply_->len);
+  }
+
+  inline size_t elements() const { return nullptr == reply_ ? 0 : reply_->elements; }
+
+  inline const redisReply *element(size_t index) const {
+    return (nullptr == reply_ || index >= reply_->elements) ? nullptr : reply_->element[index];
+  }
+
+ private:
+  int result_;
+  redisReply *reply_;
+  cmd_exec *cmd_;
+};
+
+/**
+ * @brief typed result of co_await co_exec<T>(...), the reply is decoded by decode_reply<T>
+ * @note string views in value point to the reply, they are only valid until the coroutine suspends again or returns
+ */
+template <typename T>
+struct co_result {
+  int result;  // error code of the cmd if it failed, or the result of decode_reply
+  T value;     // value-initialized if result is not REDIS_HAPP_OK
+
+  co_result() : result(error_code::REDIS_HAPP_UNKNOWD), value() {}
+
+  inline bool is_ok() const { return error_code::REDIS_HAPP_OK == result; }
+};
+
+/**
+ * @brief awaitable of a cmd, the cmd is sent when it's created and the coroutine is resumed in the reply callback
+ * @note co_await returns co_result<T>, or co_reply with the raw reply if T is co_reply
+ * @note the callback only keeps a pointer to this object, so it's stored in the inline buffer of the cmd and no memory
+ *       is allocated for every co_await
+ * @note if the cmd is destroyed without calling back, such as SUBSCRIBE and MONITOR, the coroutine is resumed with
+ *       REDIS_HAPP_CONNECTION when the callback is destroyed
+ * @note it can not be copied or moved, it must be co_awaited before it's destroyed
+ */
+template <typename T = co_reply>
+class [[nodiscard]] co_exec_awaitable {
+ public:
+  typedef typename std::conditional<std::is_same<T, co_reply>::value, co_reply, co_result<T> >::type result_type;
+
+  // send a cmd by cluster, args are the same as cluster::exec after the callback
+  template <typename... Args>
+  co_exec_awaitable(cluster &clu, const char *key, size_t ks, Args &&...args) : done_(false), lost_(false) {
+    callback_t cbk(this);
+    on_sent(clu.exec(key, ks, std::move(cbk), std::forward<Args>(args)...));
+  }
+
+  // send a cmd by raw, args are the same as raw::exec after the callback
+  template <typename... Args>
+  explicit co_exec_awaitable(raw &r, Args &&...args) : done_(false), lost_(false) {
+    callback_t cbk(this);
+    on_sent(r.exec(std::move(cbk), std::forward<Args>(args)...));
+  }
+
+  co_exec_awaitable(const co_exec_awaitable &) = delete;
+  co_exec_awaitable &operator=(const co_exec_awaitable &) = delete;
+
+  // the cmd may fail before it's sent, and then the coroutine does not suspend
+  inline bool await_ready() const noexcept { return done_; }
+  inline void await_suspend(std::coroutine_handle<> waiter) noexcept { waiter_ = waiter; }
+  inline result_type await_resume() { return std::move(result_); }
+
+ private:
+  // move-only, so only the callback stored in the cmd can finish the awaitable
+  struct callback_t {
+    co_exec_awaitable *self;
+
+    explicit callback_t(co_exec_awaitable *s) : self(s) {}
+    callback_t(callback_t &&other) noexcept : self(other.self) { other.self = nullptr; }
+    callback_t(const callback_t &) = delete;
+    callback_t &operator=(const callback_t &) = delete;
+
+    // the cmd is destroyed without calling back, the coroutine must not be left suspended
+    ~callback_t() {
+      if (nullptr != self && !self->done_) {
+        co_exec_awaitable *s = self;
+        self = nullptr;
+        s->lost_ = true;
+        s->finish(error_code::REDIS_HAPP_CONNECTION, nullptr, nullptr);
+      }
+    }
+
+    void operator()(cmd_exec *cmd, redisAsyncContext *, void *reply) {
+      co_exec_awaitable *s = self;
+      self = nullptr;
+      if (nullptr != s) {
+        s->finish(cmd->result(), reinterpret_cast<redisReply *>(reply), cmd);
+      }
+    }
+  };
+
+  inline void finish(int result, redisReply *reply, cmd_exec *cmd) {
+    set_result(result_, result, reply, cmd);
+    done_ = true;
+
+    // this object may be destroyed by the resumed coroutine, so do not touch it after resuming
+    if (waiter_) {
+      std::coroutine_handle<> waiter = waiter_;
+      waiter_ = nullptr;
+      waiter.resume();
+    }
+  }
+
+  static inline void set_result(co_reply &out, int result, redisReply *reply, cmd_exec *cmd) {
+    out = co_reply(result, reply, cmd);
+  }
+
+  template <typename U>
+  static inline void set_result(co_result<U> &out, int result, redisReply *reply, cmd_exec *) {
+    out.result = result;
+    if (error_code::REDIS_HAPP_OK == result) {
+      out.result = decode_reply(reply, out.value);
+    }
+    if (error_code::REDIS_HAPP_OK != out.result) {
+      out.value = U();
+    }
+  }
+
+  inline void on_sent(cmd_exec *cmd) {
+    // failed to create the cmd, the callback is not called or it's destroyed with the cmd
+    if (nullptr == cmd && (!done_ || lost_)) {
+      set_result(result_, error_code::REDIS_HAPP_CREATE, nullptr, nullptr);
+      done_ = true;
+    }
+  }
+
+ private:
+  std::coroutine_handle<> waiter_;
+  result_type result_;
+  bool done_;
+  bool lost_;  // the callback is destroyed without being called
+};
+
+/**
+ * @brief coroutine which starts at once and destroys itself when it returns
+ * @note frames are allocated by the per-thread frame pool
+ * @note exceptions escaped from it call std::terminate
+ */
+class co_task {
+ public:
+  struct promise_type {
+    inline co_task get_return_object() noexcept { return co_task(); }
+    inline std::suspend_never initial_suspend() noexcept { return std::suspend_never(); }
+    inline std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+    inline void return_void() noexcept {}
+    inline void unhandled_exception() noexcept { std::terminate(); }
+
+    static void *operator new(std::size_t size) { return detail::co_frame_pool::allocate(size); }
+    static void operator delete(void *p, std::size_t size) noexcept { detail::co_frame_pool::deallocate(p, size); }
+  };
+};
+
+/**
+ * @brief send a cmd by cluster and co_await its decoded reply, such as
+ *        co_result<std::optional<std::string> > value = co_await co_exec<std::optional<std::string> >(clu, key, ks,
+ *        "GET %s", key)
+ * @param args the same as cluster::exec after the callback, a format string with its values, argc/argv/argvlen or a
+ *        cmd_literal/prepared_cmd with its values
+ * @note T can be any type supported by reply_decoder, co_exec(...) without T co_awaits the raw co_reply
+ */
+template <typename T = co_reply, typename... Args>
+inline co_exec_awaitable<T> co_exec(cluster &clu, const char *key, size_t ks, Args &&...args) {
+  return co_exec_awaitable<T>(clu, key, ks, std::forward<Args>(args)...);
+}
+
+// send a cmd by raw and co_await its decoded reply, or the raw co_reply without T
+template <typename T = co_reply, typename... Args>
+inline co_exec_awaitable<T> co_exec(raw &r, Args &&...args) {
+  return co_exec_awaitable<T>(r, std::forward<Args>(args)...);
+}
+}  // namespace happ
+}  // namespace hiredis
+
+#endif
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_COROUTINE_H
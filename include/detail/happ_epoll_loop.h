@@ -0,0 +1,158 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_EPOLL_LOOP_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_EPOLL_LOOP_H
+
+#pragma once
+
+#include "hiredis_happ_config.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+
+#  include <atomic>
+#  include <ctime>
+#  include <thread>
+#  include <vector>
+
+#  include "happ_cluster.h"
+#  include "happ_raw.h"
+
+namespace hiredis {
+namespace happ {
+
+/**
+ * @brief minimal built-in event loop based on epoll and timerfd(linux only), so cluster and raw can run without
+ *        libevent or libuv
+ * @note bind() attaches all connections of a cluster or raw to this loop, watches the eventfd of its submit_queue
+ *       and calls its proc() with a monotonic clock by a timerfd, so users need not attach connections in on_connect
+ *       or call proc() by their own timer.
+ * @note everything except stop() must be called in the thread which runs the loop. When the loop runs in a dedicated
+ *       thread by start_thread(), use post() of the bound cluster or raw to call it from other threads.
+ * @note bound clusters and raws should be reset after the loop is stopped and before it's destroyed
+ * @note sockets are polled by io_uring if it's available, all poll changes of one iteration are submitted together
+ *       with waiting by one syscall. It falls back to epoll automatically when io_uring can not be created.
+ */
+class epoll_loop {
+ public:
+  struct backend_t {
+    enum type {
+      AUTO = 0,  // io_uring if it's available, or epoll
+      EPOLL,
+      IO_URING,
+    };
+  };
+
+  // counters of syscalls called by the loop itself, reads and writes of hiredis are not included
+  struct stats_t {
+    uint64_t wait_count;     // epoll_wait, or io_uring_enter which waits
+    uint64_t control_count;  // epoll_ctl, or io_uring_enter which only submits
+    uint64_t event_count;    // handled events
+  };
+
+  HIREDIS_HAPP_API epoll_loop();
+  HIREDIS_HAPP_API ~epoll_loop();
+
+  /**
+   * @brief create epoll fd, timerfd and the eventfd to stop the loop
+   * @param tick_usec interval of calling proc() of bound clusters and raws, in microseconds
+   * @param backend poller of sockets, IO_URING fails with REDIS_HAPP_CREATE if io_uring is not available
+   * @return 0 or error code
+   */
+  HIREDIS_HAPP_API int init(time_t tick_usec = HIREDIS_HAPP_LOOP_TICK_USEC,
+                            backend_t::type backend = backend_t::AUTO);
+
+  // @return EPOLL or IO_URING after init(), AUTO before it
+  HIREDIS_HAPP_API backend_t::type get_backend() const;
+
+  HIREDIS_HAPP_API stats_t get_stats() const;
+
+  /**
+   * @brief drive a cluster by this loop, the on_connect callback of it is wrapped and still called
+   * @return 0 or error code
+   */
+  HIREDIS_HAPP_API int bind(cluster &clu);
+
+  // drive a raw by this loop, the on_connect callback of it is wrapped and still called
+  HIREDIS_HAPP_API int bind(raw &r);
+
+  // attach a hiredis context to this loop, it's called by bound clusters and raws when they connect
+  HIREDIS_HAPP_API int attach(redisAsyncContext *ctx);
+
+  /**
+   * @brief wait and handle events once
+   * @param timeout_ms max time to wait, -1 to wait until any event
+   * @return count of events handled, or error code
+   */
+  HIREDIS_HAPP_API int run_once(int timeout_ms);
+
+  // run the loop until stop() is called, it returns at once if stop() is called before
+  HIREDIS_HAPP_API int run();
+
+  // stop the running loop, it can be called by any thread
+  HIREDIS_HAPP_API void stop();
+
+  // run the loop in a dedicated thread
+  HIREDIS_HAPP_API int start_thread();
+
+  // wait for the dedicated thread to exit after stop()
+  HIREDIS_HAPP_API void join();
+
+  HIREDIS_HAPP_API bool is_running() const;
+
+  // @return count of attached hiredis contexts
+  HIREDIS_HAPP_API size_t get_attached_count() const;
+
+  // get the time of CLOCK_MONOTONIC, which is passed to proc()
+  static HIREDIS_HAPP_API void get_monotonic_time(time_t &sec, time_t &usec);
+
+ private:
+  epoll_loop(const epoll_loop &);
+  epoll_loop &operator=(const epoll_loop &);
+
+  struct handle_t;
+  struct uring_state_t;
+
+  void on_tick();
+  void dispatch(handle_t *h, uint32_t events);
+  int update(handle_t *h, uint32_t events);
+  int wait_epoll(int timeout_ms);
+  int wait_uring(int timeout_ms);
+  void flush_polls();
+  void release(handle_t *h);
+  void collect();
+
+  static void on_add_read(void *privdata);
+  static void on_del_read(void *privdata);
+  static void on_add_write(void *privdata);
+  static void on_del_write(void *privdata);
+  static void on_cleanup(void *privdata);
+  static void on_schedule_timer(void *privdata, struct timeval tv);
+
+  struct bound_t {
+    cluster *clu;
+    raw *r;
+  };
+
+ private:
+  backend_t::type backend_;
+  int epoll_fd_;
+  uring_state_t *uring_;  // io_uring poller and handles whose polls should be changed, only for IO_URING
+  stats_t stats_;
+  handle_t *timer_;
+  handle_t *wakeup_;
+  std::vector<bound_t> bound_;
+  std::vector<handle_t *> submits_;
+  std::vector<handle_t *> contexts_;  // attached hiredis contexts, released ones are removed by collect()
+  std::vector<handle_t *> released_;
+  std::atomic<bool> stopping_;
+  std::atomic<bool> running_;
+  std::thread thread_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_EPOLL_LOOP_H
@@ -0,0 +1,159 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_METRICS_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_METRICS_H
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "hiredis_happ_config.h"
+
+#include "happ_connection.h"
+
+namespace hiredis {
+namespace happ {
+
+/**
+ * @brief log-linear histogram of latency in microseconds
+ * @note every power of two is split into SUB_BUCKET_COUNT buckets, so a percentile is at most 1/SUB_BUCKET_COUNT
+ *       larger than the real value. Values below 2 * SUB_BUCKET_COUNT are exact.
+ */
+class latency_histogram {
+ public:
+  enum {
+    SUB_BUCKET_BITS = 3,
+    SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS,
+    MAX_SHIFT = 40,  // latency of 2^41 microseconds or longer is counted into the last bucket
+    BUCKET_COUNT = (MAX_SHIFT - SUB_BUCKET_BITS + 2) * SUB_BUCKET_COUNT,
+  };
+
+ public:
+  HIREDIS_HAPP_API latency_histogram();
+
+  HIREDIS_HAPP_API void add(uint64_t usec);
+
+  HIREDIS_HAPP_API void merge(const latency_histogram &other);
+
+  HIREDIS_HAPP_API void reset();
+
+  HIREDIS_HAPP_API uint64_t get_count() const;
+
+  HIREDIS_HAPP_API uint64_t get_sum_usec() const;
+
+  HIREDIS_HAPP_API uint64_t get_max_usec() const;
+
+  HIREDIS_HAPP_API uint64_t get_bucket(size_t index) const;
+
+  /**
+   * @brief get latency at percentile
+   * @param percentile 0-100
+   * @return upper bound of the bucket which contains the percentile, never larger than get_max_usec()
+   */
+  HIREDIS_HAPP_API uint64_t get_percentile(double percentile) const;
+
+  static HIREDIS_HAPP_API size_t get_bucket_index(uint64_t usec);
+
+  static HIREDIS_HAPP_API uint64_t get_bucket_upper_bound(size_t index);
+
+ private:
+  uint64_t count_;
+  uint64_t sum_usec_;
+  uint64_t max_usec_;
+  uint64_t buckets_[BUCKET_COUNT];
+};
+
+/**
+ * @brief counters and per-node latency of a cluster
+ * @note it's not thread-safe, all fields are plain integers updated by the thread which runs the event loop. Read
+ *       them in that thread, or post() a task which copies cluster::snapshot_metrics() to other threads.
+ */
+class metrics {
+ public:
+  enum {
+    // REDIS_HAPP_OK and every error_code from REDIS_HAPP_UNKNOWD to the one before REDIS_HAPP_ERROR_END
+    ERROR_CODE_COUNT = static_cast<int>(error_code::REDIS_HAPP_UNKNOWD) -
+                       static_cast<int>(error_code::REDIS_HAPP_ERROR_END) + 1,
+  };
+
+  struct HIREDIS_HAPP_API_HEAD_ONLY counters_t {
+    uint64_t cmd_sent;       // cmds written into connections, a retried cmd is counted every time it's sent
+    uint64_t cmd_succeeded;  // cmds finished with REDIS_HAPP_OK
+    uint64_t cmd_failed;     // cmds finished with any error code
+    uint64_t cmd_finished_by_code[ERROR_CODE_COUNT];  // use get_error_index() to get the index of an error code
+    uint64_t moved;
+    uint64_t ask;
+    uint64_t tryagain;
+    uint64_t clusterdown;
+    uint64_t slot_reloads;  // CLUSTER SLOTS sent
+    uint64_t retries;       // cmds retried after redirections or network errors
+    uint64_t ttl_exhausted;
+    uint64_t connects;  // connections created
+    uint64_t connect_failures;
+    uint64_t disconnects;
+  };
+
+  struct HIREDIS_HAPP_API_HEAD_ONLY gauges_t {
+    size_t in_flight;      // cmds waiting for replies in all connections
+    size_t slot_pending;   // cmds waiting for slots
+    size_t timer_pending;  // cmds waiting for retry timer
+    size_t connections;
+  };
+
+  struct HIREDIS_HAPP_API_HEAD_ONLY node_t {
+    connection::node_id_t id;
+    std::string name;  // ip:port
+    uint64_t cmd_sent;
+    uint64_t replies;
+    uint64_t failures;  // network errors, failed connecting and busy replies such as LOADING or CLUSTERDOWN
+    latency_histogram latency;  // from sending a cmd to receiving its reply, empty if latency is disabled
+  };
+
+  struct HIREDIS_HAPP_API_HEAD_ONLY snapshot_t {
+    counters_t counters;
+    gauges_t gauges;
+    std::vector<node_t> nodes;  // sorted by id
+  };
+
+ public:
+  HIREDIS_HAPP_API metrics();
+
+  HIREDIS_HAPP_API void reset();
+
+  HIREDIS_HAPP_API counters_t &get_counters();
+  HIREDIS_HAPP_API const counters_t &get_counters() const;
+
+  /**
+   * @brief get metrics of a node, create it if it's not found
+   */
+  HIREDIS_HAPP_API node_t &mutable_node(const connection::key_t &key);
+
+  /**
+   * @brief get metrics of a node
+   * @return nullptr if nothing is recorded for this node
+   */
+  HIREDIS_HAPP_API const node_t *get_node(connection::node_id_t id) const;
+
+  HIREDIS_HAPP_API void get_nodes(std::vector<node_t> &out) const;
+
+  HIREDIS_HAPP_API void add_cmd_finished(int rcode);
+
+  /**
+   * @brief index of an error code in counters_t::cmd_finished_by_code
+   * @note 0 for REDIS_HAPP_OK, unknown codes are counted as REDIS_HAPP_UNKNOWD
+   */
+  static HIREDIS_HAPP_API size_t get_error_index(int rcode);
+
+ private:
+  counters_t counters_;
+  HIREDIS_HAPP_MAP(connection::node_id_t, node_t) nodes_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_METRICS_H
@@ -0,0 +1,64 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_NODE_REGISTRY_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_NODE_REGISTRY_H
+
+#pragma once
+
+#include <deque>
+#include <string>
+
+#include "hiredis_happ_config.h"
+
+#include "happ_connection.h"
+
+namespace hiredis {
+namespace happ {
+
+/**
+ * @brief interns redis nodes into stable integer ids
+ * @note a node keeps its id for the lifetime of the registry, so ids can be stored in slots, maps and cmds and be
+ *       compared without touching the name. Nodes are never removed, the count is bounded by the topology history
+ *       of the cluster.
+ * @note ids start from 1, and 0 is never used
+ */
+class node_registry {
+ public:
+  typedef connection::node_id_t node_id_t;
+
+  HIREDIS_HAPP_API node_registry();
+
+  /**
+   * @brief get the node of an address, add it if it's not interned yet
+   * @return key of the node, it's valid until the registry is destroyed
+   */
+  HIREDIS_HAPP_API const connection::key_t *intern(const std::string &ip, uint16_t port);
+
+  // key.id is used directly if it's valid, or key.ip and key.port are interned
+  HIREDIS_HAPP_API const connection::key_t *intern(const connection::key_t &key);
+
+  // @return id of the node, or 0 if it's not interned
+  HIREDIS_HAPP_API node_id_t find(const std::string &name) const;
+
+  // @return id of the node, or 0 if it's not interned
+  HIREDIS_HAPP_API node_id_t find(const std::string &ip, uint16_t port) const;
+
+  // @return key of the node, or nullptr if id is invalid
+  HIREDIS_HAPP_API const connection::key_t *get(node_id_t id) const;
+
+  HIREDIS_HAPP_API size_t size() const;
+
+ private:
+  node_registry(const node_registry &);
+  node_registry &operator=(const node_registry &);
+
+ private:
+  std::deque<connection::key_t> nodes_;  // node of id is nodes_[id - 1], deque keeps the address of keys
+  HIREDIS_HAPP_MAP(std::string, node_id_t) names_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_NODE_REGISTRY_H
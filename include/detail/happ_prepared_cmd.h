@@ -0,0 +1,74 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_PREPARED_CMD_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_PREPARED_CMD_H
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "hiredis_happ_config.h"
+
+namespace hiredis {
+namespace happ {
+
+/**
+ * @brief command shape whose constant arguments are encoded once and reused by every execution
+ * @note the RESP of a command is split into constant segments and placeholders, e.g. "HINCRBY ? counter 1" is
+ *       stored as "*4\r\n$7\r\nHINCRBY\r\n", placeholder and "$7\r\ncounter\r\n$1\r\n1\r\n". Formatting a cmd
+ *       only encodes the placeholders and copies the segments.
+ * @note it's immutable after init, so it can be shared by any number of cmds, clusters and raws
+ */
+class prepared_cmd {
+ public:
+  HIREDIS_HAPP_API prepared_cmd();
+
+  /**
+   * @brief prepare a command from a pattern
+   * @param pattern arguments separated by spaces, and a single ? is a placeholder, such as "HINCRBY ? counter 1"
+   * @note use the argv version if any constant argument contains spaces or is a single ?
+   * @return 0 or error code
+   */
+  HIREDIS_HAPP_API int init(const char *pattern);
+
+  /**
+   * @brief prepare a command from arguments
+   * @param argc argument count
+   * @param argv every argument, nullptr is a placeholder
+   * @param argvlen size of every argument, nullptr means all arguments are strings ended with \0
+   * @return 0 or error code
+   */
+  HIREDIS_HAPP_API int init(int argc, const char **argv, const size_t *argvlen);
+
+  HIREDIS_HAPP_API void reset();
+
+  HIREDIS_HAPP_API bool empty() const;
+
+  // argument count of the whole command, including the command name
+  HIREDIS_HAPP_API size_t get_argument_count() const;
+
+  HIREDIS_HAPP_API size_t get_placeholder_count() const;
+
+  // total size of constant segments
+  HIREDIS_HAPP_API size_t get_constant_length() const;
+
+  /**
+   * @brief get the constant segment before placeholder idx, or after the last placeholder if idx is
+   * get_placeholder_count()
+   * @return start of the segment, len is set to its size, and it may be 0
+   */
+  HIREDIS_HAPP_API const char *get_segment(size_t idx, size_t *len) const;
+
+ private:
+  std::string encoded_;          // constant segments
+  std::vector<size_t> offsets_;  // end of every constant segment in encoded_
+  size_t argc_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_PREPARED_CMD_H
@@ -12,7 +12,12 @@
 
 #include "hiredis_happ_config.h"
 
+#include "happ_cmd_pool.h"
 #include "happ_connection.h"
+#include "happ_reply_arena.h"
+#include "happ_reply_stream.h"
+#include "happ_submit_queue.h"
+#include "happ_timer.h"
 
 namespace hiredis {
 namespace happ {
@@ -41,18 +46,16 @@ class raw {
     time_t keepalive_interval_sec;
 
     size_t cmd_buffer_size;
+    size_t reply_arena_chunk_size;
+    bool reply_stream;
   };
 
   struct timer_t {
     time_t last_update_sec;
     time_t last_update_usec;
 
-    struct delay_t {
-      time_t sec;
-      time_t usec;
-      cmd_t *cmd;
-    };
-    std::list<delay_t> timer_pending;
+    // retry cmds, timer_node::data is the cmd_t
+    timer_wheel timer_pending;
 
     struct conn_timetout_t {
       uint64_t sequence;
@@ -100,6 +103,25 @@ class raw {
   HIREDIS_HAPP_API cmd_t *exec(cmd_t::callback_fn_t cbk, void *priv_data, int argc, const char **argv,
                                const size_t *argvlen);
 
+  /**
+   * @breif send a request to redis server without copying large arguments
+   * @param cbk callback
+   * @param priv_data private data passed to callback
+   * @param argc argument count
+   * @param argv pointer of every argument
+   * @param argvlen size of every argument
+   * @param release_fn called with release_data when argv is not used any more, can be nullptr
+   * @param release_data data passed to release_fn
+   *
+   * @note large arguments must be kept valid until release_fn is called, and release_fn is always called even
+   * if this function failed
+   *
+   * @see cmd_exec::vformat_reference
+   * @return command wrapper of this message, nullptr if failed
+   */
+  HIREDIS_HAPP_API cmd_t *exec_reference(cmd_t::callback_fn_t cbk, void *priv_data, int argc, const char **argv,
+                                         const size_t *argvlen, cmd_t::release_fn_t release_fn, void *release_data);
+
   /**
    * @breif send a request to redis server
    * @param cbk callback
@@ -134,6 +156,82 @@ class raw {
    */
   HIREDIS_HAPP_API cmd_t *exec(cmd_t::callback_fn_t cbk, void *priv_data, const char *fmt, va_list ap);
 
+  /**
+   * @breif send a request to redis server with a callable callback
+   * @param fn callable object called as fn(cmd_t *cmd, redisAsyncContext *c, void *reply), usually a lambda.
+   *        it's moved into the cmd if it's not larger than HIREDIS_HAPP_CMD_CALLABLE_INLINE_SIZE, or allocated on
+   *        heap, and it's destroyed after it's called
+   * @param argc argument count
+   * @param argv pointer of every argument
+   * @param argvlen size of every argument
+   *
+   * @note buffer() of the cmd is used by fn, and private_data() is nullptr
+   * @see exec
+   * @return command wrapper of this message, nullptr if failed
+   */
+  template <typename F, typename = typename std::enable_if<detail::is_cmd_callable<F>::value>::type>
+  cmd_t *exec(F &&fn, int argc, const char **argv, const size_t *argvlen) {
+    return exec_callable(create_callable_cmd(std::forward<F>(fn)), argc, argv, argvlen);
+  }
+
+  /**
+   * @breif send a request to redis server with a callable callback
+   * @param fn callable object called as fn(cmd_t *cmd, redisAsyncContext *c, void *reply)
+   * @param fmt format string
+   * @param ... format data
+   *
+   * @see exec
+   * @return command wrapper of this message, nullptr if failed
+   */
+  template <typename F, typename = typename std::enable_if<detail::is_cmd_callable<F>::value>::type>
+  cmd_t *exec(F &&fn, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    cmd_t *ret = exec_callable(create_callable_cmd(std::forward<F>(fn)), fmt, ap);
+    va_end(ap);
+    return ret;
+  }
+
+  /**
+   * @breif send a request to redis server, arguments are encoded without parsing any format string
+   * @param cbk callback
+   * @param priv_data private data passed to callback
+   * @param cmd command name encoded at compile time, such as hiredis::happ::cmd_literal("HSET"), or a prepared_cmd
+   * @param args string-like values, integers or floating point numbers, they are placeholder values for prepared_cmd
+   *
+   * @see cmd_exec::format_args
+   * @return command wrapper of this message, nullptr if failed
+   */
+  template <typename T, typename... Args, typename = typename std::enable_if<detail::is_cmd_template<T>::value>::type>
+  cmd_t *exec(cmd_t::callback_fn_t cbk, void *priv_data, const T &cmd, Args &&...args) {
+    cmd_t *ret = create_cmd(cbk, priv_data);
+    if (nullptr == ret) {
+      return nullptr;
+    }
+    return exec_encoded(ret, ret->format_args(cmd, std::forward<Args>(args)...));
+  }
+
+  /**
+   * @breif send a request to redis server with a callable callback, arguments are encoded without parsing any
+   * format string
+   * @param fn callable object called as fn(cmd_t *cmd, redisAsyncContext *c, void *reply)
+   * @param cmd command name encoded at compile time, such as hiredis::happ::cmd_literal("HSET"), or a prepared_cmd
+   * @param args string-like values, integers or floating point numbers, they are placeholder values for prepared_cmd
+   *
+   * @see cmd_exec::format_args
+   * @return command wrapper of this message, nullptr if failed
+   */
+  template <typename F, typename T, typename... Args,
+            typename = typename std::enable_if<detail::is_cmd_callable<F>::value &&
+                                               detail::is_cmd_template<T>::value>::type>
+  cmd_t *exec(F &&fn, const T &cmd, Args &&...args) {
+    cmd_t *ret = create_callable_cmd(std::forward<F>(fn));
+    if (nullptr == ret) {
+      return nullptr;
+    }
+    return exec_encoded(ret, ret->format_args(cmd, std::forward<Args>(args)...));
+  }
+
   /**
    * @breif send a request to redis server
    * @param cmd cmd wrapper
@@ -192,6 +290,32 @@ class raw {
 
   HIREDIS_HAPP_API size_t get_cmd_buffer_size() const;
 
+  /**
+   * @breif build replies of new connections in a bump arena instead of one malloc per element
+   * @param chunk_size size of the first chunk of arena, 0 to disable it(default)
+   * @note replies must not be used after the callback returns, and it only works with hiredis 1.0 or upper
+   * @see reply_arena
+   */
+  HIREDIS_HAPP_API void set_reply_arena_chunk_size(size_t chunk_size);
+
+  HIREDIS_HAPP_API size_t get_reply_arena_chunk_size() const;
+
+  /**
+   * @breif let new connections deliver elements of replies to the stream visitor of cmds as they are parsed
+   * @param enable true to enable it, it's disabled by default
+   * @note reply arena is not used when it's enabled, and it only works with hiredis 1.0 or upper
+   * @see reply_stream, cmd_exec::set_stream_visitor
+   */
+  HIREDIS_HAPP_API void set_reply_stream(bool enable);
+
+  HIREDIS_HAPP_API bool is_reply_stream_enabled() const;
+
+  /**
+   * @breif get the slab pool of cmds, it can be used to get stats or trim idle memory
+   */
+  HIREDIS_HAPP_API cmd_pool *get_cmd_pool();
+  HIREDIS_HAPP_API const cmd_pool *get_cmd_pool() const;
+
   HIREDIS_HAPP_API bool is_timer_available() const;
 
   HIREDIS_HAPP_API bool is_timer_active() const;
@@ -204,11 +328,38 @@ class raw {
 
   HIREDIS_HAPP_API int proc(time_t sec, time_t usec);
 
+  /**
+   * @breif post a task to the thread which runs the event loop, it can be called by any thread
+   * @note tasks are run in batches by proc() or when the wakeup eventfd or function of get_submit_queue() fires,
+   *       exec() and other functions of this object should only be called in tasks by other threads
+   * @return 0 or error code
+   */
+  template <typename F>
+  int post(F &&fn) {
+    return submit_queue_.post(std::forward<F>(fn));
+  }
+
+  HIREDIS_HAPP_API submit_queue &get_submit_queue();
+
   HIREDIS_HAPP_API void set_log_writer(log_fn_t info_fn, log_fn_t debug_fn, size_t max_size = 65536);
 
  private:
   HIREDIS_HAPP_API cmd_t *create_cmd(cmd_t::callback_fn_t cbk, void *pridata);
   HIREDIS_HAPP_API void destroy_cmd(cmd_t *c);
+
+  template <typename F>
+  cmd_t *create_callable_cmd(F &&fn) {
+    holder_t h;
+    h.r = this;
+    return cmd_t::create_callable(cmd_pool_, h, std::forward<F>(fn));
+  }
+
+  // format and send a cmd created by create_callable_cmd
+  HIREDIS_HAPP_API cmd_t *exec_callable(cmd_t *cmd, int argc, const char **argv, const size_t *argvlen);
+  HIREDIS_HAPP_API cmd_t *exec_callable(cmd_t *cmd, const char *fmt, va_list ap);
+
+  // send a cmd formatted by format_args, len is its result
+  HIREDIS_HAPP_API cmd_t *exec_encoded(cmd_t *cmd, int64_t len);
   HIREDIS_HAPP_API int call_cmd(cmd_t *c, int err, redisAsyncContext *context, void *reply);
 
  private:
@@ -228,12 +379,18 @@ class raw {
   // authorization information
   connection::auth_info_t auth_;
 
+  // allocator of cmds
+  cmd_pool *cmd_pool_;
+
   // current connection
   connection_ptr_t conn_;
 
   // timers
   timer_t timer_actions_;
 
+  // tasks posted by other threads
+  submit_queue submit_queue_;
+
   // callbacks_
   struct callback_set_t {
     onconnect_fn_t on_connect;
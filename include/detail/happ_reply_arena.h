@@ -0,0 +1,121 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_REPLY_ARENA_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_REPLY_ARENA_H
+
+#pragma once
+
+#include <cstddef>
+
+#include "hiredis_happ_config.h"
+
+namespace hiredis {
+namespace happ {
+
+/**
+ * @brief bump allocator of redisReply trees, every connection which enables it owns one
+ * @note all objects of a reply are allocated from chunks of the arena, and the arena is reset when hiredis frees the
+ *       root reply, which happens just after the callback of the cmd returns. So replies must not be used after the
+ *       callback, just like the replies built by hiredis's default functions.
+ * @note every redisReply is prefixed with the arena pointer, so freeReplyObject must not be called on them
+ * @note it's not thread-safe, just like cluster and raw
+ */
+class reply_arena {
+ public:
+  struct HIREDIS_HAPP_API_HEAD_ONLY stats_t {
+    size_t chunk_count;         // chunks allocated from system now
+    size_t chunk_bytes;         // bytes of all chunks now
+    size_t system_allocations;  // total times of allocating chunks from system
+    size_t allocations;         // total objects allocated from arena
+    size_t reset_count;         // total replies released
+  };
+
+ private:
+  struct chunk_t;
+
+  reply_arena(const reply_arena &);
+  reply_arena &operator=(const reply_arena &);
+
+  explicit reply_arena(size_t chunk_size);
+  ~reply_arena();
+
+ public:
+  /**
+   * @brief create a arena
+   * @param chunk_size size of the first chunk, larger replies use more chunks
+   * @return arena, nullptr if failed
+   */
+  static HIREDIS_HAPP_API reply_arena *create(size_t chunk_size);
+
+  /**
+   * @brief destroy a arena created by create, it can also be used as redisContext::free_privdata
+   */
+  static HIREDIS_HAPP_API void release(void *arena);
+
+  /**
+   * @brief let a hiredis context build replies in a new arena
+   * @param c hiredis context, the arena is owned by c->c.privdata and released with the context
+   * @param chunk_size size of the first chunk
+   * @note it must be called before any reply is received, and c->c.privdata must not be used by others
+   * @return the arena attached, nullptr if failed or not supported by this version of hiredis
+   */
+  static HIREDIS_HAPP_API reply_arena *attach(redisAsyncContext *c, size_t chunk_size);
+
+  /**
+   * @brief get the arena attached to a hiredis context
+   * @return the arena, nullptr if not attached
+   */
+  static HIREDIS_HAPP_API reply_arena *get(const redisAsyncContext *c);
+
+  /**
+   * @brief reply object functions which allocate objects from the arena in redisReader::privdata
+   */
+  static HIREDIS_HAPP_API redisReplyObjectFunctions *get_reply_functions();
+
+  /**
+   * @brief allocate memory from the arena, it will be freed by reset
+   * @return address aligned like malloc, nullptr if failed
+   */
+  HIREDIS_HAPP_API void *allocate(size_t size);
+
+  /**
+   * @brief free all objects in the arena
+   * @note extra chunks are merged into one chunk of at most HIREDIS_HAPP_REPLY_ARENA_MAX_RETAIN bytes, so the next
+   *       reply of the same size needs only one chunk
+   */
+  HIREDIS_HAPP_API void reset();
+
+  HIREDIS_HAPP_API const stats_t &get_stats() const;
+
+ private:
+  static redisReplyObjectFunctions make_reply_functions();
+
+  chunk_t *alloc_chunk(size_t min_size);
+  void free_chunk(chunk_t *chunk);
+
+  static void *create_string(const redisReadTask *task, char *str, size_t len);
+  static void *create_array(const redisReadTask *task, size_t elements);
+  static void *create_integer(const redisReadTask *task, long long value);
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+  static void *create_double(const redisReadTask *task, double value, char *str, size_t len);
+  static void *create_bool(const redisReadTask *task, int bval);
+#endif
+  static void *create_nil(const redisReadTask *task);
+  static void free_object(void *reply);
+
+  static redisReply *create_reply(const redisReadTask *task, int type);
+  static char *create_buffer(const redisReadTask *task, const char *str, size_t len);
+
+ private:
+  chunk_t *head_;  // current chunk
+  size_t chunk_size_;
+  size_t used_;  // bytes used by objects since last reset
+  void *root_;   // root reply being built
+  stats_t stats_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_REPLY_ARENA_H
@@ -0,0 +1,401 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_REPLY_DECODER_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_REPLY_DECODER_H
+
+#pragma once
+
+#include <charconv>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "hiredis_happ_config.h"
+
+#include "happ_cmd.h"
+
+namespace hiredis {
+namespace happ {
+namespace detail {
+template <typename T>
+struct reply_decoder_unsupported : std::false_type {};
+
+inline bool reply_is_string(const redisReply *reply) {
+  switch (reply->type) {
+    case REDIS_REPLY_STRING:
+    case REDIS_REPLY_STATUS:
+#if defined(REDIS_REPLY_VERB)
+    case REDIS_REPLY_VERB:
+#endif
+#if defined(REDIS_REPLY_BIGNUM)
+    case REDIS_REPLY_BIGNUM:
+#endif
+      return nullptr != reply->str || 0 == reply->len;
+    default:
+      return false;
+  }
+}
+
+inline bool reply_is_aggregate(const redisReply *reply) {
+  switch (reply->type) {
+    case REDIS_REPLY_ARRAY:
+#if defined(REDIS_REPLY_SET)
+    case REDIS_REPLY_SET:
+#endif
+#if defined(REDIS_REPLY_MAP)
+    case REDIS_REPLY_MAP:
+#endif
+#if defined(REDIS_REPLY_PUSH)
+    case REDIS_REPLY_PUSH:
+#endif
+      // element is nullptr when elements are streamed to the visitor of cmd
+      return 0 == reply->elements || nullptr != reply->element;
+    default:
+      return false;
+  }
+}
+
+template <typename T>
+inline bool reply_integer_cast(long long value, T &out) {
+  if constexpr (std::is_signed<T>::value) {
+    if (value < static_cast<long long>(std::numeric_limits<T>::min()) ||
+        value > static_cast<long long>(std::numeric_limits<T>::max())) {
+      return false;
+    }
+  } else {
+    if (value < 0 || static_cast<unsigned long long>(value) > std::numeric_limits<T>::max()) {
+      return false;
+    }
+  }
+
+  out = static_cast<T>(value);
+  return true;
+}
+}  // namespace detail
+
+/**
+ * @brief decode a redisReply into a C++ value
+ * @note supported types are:
+ *       const redisReply *                     : any reply, including error replies
+ *       std::string_view                       : string, status, verbatim string or big number, without copying
+ *       std::string                            : the same as std::string_view, but the data is copied
+ *       integers                               : integer, or string which is a decimal integer in range
+ *       bool                                   : boolean, or integer 0 and 1
+ *       float, double, long double             : double, integer, or string which is a number
+ *       std::optional<T>                       : nil, or any reply which can be decoded into T
+ *       std::pair<A, B>                        : aggregate with two elements
+ *       std::vector<T>                         : array, set or push
+ *       std::vector<std::pair<K, V> >, std::map<K, V>, std::unordered_map<K, V>
+ *                                              : map, flat array like HGETALL and ZRANGE WITHSCORES of RESP2, or
+ *                                                array of pairs like ZRANGE WITHSCORES of RESP3
+ * @note other types can be supported by specializing reply_decoder with a static function
+ *       int decode(const redisReply *reply, T &out)
+ */
+template <typename T, typename = void>
+struct reply_decoder {
+  static_assert(detail::reply_decoder_unsupported<T>::value, "type is not supported by hiredis::happ::reply_decoder");
+};
+
+/**
+ * @brief decode a redisReply into a C++ value
+ * @param reply reply to decode
+ * @param out output value, string views in it point to the reply, so they are valid only when the reply is alive,
+ *        which usually means in the callback of cmd
+ * @return error_code::REDIS_HAPP_OK, error_code::REDIS_HAPP_TYPE_MISMATCH if the reply can not be decoded into T,
+ *         or error_code::REDIS_HAPP_PARAM if reply is nullptr. out may be partly modified if failed.
+ */
+template <typename T>
+inline int decode_reply(const redisReply *reply, T &out) {
+  if (nullptr == reply) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  return reply_decoder<T>::decode(reply, out);
+}
+
+namespace detail {
+template <typename T>
+inline int reply_decode_element(const redisReply *reply, T &out) {
+  if (nullptr == reply) {
+    return error_code::REDIS_HAPP_TYPE_MISMATCH;
+  }
+
+  return reply_decoder<T>::decode(reply, out);
+}
+
+// call fn(key, value) for every key-value pair in a map, a flat array or an array of pairs
+template <typename K, typename V, typename F>
+inline int reply_decode_pairs(const redisReply *reply, F fn) {
+  if (!reply_is_aggregate(reply)) {
+    return error_code::REDIS_HAPP_TYPE_MISMATCH;
+  }
+
+  bool nested = reply->elements > 0 && nullptr != reply->element[0] && reply_is_aggregate(reply->element[0]);
+  if (!nested && 0 != reply->elements % 2) {
+    return error_code::REDIS_HAPP_TYPE_MISMATCH;
+  }
+
+  size_t step = nested ? 1 : 2;
+  for (size_t i = 0; i < reply->elements; i += step) {
+    const redisReply *k = reply->element[i];
+    const redisReply *v = nested ? nullptr : reply->element[i + 1];
+    if (nested) {
+      const redisReply *pair = reply->element[i];
+      if (nullptr == pair || !reply_is_aggregate(pair) || 2 != pair->elements) {
+        return error_code::REDIS_HAPP_TYPE_MISMATCH;
+      }
+      k = pair->element[0];
+      v = pair->element[1];
+    }
+
+    std::pair<K, V> kv;
+    int res = reply_decode_element(k, kv.first);
+    if (error_code::REDIS_HAPP_OK != res) {
+      return res;
+    }
+    res = reply_decode_element(v, kv.second);
+    if (error_code::REDIS_HAPP_OK != res) {
+      return res;
+    }
+
+    fn(std::move(kv));
+  }
+
+  return error_code::REDIS_HAPP_OK;
+}
+
+template <typename T>
+struct typed_callback_value;
+
+template <typename T>
+struct typed_callback_value<void (*)(cmd_exec *, int, T &, void *)> {
+  typedef T type;
+};
+}  // namespace detail
+
+template <>
+struct reply_decoder<const redisReply *> {
+  static int decode(const redisReply *reply, const redisReply *&out) {
+    out = reply;
+    return error_code::REDIS_HAPP_OK;
+  }
+};
+
+template <>
+struct reply_decoder<std::string_view> {
+  static int decode(const redisReply *reply, std::string_view &out) {
+    if (!detail::reply_is_string(reply)) {
+      return error_code::REDIS_HAPP_TYPE_MISMATCH;
+    }
+
+    out = std::string_view(reply->str, reply->len);
+    return error_code::REDIS_HAPP_OK;
+  }
+};
+
+template <>
+struct reply_decoder<std::string> {
+  static int decode(const redisReply *reply, std::string &out) {
+    if (!detail::reply_is_string(reply)) {
+      return error_code::REDIS_HAPP_TYPE_MISMATCH;
+    }
+
+    out.assign(reply->str, reply->len);
+    return error_code::REDIS_HAPP_OK;
+  }
+};
+
+template <typename T>
+struct reply_decoder<T, typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, bool>::value>::type> {
+  static int decode(const redisReply *reply, T &out) {
+    if (REDIS_REPLY_INTEGER == reply->type) {
+      return detail::reply_integer_cast(reply->integer, out) ? error_code::REDIS_HAPP_OK
+                                                             : error_code::REDIS_HAPP_TYPE_MISMATCH;
+    }
+
+    // GET, HGET and many other commands return numbers as strings
+    if (!detail::reply_is_string(reply) || 0 == reply->len) {
+      return error_code::REDIS_HAPP_TYPE_MISMATCH;
+    }
+
+    T value;
+    std::from_chars_result res = std::from_chars(reply->str, reply->str + reply->len, value);
+    if (std::errc() != res.ec || res.ptr != reply->str + reply->len) {
+      return error_code::REDIS_HAPP_TYPE_MISMATCH;
+    }
+
+    out = value;
+    return error_code::REDIS_HAPP_OK;
+  }
+};
+
+template <>
+struct reply_decoder<bool> {
+  static int decode(const redisReply *reply, bool &out) {
+#if defined(REDIS_REPLY_BOOL)
+    if (REDIS_REPLY_BOOL == reply->type) {
+      out = 0 != reply->integer;
+      return error_code::REDIS_HAPP_OK;
+    }
+#endif
+
+    if (REDIS_REPLY_INTEGER == reply->type && (0 == reply->integer || 1 == reply->integer)) {
+      out = 1 == reply->integer;
+      return error_code::REDIS_HAPP_OK;
+    }
+
+    return error_code::REDIS_HAPP_TYPE_MISMATCH;
+  }
+};
+
+template <typename T>
+struct reply_decoder<T, typename std::enable_if<std::is_floating_point<T>::value>::type> {
+  static int decode(const redisReply *reply, T &out) {
+#if defined(REDIS_REPLY_DOUBLE)
+    if (REDIS_REPLY_DOUBLE == reply->type) {
+      out = static_cast<T>(reply->dval);
+      return error_code::REDIS_HAPP_OK;
+    }
+#endif
+
+    if (REDIS_REPLY_INTEGER == reply->type) {
+      out = static_cast<T>(reply->integer);
+      return error_code::REDIS_HAPP_OK;
+    }
+
+    // scores of ZRANGE WITHSCORES in RESP2 and INCRBYFLOAT are strings, hiredis always ends them with \0
+    if (!detail::reply_is_string(reply) || 0 == reply->len) {
+      return error_code::REDIS_HAPP_TYPE_MISMATCH;
+    }
+
+    char *end = nullptr;
+    long double value = strtold(reply->str, &end);
+    if (end != reply->str + reply->len) {
+      return error_code::REDIS_HAPP_TYPE_MISMATCH;
+    }
+
+    out = static_cast<T>(value);
+    return error_code::REDIS_HAPP_OK;
+  }
+};
+
+template <typename T>
+struct reply_decoder<std::optional<T> > {
+  static int decode(const redisReply *reply, std::optional<T> &out) {
+    if (REDIS_REPLY_NIL == reply->type) {
+      out.reset();
+      return error_code::REDIS_HAPP_OK;
+    }
+
+    T value;
+    int res = reply_decoder<T>::decode(reply, value);
+    if (error_code::REDIS_HAPP_OK == res) {
+      out = std::move(value);
+    }
+    return res;
+  }
+};
+
+template <typename A, typename B>
+struct reply_decoder<std::pair<A, B> > {
+  static int decode(const redisReply *reply, std::pair<A, B> &out) {
+    if (!detail::reply_is_aggregate(reply) || 2 != reply->elements) {
+      return error_code::REDIS_HAPP_TYPE_MISMATCH;
+    }
+
+    int res = detail::reply_decode_element(reply->element[0], out.first);
+    if (error_code::REDIS_HAPP_OK != res) {
+      return res;
+    }
+    return detail::reply_decode_element(reply->element[1], out.second);
+  }
+};
+
+template <typename T, typename Alloc>
+struct reply_decoder<std::vector<T, Alloc> > {
+  static int decode(const redisReply *reply, std::vector<T, Alloc> &out) {
+    if (!detail::reply_is_aggregate(reply)) {
+      return error_code::REDIS_HAPP_TYPE_MISMATCH;
+    }
+
+    out.clear();
+    out.resize(reply->elements);
+    for (size_t i = 0; i < reply->elements; ++i) {
+      int res = detail::reply_decode_element(reply->element[i], out[i]);
+      if (error_code::REDIS_HAPP_OK != res) {
+        return res;
+      }
+    }
+
+    return error_code::REDIS_HAPP_OK;
+  }
+};
+
+template <typename K, typename V, typename Alloc>
+struct reply_decoder<std::vector<std::pair<K, V>, Alloc> > {
+  static int decode(const redisReply *reply, std::vector<std::pair<K, V>, Alloc> &out) {
+    out.clear();
+    if (detail::reply_is_aggregate(reply)) {
+      out.reserve(reply->elements / 2);
+    }
+    return detail::reply_decode_pairs<K, V>(reply, [&out](std::pair<K, V> &&kv) { out.push_back(std::move(kv)); });
+  }
+};
+
+template <typename K, typename V, typename Compare, typename Alloc>
+struct reply_decoder<std::map<K, V, Compare, Alloc> > {
+  static int decode(const redisReply *reply, std::map<K, V, Compare, Alloc> &out) {
+    out.clear();
+    return detail::reply_decode_pairs<K, V>(reply,
+                                            [&out](std::pair<K, V> &&kv) { out[kv.first] = std::move(kv.second); });
+  }
+};
+
+template <typename K, typename V, typename Hash, typename Equal, typename Alloc>
+struct reply_decoder<std::unordered_map<K, V, Hash, Equal, Alloc> > {
+  static int decode(const redisReply *reply, std::unordered_map<K, V, Hash, Equal, Alloc> &out) {
+    out.clear();
+    if (detail::reply_is_aggregate(reply)) {
+      out.reserve(reply->elements / 2);
+    }
+    return detail::reply_decode_pairs<K, V>(reply,
+                                            [&out](std::pair<K, V> &&kv) { out[kv.first] = std::move(kv.second); });
+  }
+};
+
+/**
+ * @brief adapt a typed callback to cmd_exec::callback_fn_t
+ * @note usage: void on_get(cmd_exec *cmd, int status, std::optional<std::string_view> &value, void *private_data);
+ *              clu.exec(key, ks, hiredis::happ::typed_callback<on_get>, private_data, "GET %s", key);
+ *       status is the result of cmd if it failed, or the result of decode_reply. value is value-initialized if
+ *       status is not error_code::REDIS_HAPP_OK. Error replies can only be decoded into const redisReply *.
+ * @note string views in value are valid only in the callback
+ */
+template <auto Fn>
+void typed_callback(cmd_exec *cmd, redisAsyncContext *, void *reply, void *private_data) {
+  typedef typename detail::typed_callback_value<decltype(Fn)>::type value_type;
+
+  value_type value{};
+  int status = cmd->result();
+  if (error_code::REDIS_HAPP_OK == status) {
+    status = decode_reply(reinterpret_cast<const redisReply *>(reply), value);
+    if (error_code::REDIS_HAPP_OK != status) {
+      value = value_type{};
+    }
+  }
+
+  Fn(cmd, status, value, private_data);
+}
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_REPLY_DECODER_H
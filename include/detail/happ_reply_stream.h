@@ -0,0 +1,126 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_REPLY_STREAM_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_REPLY_STREAM_H
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+#include "hiredis_happ_config.h"
+
+#include "happ_cmd.h"
+
+namespace hiredis {
+namespace happ {
+
+/**
+ * @brief reply builder which delivers elements of huge aggregate replies to the visitor of cmd as they are parsed
+ * @note hiredis only passes complete replies to callbacks, so elements are delivered from the reply object functions.
+ *       When the reply of a cmd with stream visitor starts, every element at the stream depth is built, delivered
+ *       and freed as soon as it's complete, so at most one element is kept in memory no matter how large the reply is.
+ *       The final callback receives a reply without the streamed elements.
+ * @note the cmd of a reply is found by the first callback of redisAsyncContext, so only callbacks of cmd_fn are
+ *       streamed, and replies of pub/sub and monitor mode are never streamed.
+ * @note it's not thread-safe, just like cluster and raw
+ */
+class reply_stream {
+ public:
+  struct HIREDIS_HAPP_API_HEAD_ONLY stats_t {
+    size_t streamed_replies;   // total replies streamed
+    size_t streamed_elements;  // total elements delivered to visitors
+    size_t live_objects;       // redisReply objects alive now
+    size_t peak_live_objects;  // max redisReply objects alive at the same time
+  };
+
+ private:
+  reply_stream(const reply_stream &);
+  reply_stream &operator=(const reply_stream &);
+
+  explicit reply_stream(redisCallbackFn *cmd_fn);
+  ~reply_stream();
+
+ public:
+  /**
+   * @brief create a reply stream
+   * @param cmd_fn callback function of hiredis whose privdata is the cmd_exec, on_reply_wrapper of cluster or raw
+   * @return reply stream, nullptr if failed
+   */
+  static HIREDIS_HAPP_API reply_stream *create(redisCallbackFn *cmd_fn);
+
+  /**
+   * @brief destroy a reply stream created by create, it can also be used as redisContext::free_privdata
+   */
+  static HIREDIS_HAPP_API void release(void *stream);
+
+  /**
+   * @brief let a hiredis context stream replies of cmds with stream visitor
+   * @param c hiredis context, the reply stream is owned by c->c.privdata and released with the context
+   * @param cmd_fn callback function of hiredis whose privdata is the cmd_exec
+   * @note it must be called before any reply is received, and c->c.privdata must not be used by others, so it can
+   *       not be used together with reply_arena
+   * @return the reply stream attached, nullptr if failed or not supported by this version of hiredis
+   */
+  static HIREDIS_HAPP_API reply_stream *attach(redisAsyncContext *c, redisCallbackFn *cmd_fn);
+
+  /**
+   * @brief get the reply stream attached to a hiredis context
+   * @return the reply stream, nullptr if not attached
+   */
+  static HIREDIS_HAPP_API reply_stream *get(const redisAsyncContext *c);
+
+  /**
+   * @brief reply object functions which stream replies, redisReader::privdata must be the reply_stream
+   */
+  static HIREDIS_HAPP_API redisReplyObjectFunctions *get_reply_functions();
+
+  /**
+   * @brief set the context whose pending callbacks are used to find the cmd of replies
+   * @note attach sets it, it's public only for unit test
+   */
+  HIREDIS_HAPP_API void set_context(const redisAsyncContext *c);
+
+  HIREDIS_HAPP_API const stats_t &get_stats() const;
+
+ private:
+  static redisReplyObjectFunctions make_reply_functions();
+
+  static void *create_string(const redisReadTask *task, char *str, size_t len);
+  static void *create_array(const redisReadTask *task, size_t elements);
+  static void *create_integer(const redisReadTask *task, long long value);
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+  static void *create_double(const redisReadTask *task, double value, char *str, size_t len);
+  static void *create_bool(const redisReadTask *task, int bval);
+#endif
+  static void *create_nil(const redisReadTask *task);
+  static void free_object(void *reply);
+
+  static redisReply *create_reply(const redisReadTask *task, int type, size_t *depth);
+  static char *create_buffer(const char *str, size_t len);
+  static reply_stream *get_owner(void *reply);
+
+  // find the cmd with stream visitor which the next reply belongs to
+  cmd_exec *find_stream_cmd() const;
+
+  // called when obj at depth is complete
+  void finish(const redisReadTask *task, redisReply *obj, size_t depth);
+
+  void free_reply(redisReply *reply);
+
+ private:
+  const redisAsyncContext *context_;
+  redisCallbackFn *cmd_fn_;
+  cmd_exec *cmd_;                // cmd of the reply being streamed, nullptr if not streaming
+  size_t depth_;                 // stream depth of cmd_
+  redisReply *root_;             // root reply being built
+  redisReply *building_;         // element being built at stream depth, nullptr if there is none
+  std::vector<size_t> pending_;  // left children of unfinished aggregates in building_
+  stats_t stats_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_REPLY_STREAM_H
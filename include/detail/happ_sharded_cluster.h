@@ -0,0 +1,151 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_SHARDED_CLUSTER_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_SHARDED_CLUSTER_H
+
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "hiredis_happ_config.h"
+
+#include "happ_cluster.h"
+
+namespace hiredis {
+namespace happ {
+
+/**
+ * @brief front end of several clusters, every one of them runs in its own event loop thread
+ * @note every shard owns its connections and cmd pool. Slots are routed to the shard which owns their master node,
+ *       so the traffic of a node stays on one thread. A shard never connects to nodes of other shards, cmds
+ *       redirected to them by MOVED or ASK fail with REDIS_HAPP_SLOT_UNAVAILABLE and should be posted again.
+ * @note all shards share one topology view: when any shard loads slots by CLUSTER SLOTS, the slots are published
+ *       here and applied to all other shards in their own threads.
+ * @note do not replace the on_slots_updated callback of shards, it's used to publish slots
+ */
+class sharded_cluster {
+ public:
+  // run the event loop of a shard until is_running() returns false
+  typedef std::function<void(size_t index, cluster &shard)> loop_fn_t;
+  typedef std::vector<cluster::slot_range_t> topology_t;
+
+  HIREDIS_HAPP_API sharded_cluster();
+  HIREDIS_HAPP_API ~sharded_cluster();
+
+  /**
+   * @brief create shards
+   * @param ip ip of one node of the cluster
+   * @param port port of one node of the cluster
+   * @param shard_count count of shards and loop threads
+   * @return 0 or error code
+   */
+  HIREDIS_HAPP_API int init(const std::string &ip, uint16_t port, size_t shard_count);
+
+  /**
+   * @brief start one thread for every shard
+   * @param fn loop of every shard, it should set callbacks of the shard, attach connections to its own loop, call
+   *        get_submit_queue().on_wakeup() when the queue is woken up, call proc() by timer and return after
+   *        is_running() becomes false
+   * @return 0 or error code
+   */
+  HIREDIS_HAPP_API int start(loop_fn_t fn);
+
+  /**
+   * @brief reset all shards in their own threads and wait for all loop threads to exit
+   */
+  HIREDIS_HAPP_API void stop();
+
+  HIREDIS_HAPP_API bool is_running() const;
+
+  HIREDIS_HAPP_API size_t get_shard_count() const;
+
+  HIREDIS_HAPP_API cluster *get_shard(size_t index);
+  HIREDIS_HAPP_API const cluster *get_shard(size_t index) const;
+
+  /**
+   * @brief get shard of a slot, it can be called by any thread
+   * @param slot slot index, slots less than 0 are routed to shards by turns in proportion to their slots
+   * @note before slots are loaded, slots are split into continuous ranges for shards
+   */
+  HIREDIS_HAPP_API size_t get_shard_index(int slot) const;
+
+  HIREDIS_HAPP_API size_t get_shard_index(const char *key, size_t ks) const;
+
+  // get the topology published by shards, it can be called by any thread
+  HIREDIS_HAPP_API std::shared_ptr<const topology_t> get_topology() const;
+
+  // increased every time slots are published
+  HIREDIS_HAPP_API uint64_t get_topology_version() const;
+
+  /**
+   * @brief run fn(cluster *) in the thread of a shard, it can be called by any thread
+   * @note exec() of the shard should be called in fn, and all data used by it should be owned by fn
+   * @return 0 or error code
+   */
+  template <typename F>
+  int post(size_t index, F &&fn) {
+    if (index >= shards_.size()) {
+      return error_code::REDIS_HAPP_PARAM;
+    }
+
+    cluster *shard = shards_[index].get();
+    return shard->post(shard_task<typename std::decay<F>::type>(shard, std::forward<F>(fn)));
+  }
+
+  // run fn(cluster *) in the thread of the shard which owns the key
+  template <typename F>
+  int post(const char *key, size_t ks, F &&fn) {
+    return post(get_shard_index(key, ks), std::forward<F>(fn));
+  }
+
+ private:
+  sharded_cluster(const sharded_cluster &);
+  sharded_cluster &operator=(const sharded_cluster &);
+
+  template <typename F>
+  struct shard_task {
+    cluster *shard;
+    F fn;
+
+    template <typename U>
+    shard_task(cluster *s, U &&f) : shard(s), fn(std::forward<U>(f)) {}
+    void operator()() { fn(shard); }
+  };
+
+  struct apply_topology_t;
+  struct slots_updated_t;
+  struct node_filter_t;
+
+  // nodes not in the topology, such as seeds before slots are loaded, can be connected by any shard
+  bool is_node_owner(size_t index, const connection::key_t &key) const;
+  void publish_topology(cluster *source);
+
+ private:
+  std::vector<std::unique_ptr<cluster> > shards_;
+  std::vector<std::thread> threads_;
+  std::atomic<bool> running_;
+
+  // shard of every slot, readers do not lock
+  std::unique_ptr<std::atomic<uint32_t>[]> slot_shards_;
+  mutable std::atomic<uint32_t> next_shard_;
+
+  // published topology
+  mutable std::mutex topology_lock_;
+  std::shared_ptr<const topology_t> topology_;
+  std::atomic<uint64_t> topology_version_;
+  HIREDIS_HAPP_MAP(std::string, size_t) node_shards_;  // node name -> shard index, replicas go with their masters
+  std::vector<size_t> shard_node_count_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_SHARDED_CLUSTER_H
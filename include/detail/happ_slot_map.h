@@ -0,0 +1,144 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_SLOT_MAP_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_SLOT_MAP_H
+
+#pragma once
+
+#include <stdint.h>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "hiredis_happ_config.h"
+
+#include "happ_connection.h"
+#include "happ_node_registry.h"
+
+namespace hiredis {
+namespace happ {
+class cluster;
+class slot_map_holder;
+
+/**
+ * @brief immutable snapshot of the hosts of all slots, it can be read by any thread
+ * @note a snapshot is never changed after it's published, the owner publishes a new one when slots change
+ * @note nodes are copied into the snapshot, so it does not touch the node_registry of the cluster
+ */
+class slot_map {
+ public:
+  // increased every time a snapshot is published by the same holder
+  HIREDIS_HAPP_API uint64_t get_version() const;
+
+  // @return count of slots which are served by any host
+  HIREDIS_HAPP_API size_t get_slot_count() const;
+
+  // @return count of hosts of a slot, 0 if it's not served
+  HIREDIS_HAPP_API size_t get_host_count(int slot) const;
+
+  // @return host of a slot, the master is the first one, or nullptr if it's not found
+  HIREDIS_HAPP_API const connection::key_t *get_host(int slot, size_t index) const;
+
+  // @return master of a slot, or nullptr if it's not served
+  HIREDIS_HAPP_API const connection::key_t *get_master(int slot) const;
+
+  // @return master of the slot of a key, or nullptr if it's not served
+  HIREDIS_HAPP_API const connection::key_t *get_master(const char *key, size_t ks) const;
+
+ private:
+  slot_map();
+  slot_map(const slot_map &);
+  slot_map &operator=(const slot_map &);
+
+  // set hosts of a slot when building the snapshot, nodes are copied from the registry
+  void set_hosts(int slot, const std::vector<connection::node_id_t> &hosts, const node_registry &registry);
+
+  friend class cluster;
+  friend class slot_map_ref;
+  friend class slot_map_holder;
+
+ private:
+  uint64_t version_;
+  size_t slot_count_;
+  mutable std::atomic<uint32_t> refs_;  // count of slot_map_ref on this snapshot
+
+  std::vector<connection::key_t> nodes_;
+  // host lists, hosts_[0] is empty and is used by slots which are not served
+  std::vector<std::vector<uint32_t> > hosts_;  // index in nodes_
+  uint16_t slot_hosts_[HIREDIS_HAPP_SLOT_NUMBER];  // index in hosts_
+
+  // only used while building, cleared when it's published
+  std::vector<uint32_t> build_node_index_;  // node id -> index in nodes_ + 1
+  std::vector<connection::node_id_t> build_last_hosts_;
+};
+
+/**
+ * @brief reference of a slot_map snapshot, it keeps the snapshot alive until it's destroyed
+ * @note it must be destroyed before the holder(and the cluster) which publishes the snapshot
+ */
+class slot_map_ref {
+ public:
+  HIREDIS_HAPP_API slot_map_ref();
+  HIREDIS_HAPP_API slot_map_ref(const slot_map_ref &other);
+  HIREDIS_HAPP_API slot_map_ref(slot_map_ref &&other);
+  HIREDIS_HAPP_API ~slot_map_ref();
+
+  HIREDIS_HAPP_API slot_map_ref &operator=(const slot_map_ref &other);
+  HIREDIS_HAPP_API slot_map_ref &operator=(slot_map_ref &&other);
+
+  HIREDIS_HAPP_API void reset();
+
+  inline const slot_map *get() const { return map_; }
+  inline const slot_map *operator->() const { return map_; }
+  inline const slot_map &operator*() const { return *map_; }
+  inline explicit operator bool() const { return nullptr != map_; }
+
+ private:
+  friend class slot_map_holder;
+  explicit slot_map_ref(const slot_map *map);
+
+ private:
+  const slot_map *map_;
+};
+
+/**
+ * @brief publishes slot_map snapshots in RCU style
+ * @note acquire() can be called by any thread without locks. publish() and reclaim() must only be called by the
+ *       owner thread, they never wait for readers.
+ * @note replaced snapshots are retired, and deleted by publish() or reclaim() after all references to them are
+ *       released.
+ */
+class slot_map_holder {
+ public:
+  HIREDIS_HAPP_API slot_map_holder();
+  HIREDIS_HAPP_API ~slot_map_holder();
+
+  // get the latest snapshot, it's empty before anything is published
+  HIREDIS_HAPP_API slot_map_ref acquire() const;
+
+  // replace the latest snapshot, the holder takes the ownership of map
+  HIREDIS_HAPP_API void publish(slot_map *map);
+
+  // @return count of retired snapshots which are still referenced
+  HIREDIS_HAPP_API size_t reclaim();
+
+  // version of the latest snapshot, must only be called by the owner thread
+  HIREDIS_HAPP_API uint64_t get_version() const;
+
+ private:
+  slot_map_holder(const slot_map_holder &);
+  slot_map_holder &operator=(const slot_map_holder &);
+
+ private:
+  std::atomic<slot_map *> current_;
+  // count of readers between loading current_ and adding a reference, retired snapshots are not deleted if it's not 0
+  mutable std::atomic<uint32_t> acquiring_;
+  std::vector<slot_map *> retired_;
+  uint64_t version_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_SLOT_MAP_H
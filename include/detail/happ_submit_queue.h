@@ -0,0 +1,123 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_SUBMIT_QUEUE_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_SUBMIT_QUEUE_H
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "hiredis_happ_config.h"
+
+namespace hiredis {
+namespace happ {
+
+/**
+ * @brief lock-free multi-producer single-consumer queue of tasks, used to hand work from any thread to the thread
+ *        which runs the event loop
+ * @note post() can be called by any thread. drain() and on_wakeup() must only be called by the event loop thread.
+ * @note producers push tasks onto an atomic stack, and the consumer takes the whole stack with one exchange, so
+ *       tasks are drained in batches in the order they are posted.
+ * @note the loop thread is woken up only when the queue changes from empty to non-empty, by an eventfd(linux only)
+ *       which can be watched by the event loop, or by a function set with set_wakeup_fn (such as event_active of
+ *       libevent or uv_async_send of libuv).
+ */
+class submit_queue {
+ public:
+  typedef std::function<void()> wakeup_fn_t;
+
+  HIREDIS_HAPP_API submit_queue();
+  HIREDIS_HAPP_API ~submit_queue();
+
+  /**
+   * @brief post a task to the loop thread, thread safe
+   * @param fn any callable(including move-only ones) with signature void()
+   * @return 0 or error code
+   */
+  template <typename F>
+  int post(F &&fn) {
+    typedef typename std::decay<F>::type fn_t;
+    task_node *task = new (std::nothrow) task_impl<fn_t>(std::forward<F>(fn));
+    if (nullptr == task) {
+      return error_code::REDIS_HAPP_CREATE;
+    }
+
+    push(task);
+    return error_code::REDIS_HAPP_OK;
+  }
+
+  /**
+   * @brief run tasks posted to this queue, must be called in the loop thread
+   * @param max_count max count of tasks to run, 0 means all tasks which are already posted
+   * @note tasks posted while draining are run by the next call
+   * @return count of tasks run
+   */
+  HIREDIS_HAPP_API size_t drain(size_t max_count = 0);
+
+  // there may be tasks which are being posted by other threads when it return true
+  HIREDIS_HAPP_API bool empty() const;
+
+  /**
+   * @brief create an eventfd to wake up the loop thread, the event loop should watch it for reading and call
+   *        on_wakeup() when it's readable
+   * @return the eventfd, or error code if it's not supported
+   */
+  HIREDIS_HAPP_API int enable_eventfd();
+
+  // @return eventfd created by enable_eventfd, or -1
+  HIREDIS_HAPP_API int get_wakeup_fd() const;
+
+  /**
+   * @brief set a wakeup function, which will be called in the thread which post a task to an empty queue
+   * @note it must be thread safe, and must be set before any thread post tasks
+   */
+  HIREDIS_HAPP_API wakeup_fn_t set_wakeup_fn(wakeup_fn_t fn);
+
+  /**
+   * @brief consume the eventfd and run all posted tasks, must be called in the loop thread
+   * @return count of tasks run
+   */
+  HIREDIS_HAPP_API size_t on_wakeup();
+
+ private:
+  submit_queue(const submit_queue &);
+  submit_queue &operator=(const submit_queue &);
+
+  struct task_node {
+    task_node *next;
+
+    task_node() : next(nullptr) {}
+    virtual ~task_node() {}
+    virtual void run() = 0;
+  };
+
+  template <typename F>
+  struct task_impl : public task_node {
+    F fn;
+
+    template <typename U>
+    explicit task_impl(U &&f) : fn(std::forward<U>(f)) {}
+    void run() override { fn(); }
+  };
+
+  HIREDIS_HAPP_API void push(task_node *task);
+  void take();
+  void wakeup();
+
+ private:
+  std::atomic<task_node *> head_;  // stack of posted tasks, the latest one is at the head
+  task_node *ready_;               // tasks taken from head_ in FIFO order, only used by the loop thread
+  int wakeup_fd_;
+  wakeup_fn_t wakeup_fn_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_SUBMIT_QUEUE_H
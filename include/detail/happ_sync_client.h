@@ -0,0 +1,141 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_SYNC_CLIENT_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_SYNC_CLIENT_H
+
+#pragma once
+
+#include "hiredis_happ_config.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+
+#  include <atomic>
+#  include <ctime>
+#  include <future>
+#  include <memory>
+#  include <shared_mutex>
+#  include <string>
+#  include <unordered_set>
+#  include <vector>
+
+#  include "happ_cluster.h"
+#  include "happ_epoll_loop.h"
+#  include "happ_raw.h"
+
+namespace hiredis {
+namespace happ {
+
+// reply copied out of hiredis, so it can be passed to other threads
+struct HIREDIS_HAPP_API_HEAD_ONLY sync_reply {
+  int result;  // REDIS_HAPP_OK if the reply is received
+  int type;    // REDIS_REPLY_*, 0 if there is no reply
+  long long integer;
+  double dval;
+  std::string str;  // content of string, status, error, double, verbatim and big number replies
+  std::vector<sync_reply> elements;
+
+  HIREDIS_HAPP_API sync_reply();
+
+  // true if a reply is received and it's not an error reply
+  HIREDIS_HAPP_API bool is_ok() const;
+
+  // copy a hiredis reply and all its elements, result is not changed
+  static HIREDIS_HAPP_API void copy(sync_reply &out, const redisReply *reply);
+};
+
+/**
+ * @brief blocking and future facade of cluster or raw, which run in an internal epoll_loop thread
+ * @note exec_async(), exec() and exec_batch() can be called by any thread. Requests are posted to the submit_queue of
+ *       the loop thread, requests posted by all threads between two wakeups are sent in one batch, so they are
+ *       pipelined on every connection.
+ * @note configure get_cluster() or get_raw() after init and before start(), they must not be touched after start()
+ * @note requests which are not posted before stop() fail with REDIS_HAPP_CONNECTION
+ */
+class sync_client {
+ public:
+  struct mode_t {
+    enum type { NONE = 0, CLUSTER, RAW };
+  };
+
+  typedef std::vector<std::string> args_t;
+
+  struct HIREDIS_HAPP_API_HEAD_ONLY request_t {
+    std::string key;  // used to choose the slot in cluster mode, ignored in raw mode
+    args_t args;
+  };
+
+  HIREDIS_HAPP_API sync_client();
+  HIREDIS_HAPP_API ~sync_client();
+
+  // create a cluster and the loop, @return 0 or error code
+  HIREDIS_HAPP_API int init_cluster(const std::string &ip, uint16_t port);
+
+  // create a raw and the loop, @return 0 or error code
+  HIREDIS_HAPP_API int init_raw(const std::string &ip, uint16_t port);
+
+  HIREDIS_HAPP_API mode_t::type get_mode() const;
+  HIREDIS_HAPP_API cluster *get_cluster();
+  HIREDIS_HAPP_API raw *get_raw();
+
+  // start the cluster or raw, and the loop thread
+  HIREDIS_HAPP_API int start();
+
+  // reset the cluster or raw in the loop thread, pending requests fail, and then wait for the thread to exit
+  HIREDIS_HAPP_API void stop();
+
+  HIREDIS_HAPP_API bool is_running() const;
+
+  /**
+   * @brief send a request, thread safe
+   * @param key key used to choose the slot in cluster mode
+   * @param args command and arguments
+   * @return future of the reply, it's always set even if the request fails
+   */
+  HIREDIS_HAPP_API std::future<sync_reply> exec_async(const std::string &key, const args_t &args);
+
+  /**
+   * @brief send a request and wait for its reply, thread safe
+   * @param timeout_ms max time to wait, 0 or negative to wait until the reply or the timeout of the cluster or raw
+   * @return the reply, result is REDIS_HAPP_TIMEOUT if it's not received in time
+   */
+  HIREDIS_HAPP_API sync_reply exec(const std::string &key, const args_t &args, time_t timeout_ms = 0);
+
+  /**
+   * @brief send requests in one batch and wait for all their replies, thread safe
+   * @param timeout_ms max time to wait all replies, 0 or negative to wait until all replies or timeouts
+   * @return replies in the order of requests
+   */
+  HIREDIS_HAPP_API std::vector<sync_reply> exec_batch(const std::vector<request_t> &requests, time_t timeout_ms = 0);
+
+ private:
+  sync_client(const sync_client &);
+  sync_client &operator=(const sync_client &);
+
+  struct state_t;
+  struct callback_t;
+  struct exec_task_t;
+  struct stop_task_t;
+
+  int post_requests(const std::vector<request_t> &requests, std::vector<std::future<sync_reply> > &futures);
+  void exec_in_loop(const request_t &request, const std::shared_ptr<state_t> &state);
+  void fail_pending(int result);
+  submit_queue *get_submit_queue();
+
+ private:
+  mode_t::type mode_;
+  epoll_loop loop_;
+  std::unordered_set<std::shared_ptr<state_t> > pending_;  // sent but not replied, only used by the loop thread
+  std::unique_ptr<cluster> cluster_;
+  std::unique_ptr<raw> raw_;
+  std::atomic<bool> running_;
+  std::shared_mutex post_lock_;  // shared by producers checking running_ and posting, exclusive to stop()
+  bool closing_;                 // only used by the loop thread
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_SYNC_CLIENT_H
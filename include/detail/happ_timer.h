@@ -0,0 +1,126 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_TIMER_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_TIMER_H
+
+#pragma once
+
+#include <ctime>
+
+#include "hiredis_happ_config.h"
+
+namespace hiredis {
+namespace happ {
+class timer_wheel;
+
+/**
+ * @brief intrusive timer node, embed it into the object which need a deadline
+ * @note a zero-initialized node is a valid unscheduled node, so it can be placed in POD types like cmd_exec
+ */
+struct HIREDIS_HAPP_API_HEAD_ONLY timer_node {
+  timer_node *prev;
+  timer_node *next;
+  timer_wheel *owner;  // nullptr if not scheduled
+  uint32_t slot;       // slot index inside owner
+  uint64_t expire;     // absolute expire tick(in milliseconds)
+  void *data;          // user data
+};
+
+/**
+ * @brief hierarchical timer wheel with 1ms tick
+ * @note level 0 has 256 slots and every upper level has 64 slots, so it can hold timers within 2^32 - 1 ticks
+ *       without any sorting. add/remove are O(1) and advance only walks the non-empty slots of level 0 and the
+ *       cascading slots of upper levels.
+ *       Timers further away are parked in the last slot the wheel can reach. They keep their real expire tick and are
+ *       re-inserted when that slot cascades, so they never expire early.
+ */
+class timer_wheel {
+ public:
+  typedef uint64_t tick_t;
+
+  enum {
+    NEAR_BITS = 8,
+    LEVEL_BITS = 6,
+    NEAR_SIZE = 1 << NEAR_BITS,
+    LEVEL_SIZE = 1 << LEVEL_BITS,
+    LEVEL_COUNT = 4,
+    SLOT_COUNT = NEAR_SIZE + LEVEL_SIZE * LEVEL_COUNT,
+    EXPIRED_SLOT = SLOT_COUNT,
+  };
+
+ private:
+  timer_wheel(const timer_wheel &);
+  timer_wheel &operator=(const timer_wheel &);
+
+ public:
+  HIREDIS_HAPP_API timer_wheel();
+  HIREDIS_HAPP_API ~timer_wheel();
+
+  /**
+   * @brief schedule a node
+   * @param node timer node, it will be removed from its old wheel first if it's already scheduled
+   * @param expire absolute expire tick, timers in the past will expire at the next advance
+   * @param data user data
+   */
+  HIREDIS_HAPP_API void add(timer_node *node, tick_t expire, void *data);
+
+  /**
+   * @brief remove a node from the wheel which it's scheduled in
+   * @return true if node is scheduled before
+   */
+  static HIREDIS_HAPP_API bool remove(timer_node *node);
+
+  static HIREDIS_HAPP_API bool is_scheduled(const timer_node *node);
+
+  /**
+   * @brief move all timers with expire <= now into the expired list
+   * @return number of timers moved into expired list
+   */
+  HIREDIS_HAPP_API size_t advance(tick_t now);
+
+  /**
+   * @brief move all timers into the expired list, whatever their expire ticks are
+   * @return number of timers moved into expired list
+   */
+  HIREDIS_HAPP_API size_t flush();
+
+  /**
+   * @brief pop a node from the expired list
+   * @return the node(already unscheduled) or nullptr if there is no more expired node
+   */
+  HIREDIS_HAPP_API timer_node *pop_expired();
+
+  HIREDIS_HAPP_API size_t size() const;
+
+  HIREDIS_HAPP_API bool empty() const;
+
+  /**
+   * @brief get the next tick which is not processed yet
+   */
+  HIREDIS_HAPP_API tick_t get_next_tick() const;
+
+  static HIREDIS_HAPP_API tick_t make_tick(time_t sec, time_t usec);
+
+ private:
+  void insert(timer_node *node);
+  void unlink(timer_node *node);
+  size_t move_to_expired(uint32_t slot);
+  void cascade(uint32_t level, uint32_t index);
+  uint32_t find_near(uint32_t start) const;
+
+  static void list_init(timer_node *head);
+  static bool list_empty(const timer_node *head);
+
+ private:
+  tick_t next_tick_;
+  size_t size_;
+  size_t pending_;  // timers not in expired list
+  uint64_t near_bitmap_[NEAR_SIZE / 64];
+  timer_node slots_[SLOT_COUNT + 1];  // the last one is expired list
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_TIMER_H
@@ -8,6 +8,11 @@
 #pragma once
 
 #include "detail/happ_cluster.h"
+#include "detail/happ_coroutine.h"
+#include "detail/happ_epoll_loop.h"
 #include "detail/happ_raw.h"
+#include "detail/happ_reply_decoder.h"
+#include "detail/happ_sharded_cluster.h"
+#include "detail/happ_sync_client.h"
 
 #endif  // HIREDIS_HAPP_HIREDIS_HAPP_H
@@ -0,0 +1,619 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+// redis-benchmark style load generator on cluster or raw, every loop thread runs its own built-in epoll_loop
+// Usage: hiredis-happ-sample_load_gen [--mode cluster|raw] [--host ip] [--port port] [--threads n] [--pipeline n]
+//        [--keys n] [--dist uniform|zipf] [--theta t] [--value-size n|min-max] [--read-ratio r] [--duration sec]
+//        [--requests n] [--warmup sec] [--password passwd]
+// Host and port default to the cluster or the standalone server of test/redis/redis-fixture.sh.
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "hiredis_happ.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+
+namespace {
+struct options_t {
+  bool cluster_mode;
+  std::string host;
+  uint16_t port;
+  std::string password;
+  size_t threads;
+  size_t pipeline;
+  uint64_t keys;
+  bool zipf;
+  double theta;
+  size_t value_min;
+  size_t value_max;
+  double read_ratio;
+  int duration_sec;
+  uint64_t requests;
+  int warmup_sec;
+};
+
+/**
+ * @brief latency histogram in microseconds, buckets are log-linear just like HdrHistogram
+ * @note every power of 2 is split into 128 sub-buckets, so values are recorded in less than 1% error
+ */
+class latency_histogram {
+ public:
+  latency_histogram() : counts_(BUCKET_COUNT, 0), total_count_(0), total_value_(0), max_value_(0) {}
+
+  void record(uint64_t value) {
+    ++counts_[get_index(value)];
+    ++total_count_;
+    total_value_ += value;
+    if (value > max_value_) {
+      max_value_ = value;
+    }
+  }
+
+  void merge(const latency_histogram &other) {
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+      counts_[i] += other.counts_[i];
+    }
+    total_count_ += other.total_count_;
+    total_value_ += other.total_value_;
+    if (other.max_value_ > max_value_) {
+      max_value_ = other.max_value_;
+    }
+  }
+
+  // highest value equivalent to the bucket of the percentile, such as 99.9
+  uint64_t get_percentile(double percentile) const {
+    if (0 == total_count_) {
+      return 0;
+    }
+
+    uint64_t target = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(total_count_)));
+    if (target < 1) {
+      target = 1;
+    }
+
+    uint64_t count = 0;
+    for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+      count += counts_[i];
+      if (count >= target) {
+        uint64_t ret = get_highest_value(i);
+        return ret < max_value_ ? ret : max_value_;
+      }
+    }
+    return max_value_;
+  }
+
+  uint64_t get_count() const { return total_count_; }
+  uint64_t get_max() const { return max_value_; }
+  double get_mean() const {
+    return 0 == total_count_ ? 0.0 : static_cast<double>(total_value_) / static_cast<double>(total_count_);
+  }
+
+ private:
+  static constexpr size_t SUB_BUCKET_BITS = 7;
+  static constexpr size_t SUB_BUCKET_COUNT = static_cast<size_t>(1) << SUB_BUCKET_BITS;
+  static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+  static size_t get_index(uint64_t value) {
+    if (value < 2 * SUB_BUCKET_COUNT) {
+      return static_cast<size_t>(value);
+    }
+
+    size_t msb = 63 - static_cast<size_t>(__builtin_clzll(value));
+    size_t shift = msb - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKET_COUNT + static_cast<size_t>(value >> shift) - SUB_BUCKET_COUNT;
+  }
+
+  static uint64_t get_highest_value(size_t index) {
+    if (index < 2 * SUB_BUCKET_COUNT) {
+      return index;
+    }
+
+    size_t shift = index / SUB_BUCKET_COUNT - 1;
+    uint64_t sub = index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT;
+    return ((sub + 1) << shift) - 1;
+  }
+
+  std::vector<uint64_t> counts_;
+  uint64_t total_count_;
+  uint64_t total_value_;
+  uint64_t max_value_;
+};
+
+/**
+ * @brief key index generator, zipf is the same as the zipfian generator of YCSB
+ * @note it's shared by all threads after init, random engines are owned by every thread
+ */
+class key_generator {
+ public:
+  key_generator() : keys_(1), zipf_(false), theta_(0.99), zetan_(1.0), alpha_(0.0), eta_(0.0) {}
+
+  void init(uint64_t keys, bool zipf, double theta) {
+    keys_ = keys > 0 ? keys : 1;
+    zipf_ = zipf;
+    theta_ = theta;
+    if (!zipf_) {
+      return;
+    }
+
+    zetan_ = 0.0;
+    for (uint64_t i = 1; i <= keys_; ++i) {
+      zetan_ += 1.0 / std::pow(static_cast<double>(i), theta_);
+    }
+    double zeta2 = 1.0 + 1.0 / std::pow(2.0, theta_);
+    alpha_ = 1.0 / (1.0 - theta_);
+    eta_ = (1.0 - std::pow(2.0 / static_cast<double>(keys_), 1.0 - theta_)) / (1.0 - zeta2 / zetan_);
+  }
+
+  uint64_t next(std::mt19937_64 &engine) const {
+    if (!zipf_) {
+      return std::uniform_int_distribution<uint64_t>(0, keys_ - 1)(engine);
+    }
+
+    double u = std::uniform_real_distribution<double>(0.0, 1.0)(engine);
+    double uz = u * zetan_;
+    if (uz < 1.0) {
+      return 0;
+    }
+    if (uz < 1.0 + std::pow(0.5, theta_)) {
+      return keys_ > 1 ? 1 : 0;
+    }
+
+    uint64_t ret = static_cast<uint64_t>(static_cast<double>(keys_) * std::pow(eta_ * u - eta_ + 1.0, alpha_));
+    return ret < keys_ ? ret : keys_ - 1;
+  }
+
+ private:
+  uint64_t keys_;
+  bool zipf_;
+  double theta_;
+  double zetan_;
+  double alpha_;
+  double eta_;
+};
+
+std::atomic<bool> g_sending(true);
+key_generator g_key_generator;
+
+class worker_t {
+ public:
+  worker_t(const options_t &opts, size_t index)
+      : opts_(opts),
+        engine_(static_cast<uint64_t>(index) * 2654435761ULL + 1),
+        value_(opts.value_max, 'x'),
+        request_limit_(0),
+        sent_(0),
+        in_flight_(0),
+        sending_depth_(0),
+        deferred_(0),
+        reads_(0),
+        writes_(0),
+        errors_(0),
+        recording_(false),
+        done_(false) {
+    if (opts.requests > 0) {
+      request_limit_ = opts.requests / opts.threads + (index < opts.requests % opts.threads ? 1 : 0);
+    }
+  }
+
+  void start() { thread_ = std::thread(run_thread, this); }
+  void join() {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  void set_recording(bool v) { recording_.store(v, std::memory_order_release); }
+
+  const latency_histogram &get_histogram() const { return histogram_; }
+  uint64_t get_reads() const { return reads_; }
+  uint64_t get_writes() const { return writes_; }
+  uint64_t get_errors() const { return errors_; }
+  // all requests are sent and replied, or the loop failed
+  bool is_done() const { return done_.load(std::memory_order_acquire); }
+
+ private:
+  struct reply_callback_t {
+    worker_t *self;
+    std::chrono::steady_clock::time_point start;
+    bool is_read;
+
+    void operator()(hiredis::happ::cmd_exec *cmd, redisAsyncContext *, void *r) {
+      self->on_reply(cmd, reinterpret_cast<redisReply *>(r), start, is_read);
+    }
+  };
+
+  static void run_thread(worker_t *self) {
+    self->run();
+    self->done_.store(true, std::memory_order_release);
+  }
+
+  void run() {
+    hiredis::happ::epoll_loop loop;
+    if (hiredis::happ::error_code::REDIS_HAPP_OK != loop.init()) {
+      fprintf(stderr, "init epoll_loop failed\n");
+      return;
+    }
+
+    if (opts_.cluster_mode) {
+      clu_.init(opts_.host, opts_.port);
+      clu_.set_timeout(5);
+      if (!opts_.password.empty()) {
+        clu_.set_auth_password(opts_.password);
+      }
+      loop.bind(clu_);
+      clu_.start();
+    } else {
+      raw_.init(opts_.host, opts_.port);
+      raw_.set_timeout(5);
+      if (!opts_.password.empty()) {
+        raw_.set_auth_password(opts_.password);
+      }
+      loop.bind(raw_);
+      raw_.start();
+    }
+
+    for (size_t i = 0; i < opts_.pipeline; ++i) {
+      send_one();
+    }
+
+    // keep running until all sent requests are replied, or they are given up after the timeout
+    std::chrono::steady_clock::time_point give_up = std::chrono::steady_clock::time_point::max();
+    while (in_flight_ > 0 || deferred_ > 0) {
+      loop.run_once(10);
+      while (deferred_ > 0) {
+        --deferred_;
+        send_one();
+      }
+
+      if (!g_sending.load(std::memory_order_acquire) && give_up == std::chrono::steady_clock::time_point::max()) {
+        give_up = std::chrono::steady_clock::now() + std::chrono::seconds(6);
+      }
+      if (std::chrono::steady_clock::now() > give_up) {
+        break;
+      }
+    }
+
+    if (opts_.cluster_mode) {
+      clu_.reset();
+    } else {
+      raw_.reset();
+    }
+    for (int i = 0; i < 10; ++i) {
+      loop.run_once(0);
+    }
+  }
+
+  bool can_send() const {
+    if (!g_sending.load(std::memory_order_acquire)) {
+      return false;
+    }
+    return 0 == request_limit_ || sent_ < request_limit_;
+  }
+
+  void send_one() {
+    if (!can_send()) {
+      return;
+    }
+
+    char key[64];
+    int key_len = snprintf(key, sizeof(key), "happ:load:%llu",
+                           static_cast<unsigned long long>(g_key_generator.next(engine_)));
+    std::string_view key_view(key, static_cast<size_t>(key_len));
+
+    reply_callback_t cbk;
+    cbk.self = this;
+    cbk.is_read = std::uniform_real_distribution<double>(0.0, 1.0)(engine_) < opts_.read_ratio;
+    cbk.start = std::chrono::steady_clock::now();
+
+    ++sent_;
+    ++in_flight_;
+    ++sending_depth_;
+    hiredis::happ::cmd_exec *cmd;
+    if (cbk.is_read) {
+      static constexpr hiredis::happ::cmd_literal get("GET");
+      if (opts_.cluster_mode) {
+        cmd = clu_.exec(key, key_view.size(), cbk, get, key_view);
+      } else {
+        cmd = raw_.exec(cbk, get, key_view);
+      }
+    } else {
+      static constexpr hiredis::happ::cmd_literal set("SET");
+      size_t value_size = opts_.value_min;
+      if (opts_.value_max > opts_.value_min) {
+        value_size = std::uniform_int_distribution<size_t>(opts_.value_min, opts_.value_max)(engine_);
+      }
+      std::string_view value(value_.data(), value_size);
+      if (opts_.cluster_mode) {
+        cmd = clu_.exec(key, key_view.size(), cbk, set, key_view, value);
+      } else {
+        cmd = raw_.exec(cbk, set, key_view, value);
+      }
+    }
+
+    --sending_depth_;
+
+    // the callback is not called if the cmd can not be created
+    if (nullptr == cmd) {
+      --in_flight_;
+      ++errors_;
+    }
+  }
+
+  void on_reply(hiredis::happ::cmd_exec *cmd, redisReply *reply, std::chrono::steady_clock::time_point start,
+                bool is_read) {
+    --in_flight_;
+
+    if (recording_.load(std::memory_order_acquire)) {
+      if (hiredis::happ::error_code::REDIS_HAPP_OK != cmd->result() || nullptr == reply ||
+          REDIS_REPLY_ERROR == reply->type) {
+        ++errors_;
+      } else {
+        uint64_t cost = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+        histogram_.record(cost);
+        if (is_read) {
+          ++reads_;
+        } else {
+          ++writes_;
+        }
+      }
+    }
+
+    // the reply of a failed request may be called in exec(), send the next one after this exec() returns
+    if (sending_depth_ > 0) {
+      ++deferred_;
+    } else {
+      send_one();
+    }
+  }
+
+ private:
+  const options_t &opts_;
+  std::mt19937_64 engine_;
+  std::string value_;
+  uint64_t request_limit_;
+  uint64_t sent_;
+  size_t in_flight_;
+  size_t sending_depth_;
+  size_t deferred_;  // requests to send after replies called in exec()
+
+  hiredis::happ::cluster clu_;
+  hiredis::happ::raw raw_;
+
+  latency_histogram histogram_;
+  uint64_t reads_;
+  uint64_t writes_;
+  uint64_t errors_;
+  std::atomic<bool> recording_;
+  std::atomic<bool> done_;
+
+  std::thread thread_;
+};
+
+const char *get_env(const char *name, const char *default_value) {
+  const char *ret = getenv(name);
+  return (nullptr == ret || 0 == *ret) ? default_value : ret;
+}
+
+void print_usage(const char *name) {
+  printf("usage: %s [options]\n", name);
+  puts("  --mode cluster|raw        connect to a cluster or a standalone server, default: cluster");
+  puts("  --host ip                 default: HIREDIS_HAPP_TEST_CLUSTER_HOST or HIREDIS_HAPP_TEST_SINGLE_HOST");
+  puts(
+      "  --port port               default: HIREDIS_HAPP_TEST_CLUSTER_PORT(7300) or "
+      "HIREDIS_HAPP_TEST_SINGLE_PORT(6390)");
+  puts("  --threads n               loop threads, every thread has its own connections, default: 1");
+  puts("  --pipeline n              requests in flight of every thread, default: 16");
+  puts("  --keys n                  size of the key space, default: 100000");
+  puts("  --dist uniform|zipf       key distribution, default: uniform");
+  puts("  --theta t                 skew of zipf, must not be 1, default: 0.99");
+  puts("  --value-size n|min-max    bytes of SET values, default: 64");
+  puts("  --read-ratio r            ratio of GET in all requests, default: 0.8");
+  puts("  --duration sec            seconds to run after warmup, default: 10");
+  puts("  --requests n              stop after n requests in total(warmup included), 0 means by duration, default: 0");
+  puts("  --warmup sec              seconds before recording, default: 1");
+  puts("  --password passwd         password of AUTH");
+}
+
+bool parse_options(int argc, char *argv[], options_t &opts) {
+  opts.cluster_mode = true;
+  opts.threads = 1;
+  opts.pipeline = 16;
+  opts.keys = 100000;
+  opts.zipf = false;
+  opts.theta = 0.99;
+  opts.value_min = 64;
+  opts.value_max = 64;
+  opts.read_ratio = 0.8;
+  opts.duration_sec = 10;
+  opts.requests = 0;
+  opts.warmup_sec = 1;
+
+  std::string host;
+  long port = 0;
+  for (int i = 1; i < argc; ++i) {
+    std::string name = argv[i];
+    if ("--help" == name || "-h" == name) {
+      return false;
+    }
+    if (i + 1 >= argc) {
+      fprintf(stderr, "option %s requires a value\n", argv[i]);
+      return false;
+    }
+
+    const char *value = argv[++i];
+    if ("--mode" == name) {
+      opts.cluster_mode = 0 != strcmp("raw", value);
+    } else if ("--host" == name) {
+      host = value;
+    } else if ("--port" == name) {
+      port = strtol(value, nullptr, 10);
+    } else if ("--threads" == name) {
+      opts.threads = static_cast<size_t>(strtoull(value, nullptr, 10));
+    } else if ("--pipeline" == name) {
+      opts.pipeline = static_cast<size_t>(strtoull(value, nullptr, 10));
+    } else if ("--keys" == name) {
+      opts.keys = strtoull(value, nullptr, 10);
+    } else if ("--dist" == name) {
+      opts.zipf = 0 == strcmp("zipf", value);
+    } else if ("--theta" == name) {
+      opts.theta = strtod(value, nullptr);
+    } else if ("--value-size" == name) {
+      char *end = nullptr;
+      opts.value_min = static_cast<size_t>(strtoull(value, &end, 10));
+      opts.value_max = opts.value_min;
+      if (nullptr != end && '-' == *end) {
+        opts.value_max = static_cast<size_t>(strtoull(end + 1, nullptr, 10));
+      }
+    } else if ("--read-ratio" == name) {
+      opts.read_ratio = strtod(value, nullptr);
+    } else if ("--duration" == name) {
+      opts.duration_sec = static_cast<int>(strtol(value, nullptr, 10));
+    } else if ("--requests" == name) {
+      opts.requests = strtoull(value, nullptr, 10);
+    } else if ("--warmup" == name) {
+      opts.warmup_sec = static_cast<int>(strtol(value, nullptr, 10));
+    } else if ("--password" == name) {
+      opts.password = value;
+    } else {
+      fprintf(stderr, "unknown option %s\n", name.c_str());
+      return false;
+    }
+  }
+
+  if (host.empty()) {
+    host = opts.cluster_mode ? get_env("HIREDIS_HAPP_TEST_CLUSTER_HOST", "127.0.0.1")
+                             : get_env("HIREDIS_HAPP_TEST_SINGLE_HOST", "127.0.0.1");
+  }
+  if (port <= 0) {
+    port = strtol(opts.cluster_mode ? get_env("HIREDIS_HAPP_TEST_CLUSTER_PORT", "7300")
+                                    : get_env("HIREDIS_HAPP_TEST_SINGLE_PORT", "6390"),
+                  nullptr, 10);
+  }
+  opts.host = host;
+  opts.port = static_cast<uint16_t>(port);
+
+  if (0 == opts.threads) {
+    opts.threads = 1;
+  }
+  if (0 == opts.pipeline) {
+    opts.pipeline = 1;
+  }
+  if (opts.value_max < opts.value_min) {
+    opts.value_max = opts.value_min;
+  }
+  if (opts.duration_sec <= 0) {
+    opts.duration_sec = 1;
+  }
+  if (opts.warmup_sec < 0) {
+    opts.warmup_sec = 0;
+  }
+  if (opts.zipf && std::fabs(opts.theta - 1.0) < 1e-9) {
+    fprintf(stderr, "theta of zipf must not be 1\n");
+    return false;
+  }
+  return true;
+}
+
+bool is_all_done(const std::vector<worker_t *> &workers) {
+  for (size_t i = 0; i < workers.size(); ++i) {
+    if (!workers[i]->is_done()) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  options_t opts;
+  if (!parse_options(argc, argv, opts)) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  g_key_generator.init(opts.keys, opts.zipf, opts.theta);
+  printf("%s %s:%u, threads: %zu, pipeline: %zu, keys: %llu(%s), value size: %zu-%zu, read ratio: %.2f\n",
+         opts.cluster_mode ? "cluster" : "raw", opts.host.c_str(), static_cast<unsigned>(opts.port), opts.threads,
+         opts.pipeline, static_cast<unsigned long long>(opts.keys), opts.zipf ? "zipf" : "uniform", opts.value_min,
+         opts.value_max, opts.read_ratio);
+
+  std::vector<worker_t *> workers;
+  for (size_t i = 0; i < opts.threads; ++i) {
+    workers.push_back(new worker_t(opts, i));
+    workers.back()->set_recording(0 == opts.warmup_sec);
+  }
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i]->start();
+  }
+
+  // requests in warmup load slots and make connections, their latency is not recorded
+  std::this_thread::sleep_for(std::chrono::seconds(opts.warmup_sec));
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i]->set_recording(true);
+  }
+
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point end = begin + std::chrono::seconds(opts.duration_sec);
+  while (std::chrono::steady_clock::now() < end) {
+    if (is_all_done(workers)) {
+      break;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // close the window before taking its cost, replies after this are not counted in throughput and latency
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i]->set_recording(false);
+  }
+  double cost_sec =
+      std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::steady_clock::now() - begin).count();
+
+  g_sending.store(false, std::memory_order_release);
+  latency_histogram histogram;
+  uint64_t reads = 0;
+  uint64_t writes = 0;
+  uint64_t errors = 0;
+  for (size_t i = 0; i < workers.size(); ++i) {
+    workers[i]->join();
+    histogram.merge(workers[i]->get_histogram());
+    reads += workers[i]->get_reads();
+    writes += workers[i]->get_writes();
+    errors += workers[i]->get_errors();
+    delete workers[i];
+  }
+  workers.clear();
+
+  printf("requests: %llu (GET: %llu, SET: %llu), errors: %llu, cost: %.3fs, throughput: %.0f ops/s\n",
+         static_cast<unsigned long long>(histogram.get_count()), static_cast<unsigned long long>(reads),
+         static_cast<unsigned long long>(writes), static_cast<unsigned long long>(errors), cost_sec,
+         cost_sec > 0.0 ? static_cast<double>(histogram.get_count()) / cost_sec : 0.0);
+  printf("latency(us): mean: %.1f, p50: %llu, p90: %llu, p99: %llu, p999: %llu, max: %llu\n", histogram.get_mean(),
+         static_cast<unsigned long long>(histogram.get_percentile(50.0)),
+         static_cast<unsigned long long>(histogram.get_percentile(90.0)),
+         static_cast<unsigned long long>(histogram.get_percentile(99.0)),
+         static_cast<unsigned long long>(histogram.get_percentile(99.9)),
+         static_cast<unsigned long long>(histogram.get_max()));
+  return 0;
+}
+
+#else
+
+#  include <cstdio>
+
+int main() {
+  puts("sample_load_gen requires the built-in epoll_loop, which is only available on linux");
+  return 0;
+}
+
+#endif
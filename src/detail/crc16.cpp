@@ -34,5 +34,31 @@ HIREDIS_HAPP_API uint16_t crc16(const char *buf, size_t len) {
   for (counter = 0; counter < len; counter++) crc = (crc << 8) ^ crc16tab[((crc >> 8) ^ *buf++) & 0x00FF];
   return crc;
 }
+
+HIREDIS_HAPP_API int hash_slot(const char *key, size_t key_len) {
+  if (nullptr == key || 0 == key_len) {
+    return -1;
+  }
+
+  size_t start = 0;
+  while (start < key_len && key[start] != '{') {
+    ++start;
+  }
+
+  if (start == key_len) {
+    return static_cast<int>(crc16(key, key_len) % HIREDIS_HAPP_SLOT_NUMBER);
+  }
+
+  size_t end = start + 1;
+  while (end < key_len && key[end] != '}') {
+    ++end;
+  }
+
+  if (end == key_len || end == start + 1) {
+    return static_cast<int>(crc16(key, key_len) % HIREDIS_HAPP_SLOT_NUMBER);
+  }
+
+  return static_cast<int>(crc16(key + start + 1, end - start - 1) % HIREDIS_HAPP_SLOT_NUMBER);
+}
 }  // namespace happ
 }  // namespace hiredis
@@ -0,0 +1,143 @@
+// Copyright 2026 owent
+
+#include "detail/happ_circuit_breaker.h"
+
+namespace hiredis {
+namespace happ {
+HIREDIS_HAPP_API circuit_breaker::circuit_breaker() { reset(); }
+
+HIREDIS_HAPP_API bool circuit_breaker::allow(tick_t now, const config_t &conf, bool *is_probe) {
+  if (nullptr != is_probe) {
+    *is_probe = false;
+  }
+
+  if (0 == conf.half_open_probes) {
+    return true;
+  }
+
+  switch (state_) {
+    case state::CLOSED:
+      return true;
+
+    case state::OPEN:
+      if (now < deadline_) {
+        return false;
+      }
+
+      state_ = state::HALF_OPEN;
+      deadline_ = now + conf.open_msec;
+      probes_inflight_ = 0;
+      probes_success_ = 0;
+      break;
+
+    default:
+      // probes may be lost when connection released, give them up after a while
+      if (probes_inflight_ >= conf.half_open_probes && now >= deadline_) {
+        deadline_ = now + conf.open_msec;
+        probes_inflight_ = probes_success_;
+      }
+      break;
+  }
+
+  if (probes_inflight_ >= conf.half_open_probes) {
+    return false;
+  }
+
+  ++probes_inflight_;
+  if (nullptr != is_probe) {
+    *is_probe = true;
+  }
+  return true;
+}
+
+HIREDIS_HAPP_API void circuit_breaker::on_success(tick_t now, const config_t &conf, bool is_probe) {
+  switch (state_) {
+    case state::CLOSED:
+      roll_window(now, conf);
+      ++requests_;
+      break;
+
+    case state::HALF_OPEN:
+      // replies of requests sent before the breaker opened say nothing about the node now
+      if (!is_probe) {
+        break;
+      }
+
+      ++probes_success_;
+      if (probes_success_ >= conf.half_open_probes) {
+        reset();
+        window_begin_ = now;
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+HIREDIS_HAPP_API void circuit_breaker::on_failure(tick_t now, const config_t &conf, bool is_probe) {
+  switch (state_) {
+    case state::CLOSED:
+      roll_window(now, conf);
+      ++requests_;
+      ++failures_;
+      if (0 != conf.half_open_probes && requests_ >= conf.min_requests &&
+          static_cast<uint64_t>(failures_) * 100 >= static_cast<uint64_t>(requests_) * conf.error_rate_percent) {
+        open(now, conf);
+      }
+      break;
+
+    case state::HALF_OPEN:
+      // failures of requests sent before the breaker opened are stale, just like their successes
+      if (is_probe) {
+        open(now, conf);
+      }
+      break;
+
+    default:
+      break;
+  }
+}
+
+HIREDIS_HAPP_API void circuit_breaker::reset() {
+  state_ = state::CLOSED;
+  window_begin_ = 0;
+  requests_ = 0;
+  failures_ = 0;
+  deadline_ = 0;
+  probes_inflight_ = 0;
+  probes_success_ = 0;
+}
+
+HIREDIS_HAPP_API circuit_breaker::state::type circuit_breaker::get_state() const { return state_; }
+
+HIREDIS_HAPP_API uint32_t circuit_breaker::get_requests() const { return requests_; }
+
+HIREDIS_HAPP_API uint32_t circuit_breaker::get_failures() const { return failures_; }
+
+HIREDIS_HAPP_API void circuit_breaker::default_config(config_t &conf) {
+  conf.error_rate_percent = HIREDIS_HAPP_BREAKER_ERROR_RATE_PERCENT;
+  conf.min_requests = HIREDIS_HAPP_BREAKER_MIN_REQUESTS;
+  conf.window_msec = HIREDIS_HAPP_BREAKER_WINDOW_MSEC;
+  conf.open_msec = HIREDIS_HAPP_BREAKER_OPEN_MSEC;
+  conf.half_open_probes = HIREDIS_HAPP_BREAKER_HALF_OPEN_PROBES;
+}
+
+void circuit_breaker::roll_window(tick_t now, const config_t &conf) {
+  if (now >= window_begin_ + conf.window_msec) {
+    window_begin_ = now;
+    requests_ = 0;
+    failures_ = 0;
+  }
+}
+
+void circuit_breaker::open(tick_t now, const config_t &conf) {
+  state_ = state::OPEN;
+  deadline_ = now + conf.open_msec;
+  requests_ = 0;
+  failures_ = 0;
+  probes_inflight_ = 0;
+  probes_success_ = 0;
+}
+}  // namespace happ
+}  // namespace hiredis
@@ -19,9 +19,12 @@
 
 #include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
 #include <ctime>
 #include <limits>
+#include <new>
 #include <random>
 
 #include "detail/crc16.h"
@@ -46,32 +49,6 @@ static int random() {
 #endif
 }
 
-static int hash_slot(const char *key, size_t key_len) {
-  if (nullptr == key || 0 == key_len) {
-    return -1;
-  }
-
-  size_t start = 0;
-  while (start < key_len && key[start] != '{') {
-    ++start;
-  }
-
-  if (start == key_len) {
-    return static_cast<int>(crc16(key, key_len) % HIREDIS_HAPP_SLOT_NUMBER);
-  }
-
-  size_t end = start + 1;
-  while (end < key_len && key[end] != '}') {
-    ++end;
-  }
-
-  if (end == key_len || end == start + 1) {
-    return static_cast<int>(crc16(key, key_len) % HIREDIS_HAPP_SLOT_NUMBER);
-  }
-
-  return static_cast<int>(crc16(key + start + 1, end - start - 1) % HIREDIS_HAPP_SLOT_NUMBER);
-}
-
 static bool pick_cluster_endpoint_from_reply(redisAsyncContext *rctx, redisReply *endpoint_reply,
                                              redisReply *port_reply, std::string &ip, uint16_t &port) {
   if (nullptr == endpoint_reply || nullptr == port_reply || REDIS_REPLY_INTEGER != port_reply->type) {
@@ -119,9 +96,39 @@ static bool pick_cluster_endpoint_from_reply(redisAsyncContext *rctx, redisReply
 }
 
 static char NONE_MSG[] = "none";
+
+// error text starts with the whole token, so BUSYGROUP and BUSYKEY do not match BUSY
+static bool is_error_token(const char *msg, const char *token, size_t len) {
+  return 0 == HIREDIS_HAPP_STRNCASE_CMP(token, msg, len) && (0 == msg[len] || ' ' == msg[len]);
+}
+
+// the node is alive but can not serve requests now
+static bool is_node_busy_error(const char *msg) {
+  return is_error_token(msg, "LOADING", 7) || is_error_token(msg, "BUSY", 4) ||
+         is_error_token(msg, "MASTERDOWN", 10) || is_error_token(msg, "CLUSTERDOWN", 11);
+}
+
+static time_t steady_now_usec() {
+  return static_cast<time_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch())
+          .count());
+}
 }  // namespace detail
 
-HIREDIS_HAPP_API cluster::cluster() : slot_flag_(slot_status::INVALID) {
+struct cluster::hedge_t {
+  cmd_t::callback_fn_t callback;
+  void *private_data;
+  cmd_t *primary;    // primary cmd sent to master, nullptr after it's finished
+  cmd_t *secondary;  // secondary cmd sent to replica, nullptr after it's finished
+  int pending;       // cmds not finished
+  bool done;         // the winner is already passed to callback
+  int slot;
+  time_t start_usec;
+  timer_node timer;
+};
+
+HIREDIS_HAPP_API cluster::cluster()
+    : cmd_pool_(cmd_pool::create()), slot_flag_(slot_status::INVALID), slot_map_dirty_(false) {
   conf_.log_fn_debug = conf_.log_fn_info = nullptr;
   conf_.log_buffer = nullptr;
   conf_.log_max_size = 0;
@@ -130,6 +137,22 @@ HIREDIS_HAPP_API cluster::cluster() : slot_flag_(slot_status::INVALID) {
   conf_.timer_timeout_sec = HIREDIS_HAPP_TIMER_TIMEOUT_SEC;
   conf_.keepalive_interval_sec = 0;
   conf_.cmd_buffer_size = 0;
+  conf_.reply_arena_chunk_size = 0;
+  conf_.reply_stream = false;
+  conf_.hedge_min_delay_usec = HIREDIS_HAPP_HEDGE_MIN_DELAY_USEC;
+  conf_.hedge_max_delay_usec = HIREDIS_HAPP_HEDGE_MAX_DELAY_USEC;
+  conf_.hedge_percentile = HIREDIS_HAPP_HEDGE_PERCENTILE;
+
+  memset(&hedge_.stats, 0, sizeof(hedge_.stats));
+  hedge_.samples.resize(HIREDIS_HAPP_HEDGE_SAMPLE_SIZE, 0);
+  hedge_.sample_next = 0;
+  hedge_.sample_count = 0;
+  hedge_.delay_usec = conf_.hedge_max_delay_usec;
+
+  // circuit breakers are disabled until set_circuit_breaker() is called
+  circuit_breaker::default_config(conf_.breaker);
+  conf_.breaker.half_open_probes = 0;
+  conf_.metrics_latency = false;
 
   for (int i = 0; i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
     slots_[i].index = i;
@@ -146,6 +169,10 @@ HIREDIS_HAPP_API cluster::cluster() : slot_flag_(slot_status::INVALID) {
 HIREDIS_HAPP_API cluster::~cluster() {
   reset();
 
+  // cmds still in use will return to pool later, the pool will be destroyed after that
+  cmd_pool::release(cmd_pool_);
+  cmd_pool_ = nullptr;
+
   // log buffer
   if (nullptr != conf_.log_buffer) {
     free(conf_.log_buffer);
@@ -154,7 +181,7 @@ HIREDIS_HAPP_API cluster::~cluster() {
 }
 
 HIREDIS_HAPP_API int cluster::init(const std::string &ip, uint16_t port) {
-  connection::set_key(conf_.init_connection, ip, port);
+  conf_.init_connection = *nodes_.intern(ip, port);
 
   return error_code::REDIS_HAPP_OK;
 }
@@ -208,35 +235,29 @@ HIREDIS_HAPP_API int cluster::reset() {
   for (int i = 0; i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
     slots_[i].hosts.clear();
   }
+  slot_views_.clear();
+  publish_slot_map();
 
   // release timer pending list
-  while (!timer_actions_.timer_pending.empty()) {
-    cmd_t *cmd = timer_actions_.timer_pending.front().cmd;
-    timer_actions_.timer_pending.pop_front();
+  timer_actions_.timer_pending.flush();
+  for (timer_node *node = timer_actions_.timer_pending.pop_expired(); nullptr != node;
+       node = timer_actions_.timer_pending.pop_expired()) {
+    cmd_t *cmd = reinterpret_cast<cmd_t *>(node->data);
 
     call_cmd(cmd, error_code::REDIS_HAPP_TIMEOUT, nullptr, nullptr);
     destroy_cmd(cmd);
   }
 
-  // connection timeout
-  // while(!timer_actions_.timer_conns.empty()) {
-  //    timer_t::conn_timetout_t& conn_expire = timer_actions_.timer_conns.front();
-
-  //    connection_t* conn = get_connection(conn_expire.name);
-  //    if (nullptr != conn && conn->get_sequence() == conn_expire.sequence) {
-  //        // if connection is in callback_ mode, the cmds in it will not finish
-  //        // so the connection can not be released right now
-  //        // this will be released after callback_ in disconnect event
-  //        if (!(conn->get_context()->c.flags & REDIS_IN_CALLBACK)) {
-  //            release_connection(conn->get_key(), true, error_code::REDIS_HAPP_TIMEOUT);
-  //        }
-  //    }
-
-  //    timer_actions_.timer_conns.pop_front();
-  //}
-
   // all connections_ are marked disconnection or disconnected, so timeout timers are useless
-  timer_actions_.timer_conns.clear();
+  timer_actions_.timer_conns.flush();
+  while (nullptr != timer_actions_.timer_conns.pop_expired()) {
+  }
+
+  // do not send hedge any more, hedge states will be released when their cmds finished
+  timer_actions_.timer_hedges.flush();
+  while (nullptr != timer_actions_.timer_hedges.pop_expired()) {
+  }
+  hedge_.readonly_conns.clear();
   timer_actions_.last_update_sec = 0;
   timer_actions_.last_update_usec = 0;
 
@@ -269,6 +290,28 @@ HIREDIS_HAPP_API cluster::cmd_t *cluster::exec(const char *key, size_t ks, cmd_t
   return exec(key, ks, cmd);
 }
 
+HIREDIS_HAPP_API cluster::cmd_t *cluster::exec_reference(const char *key, size_t ks, cmd_t::callback_fn_t cbk,
+                                                         void *priv_data, int argc, const char **argv,
+                                                         const size_t *argvlen, cmd_t::release_fn_t release_fn,
+                                                         void *release_data) {
+  cmd_t *cmd = create_cmd(cbk, priv_data);
+  if (nullptr == cmd) {
+    if (nullptr != release_fn) {
+      release_fn(release_data);
+    }
+    return nullptr;
+  }
+
+  int64_t len = cmd->vformat_reference(argc, argv, argvlen, release_fn, release_data);
+  if (len <= 0) {
+    log_info("format cmd with argc=%d failed", argc);
+    destroy_cmd(cmd);
+    return nullptr;
+  }
+
+  return exec(key, ks, cmd);
+}
+
 HIREDIS_HAPP_API cluster::cmd_t *cluster::exec(const char *key, size_t ks, cmd_t::callback_fn_t cbk, void *priv_data,
                                                const char *fmt, ...) {
   cmd_t *cmd = create_cmd(cbk, priv_data);
@@ -311,14 +354,17 @@ HIREDIS_HAPP_API cluster::cmd_t *cluster::exec(const char *key, size_t ks, cmd_t
     return nullptr;
   }
 
+  cmd->metrics_ = &metrics_;
+
   // calculate the slot index
   if (nullptr != key && 0 != ks) {
-    cmd->engine_.slot = detail::hash_slot(key, ks);
+    cmd->engine_.slot = hash_slot(key, ks);
   }
 
   // ttl_ pre-judge
   if (0 == cmd->ttl_) {
     log_debug("cmd %p at slot %d ttl_ expired", cmd, cmd->engine_.slot);
+    ++metrics_.get_counters().ttl_exhausted;
     call_cmd(cmd, error_code::REDIS_HAPP_TTL, nullptr, nullptr);
     destroy_cmd(cmd);
     return nullptr;
@@ -344,15 +390,12 @@ HIREDIS_HAPP_API cluster::cmd_t *cluster::exec(const char *key, size_t ks, cmd_t
   }
 
   // move cmd into connection
-  connection_t *conn_inst = get_connection(conn_key->name);
-  if (nullptr == conn_inst) {
-    conn_inst = make_connection(*conn_key);
-  }
-
+  connection_t *conn_inst = get_or_make_connection(*conn_key);
   if (nullptr == conn_inst) {
     log_info("connect to %s failed", conn_key->name.c_str());
 
-    call_cmd(cmd, error_code::REDIS_HAPP_CONNECTION, nullptr, nullptr);
+    call_cmd(cmd, accept_node(*conn_key) ? error_code::REDIS_HAPP_CONNECTION : error_code::REDIS_HAPP_SLOT_UNAVAILABLE,
+             nullptr, nullptr);
     destroy_cmd(cmd);
 
     return nullptr;
@@ -366,9 +409,12 @@ HIREDIS_HAPP_API cluster::cmd_t *cluster::exec(connection_t *conn, cmd_t *cmd) {
     return nullptr;
   }
 
+  cmd->metrics_ = &metrics_;
+
   // ttl_
   if (0 == cmd->ttl_) {
     log_debug("cmd %p at slot %d ttl_ expired", cmd, cmd->engine_.slot);
+    ++metrics_.get_counters().ttl_exhausted;
     call_cmd(cmd, error_code::REDIS_HAPP_TTL, nullptr, nullptr);
     destroy_cmd(cmd);
     return nullptr;
@@ -383,6 +429,20 @@ HIREDIS_HAPP_API cluster::cmd_t *cluster::exec(connection_t *conn, cmd_t *cmd) {
     return nullptr;
   }
 
+  // fail fast, do not send more requests to a overloaded node.
+  // CLUSTER SLOTS is always sent, or slots moved away from the node will never be known.
+  cmd->breaker_probe_ = false;
+  if (on_reply_update_slot != cmd->callback_ && !allow_request(conn, cmd->breaker_probe_)) {
+    log_debug("cmd %p at slot %d failed, circuit breaker of %s is open", cmd, cmd->engine_.slot,
+              conn->get_key().name.c_str());
+    call_cmd(cmd, error_code::REDIS_HAPP_CIRCUIT_OPEN, conn->get_context(), nullptr);
+    destroy_cmd(cmd);
+    return nullptr;
+  }
+
+  // cmd may be finished and destroyed in redis_cmd
+  cmd->sent_usec_ = conf_.metrics_latency ? detail::steady_now_usec() : 0;
+
   // main loop
   int res = conn->redis_cmd(cmd, on_reply_wrapper);
 
@@ -392,7 +452,7 @@ HIREDIS_HAPP_API cluster::cmd_t *cluster::exec(connection_t *conn, cmd_t *cmd) {
     // other situation should trigger error
     if (nullptr != context && (context->c.flags & (REDIS_DISCONNECTING | REDIS_FREEING))) {
       // remove the invalid connection, so this connection will not be selected next time.
-      remove_connection_key(conn->get_key().name);
+      remove_connection_key(conn->get_key().id);
 
       // Patch: hiredis will miss onDisconnect in some older version
       // If not in hiredis's callback_, REDIS_DISCONNECTING or REDIS_FREEING means resource is freed
@@ -414,6 +474,9 @@ HIREDIS_HAPP_API cluster::cmd_t *cluster::exec(connection_t *conn, cmd_t *cmd) {
     return nullptr;
   }
 
+  ++metrics_.get_counters().cmd_sent;
+  ++metrics_.mutable_node(conn->get_key()).cmd_sent;
+
   log_debug("exec cmd %p at slot %d, connection %s", cmd, cmd->engine_.slot, conn->get_key().name.c_str());
   return cmd;
 }
@@ -423,6 +486,11 @@ HIREDIS_HAPP_API cluster::cmd_t *cluster::retry(cmd_t *cmd, connection_t *conn)
     return nullptr;
   }
 
+  ++metrics_.get_counters().retries;
+  return reschedule(cmd, conn);
+}
+
+cluster::cmd_t *cluster::reschedule(cmd_t *cmd, connection_t *conn) {
   // First, retry immediately for several times.
   if (false == is_timer_active() || cmd->ttl_ > HIREDIS_HAPP_TTL / 2) {
     if (nullptr == conn) {
@@ -446,6 +514,126 @@ HIREDIS_HAPP_API cluster::cmd_t *cluster::retry(cmd_t *cmd, connection_t *conn)
   return cmd;
 }
 
+HIREDIS_HAPP_API cluster::cmd_t *cluster::exec_hedged(const char *key, size_t ks, cmd_t::callback_fn_t cbk,
+                                                      void *priv_data, int argc, const char **argv,
+                                                      const size_t *argvlen) {
+  cmd_t *cmd = create_cmd(cbk, priv_data);
+  if (nullptr == cmd) {
+    return nullptr;
+  }
+
+  int64_t len = cmd->vformat(argc, argv, argvlen);
+  if (len <= 0) {
+    log_info("format cmd with argc=%d failed", argc);
+    destroy_cmd(cmd);
+    return nullptr;
+  }
+
+  return exec_hedged(key, ks, cmd);
+}
+
+HIREDIS_HAPP_API cluster::cmd_t *cluster::exec_hedged(const char *key, size_t ks, cmd_t::callback_fn_t cbk,
+                                                      void *priv_data, const char *fmt, ...) {
+  cmd_t *cmd = create_cmd(cbk, priv_data);
+  if (nullptr == cmd) {
+    return nullptr;
+  }
+
+  va_list ap;
+  va_start(ap, fmt);
+  int len = cmd->vformat(fmt, ap);
+  va_end(ap);
+  if (len <= 0) {
+    log_info("format cmd with format=%s failed", fmt);
+    destroy_cmd(cmd);
+    return nullptr;
+  }
+
+  return exec_hedged(key, ks, cmd);
+}
+
+HIREDIS_HAPP_API cluster::cmd_t *cluster::exec_hedged(const char *key, size_t ks, cmd_t *cmd) {
+  if (nullptr == cmd) {
+    return nullptr;
+  }
+
+  // elements of streamed replies can not be delivered twice, and the visitor needs the private data of cmd
+  // callable callbacks live in buffer() and can not be copied into the hedge cmd
+  if (nullptr != cmd->stream_fn_ || nullptr != cmd->callable_destroy_) {
+    return exec(key, ks, cmd);
+  }
+
+  hedge_t *hedge = new (std::nothrow) hedge_t();
+  if (nullptr == hedge) {
+    return exec(key, ks, cmd);
+  }
+
+  hedge->callback = cmd->callback_;
+  hedge->private_data = cmd->private_data_;
+  hedge->primary = cmd;
+  hedge->secondary = nullptr;
+  hedge->pending = 1;
+  hedge->done = false;
+  hedge->slot = hash_slot(key, ks);
+  hedge->start_usec = detail::steady_now_usec();
+  memset(&hedge->timer, 0, sizeof(hedge->timer));
+
+  cmd->callback_ = on_reply_hedge;
+  cmd->private_data_ = hedge;
+  ++hedge_.stats.requests;
+
+  // hedge timer can only work when timer is active and the slot has replicas
+  if (hedge->slot >= 0 && is_timer_active() && slot_status::OK == slot_flag_ &&
+      slots_[hedge->slot].hosts.size() > 1) {
+    time_t delay_usec = get_hedge_delay();
+    timer_wheel::tick_t delay_tick = static_cast<timer_wheel::tick_t>((delay_usec + 999) / 1000);
+    timer_actions_.timer_hedges.add(
+        &hedge->timer,
+        timer_wheel::make_tick(timer_actions_.last_update_sec, timer_actions_.last_update_usec) +
+            (delay_tick > 0 ? delay_tick : 1),
+        hedge);
+  }
+
+  // the hedge state may be destroyed here if the primary cmd failed immediately
+  return exec(key, ks, cmd);
+}
+
+HIREDIS_HAPP_API int cluster::exec_broadcast(cmd_t::callback_fn_t cbk, void *priv_data, int argc, const char **argv,
+                                             const size_t *argvlen) {
+  cmd_t *cmd = create_cmd(cbk, priv_data);
+  if (nullptr == cmd) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  int64_t len = cmd->vformat(argc, argv, argvlen);
+  if (len <= 0) {
+    log_info("format cmd with argc=%d failed", argc);
+    destroy_cmd(cmd);
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  return broadcast_cmd(cmd);
+}
+
+HIREDIS_HAPP_API int cluster::exec_broadcast(cmd_t::callback_fn_t cbk, void *priv_data, const char *fmt, ...) {
+  cmd_t *cmd = create_cmd(cbk, priv_data);
+  if (nullptr == cmd) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  va_list ap;
+  va_start(ap, fmt);
+  int len = cmd->vformat(fmt, ap);
+  va_end(ap);
+  if (len <= 0) {
+    log_info("format cmd with format=%s failed", fmt);
+    destroy_cmd(cmd);
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  return broadcast_cmd(cmd);
+}
+
 HIREDIS_HAPP_API bool cluster::reload_slots() {
   if (slot_status::UPDATING == slot_flag_) {
     return false;
@@ -456,11 +644,7 @@ HIREDIS_HAPP_API bool cluster::reload_slots() {
     return false;
   }
 
-  connection_t *conn = get_connection(conn_key->name);
-  if (nullptr == conn) {
-    conn = make_connection(*conn_key);
-  }
-
+  connection_t *conn = get_or_make_connection(*conn_key);
   if (nullptr == conn) {
     return false;
   }
@@ -481,6 +665,7 @@ HIREDIS_HAPP_API bool cluster::reload_slots() {
 
   if (nullptr != exec(conn, cmd)) {
     slot_flag_ = slot_status::UPDATING;
+    ++metrics_.get_counters().slot_reloads;
   }
 
   return true;
@@ -488,7 +673,7 @@ HIREDIS_HAPP_API bool cluster::reload_slots() {
 
 HIREDIS_HAPP_API const connection::key_t *cluster::get_slot_master(int index) {
   if (index >= 0 && index < HIREDIS_HAPP_SLOT_NUMBER && !slots_[index].hosts.empty()) {
-    return &slots_[index].hosts.front();
+    return nodes_.get(slots_[index].hosts.front());
   }
 
   // random a address
@@ -497,19 +682,136 @@ HIREDIS_HAPP_API const connection::key_t *cluster::get_slot_master(int index) {
     return &conf_.init_connection;
   }
 
-  return &slots_[index].hosts.front();
+  const connection::key_t *ret = nodes_.get(slots_[index].hosts.front());
+  if (!callbacks_.connection_filter || nullptr == ret || accept_node(*ret)) {
+    return ret;
+  }
+
+  // find a master accepted by the connection filter after the random slot, continuous slots mostly share a master
+  connection::node_id_t refused = ret->id;
+  for (int i = 1; i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
+    const slot_entry_t &slot = slots_[(index + i) % HIREDIS_HAPP_SLOT_NUMBER];
+    if (slot.hosts.empty() || slot.hosts.front() == refused) {
+      continue;
+    }
+
+    const connection::key_t *other = nodes_.get(slot.hosts.front());
+    if (nullptr != other && accept_node(*other)) {
+      return other;
+    }
+    refused = slot.hosts.front();
+  }
+
+  return &conf_.init_connection;
 }
 
 HIREDIS_HAPP_API const cluster::slot_t *cluster::get_slot_by_key(const char *key, size_t ks) const {
-  int index = detail::hash_slot(key, ks);
+  int index = hash_slot(key, ks);
   if (index < 0) {
     return nullptr;
   }
-  return &slots_[index];
+
+  slot_t &ret = slot_views_[index];
+  ret.index = index;
+  ret.hosts.clear();
+  ret.hosts.reserve(slots_[index].hosts.size());
+  for (size_t i = 0; i < slots_[index].hosts.size(); ++i) {
+    const connection::key_t *node = nodes_.get(slots_[index].hosts[i]);
+    if (nullptr != node) {
+      ret.hosts.push_back(*node);
+    }
+  }
+  return &ret;
+}
+
+HIREDIS_HAPP_API bool cluster::parse_redirect(const char *msg, int &slot_index, std::string &ip, uint16_t &port) {
+  if (nullptr == msg) {
+    return false;
+  }
+
+  char *addr = nullptr;
+  long slot = strtol(msg, &addr, 10);
+  if (addr == msg) {
+    return false;
+  }
+  slot_index = static_cast<int>(slot);
+
+  // the address is not copied into a fixed buffer, the reply may be any length
+  while (' ' == *addr) {
+    ++addr;
+  }
+  const char *addr_end = addr;
+  while ('\0' != *addr_end && ' ' != *addr_end && '\r' != *addr_end && '\n' != *addr_end) {
+    ++addr_end;
+  }
+  return connection::pick_name(std::string(addr, static_cast<size_t>(addr_end - addr)), ip, port);
+}
+
+HIREDIS_HAPP_API slot_map_ref cluster::get_slot_map() const { return slot_map_.acquire(); }
+
+HIREDIS_HAPP_API size_t cluster::get_slot_ranges(std::vector<slot_range_t> &out) const {
+  size_t ret = 0;
+  for (int i = 0; i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
+    if (slots_[i].hosts.empty()) {
+      continue;
+    }
+
+    // slots of the same hosts are usually continuous
+    int end = i;
+    while (end + 1 < HIREDIS_HAPP_SLOT_NUMBER && slots_[end + 1].hosts == slots_[i].hosts) {
+      ++end;
+    }
+
+    out.push_back(slot_range_t());
+    slot_range_t &range = out.back();
+    range.start = i;
+    range.end = end;
+    range.hosts.reserve(slots_[i].hosts.size());
+    for (size_t j = 0; j < slots_[i].hosts.size(); ++j) {
+      range.hosts.push_back(*nodes_.get(slots_[i].hosts[j]));
+    }
+
+    ++ret;
+    i = end;
+  }
+
+  return ret;
+}
+
+HIREDIS_HAPP_API int cluster::update_slots(const std::vector<slot_range_t> &ranges) {
+  if (ranges.empty()) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  for (int i = 0; i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
+    slots_[i].hosts.clear();
+  }
+
+  std::vector<connection::node_id_t> hosts;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    int si = ranges[i].start < 0 ? 0 : ranges[i].start;
+    int ei = ranges[i].end >= HIREDIS_HAPP_SLOT_NUMBER ? HIREDIS_HAPP_SLOT_NUMBER - 1 : ranges[i].end;
+    if (si > ei) {
+      continue;
+    }
+
+    hosts.clear();
+    for (size_t j = 0; j < ranges[i].hosts.size(); ++j) {
+      hosts.push_back(nodes_.intern(ranges[i].hosts[j])->id);
+    }
+
+    for (; si <= ei; ++si) {
+      slots_[si].hosts = hosts;
+    }
+  }
+
+  log_info("update %d slots_ from ranges done", static_cast<int>(ranges.size()));
+  finish_slot_update();
+  return error_code::REDIS_HAPP_OK;
 }
 
 HIREDIS_HAPP_API const cluster::connection_t *cluster::get_connection(const std::string &key) const {
-  connection_map_t::const_iterator it = connections_.find(key);
+  connection_map_t::const_iterator it = connections_.find(nodes_.find(key));
   if (it == connections_.end()) {
     return nullptr;
   }
@@ -518,7 +820,11 @@ HIREDIS_HAPP_API const cluster::connection_t *cluster::get_connection(const std:
 }
 
 HIREDIS_HAPP_API cluster::connection_t *cluster::get_connection(const std::string &key) {
-  connection_map_t::iterator it = connections_.find(key);
+  return get_connection_by_id(nodes_.find(key));
+}
+
+HIREDIS_HAPP_API const cluster::connection_t *cluster::get_connection(const std::string &ip, uint16_t port) const {
+  connection_map_t::const_iterator it = connections_.find(nodes_.find(ip, port));
   if (it == connections_.end()) {
     return nullptr;
   }
@@ -526,22 +832,25 @@ HIREDIS_HAPP_API cluster::connection_t *cluster::get_connection(const std::strin
   return it->second.get();
 }
 
-HIREDIS_HAPP_API const cluster::connection_t *cluster::get_connection(const std::string &ip, uint16_t port) const {
-  return get_connection(connection::make_name(ip, port));
-}
-
 HIREDIS_HAPP_API cluster::connection_t *cluster::get_connection(const std::string &ip, uint16_t port) {
-  return get_connection(connection::make_name(ip, port));
+  return get_connection_by_id(nodes_.find(ip, port));
 }
 
-HIREDIS_HAPP_API cluster::connection_t *cluster::make_connection(const connection::key_t &key) {
+HIREDIS_HAPP_API cluster::connection_t *cluster::make_connection(const connection::key_t &input_key) {
   holder_t h;
-  connection_map_t::iterator check_it = connections_.find(key.name);
+  // connections always use the interned key, so they can be found by id
+  const connection::key_t &key = *nodes_.intern(input_key);
+  connection_map_t::iterator check_it = connections_.find(key.id);
   if (check_it != connections_.end()) {
     log_debug("connection %s already exists", key.name.c_str());
     return nullptr;
   }
 
+  if (!accept_node(key)) {
+    log_debug("connection %s is refused by connection filter", key.name.c_str());
+    return nullptr;
+  }
+
   redisAsyncContext *c = redisAsyncConnect(key.ip.c_str(), static_cast<int>(key.port));
   if (nullptr == c || c->err) {
     log_info("redis connect to %s failed, msg: %s", key.name.c_str(), nullptr == c ? detail::NONE_MSG : c->errstr);
@@ -561,9 +870,17 @@ HIREDIS_HAPP_API cluster::connection_t *cluster::make_connection(const connectio
     redisSetTimeout(&c->c, tv);
   }
 
+  if (conf_.reply_stream) {
+    if (nullptr == reply_stream::attach(c, on_reply_wrapper)) {
+      log_info("enable reply stream of %s failed, stream visitors of cmds will not be called", key.name.c_str());
+    }
+  } else if (conf_.reply_arena_chunk_size > 0 && nullptr == reply_arena::attach(c, conf_.reply_arena_chunk_size)) {
+    log_info("enable reply arena of %s failed, use default reply functions of hiredis", key.name.c_str());
+  }
+
   std::unique_ptr<connection_t> ret_ptr(new connection_t());
   connection_t &ret = *ret_ptr;
-  swap(connections_[key.name], ret_ptr);
+  swap(connections_[key.id], ret_ptr);
   ret.init(h, key);
   ret.set_connecting(c);
 
@@ -571,11 +888,9 @@ HIREDIS_HAPP_API cluster::connection_t *cluster::make_connection(const connectio
 
   // timeout timer
   if (conf_.timer_timeout_sec > 0 && is_timer_active()) {
-    timer_actions_.timer_conns.push_back(timer_t::conn_timetout_t());
-    timer_t::conn_timetout_t &conn_expire = timer_actions_.timer_conns.back();
-    conn_expire.name = key.name;
-    conn_expire.sequence = ret.get_sequence();
-    conn_expire.timeout = timer_actions_.last_update_sec + conf_.timer_timeout_sec;
+    timer_actions_.timer_conns.add(
+        &ret.get_connect_timer(),
+        timer_wheel::make_tick(timer_actions_.last_update_sec + conf_.timer_timeout_sec, 0), &ret);
   }
 
   // auth_ command
@@ -606,12 +921,19 @@ HIREDIS_HAPP_API cluster::connection_t *cluster::make_connection(const connectio
     callbacks_.on_connect(this, &ret);
   }
 
+  ++metrics_.get_counters().connects;
   log_debug("redis make connection to %s ", key.name.c_str());
   return &ret;
 }
 
 HIREDIS_HAPP_API bool cluster::release_connection(const connection::key_t &key, bool close_fd, int status) {
-  connection_map_t::iterator it = connections_.find(key.name);
+  // key may be made by the caller or another cluster, so the id is checked by name
+  connection::node_id_t id = key.id;
+  if (nullptr == nodes_.get(id) || nodes_.get(id)->name != key.name) {
+    id = nodes_.find(key.name);
+  }
+
+  connection_map_t::iterator it = connections_.find(id);
   if (connections_.end() == it) {
     log_debug("connection %s not found", key.name.c_str());
     return false;
@@ -653,6 +975,8 @@ HIREDIS_HAPP_API bool cluster::release_connection(const connection::key_t &key,
 
 HIREDIS_HAPP_API size_t cluster::get_connection_size() const { return connections_.size(); }
 
+HIREDIS_HAPP_API const node_registry &cluster::get_node_registry() const { return nodes_; }
+
 HIREDIS_HAPP_API cluster::onconnect_fn_t cluster::set_on_connect(onconnect_fn_t cbk) {
   using std::swap;
   swap(cbk, callbacks_.on_connect);
@@ -671,10 +995,36 @@ HIREDIS_HAPP_API cluster::ondisconnected_fn_t cluster::set_on_disconnected(ondis
   return cbk;
 }
 
+HIREDIS_HAPP_API cluster::onslotsupdated_fn_t cluster::set_on_slots_updated(onslotsupdated_fn_t cbk) {
+  using std::swap;
+  swap(cbk, callbacks_.on_slots_updated);
+  return cbk;
+}
+
+HIREDIS_HAPP_API cluster::connection_filter_fn_t cluster::set_connection_filter(connection_filter_fn_t cbk) {
+  using std::swap;
+  swap(cbk, callbacks_.connection_filter);
+  return cbk;
+}
+
 HIREDIS_HAPP_API void cluster::set_cmd_buffer_size(size_t s) { conf_.cmd_buffer_size = s; }
 
 HIREDIS_HAPP_API size_t cluster::get_cmd_buffer_size() const { return conf_.cmd_buffer_size; }
 
+HIREDIS_HAPP_API void cluster::set_reply_arena_chunk_size(size_t chunk_size) {
+  conf_.reply_arena_chunk_size = chunk_size;
+}
+
+HIREDIS_HAPP_API size_t cluster::get_reply_arena_chunk_size() const { return conf_.reply_arena_chunk_size; }
+
+HIREDIS_HAPP_API void cluster::set_reply_stream(bool enable) { conf_.reply_stream = enable; }
+
+HIREDIS_HAPP_API bool cluster::is_reply_stream_enabled() const { return conf_.reply_stream; }
+
+HIREDIS_HAPP_API cmd_pool *cluster::get_cmd_pool() { return cmd_pool_; }
+
+HIREDIS_HAPP_API const cmd_pool *cluster::get_cmd_pool() const { return cmd_pool_; }
+
 HIREDIS_HAPP_API bool cluster::is_timer_available() const {
   return conf_.timer_interval_sec > 0 || conf_.timer_interval_usec > 0;
 }
@@ -690,6 +1040,69 @@ HIREDIS_HAPP_API void cluster::set_timer_interval(time_t sec, time_t usec) {
 
 HIREDIS_HAPP_API void cluster::set_timeout(time_t sec) { conf_.timer_timeout_sec = sec; }
 
+HIREDIS_HAPP_API void cluster::set_hedge_delay(time_t min_usec, time_t max_usec, int percentile) {
+  if (min_usec < 0) {
+    min_usec = 0;
+  }
+  if (max_usec < min_usec) {
+    max_usec = min_usec;
+  }
+  if (percentile <= 0 || percentile > 100) {
+    percentile = HIREDIS_HAPP_HEDGE_PERCENTILE;
+  }
+
+  conf_.hedge_min_delay_usec = min_usec;
+  conf_.hedge_max_delay_usec = max_usec;
+  conf_.hedge_percentile = percentile;
+
+  // recalculate with new configure
+  hedge_.delay_usec = max_usec;
+  if (hedge_.sample_count > 0) {
+    add_hedge_sample(-1);
+  }
+}
+
+HIREDIS_HAPP_API time_t cluster::get_hedge_delay() const { return hedge_.delay_usec; }
+
+HIREDIS_HAPP_API const cluster::hedge_stats_t &cluster::get_hedge_stats() const { return hedge_.stats; }
+
+HIREDIS_HAPP_API void cluster::set_circuit_breaker(const circuit_breaker::config_t &conf) { conf_.breaker = conf; }
+
+HIREDIS_HAPP_API const circuit_breaker::config_t &cluster::get_circuit_breaker_config() const {
+  return conf_.breaker;
+}
+
+HIREDIS_HAPP_API const circuit_breaker *cluster::get_circuit_breaker(const std::string &key) const {
+  HIREDIS_HAPP_MAP(connection::node_id_t, circuit_breaker)::const_iterator iter = breakers_.find(nodes_.find(key));
+  if (breakers_.end() == iter) {
+    return nullptr;
+  }
+
+  return &iter->second;
+}
+
+HIREDIS_HAPP_API void cluster::set_latency_metrics(bool enable) { conf_.metrics_latency = enable; }
+
+HIREDIS_HAPP_API bool cluster::is_latency_metrics_enabled() const { return conf_.metrics_latency; }
+
+HIREDIS_HAPP_API const metrics &cluster::get_metrics() const { return metrics_; }
+
+HIREDIS_HAPP_API void cluster::snapshot_metrics(metrics::snapshot_t &out) const {
+  out.counters = metrics_.get_counters();
+
+  out.gauges.in_flight = 0;
+  for (connection_map_t::const_iterator iter = connections_.begin(); iter != connections_.end(); ++iter) {
+    out.gauges.in_flight += iter->second->get_pending_count();
+  }
+  out.gauges.slot_pending = slot_pending_.size();
+  out.gauges.timer_pending = timer_actions_.timer_pending.size();
+  out.gauges.connections = connections_.size();
+
+  metrics_.get_nodes(out.nodes);
+}
+
+HIREDIS_HAPP_API void cluster::reset_metrics() { metrics_.reset(); }
+
 HIREDIS_HAPP_API void cluster::add_timer_cmd(cmd_t *cmd) {
   if (nullptr == cmd) {
     return;
@@ -703,11 +1116,11 @@ HIREDIS_HAPP_API void cluster::add_timer_cmd(cmd_t *cmd) {
   }
 
   if (is_timer_active()) {
-    timer_actions_.timer_pending.push_back(timer_t::delay_t());
-    timer_t::delay_t &d = timer_actions_.timer_pending.back();
-    d.sec = timer_actions_.last_update_sec + conf_.timer_interval_sec;
-    d.usec = timer_actions_.last_update_usec + conf_.timer_interval_usec;
-    d.cmd = cmd;
+    timer_actions_.timer_pending.add(
+        &cmd->timer_,
+        timer_wheel::make_tick(timer_actions_.last_update_sec + conf_.timer_interval_sec,
+                               timer_actions_.last_update_usec + conf_.timer_interval_usec),
+        cmd);
   } else {
     exec(nullptr, 0, cmd);
   }
@@ -716,40 +1129,55 @@ HIREDIS_HAPP_API void cluster::add_timer_cmd(cmd_t *cmd) {
 HIREDIS_HAPP_API int cluster::proc(time_t sec, time_t usec) {
   int ret = 0;
 
+  // tasks from other threads, the wakeup fd or function may be not used
+  submit_queue_.drain(HIREDIS_HAPP_SUBMIT_BATCH_SIZE);
+
   timer_actions_.last_update_sec = sec;
   timer_actions_.last_update_usec = usec;
 
-  while (!timer_actions_.timer_pending.empty()) {
-    timer_t::delay_t &rd = timer_actions_.timer_pending.front();
-    if (rd.sec > sec || (rd.sec == sec && rd.usec > usec)) {
-      break;
-    }
+  // slots changed by MOVED replies or disconnections are published once a tick
+  if (slot_map_dirty_) {
+    publish_slot_map();
+  } else {
+    slot_map_.reclaim();
+  }
 
-    timer_t::delay_t d = rd;
-    timer_actions_.timer_pending.pop_front();
+  timer_wheel::tick_t now = timer_wheel::make_tick(sec, usec);
 
-    exec(nullptr, 0, d.cmd);
+  // retry cmds will be added with a later tick, so they will not be popped again in this round
+  timer_actions_.timer_pending.advance(now);
+  for (timer_node *node = timer_actions_.timer_pending.pop_expired(); nullptr != node;
+       node = timer_actions_.timer_pending.pop_expired()) {
+    exec(nullptr, 0, reinterpret_cast<cmd_t *>(node->data));
 
     ++ret;
   }
 
+  // hedged reads
+  timer_actions_.timer_hedges.advance(now);
+  for (timer_node *node = timer_actions_.timer_hedges.pop_expired(); nullptr != node;
+       node = timer_actions_.timer_hedges.pop_expired()) {
+    send_hedge(reinterpret_cast<hedge_t *>(node->data));
+  }
+
   // connection timeout
   // this can not be call in callback_
-  while (!timer_actions_.timer_conns.empty() && sec >= timer_actions_.timer_conns.front().timeout) {
-    timer_t::conn_timetout_t &conn_expire = timer_actions_.timer_conns.front();
-
-    connection_t *conn = get_connection(conn_expire.name);
-    if (nullptr != conn && conn->get_sequence() == conn_expire.sequence) {
-      assert(!(conn->get_context()->c.flags & REDIS_IN_CALLBACK));
-      release_connection(conn->get_key(), true, error_code::REDIS_HAPP_TIMEOUT);
-    }
-
-    timer_actions_.timer_conns.pop_front();
+  // connect_timer of connection will be removed after connected or released, so all nodes here are still connecting
+  timer_actions_.timer_conns.advance(now);
+  for (timer_node *node = timer_actions_.timer_conns.pop_expired(); nullptr != node;
+       node = timer_actions_.timer_conns.pop_expired()) {
+    connection_t *conn = reinterpret_cast<connection_t *>(node->data);
+    assert(!(conn->get_context()->c.flags & REDIS_IN_CALLBACK));
+    // network errors are not of any request, they always count
+    on_node_failure(conn, true);
+    release_connection(conn->get_key(), true, error_code::REDIS_HAPP_TIMEOUT);
   }
 
   return ret;
 }
 
+HIREDIS_HAPP_API submit_queue &cluster::get_submit_queue() { return submit_queue_; }
+
 HIREDIS_HAPP_API void cluster::set_log_writer(log_fn_t info_fn, log_fn_t debug_fn, size_t max_size) {
   using std::swap;
   conf_.log_fn_info = info_fn;
@@ -764,10 +1192,119 @@ HIREDIS_HAPP_API void cluster::set_log_writer(log_fn_t info_fn, log_fn_t debug_f
 
 HIREDIS_HAPP_API const cluster::timer_t &cluster::get_timer_actions() const { return timer_actions_; }
 
+HIREDIS_HAPP_API cluster::cmd_t *cluster::exec_callable(const char *key, size_t ks, cmd_t *cmd, int argc,
+                                                        const char **argv, const size_t *argvlen) {
+  if (nullptr == cmd) {
+    return nullptr;
+  }
+
+  int64_t len = cmd->vformat(argc, argv, argvlen);
+  if (len <= 0) {
+    log_info("format cmd with argc=%d failed", argc);
+    destroy_cmd(cmd);
+    return nullptr;
+  }
+
+  return exec(key, ks, cmd);
+}
+
+HIREDIS_HAPP_API cluster::cmd_t *cluster::exec_callable(const char *key, size_t ks, cmd_t *cmd, const char *fmt,
+                                                        va_list ap) {
+  if (nullptr == cmd) {
+    return nullptr;
+  }
+
+  int len = cmd->vformat(fmt, ap);
+  if (len <= 0) {
+    log_info("format cmd with format=%s failed", fmt);
+    destroy_cmd(cmd);
+    return nullptr;
+  }
+
+  return exec(key, ks, cmd);
+}
+
+HIREDIS_HAPP_API cluster::cmd_t *cluster::exec_encoded(const char *key, size_t ks, cmd_t *cmd, int64_t len) {
+  if (nullptr == cmd) {
+    return nullptr;
+  }
+
+  if (len <= 0) {
+    log_info("format cmd with typed arguments failed, res: %lld", static_cast<long long>(len));
+    destroy_cmd(cmd);
+    return nullptr;
+  }
+
+  return exec(key, ks, cmd);
+}
+
+HIREDIS_HAPP_API int cluster::broadcast_cmd(cmd_t *cmd) {
+  // slots of the same master are usually continuous, and node ids are dense
+  std::vector<connection::node_id_t> masters;
+  std::vector<bool> master_flags;
+  if (slot_status::OK == slot_flag_) {
+    master_flags.resize(nodes_.size() + 1, false);
+    for (int i = 0; i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
+      if (slots_[i].hosts.empty()) {
+        continue;
+      }
+
+      connection::node_id_t id = slots_[i].hosts.front();
+      if ((masters.empty() || masters.back() != id) && !master_flags[id]) {
+        master_flags[id] = true;
+        masters.push_back(id);
+      }
+    }
+  }
+
+  if (masters.empty()) {
+    log_info("broadcast cmd %p failed, slots are not available", cmd);
+    call_cmd(cmd, error_code::REDIS_HAPP_SLOT_UNAVAILABLE, nullptr, nullptr);
+    destroy_cmd(cmd);
+    return error_code::REDIS_HAPP_SLOT_UNAVAILABLE;
+  }
+
+  // create all cmds before sending, the first one may be destroyed if it failed immediately
+  std::vector<cmd_t *> cmds;
+  cmds.reserve(masters.size());
+  cmds.push_back(cmd);
+  for (size_t i = 1; i < masters.size(); ++i) {
+    cmd_t *other = create_cmd(cmd->callback_, cmd->private_data_);
+    if (nullptr == other) {
+      break;
+    }
+
+    if (other->share_content(cmd) <= 0) {
+      destroy_cmd(other);
+      break;
+    }
+    cmds.push_back(other);
+  }
+
+  if (cmds.size() < masters.size()) {
+    log_info("broadcast cmd %p to %d of %d masters, create cmd failed", cmd, static_cast<int>(cmds.size()),
+             static_cast<int>(masters.size()));
+  }
+
+  int ret = 0;
+  for (size_t i = 0; i < cmds.size(); ++i) {
+    connection_t *conn = get_or_make_connection(*nodes_.get(masters[i]));
+
+    // never retry or redirect to other nodes
+    cmds[i]->engine_.slot = -1;
+    cmds[i]->ttl_ = 1;
+    if (nullptr != exec(conn, cmds[i])) {
+      ++ret;
+    }
+  }
+
+  return ret > 0 ? ret : error_code::REDIS_HAPP_CONNECTION;
+}
+
 HIREDIS_HAPP_API cluster::cmd_t *cluster::create_cmd(cmd_t::callback_fn_t cbk, void *pridata) {
   holder_t h;
   h.clu = this;
-  cmd_t *ret = cmd_t::create(h, cbk, pridata, conf_.cmd_buffer_size);
+  cmd_t *ret = cmd_t::create(cmd_pool_, h, cbk, pridata, conf_.cmd_buffer_size);
   return ret;
 }
 
@@ -796,6 +1333,11 @@ HIREDIS_HAPP_API int cluster::call_cmd(cmd_t *c, int err, redisAsyncContext *con
 
 void cluster::on_reply_wrapper(redisAsyncContext *c, void *r, void *privdata) {
   connection_t *conn = reinterpret_cast<connection_t *>(c->data);
+  // connection is released, and cmd is already finished by it
+  if (nullptr == conn) {
+    return;
+  }
+
   cmd_t *cmd = reinterpret_cast<cmd_t *>(privdata);
   cluster *self = cmd->holder_.clu;
 
@@ -810,6 +1352,7 @@ void cluster::on_reply_wrapper(redisAsyncContext *c, void *r, void *privdata) {
 
   if (REDIS_ERR_IO == c->err || REDIS_ERR_EOF == c->err) {
     self->log_debug("redis cmd %p reply context err %d and will retry, %s", cmd, c->err, c->errstr);
+    // failure of the node is recorded by on_disconnected_wrapper
     // retry if it's a network error
     conn->pop_reply(cmd);
     self->retry(cmd);
@@ -819,13 +1362,22 @@ void cluster::on_reply_wrapper(redisAsyncContext *c, void *r, void *privdata) {
   if (REDIS_OK != c->err || nullptr == r) {
     self->log_debug("redis cmd %p reply context err %d and abort, %s", cmd, c->err,
                     nullptr == c->errstr ? detail::NONE_MSG : c->errstr);
+    self->on_node_failure(conn, cmd->breaker_probe_);
     // other errors will be passed to caller
     conn->call_reply(cmd, r);
     return;
   }
 
+  self->add_node_reply(conn, cmd);
   redisReply *reply = reinterpret_cast<redisReply *>(r);
 
+  // MOVED, ASK and errors of user's cmd mean the node works well
+  if (REDIS_REPLY_ERROR == reply->type && nullptr != reply->str && detail::is_node_busy_error(reply->str)) {
+    self->on_node_failure(conn, cmd->breaker_probe_);
+  } else {
+    self->on_node_success(conn, cmd->breaker_probe_);
+  }
+
   // error handler
   if (REDIS_REPLY_ERROR == reply->type) {
     if (nullptr == reply->str) {
@@ -835,35 +1387,32 @@ void cluster::on_reply_wrapper(redisAsyncContext *c, void *r, void *privdata) {
     }
 
     int slot_index = 0;
-    char addr[260] = {0};
 
     // detect MOVED,ASK and CLUSTERDOWN
     if (0 == HIREDIS_HAPP_STRNCASE_CMP("ASK", reply->str, 3)) {
       self->log_debug("redis cmd %p %s", cmd, reply->str);
+      ++self->metrics_.get_counters().ask;
       // send ASK to another connection
-#if defined(_MSC_VER)
-      HIREDIS_HAPP_SSCANF(reply->str + 4, "%d %s", &slot_index, addr, static_cast<unsigned int>(sizeof(addr)));
-#else
-      HIREDIS_HAPP_SSCANF(reply->str + 4, "%d %s", &slot_index, addr);
-#endif
       std::string ip;
       uint16_t port;
-      if (connection::pick_name(addr, ip, port)) {
+      if (parse_redirect(reply->str + 4, slot_index, ip, port)) {
         if (ip.empty()) {
           ip = conn->get_key().ip;
         }
-        connection::key_t conn_key;
-        connection::set_key(conn_key, ip, port);
-
         // ASKING request
-        connection_t *ask_conn = self->get_connection(conn_key.name);
-        if (nullptr == ask_conn) {
-          ask_conn = self->make_connection(conn_key);
-        }
+        const connection::key_t &ask_key = *self->nodes_.intern(ip, port);
+        connection_t *ask_conn = self->get_or_make_connection(ask_key);
 
         // pop from old connection, and run it
         conn->pop_reply(cmd);
 
+        // the node is not served by this cluster, retrying will get ASK again
+        if (nullptr == ask_conn && !self->accept_node(ask_key)) {
+          self->call_cmd(cmd, error_code::REDIS_HAPP_SLOT_UNAVAILABLE, c, r);
+          self->destroy_cmd(cmd);
+          return;
+        }
+
         if (nullptr != ask_conn) {
           if (REDIS_OK == redisAsyncCommand(ask_conn->get_context(), on_reply_asking, cmd, "ASKING")) {
             return;
@@ -876,13 +1425,11 @@ void cluster::on_reply_wrapper(redisAsyncContext *c, void *r, void *privdata) {
       }
     } else if (0 == HIREDIS_HAPP_STRNCASE_CMP("MOVED", reply->str, 5)) {
       self->log_debug("redis cmd %p %s", cmd, reply->str);
+      ++self->metrics_.get_counters().moved;
 
-#if defined(_MSC_VER)
-      HIREDIS_HAPP_SSCANF(reply->str + 6, "%d %s", &slot_index, addr, static_cast<unsigned int>(sizeof(addr)));
-#else
-      HIREDIS_HAPP_SSCANF(reply->str + 6, "%d %s", &slot_index, addr);
-#endif
-
+      std::string ip;
+      uint16_t port;
+      bool addr_ok = parse_redirect(reply->str + 6, slot_index, ip, port);
       if (slot_index < 0 || slot_index >= HIREDIS_HAPP_SLOT_NUMBER) {
         self->log_info("cluster MOVED reply contains invalid slot: %d", slot_index);
         conn->call_reply(cmd, r);
@@ -894,16 +1441,14 @@ void cluster::on_reply_wrapper(redisAsyncContext *c, void *r, void *privdata) {
         cmd->engine_.slot = slot_index;
       }
 
-      std::string ip;
-      uint16_t port;
-      if (connection::pick_name(addr, ip, port)) {
+      if (addr_ok) {
         if (ip.empty()) {
           ip = conn->get_key().ip;
         }
         // update slot
         self->slots_[slot_index].hosts.clear();
-        self->slots_[slot_index].hosts.push_back(connection::key_t());
-        connection::set_key(self->slots_[slot_index].hosts.back(), ip, port);
+        self->slots_[slot_index].hosts.push_back(self->nodes_.intern(ip, port)->id);
+        self->slot_map_dirty_ = true;
 
         // retry
         conn->pop_reply(cmd);
@@ -922,6 +1467,7 @@ void cluster::on_reply_wrapper(redisAsyncContext *c, void *r, void *privdata) {
       }
     } else if (0 == HIREDIS_HAPP_STRNCASE_CMP("TRYAGAIN", reply->str, 8)) {
       self->log_debug("redis cmd %p %s", cmd, reply->str);
+      ++self->metrics_.get_counters().tryagain;
 
       // TRYAGAIN can be returned during resharding for multi-key operations. Keep the original
       // slot mapping and let the normal TTL/timer retry flow decide whether to retry immediately
@@ -931,6 +1477,7 @@ void cluster::on_reply_wrapper(redisAsyncContext *c, void *r, void *privdata) {
       return;
     } else if (0 == HIREDIS_HAPP_STRNCASE_CMP("CLUSTERDOWN", reply->str, 11)) {
       self->log_info("cluster down reset all connection, cmd and replys");
+      ++self->metrics_.get_counters().clusterdown;
       conn->call_reply(cmd, r);
       self->reset();
       return;
@@ -1000,7 +1547,7 @@ HIREDIS_HAPP_API void cluster::on_reply_update_slot(cmd_exec *cmd, redisAsyncCon
         continue;
       }
 
-      std::vector<connection::key_t> hosts;
+      std::vector<connection::node_id_t> hosts;
       for (size_t j = 2; j < slot_node->elements; ++j) {
         redisReply *addr = slot_node->element[j];
         // redis cluster may response a empty list when some error happened
@@ -1012,8 +1559,7 @@ HIREDIS_HAPP_API void cluster::on_reply_update_slot(cmd_exec *cmd, redisAsyncCon
             continue;
           }
 
-          hosts.push_back(connection::key_t());
-          connection::set_key(hosts.back(), ip, port);
+          hosts.push_back(self->nodes_.intern(ip, port)->id);
         }
       }
 
@@ -1021,7 +1567,7 @@ HIREDIS_HAPP_API void cluster::on_reply_update_slot(cmd_exec *cmd, redisAsyncCon
       if (nullptr != self->conf_.log_fn_debug && self->conf_.log_max_size > 0) {
         self->log_debug("slot update: [%lld-%lld]", si, ei);
         for (size_t j = 0; j < hosts.size(); ++j) {
-          self->log_debug(" -- %s", hosts[j].name.c_str());
+          self->log_debug(" -- %s", self->nodes_.get(hosts[j])->name.c_str());
         }
       }
       // copy for 16384 times
@@ -1031,16 +1577,11 @@ HIREDIS_HAPP_API void cluster::on_reply_update_slot(cmd_exec *cmd, redisAsyncCon
     }
   }
 
-  // set status first and then retry, or there will be a infinite loop
-  self->slot_flag_ = slot_status::OK;
-
   self->log_info("update %d slots_ done", static_cast<int>(reply->elements));
+  self->finish_slot_update();
 
-  // run pending list
-  while (!self->slot_pending_.empty()) {
-    cmd_t *first_cmd = self->slot_pending_.front();
-    self->slot_pending_.pop_front();
-    self->retry(first_cmd);
+  if (self->callbacks_.on_slots_updated) {
+    self->callbacks_.on_slots_updated(self);
   }
 }
 
@@ -1048,10 +1589,16 @@ void cluster::on_reply_asking(redisAsyncContext *c, void *r, void *privdata) {
   cmd_t *cmd = reinterpret_cast<cmd_t *>(privdata);
   redisReply *reply = reinterpret_cast<redisReply *>(r);
   connection_t *conn = reinterpret_cast<connection_t *>(c->data);
-  cluster *self = conn->get_holder().clu;
+  cluster *self = cmd->holder_.clu;
 
   // cmd in ask command is not in any connection
   // so there is no need to pop it, directly retry will be OK
+  if (nullptr == conn) {
+    self->log_debug("redis asking %p on a released connection and abort", cmd);
+    self->call_cmd(cmd, error_code::REDIS_HAPP_CONNECTION, nullptr, r);
+    self->destroy_cmd(cmd);
+    return;
+  }
 
   if (REDIS_ERR_IO == c->err || REDIS_ERR_EOF == c->err) {
     self->log_debug("redis asking err %d and will retry, %s", c->err, c->errstr);
@@ -1087,6 +1634,10 @@ void cluster::on_reply_asking(redisAsyncContext *c, void *r, void *privdata) {
 
 void cluster::on_connected_wrapper(struct redisAsyncContext *c, int status) {
   connection_t *conn = reinterpret_cast<connection_t *>(c->data);
+  if (nullptr == conn) {
+    return;
+  }
+
   cluster *self = conn->get_holder().clu;
 
   // hiredis bug, sometimes 0 == status but c is already closed
@@ -1102,6 +1653,8 @@ void cluster::on_connected_wrapper(struct redisAsyncContext *c, int status) {
   // failed, release resource
   if (REDIS_OK != status) {
     self->log_debug("connect to %s failed, status: %d, msg: %s", conn->get_key().name.c_str(), status, c->errstr);
+    ++self->metrics_.get_counters().connect_failures;
+    self->on_node_failure(conn, true);
     self->release_connection(conn->get_key(), false, status);
 
     // update slots_ if connect failed
@@ -1125,11 +1678,19 @@ void cluster::on_connected_wrapper(struct redisAsyncContext *c, int status) {
 
 void cluster::on_disconnected_wrapper(const struct redisAsyncContext *c, int status) {
   connection_t *conn = reinterpret_cast<connection_t *>(c->data);
+  // already released
+  if (nullptr == conn) {
+    return;
+  }
+
   cluster *self = conn->get_holder().clu;
+  ++self->metrics_.get_counters().disconnects;
 
   // We should update slots_ on next cmd if there is any connection disconnected
   if (REDIS_OK != status) {
-    self->remove_connection_key(conn->get_key().name);
+    // pending cmds get nullptr replies in REDIS_DISCONNECTING state, so network errors are recorded here
+    self->on_node_failure(conn, true);
+    self->remove_connection_key(conn->get_key().id);
   }
 
   // release resource
@@ -1179,22 +1740,288 @@ void cluster::on_reply_auth(cmd_exec *cmd, redisAsyncContext *rctx, void *r, voi
   }
 }
 
-void cluster::remove_connection_key(const std::string &name) {
+void cluster::on_reply_hedge(cmd_exec *cmd, redisAsyncContext *c, void *r, void *privdata) {
+  hedge_t *hedge = reinterpret_cast<hedge_t *>(privdata);
+  cluster *self = cmd->holder_.clu;
+  bool is_primary = cmd == hedge->primary;
+  if (is_primary) {
+    hedge->primary = nullptr;
+  } else if (cmd == hedge->secondary) {
+    hedge->secondary = nullptr;
+  }
+  --hedge->pending;
+
+  bool success = error_code::REDIS_HAPP_OK == cmd->result() && nullptr != r;
+  if (success && is_primary) {
+    self->add_hedge_sample(detail::steady_now_usec() - hedge->start_usec);
+  }
+
+  if (hedge->done) {
+    // duplicated reply, just drop it
+    ++self->hedge_.stats.discarded;
+  } else if (success || hedge->pending <= 0) {
+    // the first successful reply or the last failed one
+    hedge->done = true;
+    timer_wheel::remove(&hedge->timer);
+
+    if (success) {
+      if (is_primary) {
+        ++self->hedge_.stats.primary_wins;
+      } else {
+        ++self->hedge_.stats.hedge_wins;
+      }
+    }
+
+    cmd->private_data_ = hedge->private_data;
+    if (nullptr != hedge->callback) {
+      hedge->callback(cmd, c, r, hedge->private_data);
+    }
+  }
+
+  if (hedge->pending <= 0) {
+    self->destroy_hedge(hedge);
+  }
+}
+
+void cluster::send_hedge(hedge_t *hedge) {
+  if (nullptr == hedge || hedge->done || nullptr == hedge->primary) {
+    return;
+  }
+
+  if (hedge->slot < 0 || hedge->slot >= HIREDIS_HAPP_SLOT_NUMBER || slots_[hedge->slot].hosts.size() <= 1) {
+    return;
+  }
+
+  // pick a random replica
+  const std::vector<connection::node_id_t> &hosts = slots_[hedge->slot].hosts;
+  const connection::key_t &replica_key =
+      *nodes_.get(hosts[1 + static_cast<size_t>(detail::random() & 0x7FFFFFFF) % (hosts.size() - 1)]);
+
+  connection_t *conn = get_or_make_connection(replica_key);
+
+  if (nullptr == conn || nullptr == conn->get_context()) {
+    log_debug("hedge of cmd %p skipped, connect to %s failed", hedge->primary, replica_key.name.c_str());
+    return;
+  }
+
+  // replicas redirect all requests to master unless READONLY is set on the connection
+  uint64_t &readonly_seq = hedge_.readonly_conns[replica_key.id];
+  if (readonly_seq != conn->get_sequence()) {
+    if (REDIS_OK != conn->redis_raw_cmd(nullptr, nullptr, "READONLY")) {
+      log_debug("hedge of cmd %p skipped, send READONLY to %s failed", hedge->primary, replica_key.name.c_str());
+      return;
+    }
+    readonly_seq = conn->get_sequence();
+  }
+
+  cmd_t *cmd = create_cmd(on_reply_hedge, hedge);
+  if (nullptr == cmd) {
+    return;
+  }
+
+  // the same bytes are sent to the replica, and referenced arguments of primary cmd are released when it's shared
+  if (cmd->share_content(hedge->primary) <= 0) {
+    destroy_cmd(cmd);
+    return;
+  }
+
+  size_t buffer_len =
+      hedge->primary->buffer_len_ < cmd->buffer_len_ ? hedge->primary->buffer_len_ : cmd->buffer_len_;
+  if (buffer_len > 0) {
+    memcpy(cmd->buffer(), hedge->primary->buffer(), buffer_len);
+  }
+
+  // hedge cmd never retry
+  cmd->engine_.slot = hedge->slot;
+  cmd->ttl_ = 1;
+
+  hedge->secondary = cmd;
+  ++hedge->pending;
+  ++hedge_.stats.hedge_sent;
+
+  log_debug("send hedge cmd %p of %p to %s", cmd, hedge->primary, replica_key.name.c_str());
+  exec(conn, cmd);
+}
+
+void cluster::destroy_hedge(hedge_t *hedge) {
+  if (nullptr == hedge) {
+    return;
+  }
+
+  timer_wheel::remove(&hedge->timer);
+  delete hedge;
+}
+
+void cluster::add_hedge_sample(time_t latency_usec) {
+  if (hedge_.samples.empty()) {
+    return;
+  }
+
+  // negative latency means just recalculate
+  if (latency_usec >= 0) {
+    hedge_.samples[hedge_.sample_next] = latency_usec;
+    hedge_.sample_next = (hedge_.sample_next + 1) % hedge_.samples.size();
+    if (hedge_.sample_count < hedge_.samples.size()) {
+      ++hedge_.sample_count;
+    }
+
+    // recalculate every 16 samples
+    if (0 != (hedge_.sample_next & 0x0F)) {
+      return;
+    }
+  }
+
+  // use max delay until there are enough samples
+  if (hedge_.sample_count < 16) {
+    hedge_.delay_usec = conf_.hedge_max_delay_usec;
+    return;
+  }
+
+  std::vector<time_t> sorted(hedge_.samples.begin(),
+                             hedge_.samples.begin() + static_cast<std::ptrdiff_t>(hedge_.sample_count));
+  size_t index = sorted.size() * static_cast<size_t>(conf_.hedge_percentile) / 100;
+  if (index >= sorted.size()) {
+    index = sorted.size() - 1;
+  }
+  std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(index), sorted.end());
+
+  time_t delay = sorted[index];
+  if (delay < conf_.hedge_min_delay_usec) {
+    delay = conf_.hedge_min_delay_usec;
+  }
+  if (delay > conf_.hedge_max_delay_usec) {
+    delay = conf_.hedge_max_delay_usec;
+  }
+  hedge_.delay_usec = delay;
+}
+
+cluster::connection_t *cluster::get_connection_by_id(connection::node_id_t id) {
+  connection_map_t::iterator it = connections_.find(id);
+  if (it == connections_.end()) {
+    return nullptr;
+  }
+
+  return it->second.get();
+}
+
+// key must be interned by nodes_
+cluster::connection_t *cluster::get_or_make_connection(const connection::key_t &key) {
+  connection_t *ret = get_connection_by_id(key.id);
+  if (nullptr == ret) {
+    ret = make_connection(key);
+  }
+
+  return ret;
+}
+
+bool cluster::accept_node(const connection::key_t &key) {
+  return !callbacks_.connection_filter || callbacks_.connection_filter(this, key);
+}
+
+bool cluster::allow_request(connection_t *conn, bool &is_probe) {
+  if (0 == conf_.breaker.half_open_probes || !is_timer_active()) {
+    return true;
+  }
+
+  circuit_breaker &breaker = breakers_[conn->get_key().id];
+  circuit_breaker::state::type from_state = breaker.get_state();
+  bool ret = breaker.allow(timer_wheel::make_tick(timer_actions_.last_update_sec, timer_actions_.last_update_usec),
+                           conf_.breaker, &is_probe);
+  if (from_state != breaker.get_state()) {
+    log_info("circuit breaker of %s is half open", conn->get_key().name.c_str());
+  }
+
+  return ret;
+}
+
+void cluster::on_node_success(connection_t *conn, bool is_probe) {
+  if (0 == conf_.breaker.half_open_probes || !is_timer_active()) {
+    return;
+  }
+
+  circuit_breaker &breaker = breakers_[conn->get_key().id];
+  circuit_breaker::state::type from_state = breaker.get_state();
+  breaker.on_success(timer_wheel::make_tick(timer_actions_.last_update_sec, timer_actions_.last_update_usec),
+                     conf_.breaker, is_probe);
+  if (from_state != breaker.get_state()) {
+    log_info("circuit breaker of %s is closed", conn->get_key().name.c_str());
+  }
+}
+
+void cluster::on_node_failure(connection_t *conn, bool is_probe) {
+  ++metrics_.mutable_node(conn->get_key()).failures;
+
+  if (0 == conf_.breaker.half_open_probes || !is_timer_active()) {
+    return;
+  }
+
+  circuit_breaker &breaker = breakers_[conn->get_key().id];
+  circuit_breaker::state::type from_state = breaker.get_state();
+  breaker.on_failure(timer_wheel::make_tick(timer_actions_.last_update_sec, timer_actions_.last_update_usec),
+                     conf_.breaker, is_probe);
+  if (from_state != breaker.get_state()) {
+    log_info("circuit breaker of %s is open", conn->get_key().name.c_str());
+  }
+}
+
+void cluster::add_node_reply(connection_t *conn, cmd_t *cmd) {
+  metrics::node_t &node = metrics_.mutable_node(conn->get_key());
+  ++node.replies;
+
+  if (0 != cmd->sent_usec_) {
+    time_t now = detail::steady_now_usec();
+    node.latency.add(now > cmd->sent_usec_ ? static_cast<uint64_t>(now - cmd->sent_usec_) : 0);
+  }
+}
+
+void cluster::remove_connection_key(connection::node_id_t id) {
   slot_flag_ = slot_status::INVALID;
 
   for (int i = 0; i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
-    std::vector<connection::key_t> &hosts = slots_[i].hosts;
-    if (!hosts.empty() && hosts[0].name == name) {
+    std::vector<connection::node_id_t> &hosts = slots_[i].hosts;
+    if (!hosts.empty() && hosts[0] == id) {
       if (hosts.size() > 1) {
         using std::swap;
         swap(hosts[0], hosts[hosts.size() - 1]);
       }
 
       hosts.pop_back();
+      slot_map_dirty_ = true;
     }
   }
 }
 
+void cluster::finish_slot_update() {
+  // set status first and then retry, or there will be a infinite loop
+  slot_flag_ = slot_status::OK;
+  publish_slot_map();
+
+  // run pending list
+  while (!slot_pending_.empty()) {
+    cmd_t *first_cmd = slot_pending_.front();
+    slot_pending_.pop_front();
+    reschedule(first_cmd, nullptr);
+  }
+}
+
+void cluster::publish_slot_map() {
+  slot_map_dirty_ = false;
+
+  slot_map *snapshot = new (std::nothrow) slot_map();
+  if (nullptr == snapshot) {
+    log_info("create slot map failed");
+    slot_map_dirty_ = true;
+    return;
+  }
+
+  for (int i = 0; i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
+    snapshot->set_hosts(i, slots_[i].hosts, nodes_);
+  }
+
+  // retired snapshots are deleted after readers release them
+  slot_map_.publish(snapshot);
+}
+
 void cluster::log_debug(const char *fmt, ...) {
   if (nullptr == conf_.log_fn_debug || 0 == conf_.log_max_size) {
     return;
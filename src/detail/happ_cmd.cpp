@@ -1,6 +1,9 @@
 // Copyright 2026 owent
 
 #include "detail/happ_cmd.h"
+#include "detail/happ_cmd_pool.h"
+#include "detail/happ_metrics.h"
+#include "detail/happ_prepared_cmd.h"
 
 #include <algorithm>
 #include <cassert>
@@ -23,13 +26,208 @@ static_assert(std::is_pod<hiredis::happ::cmd_exec>::value, "hiredis::happ::cmd_e
 
 namespace hiredis {
 namespace happ {
+namespace detail {
+// memory layout: [cmd_exec][inline buffer][user buffer]
+static inline size_t cmd_inline_area_size() {
+#if HIREDIS_HAPP_CMD_INLINE_SIZE > 0
+  // one more byte for the tailing \0, pick_argument need it
+  return (static_cast<size_t>(HIREDIS_HAPP_CMD_INLINE_SIZE) + 1 + sizeof(void *) - 1) & (~(sizeof(void *) - 1));
+#else
+  return 0;
+#endif
+}
+
+// memory layout of shared content: [cmd_shared_head][content][\0], cmd_content::content.raw points to content
+struct cmd_shared_head {
+  size_t ref_count;
+};
+
+static inline cmd_shared_head *cmd_shared_get_head(char *raw) {
+  return reinterpret_cast<cmd_shared_head *>(raw - sizeof(cmd_shared_head));
+}
+
+static char *cmd_shared_create(size_t len) {
+  cmd_shared_head *head = reinterpret_cast<cmd_shared_head *>(malloc(sizeof(cmd_shared_head) + len + 1));
+  if (nullptr == head) {
+    return nullptr;
+  }
+
+  head->ref_count = 1;
+  char *ret = reinterpret_cast<char *>(head + 1);
+  ret[len] = '\0';
+  return ret;
+}
+
+static void cmd_shared_release(char *raw) {
+  cmd_shared_head *head = cmd_shared_get_head(raw);
+  if (0 == --head->ref_count) {
+    free(head);
+  }
+}
+
+// only %s, %b and %% are supported, arguments are collected first and then written into the output buffer
+struct cmd_fast_format_t {
+  enum {
+    MAX_SEGMENTS = 64,
+    MAX_ARGS = 32,
+  };
+
+  const char *seg_data[MAX_SEGMENTS];
+  size_t seg_len[MAX_SEGMENTS];
+  size_t seg_count;
+
+  size_t arg_seg_end[MAX_ARGS];
+  size_t arg_len[MAX_ARGS];
+  size_t arg_count;
+
+  size_t current_len;
+  bool touched;
+
+  bool push(const char *data, size_t len) {
+    touched = true;
+    if (0 == len) {
+      return true;
+    }
+
+    if (seg_count >= MAX_SEGMENTS) {
+      return false;
+    }
+
+    seg_data[seg_count] = data;
+    seg_len[seg_count] = len;
+    ++seg_count;
+    current_len += len;
+    return true;
+  }
+
+  bool close_arg() {
+    if (!touched) {
+      return true;
+    }
+
+    if (arg_count >= MAX_ARGS) {
+      return false;
+    }
+
+    arg_seg_end[arg_count] = seg_count;
+    arg_len[arg_count] = current_len;
+    ++arg_count;
+    current_len = 0;
+    touched = false;
+    return true;
+  }
+};
+
+// @return length of command, -1 if it can not be formatted here
+static int cmd_fast_format(char *out, size_t capacity, const char *fmt, va_list ap) {
+  cmd_fast_format_t state;
+  state.seg_count = 0;
+  state.arg_count = 0;
+  state.current_len = 0;
+  state.touched = false;
+
+  // split arguments just like redisvFormatCommand
+  const char *literal = nullptr;
+  for (const char *c = fmt; *c; ++c) {
+    if (*c != '%' || c[1] == '\0') {
+      if (*c == ' ') {
+        if ((nullptr != literal && !state.push(literal, static_cast<size_t>(c - literal))) || !state.close_arg()) {
+          return -1;
+        }
+        literal = nullptr;
+      } else if (nullptr == literal) {
+        literal = c;
+      }
+      continue;
+    }
+
+    if (nullptr != literal && !state.push(literal, static_cast<size_t>(c - literal))) {
+      return -1;
+    }
+    literal = nullptr;
+
+    ++c;
+    switch (*c) {
+      case 's': {
+        const char *str = va_arg(ap, const char *);
+        if (nullptr == str || !state.push(str, strlen(str))) {
+          return -1;
+        }
+        break;
+      }
+      case 'b': {
+        const char *data = va_arg(ap, const char *);
+        size_t len = va_arg(ap, size_t);
+        if ((nullptr == data && len > 0) || !state.push(data, len)) {
+          return -1;
+        }
+        break;
+      }
+      case '%': {
+        if (!state.push(c, 1)) {
+          return -1;
+        }
+        break;
+      }
+      default:
+        // other conversions need printf
+        return -1;
+    }
+  }
+
+  if ((nullptr != literal && !state.push(literal, strlen(literal))) || !state.close_arg()) {
+    return -1;
+  }
+
+  size_t total = 1 + resp_count_digits(state.arg_count) + 2;
+  for (size_t i = 0; i < state.arg_count; ++i) {
+    total += resp_bulk_len(state.arg_len[i]);
+  }
+  if (total > capacity) {
+    return -1;
+  }
+
+  char *pos = resp_write_header(out, '*', state.arg_count);
+  size_t seg_index = 0;
+  for (size_t i = 0; i < state.arg_count; ++i) {
+    pos = resp_write_header(pos, '$', state.arg_len[i]);
+    for (; seg_index < state.arg_seg_end[i]; ++seg_index) {
+      memcpy(pos, state.seg_data[seg_index], state.seg_len[seg_index]);
+      pos += state.seg_len[seg_index];
+    }
+    *pos++ = '\r';
+    *pos++ = '\n';
+  }
+  *pos = '\0';
+
+  return static_cast<int>(total);
+}
+
+// hiredis parses the channels of these commands from the buffer passed to redisAsyncFormattedCommand, which is only
+// segments[0] of a scatter command
+static bool cmd_is_pubsub(const char *name, size_t len) {
+  static const char *pubsub_cmds[] = {"subscribe", "unsubscribe", "psubscribe", "punsubscribe", "ssubscribe",
+                                      "sunsubscribe"};
+  for (size_t i = 0; i < sizeof(pubsub_cmds) / sizeof(pubsub_cmds[0]); ++i) {
+    if (strlen(pubsub_cmds[i]) == len && 0 == HIREDIS_HAPP_STRNCASE_CMP(name, pubsub_cmds[i], len)) {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace detail
 
 HIREDIS_HAPP_API cmd_exec *cmd_exec::create(holder_t holder_, callback_fn_t cbk, void *pridata, size_t buffer_len) {
-  size_t sum_len = sizeof(cmd_exec) + buffer_len;
+  return create(nullptr, holder_, cbk, pridata, buffer_len);
+}
+
+HIREDIS_HAPP_API cmd_exec *cmd_exec::create(cmd_pool *pool, holder_t holder_, callback_fn_t cbk, void *pridata,
+                                            size_t buffer_len) {
+  size_t sum_len = sizeof(cmd_exec) + detail::cmd_inline_area_size() + buffer_len;
   // padding to sizeof(void*)
   sum_len = (sum_len + sizeof(void *) - 1) & (~(sizeof(void *) - 1));
 
-  cmd_exec *ret = reinterpret_cast<cmd_exec *>(malloc(sum_len));
+  cmd_exec *ret = reinterpret_cast<cmd_exec *>(nullptr == pool ? malloc(sum_len) : pool->allocate(sum_len));
 
   if (nullptr == ret) {
     return nullptr;
@@ -41,8 +239,10 @@ HIREDIS_HAPP_API cmd_exec *cmd_exec::create(holder_t holder_, callback_fn_t cbk,
   ret->callback_ = cbk;
   ret->private_data_ = pridata;
   ret->ttl_ = HIREDIS_HAPP_TTL;
+  ret->buffer_len_ = buffer_len;
 
   ret->engine_.slot = -1;
+  ret->pool_ = pool;
   return ret;
 }
 
@@ -51,18 +251,42 @@ static void free_cmd_content(cmd_content *c) {
     return;
   }
 
-  if (0 == c->raw_len) {
-    if (nullptr != c->content.redis_sds) {
-      redisFreeSdsCommand(c->content.redis_sds);
-      c->content.redis_sds = nullptr;
-    }
-  } else {
-    if (nullptr != c->content.raw) {
-      redisFreeCommand(c->content.raw);
-      c->content.raw = nullptr;
-    }
-    c->raw_len = 0;
+  switch (c->kind) {
+    case cmd_content::storage::SDS:
+      if (nullptr != c->content.redis_sds) {
+        redisFreeSdsCommand(c->content.redis_sds);
+      }
+      break;
+
+    case cmd_content::storage::HEAP:
+      if (nullptr != c->content.raw) {
+        redisFreeCommand(c->content.raw);
+      }
+      break;
+
+    case cmd_content::storage::SCATTER:
+      if (nullptr != c->content.scatter) {
+        if (nullptr != c->content.scatter->release_fn) {
+          c->content.scatter->release_fn(c->content.scatter->release_data);
+        }
+        free(c->content.scatter);
+      }
+      break;
+
+    case cmd_content::storage::SHARED:
+      if (nullptr != c->content.raw) {
+        detail::cmd_shared_release(c->content.raw);
+      }
+      break;
+
+    default:
+      // inline buffer is a part of cmd_exec
+      break;
   }
+
+  c->content.raw = nullptr;
+  c->raw_len = 0;
+  c->kind = cmd_content::storage::SDS;
 }
 
 HIREDIS_HAPP_API void cmd_exec::destroy(cmd_exec *c) {
@@ -70,27 +294,287 @@ HIREDIS_HAPP_API void cmd_exec::destroy(cmd_exec *c) {
     return;
   }
 
+  // never leave a dangling node in timer wheel
+  timer_wheel::remove(&c->timer_);
+
+  if (nullptr != c->callable_destroy_) {
+    c->callable_destroy_(c->buffer());
+    c->callable_destroy_ = nullptr;
+  }
+
   free_cmd_content(&c->raw_cmd_content_);
 
-  free(c);
+  if (nullptr == c->pool_) {
+    free(c);
+  } else {
+    c->pool_->deallocate(c);
+  }
+}
+
+HIREDIS_HAPP_API char *cmd_exec::reserve_content(size_t len) {
+  free_cmd_content(&raw_cmd_content_);
+
+  if (len <= get_inline_capacity()) {
+    raw_cmd_content_.content.raw = inline_buffer();
+    raw_cmd_content_.raw_len = len;
+    raw_cmd_content_.kind = cmd_content::storage::INLINE;
+    return inline_buffer();
+  }
+
+  // sdsnewlen keeps a tailing \0 after len bytes
+  raw_cmd_content_.content.redis_sds = sdsnewlen(nullptr, len);
+  raw_cmd_content_.raw_len = 0;
+  raw_cmd_content_.kind = cmd_content::storage::SDS;
+  return raw_cmd_content_.content.redis_sds;
+}
+
+namespace detail {
+// placeholder values of prepared command, get(i, &data, &len) gets the value of placeholder i
+struct cmd_prepared_argv {
+  const char **argv;
+  const size_t *argvlen;
+
+  void get(size_t i, const char **data, size_t *len) const {
+    *data = argv[i];
+    *len = nullptr == argvlen ? strlen(argv[i]) : argvlen[i];
+  }
+};
+
+struct cmd_prepared_encoded {
+  const detail::cmd_arg *args;
+
+  void get(size_t i, const char **data, size_t *len) const {
+    *data = args[i].data;
+    *len = args[i].len;
+  }
+};
+
+template <typename ArgsT>
+static int64_t cmd_prepared_length(const prepared_cmd &cmd, size_t argc, const ArgsT &args) {
+  if (cmd.empty() || argc != cmd.get_placeholder_count()) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  size_t total = cmd.get_constant_length();
+  for (size_t i = 0; i < argc; ++i) {
+    const char *data;
+    size_t len;
+    args.get(i, &data, &len);
+    total += detail::resp_bulk_len(len);
+  }
+  return static_cast<int64_t>(total);
+}
+
+template <typename ArgsT>
+static void cmd_prepared_write(char *pos, const prepared_cmd &cmd, size_t argc, const ArgsT &args) {
+  for (size_t i = 0; i <= argc; ++i) {
+    size_t segment_len;
+    const char *segment = cmd.get_segment(i, &segment_len);
+    if (segment_len > 0) {
+      memcpy(pos, segment, segment_len);
+      pos += segment_len;
+    }
+
+    if (i == argc) {
+      break;
+    }
+
+    const char *data;
+    size_t len;
+    args.get(i, &data, &len);
+    pos = detail::resp_write_header(pos, '$', len);
+    if (len > 0) {
+      memcpy(pos, data, len);
+      pos += len;
+    }
+    *pos++ = '\r';
+    *pos++ = '\n';
+  }
+  *pos = '\0';
+}
+}  // namespace detail
+
+HIREDIS_HAPP_API int64_t cmd_exec::format_prepared(const prepared_cmd &cmd, int argc, const char **argv,
+                                                   const size_t *argvlen) {
+  if (argc < 0 || (argc > 0 && nullptr == argv)) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  detail::cmd_prepared_argv prepared_args;
+  prepared_args.argv = argv;
+  prepared_args.argvlen = argvlen;
+
+  int64_t total = detail::cmd_prepared_length(cmd, static_cast<size_t>(argc), prepared_args);
+  if (total < 0) {
+    return total;
+  }
+
+  char *pos = reserve_content(static_cast<size_t>(total));
+  if (nullptr == pos) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  detail::cmd_prepared_write(pos, cmd, static_cast<size_t>(argc), prepared_args);
+  return total;
+}
+
+HIREDIS_HAPP_API int64_t cmd_exec::write_prepared(const prepared_cmd &cmd, size_t argc, const detail::cmd_arg *args) {
+  detail::cmd_prepared_encoded prepared_args;
+  prepared_args.args = args;
+
+  int64_t total = detail::cmd_prepared_length(cmd, argc, prepared_args);
+  if (total < 0) {
+    return total;
+  }
+
+  char *pos = reserve_content(static_cast<size_t>(total));
+  if (nullptr == pos) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  detail::cmd_prepared_write(pos, cmd, argc, prepared_args);
+  return total;
 }
 
 HIREDIS_HAPP_API int64_t cmd_exec::vformat(int argc, const char **argv, const size_t *argvlen) {
   free_cmd_content(&raw_cmd_content_);
 
+  // small command, format into inline buffer
+  if (argc >= 0 && (0 == argc || nullptr != argv) && get_inline_capacity() > 0) {
+    size_t total = 1 + detail::resp_count_digits(static_cast<size_t>(argc)) + 2;
+    for (int i = 0; i < argc && total <= get_inline_capacity(); ++i) {
+      total += detail::resp_bulk_len(nullptr == argvlen ? strlen(argv[i]) : argvlen[i]);
+    }
+
+    if (total <= get_inline_capacity()) {
+      char *out = inline_buffer();
+      char *pos = detail::resp_write_header(out, '*', static_cast<size_t>(argc));
+      for (int i = 0; i < argc; ++i) {
+        size_t len = nullptr == argvlen ? strlen(argv[i]) : argvlen[i];
+        pos = detail::resp_write_header(pos, '$', len);
+        memcpy(pos, argv[i], len);
+        pos += len;
+        *pos++ = '\r';
+        *pos++ = '\n';
+      }
+      *pos = '\0';
+
+      raw_cmd_content_.content.raw = out;
+      raw_cmd_content_.raw_len = total;
+      raw_cmd_content_.kind = cmd_content::storage::INLINE;
+      return static_cast<int64_t>(total);
+    }
+  }
+
   raw_cmd_content_.raw_len = 0;
+  raw_cmd_content_.kind = cmd_content::storage::SDS;
   return redisFormatSdsCommandArgv(&raw_cmd_content_.content.redis_sds, argc, argv, argvlen);
 }
 
+HIREDIS_HAPP_API int64_t cmd_exec::vformat_reference(int argc, const char **argv, const size_t *argvlen,
+                                                     release_fn_t release_fn, void *release_data) {
+  free_cmd_content(&raw_cmd_content_);
+
+  // the command name is always copied, so pick_cmd can find it in segments[0]
+  // pub/sub commands are always copied, hiredis must see all channels in segments[0]
+  size_t reference_count = 0;
+  if (argc > 0 && nullptr != argv && nullptr != argvlen && !detail::cmd_is_pubsub(argv[0], argvlen[0])) {
+    for (int i = 1; i < argc; ++i) {
+      if (argvlen[i] >= HIREDIS_HAPP_CMD_REFERENCE_SIZE) {
+        ++reference_count;
+      }
+    }
+  }
+
+  // nothing to reference, just copy all arguments
+  if (0 == reference_count) {
+    int64_t ret = vformat(argc, argv, argvlen);
+    if (nullptr != release_fn) {
+      release_fn(release_data);
+    }
+    return ret;
+  }
+
+  size_t head_len = 1 + detail::resp_count_digits(static_cast<size_t>(argc)) + 2 + detail::resp_bulk_len(argvlen[0]);
+  size_t total_len = head_len;
+  // segments[0], one referenced segment and one owned segment before it for every large argument, and the trailer
+  size_t segment_count = 2 * reference_count + 2;
+  size_t owned_len = head_len + 1;
+  for (int i = 1; i < argc; ++i) {
+    total_len += detail::resp_bulk_len(argvlen[i]);
+    // $[LENGTH]\r\n and \r\n
+    owned_len += 1 + detail::resp_count_digits(argvlen[i]) + 2 + 2;
+    if (argvlen[i] < HIREDIS_HAPP_CMD_REFERENCE_SIZE) {
+      owned_len += argvlen[i];
+    }
+  }
+
+  cmd_scatter *scatter =
+      reinterpret_cast<cmd_scatter *>(malloc(sizeof(cmd_scatter) + segment_count * sizeof(cmd_segment) + owned_len));
+  if (nullptr == scatter) {
+    if (nullptr != release_fn) {
+      release_fn(release_data);
+    }
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  scatter->release_fn = release_fn;
+  scatter->release_data = release_data;
+  scatter->total_len = total_len;
+  scatter->segment_count = 0;
+  scatter->segments = reinterpret_cast<cmd_segment *>(scatter + 1);
+
+  char *owned = reinterpret_cast<char *>(scatter->segments + segment_count);
+  char *pos = detail::resp_write_header(owned, '*', static_cast<size_t>(argc));
+  pos = detail::resp_write_header(pos, '$', argvlen[0]);
+  memcpy(pos, argv[0], argvlen[0]);
+  pos += argvlen[0];
+  *pos++ = '\r';
+  *pos++ = '\n';
+  scatter->segments[0].data = owned;
+  scatter->segments[0].len = static_cast<size_t>(pos - owned);
+  scatter->segment_count = 1;
+  *pos++ = '\0';
+
+  char *run = pos;
+  for (int i = 1; i < argc; ++i) {
+    pos = detail::resp_write_header(pos, '$', argvlen[i]);
+    if (argvlen[i] >= HIREDIS_HAPP_CMD_REFERENCE_SIZE) {
+      scatter->segments[scatter->segment_count].data = run;
+      scatter->segments[scatter->segment_count].len = static_cast<size_t>(pos - run);
+      ++scatter->segment_count;
+
+      scatter->segments[scatter->segment_count].data = argv[i];
+      scatter->segments[scatter->segment_count].len = argvlen[i];
+      ++scatter->segment_count;
+      run = pos;
+    } else {
+      memcpy(pos, argv[i], argvlen[i]);
+      pos += argvlen[i];
+    }
+    *pos++ = '\r';
+    *pos++ = '\n';
+  }
+
+  scatter->segments[scatter->segment_count].data = run;
+  scatter->segments[scatter->segment_count].len = static_cast<size_t>(pos - run);
+  ++scatter->segment_count;
+  assert(scatter->segment_count <= segment_count);
+  assert(static_cast<size_t>(pos - owned) <= owned_len);
+
+  raw_cmd_content_.content.scatter = scatter;
+  raw_cmd_content_.raw_len = scatter->segments[0].len;
+  raw_cmd_content_.kind = cmd_content::storage::SCATTER;
+  return static_cast<int64_t>(total_len);
+}
+
 HIREDIS_HAPP_API int cmd_exec::format(const char *fmt, ...) {
   va_list ap;
 
-  free_cmd_content(&raw_cmd_content_);
   va_start(ap, fmt);
-  int ret = redisvFormatCommand(&raw_cmd_content_.content.raw, fmt, ap);
+  int ret = vformat(fmt, ap);
   va_end(ap);
 
-  raw_cmd_content_.raw_len = ret > 0 ? static_cast<size_t>(ret) : 0;
   return ret;
 }
 
@@ -98,11 +582,29 @@ HIREDIS_HAPP_API int cmd_exec::vformat(const char *fmt, va_list ap) {
   free_cmd_content(&raw_cmd_content_);
 
   va_list ap_c;
-  va_copy(ap_c, ap);
 
+  // small command with only %s and %b, format into inline buffer
+  if (nullptr != fmt && get_inline_capacity() > 0) {
+    va_copy(ap_c, ap);
+    int ret = detail::cmd_fast_format(inline_buffer(), get_inline_capacity(), fmt, ap_c);
+    va_end(ap_c);
+
+    if (ret > 0) {
+      raw_cmd_content_.content.raw = inline_buffer();
+      raw_cmd_content_.raw_len = static_cast<size_t>(ret);
+      raw_cmd_content_.kind = cmd_content::storage::INLINE;
+      return ret;
+    }
+  }
+
+  va_copy(ap_c, ap);
   int ret = redisvFormatCommand(&raw_cmd_content_.content.raw, fmt, ap_c);
   va_end(ap_c);
   raw_cmd_content_.raw_len = ret > 0 ? static_cast<size_t>(ret) : 0;
+  raw_cmd_content_.kind = ret > 0 ? cmd_content::storage::HEAP : cmd_content::storage::SDS;
+  if (ret <= 0) {
+    raw_cmd_content_.content.raw = nullptr;
+  }
   return ret;
 }
 
@@ -113,6 +615,16 @@ HIREDIS_HAPP_API int cmd_exec::vformat(const sds *src) {
     return 0;
   }
 
+  size_t len = sdslen(*src);
+  if (len > 0 && len <= get_inline_capacity()) {
+    memcpy(inline_buffer(), *src, len);
+    inline_buffer()[len] = '\0';
+    raw_cmd_content_.content.raw = inline_buffer();
+    raw_cmd_content_.raw_len = len;
+    raw_cmd_content_.kind = cmd_content::storage::INLINE;
+    return static_cast<int>(len);
+  }
+
   raw_cmd_content_.content.redis_sds = sdsdup(*src);
   if (nullptr == raw_cmd_content_.content.redis_sds) {
     return error_code::REDIS_HAPP_CREATE;
@@ -122,12 +634,99 @@ HIREDIS_HAPP_API int cmd_exec::vformat(const sds *src) {
   return static_cast<int>(sdslen(raw_cmd_content_.content.redis_sds));
 }
 
+HIREDIS_HAPP_API int64_t cmd_exec::share_content(cmd_exec *src) {
+  if (nullptr == src || this == src) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  cmd_content &from = src->raw_cmd_content_;
+  if (cmd_content::storage::INLINE == from.kind) {
+    char *out = reserve_content(from.raw_len);
+    if (nullptr == out) {
+      return error_code::REDIS_HAPP_CREATE;
+    }
+    memcpy(out, from.content.raw, from.raw_len + 1);
+    return static_cast<int64_t>(from.raw_len);
+  }
+
+  // move the content of src into a shared buffer
+  if (cmd_content::storage::SHARED != from.kind) {
+    const char *data = nullptr;
+    size_t len = 0;
+    switch (from.kind) {
+      case cmd_content::storage::SDS:
+        data = from.content.redis_sds;
+        len = nullptr == data ? 0 : sdslen(from.content.redis_sds);
+        break;
+      case cmd_content::storage::SCATTER:
+        len = nullptr == from.content.scatter ? 0 : from.content.scatter->total_len;
+        break;
+      default:
+        data = from.content.raw;
+        len = from.raw_len;
+        break;
+    }
+
+    if (0 == len) {
+      return error_code::REDIS_HAPP_PARAM;
+    }
+
+    char *shared = detail::cmd_shared_create(len);
+    if (nullptr == shared) {
+      return error_code::REDIS_HAPP_CREATE;
+    }
+
+    if (cmd_content::storage::SCATTER == from.kind) {
+      char *pos = shared;
+      for (size_t i = 0; i < from.content.scatter->segment_count; ++i) {
+        memcpy(pos, from.content.scatter->segments[i].data, from.content.scatter->segments[i].len);
+        pos += from.content.scatter->segments[i].len;
+      }
+    } else {
+      memcpy(shared, data, len);
+    }
+
+    free_cmd_content(&from);
+    from.content.raw = shared;
+    from.raw_len = len;
+    from.kind = cmd_content::storage::SHARED;
+  }
+
+  // src may share the same buffer with this cmd, so add reference before releasing the old content
+  char *shared = from.content.raw;
+  ++detail::cmd_shared_get_head(shared)->ref_count;
+  free_cmd_content(&raw_cmd_content_);
+  raw_cmd_content_.content.raw = shared;
+  raw_cmd_content_.raw_len = from.raw_len;
+  raw_cmd_content_.kind = cmd_content::storage::SHARED;
+  return static_cast<int64_t>(raw_cmd_content_.raw_len);
+}
+
+HIREDIS_HAPP_API size_t cmd_exec::get_content_ref_count() const {
+  switch (raw_cmd_content_.kind) {
+    case cmd_content::storage::SDS:
+      return nullptr == raw_cmd_content_.content.redis_sds ? 0 : 1;
+    case cmd_content::storage::SCATTER:
+      return nullptr == raw_cmd_content_.content.scatter ? 0 : 1;
+    case cmd_content::storage::SHARED:
+      return nullptr == raw_cmd_content_.content.raw
+                 ? 0
+                 : detail::cmd_shared_get_head(raw_cmd_content_.content.raw)->ref_count;
+    default:
+      return nullptr == raw_cmd_content_.content.raw ? 0 : 1;
+  }
+}
+
 HIREDIS_HAPP_API int cmd_exec::call_reply(int rcode, redisAsyncContext *context, void *reply) {
   if (nullptr == callback_) {
     return error_code::REDIS_HAPP_OK;
   }
 
   error_code_ = rcode;
+  if (nullptr != metrics_) {
+    metrics_->add_cmd_finished(rcode);
+  }
+
   callback_fn_t tc = callback_;
   callback_ = nullptr;
   tc(this, context, reply, private_data_);
@@ -137,9 +736,13 @@ HIREDIS_HAPP_API int cmd_exec::call_reply(int rcode, redisAsyncContext *context,
 
 HIREDIS_HAPP_API int cmd_exec::result() const { return error_code_; }
 
-HIREDIS_HAPP_API void *cmd_exec::buffer() { return reinterpret_cast<void *>(this + 1); }
+HIREDIS_HAPP_API void *cmd_exec::buffer() {
+  return reinterpret_cast<void *>(reinterpret_cast<char *>(this + 1) + detail::cmd_inline_area_size());
+}
 
-HIREDIS_HAPP_API const void *cmd_exec::buffer() const { return reinterpret_cast<const void *>(this + 1); }
+HIREDIS_HAPP_API const void *cmd_exec::buffer() const {
+  return reinterpret_cast<const void *>(reinterpret_cast<const char *>(this + 1) + detail::cmd_inline_area_size());
+}
 
 HIREDIS_HAPP_API void *cmd_exec::private_data() const { return private_data_; }
 
@@ -147,9 +750,14 @@ HIREDIS_HAPP_API void cmd_exec::private_data(void *pd) { private_data_ = pd; }
 
 HIREDIS_HAPP_API const char *cmd_exec::pick_argument(const char *start, const char **str, size_t *len) {
   if (nullptr == start) {
-    if (0 == raw_cmd_content_.raw_len) {
+    if (cmd_content::storage::SDS == raw_cmd_content_.kind) {
       // because sds is typedefed to be a char*, so we can only use it directly here.
       start = raw_cmd_content_.content.redis_sds;
+    } else if (cmd_content::storage::SCATTER == raw_cmd_content_.kind) {
+      // only the command name can be picked from scatter content
+      if (nullptr != raw_cmd_content_.content.scatter) {
+        start = raw_cmd_content_.content.scatter->segments[0].data;
+      }
     } else {
       start = raw_cmd_content_.content.raw;
     }
@@ -237,5 +845,39 @@ HIREDIS_HAPP_API cmd_exec::callback_fn_t cmd_exec::get_callback_fn() const { ret
 HIREDIS_HAPP_API cmd_content cmd_exec::get_cmd_raw_content() const { return raw_cmd_content_; }
 
 HIREDIS_HAPP_API int cmd_exec::get_error_code() const { return error_code_; }
+
+HIREDIS_HAPP_API void cmd_exec::set_stream_visitor(stream_fn_t fn, size_t depth) {
+  stream_fn_ = fn;
+  stream_depth_ = depth > 0 ? depth : 1;
+}
+
+HIREDIS_HAPP_API cmd_exec::stream_fn_t cmd_exec::get_stream_fn() const { return stream_fn_; }
+
+HIREDIS_HAPP_API size_t cmd_exec::get_stream_depth() const { return stream_depth_; }
+
+HIREDIS_HAPP_API size_t cmd_exec::get_inline_capacity() {
+  size_t area = detail::cmd_inline_area_size();
+  return area > 0 ? area - 1 : 0;
+}
+
+char *cmd_exec::inline_buffer() { return reinterpret_cast<char *>(this + 1); }
+
+bool cmd_exec::append_scatter_tail(sds *out) const {
+  if (nullptr == out || nullptr == *out || cmd_content::storage::SCATTER != raw_cmd_content_.kind ||
+      nullptr == raw_cmd_content_.content.scatter) {
+    return false;
+  }
+
+  const cmd_scatter *scatter = raw_cmd_content_.content.scatter;
+  for (size_t i = 1; i < scatter->segment_count; ++i) {
+    sds next = sdscatlen(*out, scatter->segments[i].data, scatter->segments[i].len);
+    if (nullptr == next) {
+      return false;
+    }
+    *out = next;
+  }
+
+  return true;
+}
 }  // namespace happ
 }  // namespace hiredis
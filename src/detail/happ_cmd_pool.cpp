@@ -0,0 +1,266 @@
+// Copyright 2026 owent
+
+#include "detail/happ_cmd_pool.h"
+
+#include <cassert>
+#include <cstdlib>
+#include <cstring>
+
+namespace hiredis {
+namespace happ {
+// keep the address returned by allocate aligned like malloc
+struct alignas(std::max_align_t) cmd_pool::block_header_t {
+  union {
+    slab_t *slab;               // owner slab when allocated, nullptr if allocated by malloc
+    block_header_t *next_free;  // next free block in the same slab
+  };
+};
+
+struct cmd_pool::slab_t {
+  slab_t *prev;
+  slab_t *next;
+  size_t class_index;
+  size_t free_count;
+  size_t total_bytes;
+  block_header_t *free_list;
+};
+
+namespace detail {
+static inline size_t cmd_pool_align(size_t sz) {
+  return (sz + alignof(std::max_align_t) - 1) & (~(alignof(std::max_align_t) - 1));
+}
+}  // namespace detail
+
+cmd_pool::cmd_pool() : idle_high_water_(HIREDIS_HAPP_CMD_POOL_IDLE_HIGH_WATER), released_(false) {
+  memset(&stats_, 0, sizeof(stats_));
+  for (size_t i = 0; i < CLASS_COUNT; ++i) {
+    classes_[i].block_size = static_cast<size_t>(1) << (MIN_CLASS_SHIFT + i);
+    classes_[i].block_count = HIREDIS_HAPP_CMD_POOL_SLAB_SIZE / classes_[i].block_size;
+    if (classes_[i].block_count < 1) {
+      classes_[i].block_count = 1;
+    }
+    classes_[i].partial = nullptr;
+    classes_[i].empty = nullptr;
+  }
+}
+
+cmd_pool::~cmd_pool() {
+  // slabs with blocks in use are not tracked, but the pool is destroyed only after all blocks are deallocated
+  assert(0 == stats_.block_in_use);
+  for (size_t i = 0; i < CLASS_COUNT; ++i) {
+    while (nullptr != classes_[i].empty) {
+      slab_t *slab = classes_[i].empty;
+      slab_list_remove(classes_[i].empty, slab);
+      stats_.idle_slab_bytes -= slab->total_bytes;
+      free_slab(slab);
+    }
+  }
+}
+
+HIREDIS_HAPP_API cmd_pool *cmd_pool::create() { return new cmd_pool(); }
+
+HIREDIS_HAPP_API void cmd_pool::release(cmd_pool *pool) {
+  if (nullptr == pool) {
+    return;
+  }
+
+  pool->released_ = true;
+  pool->idle_high_water_ = 0;
+  pool->trim();
+
+  if (pool->is_releasable()) {
+    delete pool;
+  }
+}
+
+HIREDIS_HAPP_API void *cmd_pool::allocate(size_t size) {
+  size_t header_size = sizeof(block_header_t);
+  size_t class_index = get_class_index(header_size + size);
+
+  // too large, use malloc directly
+  if (class_index >= CLASS_COUNT) {
+    block_header_t *block = reinterpret_cast<block_header_t *>(malloc(header_size + size));
+    if (nullptr == block) {
+      return nullptr;
+    }
+
+    block->slab = nullptr;
+    ++stats_.malloc_in_use;
+    return reinterpret_cast<char *>(block) + header_size;
+  }
+
+  size_class_t &cls = classes_[class_index];
+  slab_t *slab = cls.partial;
+  if (nullptr == slab) {
+    if (nullptr != cls.empty) {
+      slab = cls.empty;
+      slab_list_remove(cls.empty, slab);
+      stats_.idle_slab_bytes -= slab->total_bytes;
+    } else {
+      slab = alloc_slab(class_index);
+      if (nullptr == slab) {
+        return nullptr;
+      }
+    }
+
+    if (slab->free_count > 1) {
+      slab_list_push(cls.partial, slab);
+    }
+  } else if (1 == slab->free_count) {
+    // slab will be full
+    slab_list_remove(cls.partial, slab);
+  }
+
+  block_header_t *block = slab->free_list;
+  slab->free_list = block->next_free;
+  --slab->free_count;
+
+  block->slab = slab;
+  ++stats_.block_in_use;
+  return reinterpret_cast<char *>(block) + header_size;
+}
+
+HIREDIS_HAPP_API void cmd_pool::deallocate(void *ptr) {
+  if (nullptr == ptr) {
+    return;
+  }
+
+  block_header_t *block = reinterpret_cast<block_header_t *>(reinterpret_cast<char *>(ptr) - sizeof(block_header_t));
+  slab_t *slab = block->slab;
+  if (nullptr == slab) {
+    free(block);
+    --stats_.malloc_in_use;
+  } else {
+    size_class_t &cls = classes_[slab->class_index];
+    block->next_free = slab->free_list;
+    slab->free_list = block;
+    ++slab->free_count;
+    --stats_.block_in_use;
+
+    if (slab->free_count >= cls.block_count) {
+      // full -> empty when block_count is 1, or partial -> empty
+      if (cls.block_count > 1) {
+        slab_list_remove(cls.partial, slab);
+      }
+      slab_list_push(cls.empty, slab);
+      stats_.idle_slab_bytes += slab->total_bytes;
+
+      // high water trim
+      if (stats_.idle_slab_bytes > idle_high_water_) {
+        trim_to(idle_high_water_);
+      }
+    } else if (1 == slab->free_count) {
+      // full -> partial
+      slab_list_push(cls.partial, slab);
+    }
+  }
+
+  if (released_ && is_releasable()) {
+    delete this;
+  }
+}
+
+HIREDIS_HAPP_API size_t cmd_pool::trim() {
+  size_t before = stats_.slab_bytes;
+  trim_to(0);
+  return before - stats_.slab_bytes;
+}
+
+HIREDIS_HAPP_API void cmd_pool::set_idle_high_water(size_t bytes) {
+  idle_high_water_ = bytes;
+  if (stats_.idle_slab_bytes > idle_high_water_) {
+    trim_to(idle_high_water_);
+  }
+}
+
+HIREDIS_HAPP_API size_t cmd_pool::get_idle_high_water() const { return idle_high_water_; }
+
+HIREDIS_HAPP_API const cmd_pool::stats_t &cmd_pool::get_stats() const { return stats_; }
+
+size_t cmd_pool::get_class_index(size_t size) {
+  size_t ret = 0;
+  size_t block_size = static_cast<size_t>(1) << MIN_CLASS_SHIFT;
+  while (block_size < size && ret < CLASS_COUNT) {
+    block_size <<= 1;
+    ++ret;
+  }
+
+  return ret;
+}
+
+cmd_pool::slab_t *cmd_pool::alloc_slab(size_t class_index) {
+  size_class_t &cls = classes_[class_index];
+  size_t header_size = detail::cmd_pool_align(sizeof(slab_t));
+  size_t total_bytes = header_size + cls.block_size * cls.block_count;
+
+  slab_t *slab = reinterpret_cast<slab_t *>(malloc(total_bytes));
+  if (nullptr == slab) {
+    return nullptr;
+  }
+
+  slab->prev = nullptr;
+  slab->next = nullptr;
+  slab->class_index = class_index;
+  slab->free_count = cls.block_count;
+  slab->total_bytes = total_bytes;
+  slab->free_list = nullptr;
+
+  // link blocks in address order
+  char *begin = reinterpret_cast<char *>(slab) + header_size;
+  for (size_t i = cls.block_count; i > 0; --i) {
+    block_header_t *block = reinterpret_cast<block_header_t *>(begin + (i - 1) * cls.block_size);
+    block->next_free = slab->free_list;
+    slab->free_list = block;
+  }
+
+  ++stats_.slab_count;
+  stats_.slab_bytes += total_bytes;
+  return slab;
+}
+
+void cmd_pool::free_slab(slab_t *slab) {
+  --stats_.slab_count;
+  stats_.slab_bytes -= slab->total_bytes;
+  free(slab);
+}
+
+void cmd_pool::trim_to(size_t bytes) {
+  // release large slabs first
+  for (size_t i = CLASS_COUNT; i > 0 && stats_.idle_slab_bytes > bytes; --i) {
+    size_class_t &cls = classes_[i - 1];
+    while (nullptr != cls.empty && stats_.idle_slab_bytes > bytes) {
+      slab_t *slab = cls.empty;
+      slab_list_remove(cls.empty, slab);
+      stats_.idle_slab_bytes -= slab->total_bytes;
+      free_slab(slab);
+    }
+  }
+}
+
+bool cmd_pool::is_releasable() const { return 0 == stats_.block_in_use && 0 == stats_.malloc_in_use; }
+
+void cmd_pool::slab_list_push(slab_t *&head, slab_t *slab) {
+  slab->prev = nullptr;
+  slab->next = head;
+  if (nullptr != head) {
+    head->prev = slab;
+  }
+  head = slab;
+}
+
+void cmd_pool::slab_list_remove(slab_t *&head, slab_t *slab) {
+  if (nullptr != slab->prev) {
+    slab->prev->next = slab->next;
+  } else {
+    head = slab->next;
+  }
+
+  if (nullptr != slab->next) {
+    slab->next->prev = slab->prev;
+  }
+
+  slab->prev = nullptr;
+  slab->next = nullptr;
+}
+}  // namespace happ
+}  // namespace hiredis
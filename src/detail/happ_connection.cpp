@@ -12,6 +12,7 @@ namespace happ {
 HIREDIS_HAPP_API connection::connection() : sequence_(0), context_(nullptr), conn_status_(status::DISCONNECTED) {
   make_sequence();
   holder_.clu = nullptr;
+  memset(&connect_timer_, 0, sizeof(connect_timer_));
 }
 
 HIREDIS_HAPP_API connection::~connection() { release(true); }
@@ -78,6 +79,9 @@ HIREDIS_HAPP_API connection::status::type connection::set_connected() {
 
   conn_status_ = status::CONNECTED;
 
+  // connected, connecting timeout is useless now
+  timer_wheel::remove(&connect_timer_);
+
   // new operation sequence_
   make_sequence();
 
@@ -106,9 +110,24 @@ HIREDIS_HAPP_API int connection::redis_cmd(cmd_exec *c, redisCallbackFn fn) {
       int res = 0;
       const char *cstr = nullptr;
       size_t clen = 0;
-      if (0 == c->raw_cmd_content_.raw_len) {
+      if (cmd_content::storage::SDS == c->raw_cmd_content_.kind) {
         res = redisAsyncFormattedCommand(context_, fn, c, c->raw_cmd_content_.content.redis_sds,
                                          sdslen(c->raw_cmd_content_.content.redis_sds));
+      } else if (cmd_content::storage::SCATTER == c->raw_cmd_content_.kind) {
+        // hiredis only appends the command into obuf and writes it in event loop, so we reserve the whole command
+        // first and then append the left segments directly, large arguments are copied only once here.
+        const cmd_scatter *scatter = c->raw_cmd_content_.content.scatter;
+        sds obuf = sdsMakeRoomFor(context_->c.obuf, scatter->total_len);
+        if (nullptr == obuf) {
+          return REDIS_ERR;
+        }
+        context_->c.obuf = obuf;
+
+        res = redisAsyncFormattedCommand(context_, fn, c, scatter->segments[0].data, scatter->segments[0].len);
+        if (REDIS_OK == res) {
+          // room is already reserved, so it never fails
+          c->append_scatter_tail(&context_->c.obuf);
+        }
       } else {
         res = redisAsyncFormattedCommand(context_, fn, c, c->raw_cmd_content_.content.raw, c->raw_cmd_content_.raw_len);
       }
@@ -273,11 +292,19 @@ HIREDIS_HAPP_API cmd_exec *connection::pop_reply(cmd_exec *c) {
   return c;
 }
 
+HIREDIS_HAPP_API size_t connection::get_pending_count() const { return reply_list_.size(); }
+
 HIREDIS_HAPP_API redisAsyncContext *connection::get_context() const { return context_; }
 
 HIREDIS_HAPP_API void connection::release(bool close_fd) {
-  if (nullptr != context_ && close_fd) {
-    redisAsyncDisconnect(context_);
+  if (nullptr != context_) {
+    // hiredis may still call callbacks of this context later, such as pending replies after a failed connect, and
+    // cmds in reply_list_ are finished below, so the callbacks must not touch this connection or these cmds
+    context_->data = nullptr;
+
+    if (close_fd) {
+      redisAsyncDisconnect(context_);
+    }
   }
 
   // reply list
@@ -292,6 +319,8 @@ HIREDIS_HAPP_API void connection::release(bool close_fd) {
 
   context_ = nullptr;
   conn_status_ = status::DISCONNECTED;
+
+  timer_wheel::remove(&connect_timer_);
 }
 
 HIREDIS_HAPP_API const connection::key_t &connection::get_key() const { return key_; }
@@ -300,6 +329,10 @@ HIREDIS_HAPP_API holder_t connection::get_holder() const { return holder_; }
 
 HIREDIS_HAPP_API connection::status::type connection::get_status() const { return conn_status_; }
 
+HIREDIS_HAPP_API timer_node &connection::get_connect_timer() { return connect_timer_; }
+
+HIREDIS_HAPP_API const timer_node &connection::get_connect_timer() const { return connect_timer_; }
+
 void connection::make_sequence() {
   do {
 // sequence_ will be used to make a distinction between connections when address is reused
@@ -354,6 +387,7 @@ HIREDIS_HAPP_API void connection::set_key(connection::key_t &k, const std::strin
   k.name = make_name(ip, port);
   k.ip = ip;
   k.port = port;
+  k.id = 0;
 }
 
 HIREDIS_HAPP_API bool connection::pick_name(const std::string &name, std::string &ip, uint16_t &port) {
@@ -0,0 +1,737 @@
+// Copyright 2026 owent
+
+#include "detail/happ_epoll_loop.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+
+#  include <sys/epoll.h>
+#  include <sys/eventfd.h>
+#  include <sys/timerfd.h>
+#  include <unistd.h>
+
+#  include <cerrno>
+#  include <cstdint>
+
+#  include "happ_uring_poller.h"
+
+namespace hiredis {
+namespace happ {
+struct epoll_loop::handle_t {
+  struct kind {
+    enum type { TIMER = 0, WAKEUP, SUBMIT, CONTEXT };
+  };
+
+  epoll_loop *owner;
+  kind::type type;
+  int fd;
+  uint32_t events;  // events registered in epoll
+  bool registered;
+  bool released;
+
+  submit_queue *queue;    // SUBMIT
+  redisAsyncContext *ctx;  // CONTEXT
+  int64_t timeout_usec;    // CONTEXT, monotonic deadline set by scheduleTimer, 0 for none
+
+  // io_uring only
+  uint32_t armed_events;  // events of the latest poll in kernel, 0 for none
+  uint32_t poll_seq;      // sequence of the latest poll, its low bits are in user_data
+  uint32_t inflight;      // count of polls in kernel, it's deleted after all of them complete
+  bool dirty;             // in dirty of uring_ of the loop
+
+  handle_t(epoll_loop *o, kind::type t, int f)
+      : owner(o),
+        type(t),
+        fd(f),
+        events(0),
+        registered(false),
+        released(false),
+        queue(nullptr),
+        ctx(nullptr),
+        timeout_usec(0),
+        armed_events(0),
+        poll_seq(0),
+        inflight(0),
+        dirty(false) {}
+};
+
+#  if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+struct epoll_loop::uring_state_t {
+  uring_poller poller;
+  std::vector<handle_t *> dirty;  // handles whose polls should be changed before waiting
+};
+#  else
+struct epoll_loop::uring_state_t {};
+#  endif
+
+namespace detail {
+static int64_t epoll_loop_now_usec() {
+  time_t sec;
+  time_t usec;
+  epoll_loop::get_monotonic_time(sec, usec);
+  return static_cast<int64_t>(sec) * 1000000 + static_cast<int64_t>(usec);
+}
+
+#  if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+// handles are aligned by 8, so the low 3 bits of user_data are the sequence of the poll
+static const uint64_t epoll_loop_seq_mask = 7;
+
+static inline uint64_t epoll_loop_poll_tag(const void *h, uint32_t seq) {
+  return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(h)) | (seq & epoll_loop_seq_mask);
+}
+#  endif
+
+// attach connections when cluster or raw connect, and then call the original callback
+struct epoll_cluster_connect {
+  epoll_loop *loop;
+  cluster::onconnect_fn_t next;
+
+  void operator()(cluster *clu, connection *conn) {
+    if (nullptr != conn) {
+      loop->attach(conn->get_context());
+    }
+
+    if (next) {
+      next(clu, conn);
+    }
+  }
+};
+
+struct epoll_raw_connect {
+  epoll_loop *loop;
+  raw::onconnect_fn_t next;
+
+  void operator()(raw *r, connection *conn) {
+    if (nullptr != conn) {
+      loop->attach(conn->get_context());
+    }
+
+    if (next) {
+      next(r, conn);
+    }
+  }
+};
+}  // namespace detail
+
+HIREDIS_HAPP_API epoll_loop::epoll_loop()
+    : backend_(backend_t::AUTO),
+      epoll_fd_(-1),
+      uring_(nullptr),
+      timer_(nullptr),
+      wakeup_(nullptr),
+      stopping_(false),
+      running_(false) {
+  stats_.wait_count = 0;
+  stats_.control_count = 0;
+  stats_.event_count = 0;
+}
+
+HIREDIS_HAPP_API epoll_loop::~epoll_loop() {
+  stop();
+  join();
+
+#  if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+  // polls in kernel are dropped with the ring, so all handles can be deleted
+  if (nullptr != uring_) {
+    uring_->poller.close();
+    uring_->dirty.clear();
+  }
+  for (size_t i = 0; i < contexts_.size(); ++i) {
+    contexts_[i]->inflight = 0;
+    contexts_[i]->dirty = false;
+  }
+  for (size_t i = 0; i < released_.size(); ++i) {
+    released_[i]->inflight = 0;
+    released_[i]->dirty = false;
+  }
+#  endif
+
+  // contexts still attached will not call back into this loop
+  for (size_t i = 0; i < contexts_.size(); ++i) {
+    handle_t *h = contexts_[i];
+    if (!h->released && nullptr != h->ctx) {
+      h->ctx->ev.data = nullptr;
+      h->ctx->ev.addRead = nullptr;
+      h->ctx->ev.delRead = nullptr;
+      h->ctx->ev.addWrite = nullptr;
+      h->ctx->ev.delWrite = nullptr;
+      h->ctx->ev.cleanup = nullptr;
+      h->ctx->ev.scheduleTimer = nullptr;
+      h->released = true;
+      released_.push_back(h);
+    }
+  }
+  collect();
+
+  for (size_t i = 0; i < submits_.size(); ++i) {
+    delete submits_[i];
+  }
+  submits_.clear();
+
+  if (nullptr != timer_) {
+    close(timer_->fd);
+    delete timer_;
+    timer_ = nullptr;
+  }
+
+  if (nullptr != wakeup_) {
+    close(wakeup_->fd);
+    delete wakeup_;
+    wakeup_ = nullptr;
+  }
+
+  if (epoll_fd_ >= 0) {
+    close(epoll_fd_);
+    epoll_fd_ = -1;
+  }
+
+  delete uring_;
+  uring_ = nullptr;
+}
+
+HIREDIS_HAPP_API int epoll_loop::init(time_t tick_usec, backend_t::type backend) {
+  if (backend_t::AUTO != backend_) {
+    return error_code::REDIS_HAPP_OK;
+  }
+
+  if (tick_usec <= 0) {
+    tick_usec = HIREDIS_HAPP_LOOP_TICK_USEC;
+  }
+
+#  if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+  if (backend_t::EPOLL != backend) {
+    uring_ = new uring_state_t();
+    if (error_code::REDIS_HAPP_OK == uring_->poller.init(HIREDIS_HAPP_LOOP_URING_ENTRIES)) {
+      backend_ = backend_t::IO_URING;
+    } else {
+      delete uring_;
+      uring_ = nullptr;
+      if (backend_t::IO_URING == backend) {
+        return error_code::REDIS_HAPP_CREATE;
+      }
+    }
+  }
+#  else
+  if (backend_t::IO_URING == backend) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+#  endif
+
+  // fall back to epoll
+  if (backend_t::AUTO == backend_) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+      return error_code::REDIS_HAPP_CREATE;
+    }
+    backend_ = backend_t::EPOLL;
+  }
+
+  int timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  int wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (timer_fd < 0 || wakeup_fd < 0) {
+    if (timer_fd >= 0) {
+      close(timer_fd);
+    }
+    if (wakeup_fd >= 0) {
+      close(wakeup_fd);
+    }
+    if (epoll_fd_ >= 0) {
+      close(epoll_fd_);
+      epoll_fd_ = -1;
+    }
+    delete uring_;
+    uring_ = nullptr;
+    backend_ = backend_t::AUTO;
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  struct itimerspec spec;
+  spec.it_interval.tv_sec = tick_usec / 1000000;
+  spec.it_interval.tv_nsec = static_cast<long>((tick_usec % 1000000) * 1000);
+  spec.it_value = spec.it_interval;
+  timerfd_settime(timer_fd, 0, &spec, nullptr);
+
+  timer_ = new handle_t(this, handle_t::kind::TIMER, timer_fd);
+  update(timer_, EPOLLIN);
+
+  wakeup_ = new handle_t(this, handle_t::kind::WAKEUP, wakeup_fd);
+  update(wakeup_, EPOLLIN);
+
+  return error_code::REDIS_HAPP_OK;
+}
+
+HIREDIS_HAPP_API epoll_loop::backend_t::type epoll_loop::get_backend() const { return backend_; }
+
+HIREDIS_HAPP_API epoll_loop::stats_t epoll_loop::get_stats() const {
+  stats_t ret = stats_;
+#  if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+  if (backend_t::IO_URING == backend_) {
+    ret.wait_count = uring_->poller.get_wait_count();
+    ret.control_count = uring_->poller.get_submit_count();
+  }
+#  endif
+  return ret;
+}
+
+HIREDIS_HAPP_API int epoll_loop::bind(cluster &clu) {
+  if (backend_t::AUTO == backend_) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  int fd = clu.get_submit_queue().enable_eventfd();
+  if (fd >= 0) {
+    handle_t *h = new handle_t(this, handle_t::kind::SUBMIT, fd);
+    h->queue = &clu.get_submit_queue();
+    submits_.push_back(h);
+    update(h, EPOLLIN);
+  }
+
+  detail::epoll_cluster_connect cbk;
+  cbk.loop = this;
+  cbk.next = clu.set_on_connect(nullptr);
+  clu.set_on_connect(cbk);
+
+  bound_t b;
+  b.clu = &clu;
+  b.r = nullptr;
+  bound_.push_back(b);
+  return error_code::REDIS_HAPP_OK;
+}
+
+HIREDIS_HAPP_API int epoll_loop::bind(raw &r) {
+  if (backend_t::AUTO == backend_) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  int fd = r.get_submit_queue().enable_eventfd();
+  if (fd >= 0) {
+    handle_t *h = new handle_t(this, handle_t::kind::SUBMIT, fd);
+    h->queue = &r.get_submit_queue();
+    submits_.push_back(h);
+    update(h, EPOLLIN);
+  }
+
+  detail::epoll_raw_connect cbk;
+  cbk.loop = this;
+  cbk.next = r.set_on_connect(nullptr);
+  r.set_on_connect(cbk);
+
+  bound_t b;
+  b.clu = nullptr;
+  b.r = &r;
+  bound_.push_back(b);
+  return error_code::REDIS_HAPP_OK;
+}
+
+HIREDIS_HAPP_API int epoll_loop::attach(redisAsyncContext *ctx) {
+  if (nullptr == ctx || backend_t::AUTO == backend_) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  // already attached to a loop
+  if (nullptr != ctx->ev.data) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  handle_t *h = new handle_t(this, handle_t::kind::CONTEXT, ctx->c.fd);
+  h->ctx = ctx;
+  contexts_.push_back(h);
+
+  ctx->ev.data = h;
+  ctx->ev.addRead = on_add_read;
+  ctx->ev.delRead = on_del_read;
+  ctx->ev.addWrite = on_add_write;
+  ctx->ev.delWrite = on_del_write;
+  ctx->ev.cleanup = on_cleanup;
+  ctx->ev.scheduleTimer = on_schedule_timer;
+
+  // connecting socket becomes writable when it's connected, the write event set before attaching is lost
+  if (0 == (ctx->c.flags & REDIS_CONNECTED)) {
+    update(h, h->events | EPOLLOUT);
+  }
+
+  return error_code::REDIS_HAPP_OK;
+}
+
+HIREDIS_HAPP_API int epoll_loop::run_once(int timeout_ms) {
+  int count;
+  switch (backend_) {
+#  if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+    case backend_t::IO_URING:
+      count = wait_uring(timeout_ms);
+      break;
+#  endif
+    case backend_t::EPOLL:
+      count = wait_epoll(timeout_ms);
+      break;
+    default:
+      return error_code::REDIS_HAPP_CREATE;
+  }
+
+  if (count > 0) {
+    stats_.event_count += static_cast<uint64_t>(count);
+  }
+
+  collect();
+  return count;
+}
+
+HIREDIS_HAPP_API int epoll_loop::run() {
+  if (backend_t::AUTO == backend_) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  running_.store(true, std::memory_order_release);
+  int ret = error_code::REDIS_HAPP_OK;
+  while (!stopping_.load(std::memory_order_acquire)) {
+    int res = run_once(-1);
+    if (res < 0) {
+      ret = res;
+      break;
+    }
+  }
+
+  stopping_.store(false, std::memory_order_release);
+  running_.store(false, std::memory_order_release);
+  return ret;
+}
+
+HIREDIS_HAPP_API void epoll_loop::stop() {
+  stopping_.store(true, std::memory_order_release);
+
+  if (nullptr != wakeup_) {
+    uint64_t value = 1;
+    ssize_t res = write(wakeup_->fd, &value, sizeof(value));
+    (void)res;
+  }
+}
+
+HIREDIS_HAPP_API int epoll_loop::start_thread() {
+  if (backend_t::AUTO == backend_) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  if (thread_.joinable()) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  thread_ = std::thread(&epoll_loop::run, this);
+  return error_code::REDIS_HAPP_OK;
+}
+
+HIREDIS_HAPP_API void epoll_loop::join() {
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+HIREDIS_HAPP_API bool epoll_loop::is_running() const { return running_.load(std::memory_order_acquire); }
+
+HIREDIS_HAPP_API size_t epoll_loop::get_attached_count() const {
+  size_t ret = 0;
+  for (size_t i = 0; i < contexts_.size(); ++i) {
+    if (!contexts_[i]->released) {
+      ++ret;
+    }
+  }
+
+  return ret;
+}
+
+HIREDIS_HAPP_API void epoll_loop::get_monotonic_time(time_t &sec, time_t &usec) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  sec = now.tv_sec;
+  usec = static_cast<time_t>(now.tv_nsec / 1000);
+}
+
+void epoll_loop::on_tick() {
+  time_t sec;
+  time_t usec;
+  get_monotonic_time(sec, usec);
+
+  for (size_t i = 0; i < bound_.size(); ++i) {
+    if (nullptr != bound_[i].clu) {
+      bound_[i].clu->proc(sec, usec);
+    } else if (nullptr != bound_[i].r) {
+      bound_[i].r->proc(sec, usec);
+    }
+  }
+
+  // timeouts set by redisAsyncSetTimeout, contexts attached while handling timeouts are checked in next tick
+  int64_t now = static_cast<int64_t>(sec) * 1000000 + static_cast<int64_t>(usec);
+  size_t count = contexts_.size();
+  for (size_t i = 0; i < count; ++i) {
+    handle_t *h = contexts_[i];
+    if (!h->released && 0 != h->timeout_usec && h->timeout_usec <= now) {
+      h->timeout_usec = 0;
+      redisAsyncHandleTimeout(h->ctx);
+    }
+  }
+}
+
+void epoll_loop::dispatch(handle_t *h, uint32_t events) {
+  switch (h->type) {
+    case handle_t::kind::TIMER: {
+      uint64_t expirations;
+      while (read(h->fd, &expirations, sizeof(expirations)) > 0) {
+      }
+      on_tick();
+      break;
+    }
+    case handle_t::kind::WAKEUP: {
+      uint64_t value;
+      while (read(h->fd, &value, sizeof(value)) > 0) {
+      }
+      break;
+    }
+    case handle_t::kind::SUBMIT: {
+      h->queue->on_wakeup();
+      break;
+    }
+    case handle_t::kind::CONTEXT: {
+      redisAsyncContext *ctx = h->ctx;
+      bool error = 0 != (events & (EPOLLERR | EPOLLHUP));
+      if (((events & EPOLLIN) || error) && (h->events & EPOLLIN)) {
+        redisAsyncHandleRead(ctx);
+      }
+
+      // the context may be freed by reading
+      if (!h->released && ((events & EPOLLOUT) || error) && (h->events & EPOLLOUT)) {
+        redisAsyncHandleWrite(ctx);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+}
+
+int epoll_loop::wait_epoll(int timeout_ms) {
+  struct epoll_event events[64];
+  ++stats_.wait_count;
+  int count = epoll_wait(epoll_fd_, events, 64, timeout_ms);
+  if (count < 0) {
+    return EINTR == errno ? 0 : error_code::REDIS_HAPP_UNKNOWD;
+  }
+
+  for (int i = 0; i < count; ++i) {
+    handle_t *h = reinterpret_cast<handle_t *>(events[i].data.ptr);
+    // released by callbacks of events before it
+    if (!h->released) {
+      dispatch(h, events[i].events);
+    }
+  }
+
+  return count;
+}
+
+int epoll_loop::wait_uring(int timeout_ms) {
+#  if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+  // poll changes of the last iteration are submitted with waiting by one io_uring_enter
+  flush_polls();
+  if (error_code::REDIS_HAPP_OK != uring_->poller.submit_and_wait(timeout_ms)) {
+    return error_code::REDIS_HAPP_UNKNOWD;
+  }
+
+  int ret = 0;
+  uring_poller::completion_t completions[64];
+  size_t count;
+  do {
+    count = uring_->poller.reap(completions, 64);
+    for (size_t i = 0; i < count; ++i) {
+      uint64_t user_data = completions[i].user_data;
+      // completions of timeouts and removing polls
+      if (0 == user_data) {
+        continue;
+      }
+
+      handle_t *h = reinterpret_cast<handle_t *>(static_cast<uintptr_t>(user_data & ~detail::epoll_loop_seq_mask));
+      --h->inflight;
+
+      // polls are one-shot, the latest one is added again before next waiting
+      if ((user_data & detail::epoll_loop_seq_mask) == (h->poll_seq & detail::epoll_loop_seq_mask)) {
+        h->armed_events = 0;
+        if (!h->released && 0 != h->events && !h->dirty) {
+          h->dirty = true;
+          uring_->dirty.push_back(h);
+        }
+      }
+
+      // removed polls complete with -ECANCELED
+      if (h->released || completions[i].res <= 0) {
+        continue;
+      }
+
+      ++ret;
+      dispatch(h, static_cast<uint32_t>(completions[i].res));
+    }
+  } while (count >= 64);
+
+  return ret;
+#  else
+  (void)timeout_ms;
+  return error_code::REDIS_HAPP_CREATE;
+#  endif
+}
+
+void epoll_loop::flush_polls() {
+#  if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+  for (size_t i = 0; i < uring_->dirty.size(); ++i) {
+    handle_t *h = uring_->dirty[i];
+    h->dirty = false;
+
+    // the poll in kernel covers all events wanted, events not wanted any more are filtered when it completes
+    if (h->released || 0 == (h->events & ~h->armed_events)) {
+      continue;
+    }
+
+    if (0 != h->armed_events) {
+      uring_->poller.poll_remove(detail::epoll_loop_poll_tag(h, h->poll_seq));
+    }
+
+    ++h->poll_seq;
+    if (error_code::REDIS_HAPP_OK ==
+        uring_->poller.poll_add(h->fd, h->events, detail::epoll_loop_poll_tag(h, h->poll_seq))) {
+      h->armed_events = h->events;
+      ++h->inflight;
+    } else {
+      h->armed_events = 0;
+    }
+  }
+  uring_->dirty.clear();
+#  endif
+}
+
+int epoll_loop::update(handle_t *h, uint32_t events) {
+  if (h->registered && h->events == events) {
+    return error_code::REDIS_HAPP_OK;
+  }
+
+#  if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+  // polls are changed by flush_polls() before waiting, so changes of one iteration cost no syscall
+  if (backend_t::IO_URING == backend_) {
+    h->registered = true;
+    h->events = events;
+    if (!h->dirty) {
+      h->dirty = true;
+      uring_->dirty.push_back(h);
+    }
+    return error_code::REDIS_HAPP_OK;
+  }
+#  endif
+
+  ++stats_.control_count;
+  struct epoll_event ev;
+  ev.events = events;
+  ev.data.ptr = h;
+  int res = epoll_ctl(epoll_fd_, h->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD, h->fd, &ev);
+  if (0 != res) {
+    return error_code::REDIS_HAPP_UNKNOWD;
+  }
+
+  h->registered = true;
+  h->events = events;
+  return error_code::REDIS_HAPP_OK;
+}
+
+void epoll_loop::release(handle_t *h) {
+  if (h->released) {
+    return;
+  }
+
+  // the fd may be closed by hiredis right after cleanup, so remove it now
+#  if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+  if (backend_t::IO_URING == backend_) {
+    // a poll in kernel holds the socket, submit removing at once so it's closed in time
+    if (0 != h->armed_events) {
+      uring_->poller.poll_remove(detail::epoll_loop_poll_tag(h, h->poll_seq));
+      uring_->poller.submit();
+      h->armed_events = 0;
+    }
+    h->registered = false;
+  }
+#  endif
+  if (h->registered) {
+    ++stats_.control_count;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, h->fd, nullptr);
+    h->registered = false;
+  }
+
+  // events of it may be still in the current batch, so it's deleted after the batch
+  h->released = true;
+  h->ctx = nullptr;
+  released_.push_back(h);
+}
+
+void epoll_loop::collect() {
+  if (released_.empty()) {
+    return;
+  }
+
+  size_t left = 0;
+  for (size_t i = 0; i < contexts_.size(); ++i) {
+    if (!contexts_[i]->released) {
+      contexts_[left++] = contexts_[i];
+    }
+  }
+  contexts_.resize(left);
+
+  // handles with polls in kernel are deleted after the polls complete
+  left = 0;
+  for (size_t i = 0; i < released_.size(); ++i) {
+    if (0 == released_[i]->inflight && !released_[i]->dirty) {
+      delete released_[i];
+    } else {
+      released_[left++] = released_[i];
+    }
+  }
+  released_.resize(left);
+}
+
+void epoll_loop::on_add_read(void *privdata) {
+  handle_t *h = reinterpret_cast<handle_t *>(privdata);
+  if (nullptr != h && !h->released) {
+    h->owner->update(h, h->events | EPOLLIN);
+  }
+}
+
+void epoll_loop::on_del_read(void *privdata) {
+  handle_t *h = reinterpret_cast<handle_t *>(privdata);
+  if (nullptr != h && !h->released) {
+    h->owner->update(h, h->events & ~static_cast<uint32_t>(EPOLLIN));
+  }
+}
+
+void epoll_loop::on_add_write(void *privdata) {
+  handle_t *h = reinterpret_cast<handle_t *>(privdata);
+  if (nullptr != h && !h->released) {
+    h->owner->update(h, h->events | EPOLLOUT);
+  }
+}
+
+void epoll_loop::on_del_write(void *privdata) {
+  handle_t *h = reinterpret_cast<handle_t *>(privdata);
+  if (nullptr != h && !h->released) {
+    h->owner->update(h, h->events & ~static_cast<uint32_t>(EPOLLOUT));
+  }
+}
+
+void epoll_loop::on_cleanup(void *privdata) {
+  handle_t *h = reinterpret_cast<handle_t *>(privdata);
+  if (nullptr != h) {
+    h->owner->release(h);
+  }
+}
+
+void epoll_loop::on_schedule_timer(void *privdata, struct timeval tv) {
+  handle_t *h = reinterpret_cast<handle_t *>(privdata);
+  if (nullptr == h || h->released) {
+    return;
+  }
+
+  h->timeout_usec = detail::epoll_loop_now_usec() + static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+}  // namespace happ
+}  // namespace hiredis
+
+#endif
@@ -0,0 +1,204 @@
+// Copyright 2026 owent
+
+#include "detail/happ_metrics.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+namespace hiredis {
+namespace happ {
+namespace detail {
+static inline uint32_t highest_bit(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<uint32_t>(63 - __builtin_clzll(v));
+#elif defined(_MSC_VER) && defined(_WIN64)
+  unsigned long ret = 0;
+  _BitScanReverse64(&ret, v);
+  return static_cast<uint32_t>(ret);
+#else
+  uint32_t ret = 0;
+  while (v >>= 1) {
+    ++ret;
+  }
+  return ret;
+#endif
+}
+
+static bool node_id_less(const metrics::node_t &l, const metrics::node_t &r) { return l.id < r.id; }
+}  // namespace detail
+
+HIREDIS_HAPP_API latency_histogram::latency_histogram() { reset(); }
+
+HIREDIS_HAPP_API void latency_histogram::add(uint64_t usec) {
+  ++count_;
+  sum_usec_ += usec;
+  if (usec > max_usec_) {
+    max_usec_ = usec;
+  }
+  ++buckets_[get_bucket_index(usec)];
+}
+
+HIREDIS_HAPP_API void latency_histogram::merge(const latency_histogram &other) {
+  count_ += other.count_;
+  sum_usec_ += other.sum_usec_;
+  if (other.max_usec_ > max_usec_) {
+    max_usec_ = other.max_usec_;
+  }
+  for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+    buckets_[i] += other.buckets_[i];
+  }
+}
+
+HIREDIS_HAPP_API void latency_histogram::reset() {
+  count_ = 0;
+  sum_usec_ = 0;
+  max_usec_ = 0;
+  memset(buckets_, 0, sizeof(buckets_));
+}
+
+HIREDIS_HAPP_API uint64_t latency_histogram::get_count() const { return count_; }
+
+HIREDIS_HAPP_API uint64_t latency_histogram::get_sum_usec() const { return sum_usec_; }
+
+HIREDIS_HAPP_API uint64_t latency_histogram::get_max_usec() const { return max_usec_; }
+
+HIREDIS_HAPP_API uint64_t latency_histogram::get_bucket(size_t index) const {
+  return index < BUCKET_COUNT ? buckets_[index] : 0;
+}
+
+HIREDIS_HAPP_API uint64_t latency_histogram::get_percentile(double percentile) const {
+  if (0 == count_) {
+    return 0;
+  }
+
+  // rank of the sample, start from 1
+  uint64_t rank;
+  if (percentile <= 0.0) {
+    rank = 1;
+  } else if (percentile >= 100.0) {
+    rank = count_;
+  } else {
+    rank = static_cast<uint64_t>(static_cast<double>(count_) * percentile / 100.0 + 0.5);
+    if (rank < 1) {
+      rank = 1;
+    }
+  }
+
+  uint64_t seen = 0;
+  for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+    seen += buckets_[i];
+    if (seen >= rank) {
+      uint64_t ret = get_bucket_upper_bound(i);
+      return ret < max_usec_ ? ret : max_usec_;
+    }
+  }
+
+  return max_usec_;
+}
+
+HIREDIS_HAPP_API size_t latency_histogram::get_bucket_index(uint64_t usec) {
+  if (usec < SUB_BUCKET_COUNT) {
+    return static_cast<size_t>(usec);
+  }
+
+  uint32_t shift = detail::highest_bit(usec);
+  if (shift > MAX_SHIFT) {
+    return BUCKET_COUNT - 1;
+  }
+
+  // [SUB_BUCKET_COUNT, 2 * SUB_BUCKET_COUNT) are in group 1, and every group doubles the width of its buckets
+  size_t group = shift - SUB_BUCKET_BITS + 1;
+  size_t sub = static_cast<size_t>((usec >> (shift - SUB_BUCKET_BITS)) & (SUB_BUCKET_COUNT - 1));
+  return group * SUB_BUCKET_COUNT + sub;
+}
+
+HIREDIS_HAPP_API uint64_t latency_histogram::get_bucket_upper_bound(size_t index) {
+  if (index < SUB_BUCKET_COUNT) {
+    return static_cast<uint64_t>(index);
+  }
+
+  if (index >= BUCKET_COUNT - 1) {
+    return UINT64_MAX;
+  }
+
+  size_t group = index / SUB_BUCKET_COUNT;
+  size_t sub = index % SUB_BUCKET_COUNT;
+  uint32_t width_shift = static_cast<uint32_t>(group - 1);
+  uint64_t lower = static_cast<uint64_t>(SUB_BUCKET_COUNT + sub) << width_shift;
+  return lower + (static_cast<uint64_t>(1) << width_shift) - 1;
+}
+
+HIREDIS_HAPP_API metrics::metrics() { reset(); }
+
+HIREDIS_HAPP_API void metrics::reset() {
+  memset(&counters_, 0, sizeof(counters_));
+  nodes_.clear();
+}
+
+HIREDIS_HAPP_API metrics::counters_t &metrics::get_counters() { return counters_; }
+
+HIREDIS_HAPP_API const metrics::counters_t &metrics::get_counters() const { return counters_; }
+
+HIREDIS_HAPP_API metrics::node_t &metrics::mutable_node(const connection::key_t &key) {
+  HIREDIS_HAPP_MAP(connection::node_id_t, node_t)::iterator iter = nodes_.find(key.id);
+  if (iter != nodes_.end()) {
+    return iter->second;
+  }
+
+  node_t &ret = nodes_[key.id];
+  ret.id = key.id;
+  ret.name = key.name;
+  ret.cmd_sent = 0;
+  ret.replies = 0;
+  ret.failures = 0;
+  return ret;
+}
+
+HIREDIS_HAPP_API const metrics::node_t *metrics::get_node(connection::node_id_t id) const {
+  HIREDIS_HAPP_MAP(connection::node_id_t, node_t)::const_iterator iter = nodes_.find(id);
+  if (iter == nodes_.end()) {
+    return nullptr;
+  }
+
+  return &iter->second;
+}
+
+HIREDIS_HAPP_API void metrics::get_nodes(std::vector<node_t> &out) const {
+  out.clear();
+  out.reserve(nodes_.size());
+  for (HIREDIS_HAPP_MAP(connection::node_id_t, node_t)::const_iterator iter = nodes_.begin(); iter != nodes_.end();
+       ++iter) {
+    out.push_back(iter->second);
+  }
+
+  std::sort(out.begin(), out.end(), detail::node_id_less);
+}
+
+HIREDIS_HAPP_API void metrics::add_cmd_finished(int rcode) {
+  if (error_code::REDIS_HAPP_OK == rcode) {
+    ++counters_.cmd_succeeded;
+  } else {
+    ++counters_.cmd_failed;
+  }
+
+  ++counters_.cmd_finished_by_code[get_error_index(rcode)];
+}
+
+HIREDIS_HAPP_API size_t metrics::get_error_index(int rcode) {
+  if (error_code::REDIS_HAPP_OK == rcode) {
+    return 0;
+  }
+
+  if (rcode > error_code::REDIS_HAPP_UNKNOWD ||
+      rcode <= static_cast<int>(error_code::REDIS_HAPP_UNKNOWD) - static_cast<int>(ERROR_CODE_COUNT) + 1) {
+    return 1;
+  }
+
+  return static_cast<size_t>(error_code::REDIS_HAPP_UNKNOWD - rcode) + 1;
+}
+}  // namespace happ
+}  // namespace hiredis
@@ -0,0 +1,59 @@
+// Copyright 2026 owent
+
+#include "detail/happ_node_registry.h"
+
+namespace hiredis {
+namespace happ {
+HIREDIS_HAPP_API node_registry::node_registry() {}
+
+HIREDIS_HAPP_API const connection::key_t *node_registry::intern(const std::string &ip, uint16_t port) {
+  std::string name = connection::make_name(ip, port);
+  HIREDIS_HAPP_MAP(std::string, node_id_t)::const_iterator iter = names_.find(name);
+  if (names_.end() != iter) {
+    return &nodes_[iter->second - 1];
+  }
+
+  nodes_.push_back(connection::key_t());
+  connection::key_t &ret = nodes_.back();
+  ret.name.swap(name);
+  ret.ip = ip;
+  ret.port = port;
+  ret.id = static_cast<node_id_t>(nodes_.size());
+
+  names_[ret.name] = ret.id;
+  return &ret;
+}
+
+HIREDIS_HAPP_API const connection::key_t *node_registry::intern(const connection::key_t &key) {
+  const connection::key_t *ret = get(key.id);
+  if (nullptr != ret && ret->name == key.name) {
+    return ret;
+  }
+
+  return intern(key.ip, key.port);
+}
+
+HIREDIS_HAPP_API node_registry::node_id_t node_registry::find(const std::string &name) const {
+  HIREDIS_HAPP_MAP(std::string, node_id_t)::const_iterator iter = names_.find(name);
+  if (names_.end() == iter) {
+    return 0;
+  }
+
+  return iter->second;
+}
+
+HIREDIS_HAPP_API node_registry::node_id_t node_registry::find(const std::string &ip, uint16_t port) const {
+  return find(connection::make_name(ip, port));
+}
+
+HIREDIS_HAPP_API const connection::key_t *node_registry::get(node_id_t id) const {
+  if (0 == id || id > nodes_.size()) {
+    return nullptr;
+  }
+
+  return &nodes_[id - 1];
+}
+
+HIREDIS_HAPP_API size_t node_registry::size() const { return nodes_.size(); }
+}  // namespace happ
+}  // namespace hiredis
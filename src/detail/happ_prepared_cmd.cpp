@@ -0,0 +1,105 @@
+// Copyright 2026 owent
+
+#include "detail/happ_prepared_cmd.h"
+
+#include <cstring>
+
+#include "detail/happ_cmd.h"
+
+namespace hiredis {
+namespace happ {
+HIREDIS_HAPP_API prepared_cmd::prepared_cmd() : argc_(0) {}
+
+HIREDIS_HAPP_API int prepared_cmd::init(const char *pattern) {
+  if (nullptr == pattern) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  std::vector<const char *> argv;
+  std::vector<size_t> argvlen;
+  const char *pos = pattern;
+  while (*pos) {
+    while (' ' == *pos) {
+      ++pos;
+    }
+
+    const char *start = pos;
+    while (*pos && ' ' != *pos) {
+      ++pos;
+    }
+
+    if (pos == start) {
+      break;
+    }
+
+    if (1 == pos - start && '?' == *start) {
+      argv.push_back(nullptr);
+      argvlen.push_back(0);
+    } else {
+      argv.push_back(start);
+      argvlen.push_back(static_cast<size_t>(pos - start));
+    }
+  }
+
+  return init(static_cast<int>(argv.size()), argv.empty() ? nullptr : &argv[0],
+              argvlen.empty() ? nullptr : &argvlen[0]);
+}
+
+HIREDIS_HAPP_API int prepared_cmd::init(int argc, const char **argv, const size_t *argvlen) {
+  reset();
+  if (argc <= 0 || nullptr == argv) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  char header[32];
+  encoded_.append(header, detail::resp_write_header(header, '*', static_cast<size_t>(argc)) - header);
+  for (int i = 0; i < argc; ++i) {
+    // placeholder, start a new segment
+    if (nullptr == argv[i]) {
+      offsets_.push_back(encoded_.size());
+      continue;
+    }
+
+    size_t len = nullptr == argvlen ? strlen(argv[i]) : argvlen[i];
+    encoded_.append(header, detail::resp_write_header(header, '$', len) - header);
+    encoded_.append(argv[i], len);
+    encoded_.append("\r\n", 2);
+  }
+  offsets_.push_back(encoded_.size());
+
+  argc_ = static_cast<size_t>(argc);
+  return error_code::REDIS_HAPP_OK;
+}
+
+HIREDIS_HAPP_API void prepared_cmd::reset() {
+  encoded_.clear();
+  offsets_.clear();
+  argc_ = 0;
+}
+
+HIREDIS_HAPP_API bool prepared_cmd::empty() const { return 0 == argc_; }
+
+HIREDIS_HAPP_API size_t prepared_cmd::get_argument_count() const { return argc_; }
+
+HIREDIS_HAPP_API size_t prepared_cmd::get_placeholder_count() const {
+  return offsets_.empty() ? 0 : offsets_.size() - 1;
+}
+
+HIREDIS_HAPP_API size_t prepared_cmd::get_constant_length() const { return encoded_.size(); }
+
+HIREDIS_HAPP_API const char *prepared_cmd::get_segment(size_t idx, size_t *len) const {
+  if (idx >= offsets_.size()) {
+    if (nullptr != len) {
+      *len = 0;
+    }
+    return nullptr;
+  }
+
+  size_t start = 0 == idx ? 0 : offsets_[idx - 1];
+  if (nullptr != len) {
+    *len = offsets_[idx] - start;
+  }
+  return encoded_.data() + start;
+}
+}  // namespace happ
+}  // namespace hiredis
@@ -31,7 +31,7 @@ namespace detail {
 static char NONE_MSG[] = "none";
 }
 
-HIREDIS_HAPP_API raw::raw() {
+HIREDIS_HAPP_API raw::raw() : cmd_pool_(cmd_pool::create()) {
   conf_.log_fn_debug = conf_.log_fn_info = nullptr;
   conf_.log_buffer = nullptr;
   conf_.log_max_size = 0;
@@ -41,6 +41,8 @@ HIREDIS_HAPP_API raw::raw() {
   conf_.keepalive_interval_sec = 0;
 
   conf_.cmd_buffer_size = 0;
+  conf_.reply_arena_chunk_size = 0;
+  conf_.reply_stream = false;
 
   callbacks_.on_connect = nullptr;
   callbacks_.on_connected = nullptr;
@@ -56,6 +58,10 @@ HIREDIS_HAPP_API raw::raw() {
 HIREDIS_HAPP_API raw::~raw() {
   reset();
 
+  // cmds still in use will return to pool later, the pool will be destroyed after that
+  cmd_pool::release(cmd_pool_);
+  cmd_pool_ = nullptr;
+
   // log buffer
   if (nullptr != conf_.log_buffer) {
     free(conf_.log_buffer);
@@ -89,9 +95,10 @@ HIREDIS_HAPP_API int raw::reset() {
   }
 
   // release timer pending list
-  while (!timer_actions_.timer_pending.empty()) {
-    cmd_t *cmd = timer_actions_.timer_pending.front().cmd;
-    timer_actions_.timer_pending.pop_front();
+  timer_actions_.timer_pending.flush();
+  for (timer_node *node = timer_actions_.timer_pending.pop_expired(); nullptr != node;
+       node = timer_actions_.timer_pending.pop_expired()) {
+    cmd_t *cmd = reinterpret_cast<cmd_t *>(node->data);
 
     call_cmd(cmd, error_code::REDIS_HAPP_TIMEOUT, nullptr, nullptr);
     destroy_cmd(cmd);
@@ -129,6 +136,27 @@ HIREDIS_HAPP_API raw::cmd_t *raw::exec(cmd_t::callback_fn_t cbk, void *priv_data
   return exec(cmd);
 }
 
+HIREDIS_HAPP_API raw::cmd_t *raw::exec_reference(cmd_t::callback_fn_t cbk, void *priv_data, int argc,
+                                                 const char **argv, const size_t *argvlen,
+                                                 cmd_t::release_fn_t release_fn, void *release_data) {
+  cmd_t *cmd = create_cmd(cbk, priv_data);
+  if (nullptr == cmd) {
+    if (nullptr != release_fn) {
+      release_fn(release_data);
+    }
+    return nullptr;
+  }
+
+  int64_t len = cmd->vformat_reference(argc, argv, argvlen, release_fn, release_data);
+  if (len <= 0) {
+    log_info("format cmd with argc=%d failed", argc);
+    destroy_cmd(cmd);
+    return nullptr;
+  }
+
+  return exec(cmd);
+}
+
 HIREDIS_HAPP_API raw::cmd_t *raw::exec(cmd_t::callback_fn_t cbk, void *priv_data, const char *fmt, ...) {
   cmd_t *cmd = create_cmd(cbk, priv_data);
   if (nullptr == cmd) {
@@ -308,6 +336,16 @@ HIREDIS_HAPP_API raw::connection_t *raw::make_connection() {
     redisSetTimeout(&c->c, tv);
   }
 
+  if (conf_.reply_stream) {
+    if (nullptr == reply_stream::attach(c, on_reply_wrapper)) {
+      log_info("enable reply stream of %s failed, stream visitors of cmds will not be called",
+               conf_.init_connection.name.c_str());
+    }
+  } else if (conf_.reply_arena_chunk_size > 0 && nullptr == reply_arena::attach(c, conf_.reply_arena_chunk_size)) {
+    log_info("enable reply arena of raw %s failed, use default reply functions of hiredis",
+             conf_.init_connection.name.c_str());
+  }
+
   connection_ptr_t ret_ptr(new connection_t());
   connection_t &ret = *ret_ptr;
   swap(conn_, ret_ptr);
@@ -418,6 +456,18 @@ HIREDIS_HAPP_API void raw::set_cmd_buffer_size(size_t s) { conf_.cmd_buffer_size
 
 HIREDIS_HAPP_API size_t raw::get_cmd_buffer_size() const { return conf_.cmd_buffer_size; }
 
+HIREDIS_HAPP_API void raw::set_reply_arena_chunk_size(size_t chunk_size) { conf_.reply_arena_chunk_size = chunk_size; }
+
+HIREDIS_HAPP_API size_t raw::get_reply_arena_chunk_size() const { return conf_.reply_arena_chunk_size; }
+
+HIREDIS_HAPP_API void raw::set_reply_stream(bool enable) { conf_.reply_stream = enable; }
+
+HIREDIS_HAPP_API bool raw::is_reply_stream_enabled() const { return conf_.reply_stream; }
+
+HIREDIS_HAPP_API cmd_pool *raw::get_cmd_pool() { return cmd_pool_; }
+
+HIREDIS_HAPP_API const cmd_pool *raw::get_cmd_pool() const { return cmd_pool_; }
+
 HIREDIS_HAPP_API bool raw::is_timer_available() const {
   return conf_.timer_interval_sec > 0 || conf_.timer_interval_usec > 0;
 }
@@ -446,11 +496,11 @@ HIREDIS_HAPP_API void raw::add_timer_cmd(cmd_t *cmd) {
   }
 
   if (is_timer_active()) {
-    timer_actions_.timer_pending.push_back(timer_t::delay_t());
-    timer_t::delay_t &d = timer_actions_.timer_pending.back();
-    d.sec = timer_actions_.last_update_sec + conf_.timer_interval_sec;
-    d.usec = timer_actions_.last_update_usec + conf_.timer_interval_usec;
-    d.cmd = cmd;
+    timer_actions_.timer_pending.add(
+        &cmd->timer_,
+        timer_wheel::make_tick(timer_actions_.last_update_sec + conf_.timer_interval_sec,
+                               timer_actions_.last_update_usec + conf_.timer_interval_usec),
+        cmd);
   } else {
     exec(cmd);
   }
@@ -459,19 +509,17 @@ HIREDIS_HAPP_API void raw::add_timer_cmd(cmd_t *cmd) {
 HIREDIS_HAPP_API int raw::proc(time_t sec, time_t usec) {
   int ret = 0;
 
+  // tasks from other threads, the wakeup fd or function may be not used
+  submit_queue_.drain(HIREDIS_HAPP_SUBMIT_BATCH_SIZE);
+
   timer_actions_.last_update_sec = sec;
   timer_actions_.last_update_usec = usec;
 
-  while (!timer_actions_.timer_pending.empty()) {
-    timer_t::delay_t &rd = timer_actions_.timer_pending.front();
-    if (rd.sec > sec || (rd.sec == sec && rd.usec > usec)) {
-      break;
-    }
-
-    timer_t::delay_t d = rd;
-    timer_actions_.timer_pending.pop_front();
-
-    exec(d.cmd);
+  // retry cmds will be added with a later tick, so they will not be popped again in this round
+  timer_actions_.timer_pending.advance(timer_wheel::make_tick(sec, usec));
+  for (timer_node *node = timer_actions_.timer_pending.pop_expired(); nullptr != node;
+       node = timer_actions_.timer_pending.pop_expired()) {
+    exec(reinterpret_cast<cmd_t *>(node->data));
 
     ++ret;
   }
@@ -492,6 +540,8 @@ HIREDIS_HAPP_API int raw::proc(time_t sec, time_t usec) {
   return ret;
 }
 
+HIREDIS_HAPP_API submit_queue &raw::get_submit_queue() { return submit_queue_; }
+
 HIREDIS_HAPP_API void raw::set_log_writer(log_fn_t info_fn, log_fn_t debug_fn, size_t max_size) {
   using std::swap;
   conf_.log_fn_info = info_fn;
@@ -504,10 +554,54 @@ HIREDIS_HAPP_API void raw::set_log_writer(log_fn_t info_fn, log_fn_t debug_fn, s
   }
 }
 
+HIREDIS_HAPP_API raw::cmd_t *raw::exec_callable(cmd_t *cmd, int argc, const char **argv, const size_t *argvlen) {
+  if (nullptr == cmd) {
+    return nullptr;
+  }
+
+  int64_t len = cmd->vformat(argc, argv, argvlen);
+  if (len <= 0) {
+    log_info("format cmd with argc=%d failed", argc);
+    destroy_cmd(cmd);
+    return nullptr;
+  }
+
+  return exec(cmd);
+}
+
+HIREDIS_HAPP_API raw::cmd_t *raw::exec_callable(cmd_t *cmd, const char *fmt, va_list ap) {
+  if (nullptr == cmd) {
+    return nullptr;
+  }
+
+  int len = cmd->vformat(fmt, ap);
+  if (len <= 0) {
+    log_info("format cmd with format=%s failed", fmt);
+    destroy_cmd(cmd);
+    return nullptr;
+  }
+
+  return exec(cmd);
+}
+
+HIREDIS_HAPP_API raw::cmd_t *raw::exec_encoded(cmd_t *cmd, int64_t len) {
+  if (nullptr == cmd) {
+    return nullptr;
+  }
+
+  if (len <= 0) {
+    log_info("format cmd with typed arguments failed, res: %lld", static_cast<long long>(len));
+    destroy_cmd(cmd);
+    return nullptr;
+  }
+
+  return exec(cmd);
+}
+
 HIREDIS_HAPP_API raw::cmd_t *raw::create_cmd(cmd_t::callback_fn_t cbk, void *pridata) {
   holder_t h;
   h.r = this;
-  cmd_t *ret = cmd_t::create(h, cbk, pridata, conf_.cmd_buffer_size);
+  cmd_t *ret = cmd_t::create(cmd_pool_, h, cbk, pridata, conf_.cmd_buffer_size);
   return ret;
 }
 
@@ -536,6 +630,11 @@ HIREDIS_HAPP_API int raw::call_cmd(cmd_t *c, int err, redisAsyncContext *context
 
 void raw::on_reply_wrapper(redisAsyncContext *c, void *r, void *privdata) {
   connection_t *conn = reinterpret_cast<connection_t *>(c->data);
+  // connection is released, and cmd is already finished by it
+  if (nullptr == conn) {
+    return;
+  }
+
   cmd_t *cmd = reinterpret_cast<cmd_t *>(privdata);
   raw *self = cmd->holder_.r;
 
@@ -582,6 +681,10 @@ void raw::on_reply_wrapper(redisAsyncContext *c, void *r, void *privdata) {
 
 void raw::on_connected_wrapper(struct redisAsyncContext *c, int status) {
   connection_t *conn = reinterpret_cast<connection_t *>(c->data);
+  if (nullptr == conn) {
+    return;
+  }
+
   raw *self = conn->get_holder().r;
 
   // hiredis bug, sometimes 0 == status but c is already closed
@@ -614,6 +717,11 @@ void raw::on_connected_wrapper(struct redisAsyncContext *c, int status) {
 
 void raw::on_disconnected_wrapper(const struct redisAsyncContext *c, int status) {
   connection_t *conn = reinterpret_cast<connection_t *>(c->data);
+  // already released
+  if (nullptr == conn) {
+    return;
+  }
+
   raw *self = conn->get_holder().r;
 
   // release rreource
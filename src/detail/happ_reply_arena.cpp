@@ -0,0 +1,323 @@
+// Copyright 2026 owent
+
+#include "detail/happ_reply_arena.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace hiredis {
+namespace happ {
+struct reply_arena::chunk_t {
+  chunk_t *next;
+  size_t size;
+  size_t used;
+};
+
+namespace detail {
+static inline size_t reply_arena_align(size_t sz) {
+  return (sz + alignof(std::max_align_t) - 1) & (~(alignof(std::max_align_t) - 1));
+}
+
+// every redisReply is prefixed with the arena, so free_object can find it
+static inline size_t reply_arena_object_header() { return reply_arena_align(sizeof(void *)); }
+}  // namespace detail
+
+reply_arena::reply_arena(size_t chunk_size) : head_(nullptr), chunk_size_(chunk_size), used_(0), root_(nullptr) {
+  memset(&stats_, 0, sizeof(stats_));
+  if (chunk_size_ < sizeof(redisReply) * 4) {
+    chunk_size_ = sizeof(redisReply) * 4;
+  }
+  chunk_size_ = detail::reply_arena_align(chunk_size_);
+}
+
+reply_arena::~reply_arena() {
+  while (nullptr != head_) {
+    chunk_t *next = head_->next;
+    free_chunk(head_);
+    head_ = next;
+  }
+}
+
+HIREDIS_HAPP_API reply_arena *reply_arena::create(size_t chunk_size) { return new reply_arena(chunk_size); }
+
+HIREDIS_HAPP_API void reply_arena::release(void *arena) {
+  if (nullptr == arena) {
+    return;
+  }
+
+  delete reinterpret_cast<reply_arena *>(arena);
+}
+
+HIREDIS_HAPP_API reply_arena *reply_arena::attach(redisAsyncContext *c, size_t chunk_size) {
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+  // privdata of redisContext is released after the reader, so replies are always freed before the arena
+  if (nullptr == c || nullptr == c->c.reader || nullptr != c->c.reader->reply || nullptr != c->c.privdata) {
+    return nullptr;
+  }
+
+  reply_arena *ret = create(chunk_size);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  c->c.reader->fn = get_reply_functions();
+  c->c.reader->privdata = ret;
+  c->c.privdata = ret;
+  c->c.free_privdata = release;
+  return ret;
+#else
+  // redisContext::free_privdata is not available, we can not release the arena with the context
+  return nullptr;
+#endif
+}
+
+HIREDIS_HAPP_API reply_arena *reply_arena::get(const redisAsyncContext *c) {
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+  if (nullptr == c || nullptr == c->c.reader || get_reply_functions() != c->c.reader->fn ||
+      release != c->c.free_privdata) {
+    return nullptr;
+  }
+
+  return reinterpret_cast<reply_arena *>(c->c.privdata);
+#else
+  return nullptr;
+#endif
+}
+
+HIREDIS_HAPP_API redisReplyObjectFunctions *reply_arena::get_reply_functions() {
+  static redisReplyObjectFunctions ret = make_reply_functions();
+  return &ret;
+}
+
+HIREDIS_HAPP_API void *reply_arena::allocate(size_t size) {
+  size = detail::reply_arena_align(size);
+  if (nullptr == head_ || head_->used + size > head_->size) {
+    chunk_t *chunk = alloc_chunk(size);
+    if (nullptr == chunk) {
+      return nullptr;
+    }
+
+    chunk->next = head_;
+    head_ = chunk;
+  }
+
+  char *ret = reinterpret_cast<char *>(head_) + detail::reply_arena_align(sizeof(chunk_t)) + head_->used;
+  head_->used += size;
+  used_ += size;
+  ++stats_.allocations;
+  return ret;
+}
+
+HIREDIS_HAPP_API void reply_arena::reset() {
+  ++stats_.reset_count;
+  root_ = nullptr;
+
+  size_t limit = chunk_size_ > HIREDIS_HAPP_REPLY_ARENA_MAX_RETAIN ? chunk_size_ : HIREDIS_HAPP_REPLY_ARENA_MAX_RETAIN;
+  size_t target = used_ < chunk_size_ ? chunk_size_ : (used_ > limit ? limit : used_);
+  used_ = 0;
+
+  // only one chunk not too large, just reuse it
+  if (nullptr == head_ || (nullptr == head_->next && head_->size <= limit)) {
+    if (nullptr != head_) {
+      head_->used = 0;
+    }
+    return;
+  }
+
+  // merge all chunks into one, so the next reply of the same size needs only one chunk
+  while (nullptr != head_) {
+    chunk_t *next = head_->next;
+    free_chunk(head_);
+    head_ = next;
+  }
+
+  // allocate will try again if failed here
+  head_ = alloc_chunk(target);
+  if (nullptr != head_) {
+    head_->next = nullptr;
+  }
+}
+
+HIREDIS_HAPP_API const reply_arena::stats_t &reply_arena::get_stats() const { return stats_; }
+
+redisReplyObjectFunctions reply_arena::make_reply_functions() {
+  redisReplyObjectFunctions ret;
+  memset(&ret, 0, sizeof(ret));
+  ret.createString = create_string;
+  ret.createArray = create_array;
+  ret.createInteger = create_integer;
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+  ret.createDouble = create_double;
+  ret.createBool = create_bool;
+#endif
+  ret.createNil = create_nil;
+  ret.freeObject = free_object;
+  return ret;
+}
+
+reply_arena::chunk_t *reply_arena::alloc_chunk(size_t min_size) {
+  // double the size of chunks, so a huge reply needs only a few chunks
+  size_t size = nullptr == head_ ? chunk_size_ : head_->size * 2;
+  if (size < min_size) {
+    size = min_size;
+  }
+  size = detail::reply_arena_align(size);
+
+  chunk_t *ret = reinterpret_cast<chunk_t *>(malloc(detail::reply_arena_align(sizeof(chunk_t)) + size));
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  ret->next = nullptr;
+  ret->size = size;
+  ret->used = 0;
+
+  ++stats_.chunk_count;
+  stats_.chunk_bytes += size;
+  ++stats_.system_allocations;
+  return ret;
+}
+
+void reply_arena::free_chunk(chunk_t *chunk) {
+  --stats_.chunk_count;
+  stats_.chunk_bytes -= chunk->size;
+  free(chunk);
+}
+
+redisReply *reply_arena::create_reply(const redisReadTask *task, int type) {
+  reply_arena *self = reinterpret_cast<reply_arena *>(task->privdata);
+  if (nullptr == self) {
+    return nullptr;
+  }
+
+  char *block = reinterpret_cast<char *>(self->allocate(detail::reply_arena_object_header() + sizeof(redisReply)));
+  if (nullptr == block) {
+    return nullptr;
+  }
+
+  *reinterpret_cast<reply_arena **>(block) = self;
+  redisReply *ret = reinterpret_cast<redisReply *>(block + detail::reply_arena_object_header());
+  memset(ret, 0, sizeof(redisReply));
+  ret->type = type;
+
+  if (nullptr == task->parent) {
+    self->root_ = ret;
+  } else {
+    // parent must be an aggregate reply: array, map, set, push or attribute
+    redisReply *parent = reinterpret_cast<redisReply *>(task->parent->obj);
+    parent->element[task->idx] = ret;
+  }
+
+  return ret;
+}
+
+char *reply_arena::create_buffer(const redisReadTask *task, const char *str, size_t len) {
+  reply_arena *self = reinterpret_cast<reply_arena *>(task->privdata);
+  char *ret = reinterpret_cast<char *>(self->allocate(len + 1));
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  if (len > 0) {
+    memcpy(ret, str, len);
+  }
+  ret[len] = '\0';
+  return ret;
+}
+
+void *reply_arena::create_string(const redisReadTask *task, char *str, size_t len) {
+  redisReply *ret = create_reply(task, task->type);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+#if defined(REDIS_REPLY_VERB)
+  // verbatim string: xxx:content
+  if (REDIS_REPLY_VERB == task->type && len >= 4) {
+    memcpy(ret->vtype, str, 3);
+    ret->vtype[3] = '\0';
+    str += 4;
+    len -= 4;
+  }
+#endif
+
+  ret->str = create_buffer(task, str, len);
+  if (nullptr == ret->str) {
+    return nullptr;
+  }
+  ret->len = len;
+  return ret;
+}
+
+void *reply_arena::create_array(const redisReadTask *task, size_t elements) {
+  redisReply *ret = create_reply(task, task->type);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  if (elements > 0) {
+    reply_arena *self = reinterpret_cast<reply_arena *>(task->privdata);
+    ret->element = reinterpret_cast<redisReply **>(self->allocate(elements * sizeof(redisReply *)));
+    if (nullptr == ret->element) {
+      return nullptr;
+    }
+    memset(ret->element, 0, elements * sizeof(redisReply *));
+  }
+
+  ret->elements = elements;
+  return ret;
+}
+
+void *reply_arena::create_integer(const redisReadTask *task, long long value) {
+  redisReply *ret = create_reply(task, REDIS_REPLY_INTEGER);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  ret->integer = value;
+  return ret;
+}
+
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+void *reply_arena::create_double(const redisReadTask *task, double value, char *str, size_t len) {
+  redisReply *ret = create_reply(task, REDIS_REPLY_DOUBLE);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  ret->dval = value;
+  ret->str = create_buffer(task, str, len);
+  if (nullptr == ret->str) {
+    return nullptr;
+  }
+  ret->len = len;
+  return ret;
+}
+
+void *reply_arena::create_bool(const redisReadTask *task, int bval) {
+  redisReply *ret = create_reply(task, REDIS_REPLY_BOOL);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  ret->integer = bval != 0;
+  return ret;
+}
+#endif
+
+void *reply_arena::create_nil(const redisReadTask *task) { return create_reply(task, REDIS_REPLY_NIL); }
+
+void reply_arena::free_object(void *reply) {
+  if (nullptr == reply) {
+    return;
+  }
+
+  reply_arena *self =
+      *reinterpret_cast<reply_arena **>(reinterpret_cast<char *>(reply) - detail::reply_arena_object_header());
+  // hiredis only frees the root reply, children are released with it
+  if (reply == self->root_) {
+    self->reset();
+  }
+}
+}  // namespace happ
+}  // namespace hiredis
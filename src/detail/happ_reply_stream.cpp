@@ -0,0 +1,378 @@
+// Copyright 2026 owent
+
+#include "detail/happ_reply_stream.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace hiredis {
+namespace happ {
+namespace detail {
+// every redisReply is prefixed with the reply stream, so free_object can find it
+static inline size_t reply_stream_object_header() {
+  return (sizeof(void *) + alignof(std::max_align_t) - 1) & (~(alignof(std::max_align_t) - 1));
+}
+
+static inline bool reply_stream_is_aggregate(int type) {
+  if (REDIS_REPLY_ARRAY == type) {
+    return true;
+  }
+#if defined(REDIS_REPLY_MAP)
+  if (REDIS_REPLY_MAP == type) {
+    return true;
+  }
+#endif
+#if defined(REDIS_REPLY_SET)
+  if (REDIS_REPLY_SET == type) {
+    return true;
+  }
+#endif
+  return false;
+}
+}  // namespace detail
+
+reply_stream::reply_stream(redisCallbackFn *cmd_fn)
+    : context_(nullptr), cmd_fn_(cmd_fn), cmd_(nullptr), depth_(0), root_(nullptr), building_(nullptr) {
+  memset(&stats_, 0, sizeof(stats_));
+}
+
+reply_stream::~reply_stream() {}
+
+HIREDIS_HAPP_API reply_stream *reply_stream::create(redisCallbackFn *cmd_fn) { return new reply_stream(cmd_fn); }
+
+HIREDIS_HAPP_API void reply_stream::release(void *stream) {
+  if (nullptr == stream) {
+    return;
+  }
+
+  delete reinterpret_cast<reply_stream *>(stream);
+}
+
+HIREDIS_HAPP_API reply_stream *reply_stream::attach(redisAsyncContext *c, redisCallbackFn *cmd_fn) {
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+  // privdata of redisContext is released after the reader, so replies are always freed before the reply stream
+  if (nullptr == c || nullptr == cmd_fn || nullptr == c->c.reader || nullptr != c->c.reader->reply ||
+      nullptr != c->c.privdata) {
+    return nullptr;
+  }
+
+  reply_stream *ret = create(cmd_fn);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  ret->set_context(c);
+  c->c.reader->fn = get_reply_functions();
+  c->c.reader->privdata = ret;
+  c->c.privdata = ret;
+  c->c.free_privdata = release;
+  return ret;
+#else
+  // redisContext::free_privdata is not available, we can not release the reply stream with the context
+  return nullptr;
+#endif
+}
+
+HIREDIS_HAPP_API reply_stream *reply_stream::get(const redisAsyncContext *c) {
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+  if (nullptr == c || nullptr == c->c.reader || get_reply_functions() != c->c.reader->fn ||
+      release != c->c.free_privdata) {
+    return nullptr;
+  }
+
+  return reinterpret_cast<reply_stream *>(c->c.privdata);
+#else
+  return nullptr;
+#endif
+}
+
+HIREDIS_HAPP_API redisReplyObjectFunctions *reply_stream::get_reply_functions() {
+  static redisReplyObjectFunctions ret = make_reply_functions();
+  return &ret;
+}
+
+HIREDIS_HAPP_API void reply_stream::set_context(const redisAsyncContext *c) { context_ = c; }
+
+HIREDIS_HAPP_API const reply_stream::stats_t &reply_stream::get_stats() const { return stats_; }
+
+redisReplyObjectFunctions reply_stream::make_reply_functions() {
+  redisReplyObjectFunctions ret;
+  memset(&ret, 0, sizeof(ret));
+  ret.createString = create_string;
+  ret.createArray = create_array;
+  ret.createInteger = create_integer;
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+  ret.createDouble = create_double;
+  ret.createBool = create_bool;
+#endif
+  ret.createNil = create_nil;
+  ret.freeObject = free_object;
+  return ret;
+}
+
+cmd_exec *reply_stream::find_stream_cmd() const {
+  if (nullptr == context_ || 0 != (context_->c.flags & (REDIS_SUBSCRIBED | REDIS_MONITORING))) {
+    return nullptr;
+  }
+
+  // hiredis shifts the callback after the whole reply is parsed, so the head is the callback of this reply
+  const redisCallback *cb = context_->replies.head;
+  if (nullptr == cb || cb->fn != cmd_fn_ || nullptr == cb->privdata) {
+    return nullptr;
+  }
+
+  cmd_exec *cmd = reinterpret_cast<cmd_exec *>(cb->privdata);
+  if (nullptr == cmd->get_stream_fn()) {
+    return nullptr;
+  }
+
+  return cmd;
+}
+
+void reply_stream::finish(const redisReadTask *task, redisReply *obj, size_t depth) {
+  if (nullptr == cmd_ || depth < depth_) {
+    return;
+  }
+
+  // walk up until the element at stream depth is complete
+  while (depth > depth_) {
+    if (pending_.empty() || --pending_.back() > 0) {
+      return;
+    }
+
+    pending_.pop_back();
+    task = task->parent;
+    obj = reinterpret_cast<redisReply *>(task->obj);
+    --depth;
+  }
+
+  building_ = nullptr;
+  ++stats_.streamed_elements;
+  cmd_->get_stream_fn()(cmd_, obj, static_cast<size_t>(task->idx), cmd_->private_data());
+  free_reply(obj);
+}
+
+void reply_stream::free_reply(redisReply *reply) {
+  if (nullptr == reply) {
+    return;
+  }
+
+  if (nullptr != reply->element) {
+    for (size_t i = 0; i < reply->elements; ++i) {
+      free_reply(reply->element[i]);
+    }
+    free(reply->element);
+  }
+
+  if (nullptr != reply->str) {
+    free(reply->str);
+  }
+
+  --stats_.live_objects;
+  free(reinterpret_cast<char *>(reply) - detail::reply_stream_object_header());
+}
+
+reply_stream *reply_stream::get_owner(void *reply) {
+  return *reinterpret_cast<reply_stream **>(reinterpret_cast<char *>(reply) - detail::reply_stream_object_header());
+}
+
+redisReply *reply_stream::create_reply(const redisReadTask *task, int type, size_t *depth) {
+  reply_stream *self = reinterpret_cast<reply_stream *>(task->privdata);
+  if (nullptr == self) {
+    return nullptr;
+  }
+
+  *depth = 0;
+  for (const redisReadTask *parent = task->parent; nullptr != parent; parent = parent->parent) {
+    ++*depth;
+  }
+
+  // a new reply, check if it should be streamed
+  if (nullptr == task->parent) {
+    self->cmd_ = nullptr;
+    self->building_ = nullptr;
+    self->pending_.clear();
+    if (detail::reply_stream_is_aggregate(type)) {
+      self->cmd_ = self->find_stream_cmd();
+    }
+
+    if (nullptr != self->cmd_) {
+      self->depth_ = self->cmd_->get_stream_depth();
+      ++self->stats_.streamed_replies;
+    }
+  }
+
+  char *block = reinterpret_cast<char *>(calloc(1, detail::reply_stream_object_header() + sizeof(redisReply)));
+  if (nullptr == block) {
+    return nullptr;
+  }
+
+  *reinterpret_cast<reply_stream **>(block) = self;
+  redisReply *ret = reinterpret_cast<redisReply *>(block + detail::reply_stream_object_header());
+  ret->type = type;
+
+  if (++self->stats_.live_objects > self->stats_.peak_live_objects) {
+    self->stats_.peak_live_objects = self->stats_.live_objects;
+  }
+
+  if (nullptr == task->parent) {
+    self->root_ = ret;
+  } else if (nullptr != self->cmd_ && *depth == self->depth_) {
+    // elements at stream depth are not attached to the parent, they are freed after delivered
+    self->building_ = ret;
+  } else {
+    // parent must be an aggregate reply: array, map, set, push or attribute
+    redisReply *parent = reinterpret_cast<redisReply *>(task->parent->obj);
+    parent->element[task->idx] = ret;
+  }
+
+  return ret;
+}
+
+char *reply_stream::create_buffer(const char *str, size_t len) {
+  char *ret = reinterpret_cast<char *>(malloc(len + 1));
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  if (len > 0) {
+    memcpy(ret, str, len);
+  }
+  ret[len] = '\0';
+  return ret;
+}
+
+// the object returned may be already delivered and freed, hiredis only checks if it's nullptr for non-root objects
+void *reply_stream::create_string(const redisReadTask *task, char *str, size_t len) {
+  size_t depth;
+  redisReply *ret = create_reply(task, task->type, &depth);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+#if defined(REDIS_REPLY_VERB)
+  // verbatim string: xxx:content
+  if (REDIS_REPLY_VERB == task->type && len >= 4) {
+    memcpy(ret->vtype, str, 3);
+    ret->vtype[3] = '\0';
+    str += 4;
+    len -= 4;
+  }
+#endif
+
+  ret->str = create_buffer(str, len);
+  if (nullptr == ret->str) {
+    return nullptr;
+  }
+  ret->len = len;
+
+  reinterpret_cast<reply_stream *>(task->privdata)->finish(task, ret, depth);
+  return ret;
+}
+
+void *reply_stream::create_array(const redisReadTask *task, size_t elements) {
+  size_t depth;
+  redisReply *ret = create_reply(task, task->type, &depth);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  reply_stream *self = reinterpret_cast<reply_stream *>(task->privdata);
+  bool streaming = nullptr != self->cmd_;
+  ret->elements = elements;
+
+  // the aggregate holding streamed elements keeps only the count
+  if (elements > 0 && !(streaming && depth + 1 == self->depth_)) {
+    ret->element = reinterpret_cast<redisReply **>(calloc(elements, sizeof(redisReply *)));
+    if (nullptr == ret->element) {
+      return nullptr;
+    }
+  }
+
+  if (streaming && depth >= self->depth_) {
+    if (elements > 0) {
+      self->pending_.push_back(elements);
+    } else {
+      self->finish(task, ret, depth);
+    }
+  }
+
+  return ret;
+}
+
+void *reply_stream::create_integer(const redisReadTask *task, long long value) {
+  size_t depth;
+  redisReply *ret = create_reply(task, REDIS_REPLY_INTEGER, &depth);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  ret->integer = value;
+  reinterpret_cast<reply_stream *>(task->privdata)->finish(task, ret, depth);
+  return ret;
+}
+
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+void *reply_stream::create_double(const redisReadTask *task, double value, char *str, size_t len) {
+  size_t depth;
+  redisReply *ret = create_reply(task, REDIS_REPLY_DOUBLE, &depth);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  ret->dval = value;
+  ret->str = create_buffer(str, len);
+  if (nullptr == ret->str) {
+    return nullptr;
+  }
+  ret->len = len;
+  reinterpret_cast<reply_stream *>(task->privdata)->finish(task, ret, depth);
+  return ret;
+}
+
+void *reply_stream::create_bool(const redisReadTask *task, int bval) {
+  size_t depth;
+  redisReply *ret = create_reply(task, REDIS_REPLY_BOOL, &depth);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  ret->integer = bval != 0;
+  reinterpret_cast<reply_stream *>(task->privdata)->finish(task, ret, depth);
+  return ret;
+}
+#endif
+
+void *reply_stream::create_nil(const redisReadTask *task) {
+  size_t depth;
+  redisReply *ret = create_reply(task, REDIS_REPLY_NIL, &depth);
+  if (nullptr == ret) {
+    return nullptr;
+  }
+
+  reinterpret_cast<reply_stream *>(task->privdata)->finish(task, ret, depth);
+  return ret;
+}
+
+void reply_stream::free_object(void *reply) {
+  if (nullptr == reply) {
+    return;
+  }
+
+  reply_stream *self = get_owner(reply);
+  if (reply == self->root_) {
+    // the element being built is not attached to the root when parsing failed
+    if (nullptr != self->building_) {
+      self->free_reply(self->building_);
+    }
+
+    self->cmd_ = nullptr;
+    self->root_ = nullptr;
+    self->building_ = nullptr;
+    self->pending_.clear();
+  }
+
+  self->free_reply(reinterpret_cast<redisReply *>(reply));
+}
+}  // namespace happ
+}  // namespace hiredis
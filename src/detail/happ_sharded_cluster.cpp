@@ -0,0 +1,253 @@
+// Copyright 2026 owent
+
+#include "detail/happ_sharded_cluster.h"
+
+#include "detail/crc16.h"
+
+namespace hiredis {
+namespace happ {
+namespace detail {
+// run the loop of a shard in its thread
+struct sharded_loop_runner {
+  sharded_cluster::loop_fn_t fn;
+  size_t index;
+  cluster *shard;
+
+  void operator()() { fn(index, *shard); }
+};
+
+struct sharded_reset_task {
+  cluster *shard;
+
+  void operator()() { shard->reset(); }
+};
+}  // namespace detail
+
+// publish slots loaded by a shard
+struct sharded_cluster::slots_updated_t {
+  sharded_cluster *owner;
+
+  void operator()(cluster *source) { owner->publish_topology(source); }
+};
+
+// a shard only connects to nodes it owns, and nodes not in the topology such as seeds
+struct sharded_cluster::node_filter_t {
+  sharded_cluster *owner;
+  size_t index;
+
+  bool operator()(cluster *, const connection::key_t &key) { return owner->is_node_owner(index, key); }
+};
+
+// apply slots published by another shard, in the thread of this shard
+struct sharded_cluster::apply_topology_t {
+  sharded_cluster *owner;
+  cluster *shard;
+  std::shared_ptr<const topology_t> topology;
+  uint64_t version;
+
+  void operator()() {
+    // a newer topology is already posted
+    if (owner->topology_version_.load(std::memory_order_acquire) != version) {
+      return;
+    }
+
+    shard->update_slots(*topology);
+  }
+};
+
+HIREDIS_HAPP_API sharded_cluster::sharded_cluster() : running_(false), next_shard_(0), topology_version_(0) {}
+
+HIREDIS_HAPP_API sharded_cluster::~sharded_cluster() { stop(); }
+
+HIREDIS_HAPP_API int sharded_cluster::init(const std::string &ip, uint16_t port, size_t shard_count) {
+  if (0 == shard_count || running_.load(std::memory_order_acquire)) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  shards_.clear();
+  shards_.reserve(shard_count);
+  for (size_t i = 0; i < shard_count; ++i) {
+    std::unique_ptr<cluster> shard(new cluster());
+    int res = shard->init(ip, port);
+    if (error_code::REDIS_HAPP_OK != res) {
+      shards_.clear();
+      return res;
+    }
+
+    slots_updated_t cbk;
+    cbk.owner = this;
+    shard->set_on_slots_updated(cbk);
+
+    node_filter_t filter;
+    filter.owner = this;
+    filter.index = i;
+    shard->set_connection_filter(filter);
+    shards_.push_back(std::move(shard));
+  }
+
+  // split slots into continuous ranges before the topology is loaded
+  slot_shards_.reset(new std::atomic<uint32_t>[HIREDIS_HAPP_SLOT_NUMBER]);
+  for (size_t i = 0; i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
+    slot_shards_[i].store(static_cast<uint32_t>(i * shard_count / HIREDIS_HAPP_SLOT_NUMBER),
+                          std::memory_order_relaxed);
+  }
+
+  std::lock_guard<std::mutex> guard(topology_lock_);
+  topology_.reset();
+  node_shards_.clear();
+  shard_node_count_.assign(shard_count, 0);
+  return error_code::REDIS_HAPP_OK;
+}
+
+HIREDIS_HAPP_API int sharded_cluster::start(loop_fn_t fn) {
+  if (!fn || shards_.empty()) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  if (running_.exchange(true)) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  threads_.reserve(shards_.size());
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    detail::sharded_loop_runner runner;
+    runner.fn = fn;
+    runner.index = i;
+    runner.shard = shards_[i].get();
+    threads_.push_back(std::thread(runner));
+  }
+
+  return error_code::REDIS_HAPP_OK;
+}
+
+HIREDIS_HAPP_API void sharded_cluster::stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+
+  // reset also wakes up loops to check is_running()
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    detail::sharded_reset_task task;
+    task.shard = shards_[i].get();
+    shards_[i]->post(task);
+  }
+
+  for (size_t i = 0; i < threads_.size(); ++i) {
+    if (threads_[i].joinable()) {
+      threads_[i].join();
+    }
+  }
+  threads_.clear();
+
+  // all loop threads exited, tasks not run yet are run here
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    shards_[i]->get_submit_queue().drain();
+  }
+}
+
+HIREDIS_HAPP_API bool sharded_cluster::is_running() const { return running_.load(std::memory_order_acquire); }
+
+HIREDIS_HAPP_API size_t sharded_cluster::get_shard_count() const { return shards_.size(); }
+
+HIREDIS_HAPP_API cluster *sharded_cluster::get_shard(size_t index) {
+  return index < shards_.size() ? shards_[index].get() : nullptr;
+}
+
+HIREDIS_HAPP_API const cluster *sharded_cluster::get_shard(size_t index) const {
+  return index < shards_.size() ? shards_[index].get() : nullptr;
+}
+
+HIREDIS_HAPP_API size_t sharded_cluster::get_shard_index(int slot) const {
+  if (shards_.empty()) {
+    return 0;
+  }
+
+  // requests without slot go to shards by turns in proportion to their slots, so shards without nodes get none
+  if (slot < 0 || slot >= HIREDIS_HAPP_SLOT_NUMBER) {
+    uint32_t turn = next_shard_.fetch_add(1, std::memory_order_relaxed);
+    slot = static_cast<int>((static_cast<uint64_t>(turn) * 7919) % HIREDIS_HAPP_SLOT_NUMBER);
+  }
+
+  return slot_shards_[slot].load(std::memory_order_relaxed);
+}
+
+HIREDIS_HAPP_API size_t sharded_cluster::get_shard_index(const char *key, size_t ks) const {
+  return get_shard_index(hash_slot(key, ks));
+}
+
+HIREDIS_HAPP_API std::shared_ptr<const sharded_cluster::topology_t> sharded_cluster::get_topology() const {
+  std::lock_guard<std::mutex> guard(topology_lock_);
+  return topology_;
+}
+
+HIREDIS_HAPP_API uint64_t sharded_cluster::get_topology_version() const {
+  return topology_version_.load(std::memory_order_acquire);
+}
+
+bool sharded_cluster::is_node_owner(size_t index, const connection::key_t &key) const {
+  std::lock_guard<std::mutex> guard(topology_lock_);
+  HIREDIS_HAPP_MAP(std::string, size_t)::const_iterator iter = node_shards_.find(key.name);
+  return node_shards_.end() == iter || iter->second == index;
+}
+
+void sharded_cluster::publish_topology(cluster *source) {
+  std::shared_ptr<topology_t> topology = std::make_shared<topology_t>();
+  source->get_slot_ranges(*topology);
+
+  uint64_t version;
+  {
+    std::lock_guard<std::mutex> guard(topology_lock_);
+    topology_ = topology;
+    version = topology_version_.fetch_add(1, std::memory_order_acq_rel) + 1;
+
+    // a master keeps its shard, new masters go to the shard with the fewest masters
+    for (size_t i = 0; i < topology->size(); ++i) {
+      const cluster::slot_range_t &range = (*topology)[i];
+      if (range.hosts.empty()) {
+        continue;
+      }
+
+      HIREDIS_HAPP_MAP(std::string, size_t)::iterator iter = node_shards_.find(range.hosts[0].name);
+      size_t shard_index;
+      if (node_shards_.end() == iter) {
+        shard_index = 0;
+        for (size_t j = 1; j < shard_node_count_.size(); ++j) {
+          if (shard_node_count_[j] < shard_node_count_[shard_index]) {
+            shard_index = j;
+          }
+        }
+
+        ++shard_node_count_[shard_index];
+        node_shards_[range.hosts[0].name] = shard_index;
+      } else {
+        shard_index = iter->second;
+      }
+
+      // replicas are connected by the shard of their master, such as hedged reads
+      for (size_t j = 1; j < range.hosts.size(); ++j) {
+        if (node_shards_.end() == node_shards_.find(range.hosts[j].name)) {
+          node_shards_[range.hosts[j].name] = shard_index;
+        }
+      }
+
+      for (int slot = range.start; slot <= range.end && slot < HIREDIS_HAPP_SLOT_NUMBER; ++slot) {
+        slot_shards_[slot].store(static_cast<uint32_t>(shard_index), std::memory_order_relaxed);
+      }
+    }
+  }
+
+  for (size_t i = 0; i < shards_.size(); ++i) {
+    if (shards_[i].get() == source) {
+      continue;
+    }
+
+    apply_topology_t task;
+    task.owner = this;
+    task.shard = shards_[i].get();
+    task.topology = topology;
+    task.version = version;
+    shards_[i]->post(task);
+  }
+}
+}  // namespace happ
+}  // namespace hiredis
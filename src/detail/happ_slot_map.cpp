@@ -0,0 +1,190 @@
+// Copyright 2026 owent
+
+#include "detail/happ_slot_map.h"
+
+#include <cstring>
+
+#include "detail/crc16.h"
+
+namespace hiredis {
+namespace happ {
+slot_map::slot_map() : version_(0), slot_count_(0), refs_(0) {
+  memset(slot_hosts_, 0, sizeof(slot_hosts_));
+  hosts_.resize(1);
+}
+
+HIREDIS_HAPP_API uint64_t slot_map::get_version() const { return version_; }
+
+HIREDIS_HAPP_API size_t slot_map::get_slot_count() const { return slot_count_; }
+
+HIREDIS_HAPP_API size_t slot_map::get_host_count(int slot) const {
+  if (slot < 0 || slot >= HIREDIS_HAPP_SLOT_NUMBER) {
+    return 0;
+  }
+
+  return hosts_[slot_hosts_[slot]].size();
+}
+
+HIREDIS_HAPP_API const connection::key_t *slot_map::get_host(int slot, size_t index) const {
+  if (slot < 0 || slot >= HIREDIS_HAPP_SLOT_NUMBER) {
+    return nullptr;
+  }
+
+  const std::vector<uint32_t> &hosts = hosts_[slot_hosts_[slot]];
+  if (index >= hosts.size()) {
+    return nullptr;
+  }
+
+  return &nodes_[hosts[index]];
+}
+
+HIREDIS_HAPP_API const connection::key_t *slot_map::get_master(int slot) const { return get_host(slot, 0); }
+
+HIREDIS_HAPP_API const connection::key_t *slot_map::get_master(const char *key, size_t ks) const {
+  return get_host(hash_slot(key, ks), 0);
+}
+
+void slot_map::set_hosts(int slot, const std::vector<connection::node_id_t> &hosts, const node_registry &registry) {
+  if (slot < 0 || slot >= HIREDIS_HAPP_SLOT_NUMBER || hosts.empty()) {
+    return;
+  }
+
+  ++slot_count_;
+
+  // slots of the same hosts are usually continuous, so they share one host list
+  if (hosts_.size() > 1 && hosts == build_last_hosts_) {
+    slot_hosts_[slot] = static_cast<uint16_t>(hosts_.size() - 1);
+    return;
+  }
+
+  build_last_hosts_ = hosts;
+  hosts_.push_back(std::vector<uint32_t>());
+  std::vector<uint32_t> &host_list = hosts_.back();
+  host_list.reserve(hosts.size());
+  for (size_t i = 0; i < hosts.size(); ++i) {
+    const connection::key_t *node = registry.get(hosts[i]);
+    if (nullptr == node) {
+      continue;
+    }
+
+    if (build_node_index_.size() <= node->id) {
+      build_node_index_.resize(node->id + 1, 0);
+    }
+
+    if (0 == build_node_index_[node->id]) {
+      nodes_.push_back(*node);
+      build_node_index_[node->id] = static_cast<uint32_t>(nodes_.size());
+    }
+    host_list.push_back(build_node_index_[node->id] - 1);
+  }
+
+  slot_hosts_[slot] = static_cast<uint16_t>(hosts_.size() - 1);
+}
+
+HIREDIS_HAPP_API slot_map_ref::slot_map_ref() : map_(nullptr) {}
+
+slot_map_ref::slot_map_ref(const slot_map *map) : map_(map) {}
+
+HIREDIS_HAPP_API slot_map_ref::slot_map_ref(const slot_map_ref &other) : map_(other.map_) {
+  if (nullptr != map_) {
+    map_->refs_.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+HIREDIS_HAPP_API slot_map_ref::slot_map_ref(slot_map_ref &&other) : map_(other.map_) { other.map_ = nullptr; }
+
+HIREDIS_HAPP_API slot_map_ref::~slot_map_ref() { reset(); }
+
+HIREDIS_HAPP_API slot_map_ref &slot_map_ref::operator=(const slot_map_ref &other) {
+  if (this != &other) {
+    slot_map_ref copy(other);
+    reset();
+    map_ = copy.map_;
+    copy.map_ = nullptr;
+  }
+
+  return *this;
+}
+
+HIREDIS_HAPP_API slot_map_ref &slot_map_ref::operator=(slot_map_ref &&other) {
+  if (this != &other) {
+    reset();
+    map_ = other.map_;
+    other.map_ = nullptr;
+  }
+
+  return *this;
+}
+
+HIREDIS_HAPP_API void slot_map_ref::reset() {
+  if (nullptr != map_) {
+    // the holder deletes it after it's retired and not referenced
+    map_->refs_.fetch_sub(1, std::memory_order_release);
+    map_ = nullptr;
+  }
+}
+
+HIREDIS_HAPP_API slot_map_holder::slot_map_holder() : current_(nullptr), acquiring_(0), version_(0) {}
+
+HIREDIS_HAPP_API slot_map_holder::~slot_map_holder() {
+  delete current_.exchange(nullptr);
+  for (size_t i = 0; i < retired_.size(); ++i) {
+    delete retired_[i];
+  }
+  retired_.clear();
+}
+
+HIREDIS_HAPP_API slot_map_ref slot_map_holder::acquire() const {
+  // the holder does not delete any retired snapshot while a reader is between loading current_ and adding a
+  // reference, so the snapshot loaded here is alive
+  acquiring_.fetch_add(1, std::memory_order_seq_cst);
+  slot_map *map = current_.load(std::memory_order_seq_cst);
+  if (nullptr != map) {
+    map->refs_.fetch_add(1, std::memory_order_seq_cst);
+  }
+  acquiring_.fetch_sub(1, std::memory_order_seq_cst);
+
+  return slot_map_ref(map);
+}
+
+HIREDIS_HAPP_API void slot_map_holder::publish(slot_map *map) {
+  if (nullptr != map) {
+    map->version_ = ++version_;
+    map->build_node_index_.clear();
+    map->build_last_hosts_.clear();
+  }
+
+  slot_map *old = current_.exchange(map, std::memory_order_seq_cst);
+  if (nullptr != old) {
+    retired_.push_back(old);
+  }
+
+  reclaim();
+}
+
+HIREDIS_HAPP_API size_t slot_map_holder::reclaim() {
+  if (retired_.empty()) {
+    return 0;
+  }
+
+  // readers which load a retired snapshot have added a reference to it once acquiring_ is 0
+  if (0 != acquiring_.load(std::memory_order_seq_cst)) {
+    return retired_.size();
+  }
+
+  size_t left = 0;
+  for (size_t i = 0; i < retired_.size(); ++i) {
+    if (0 == retired_[i]->refs_.load(std::memory_order_seq_cst)) {
+      delete retired_[i];
+    } else {
+      retired_[left++] = retired_[i];
+    }
+  }
+  retired_.resize(left);
+
+  return left;
+}
+
+HIREDIS_HAPP_API uint64_t slot_map_holder::get_version() const { return version_; }
+}  // namespace happ
+}  // namespace hiredis
@@ -0,0 +1,147 @@
+// Copyright 2026 owent
+
+#include "detail/happ_submit_queue.h"
+
+#if defined(__linux__)
+#  include <sys/eventfd.h>
+#  include <unistd.h>
+
+#  include <cerrno>
+#  include <cstdint>
+#endif
+
+namespace hiredis {
+namespace happ {
+HIREDIS_HAPP_API submit_queue::submit_queue() : head_(nullptr), ready_(nullptr), wakeup_fd_(-1) {}
+
+HIREDIS_HAPP_API submit_queue::~submit_queue() {
+  // tasks not run are destroyed
+  task_node *task = head_.exchange(nullptr, std::memory_order_acquire);
+  while (nullptr != task) {
+    task_node *next = task->next;
+    delete task;
+    task = next;
+  }
+
+  while (nullptr != ready_) {
+    task_node *next = ready_->next;
+    delete ready_;
+    ready_ = next;
+  }
+
+#if defined(__linux__)
+  if (wakeup_fd_ >= 0) {
+    close(wakeup_fd_);
+    wakeup_fd_ = -1;
+  }
+#endif
+}
+
+HIREDIS_HAPP_API size_t submit_queue::drain(size_t max_count) {
+  size_t ret = 0;
+  bool taken = false;
+  while (0 == max_count || ret < max_count) {
+    // take posted tasks at most once, so tasks posted by running tasks will not make it loop forever
+    if (nullptr == ready_) {
+      if (taken) {
+        break;
+      }
+
+      take();
+      taken = true;
+      if (nullptr == ready_) {
+        break;
+      }
+    }
+
+    // task may post more tasks or drain this queue again
+    task_node *task = ready_;
+    ready_ = task->next;
+
+    task->run();
+    delete task;
+    ++ret;
+  }
+
+  return ret;
+}
+
+HIREDIS_HAPP_API bool submit_queue::empty() const {
+  return nullptr == ready_ && nullptr == head_.load(std::memory_order_acquire);
+}
+
+HIREDIS_HAPP_API int submit_queue::enable_eventfd() {
+#if defined(__linux__)
+  if (wakeup_fd_ >= 0) {
+    return wakeup_fd_;
+  }
+
+  wakeup_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (wakeup_fd_ < 0) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  return wakeup_fd_;
+#else
+  return error_code::REDIS_HAPP_UNKNOWD;
+#endif
+}
+
+HIREDIS_HAPP_API int submit_queue::get_wakeup_fd() const { return wakeup_fd_; }
+
+HIREDIS_HAPP_API submit_queue::wakeup_fn_t submit_queue::set_wakeup_fn(wakeup_fn_t fn) {
+  using std::swap;
+  swap(fn, wakeup_fn_);
+  return fn;
+}
+
+HIREDIS_HAPP_API size_t submit_queue::on_wakeup() {
+#if defined(__linux__)
+  if (wakeup_fd_ >= 0) {
+    uint64_t count = 0;
+    while (read(wakeup_fd_, &count, sizeof(count)) < 0 && EINTR == errno) {
+    }
+  }
+#endif
+
+  return drain();
+}
+
+HIREDIS_HAPP_API void submit_queue::push(task_node *task) {
+  task_node *head = head_.load(std::memory_order_relaxed);
+  do {
+    task->next = head;
+  } while (!head_.compare_exchange_weak(head, task, std::memory_order_release, std::memory_order_relaxed));
+
+  // only the first task after the queue is drained wakes up the loop thread
+  if (nullptr == head) {
+    wakeup();
+  }
+}
+
+void submit_queue::take() {
+  // take all posted tasks at once and reverse them into posting order
+  task_node *task = head_.exchange(nullptr, std::memory_order_acquire);
+  while (nullptr != task) {
+    task_node *next = task->next;
+    task->next = ready_;
+    ready_ = task;
+    task = next;
+  }
+}
+
+void submit_queue::wakeup() {
+#if defined(__linux__)
+  if (wakeup_fd_ >= 0) {
+    uint64_t count = 1;
+    while (write(wakeup_fd_, &count, sizeof(count)) < 0 && EINTR == errno) {
+    }
+  }
+#endif
+
+  if (wakeup_fn_) {
+    wakeup_fn_();
+  }
+}
+}  // namespace happ
+}  // namespace hiredis
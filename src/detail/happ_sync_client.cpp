@@ -0,0 +1,354 @@
+// Copyright 2026 owent
+
+#include "detail/happ_sync_client.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+
+#  include <chrono>
+#  include <mutex>
+
+namespace hiredis {
+namespace happ {
+// promise of one request, it's shared by the posted task and the cmd callback
+struct sync_client::state_t {
+  std::promise<sync_reply> promise;
+  bool done;
+
+  state_t() : done(false) {}
+
+  void set(int result, const redisReply *reply) {
+    if (done) {
+      return;
+    }
+    done = true;
+
+    sync_reply ret;
+    sync_reply::copy(ret, reply);
+    ret.result = result;
+    promise.set_value(std::move(ret));
+  }
+};
+
+// run requests posted by other threads in the loop thread
+struct sync_client::exec_task_t {
+  sync_client *owner;
+  std::vector<request_t> requests;
+  std::vector<std::shared_ptr<state_t> > states;
+
+  void operator()() {
+    for (size_t i = 0; i < requests.size() && i < states.size(); ++i) {
+      owner->exec_in_loop(requests[i], states[i]);
+    }
+  }
+};
+
+struct sync_client::stop_task_t {
+  sync_client *owner;
+
+  void operator()() {
+    owner->closing_ = true;
+    if (owner->cluster_) {
+      owner->cluster_->reset();
+    }
+    if (owner->raw_) {
+      owner->raw_->reset();
+    }
+
+    // hiredis waits for replies of pending commands before disconnecting, but the loop is stopping
+    owner->fail_pending(error_code::REDIS_HAPP_CONNECTION);
+    owner->loop_.stop();
+  }
+};
+
+// callback of the cmd, it's called in the loop thread
+struct sync_client::callback_t {
+  sync_client *owner;
+  std::shared_ptr<state_t> state;
+
+  void operator()(cmd_exec *cmd, redisAsyncContext *, void *reply) {
+    owner->pending_.erase(state);
+    state->set(cmd->result(), reinterpret_cast<const redisReply *>(reply));
+  }
+};
+
+HIREDIS_HAPP_API sync_reply::sync_reply() : result(error_code::REDIS_HAPP_UNKNOWD), type(0), integer(0), dval(0.0) {}
+
+HIREDIS_HAPP_API bool sync_reply::is_ok() const {
+  return error_code::REDIS_HAPP_OK == result && 0 != type && REDIS_REPLY_ERROR != type;
+}
+
+HIREDIS_HAPP_API void sync_reply::copy(sync_reply &out, const redisReply *reply) {
+  out.elements.clear();
+  out.str.clear();
+  if (nullptr == reply) {
+    out.type = 0;
+    out.integer = 0;
+    out.dval = 0.0;
+    return;
+  }
+
+  out.type = reply->type;
+  out.integer = reply->integer;
+  out.dval = reply->dval;
+  if (nullptr != reply->str) {
+    out.str.assign(reply->str, reply->len);
+  }
+
+  if (nullptr != reply->element && reply->elements > 0) {
+    out.elements.resize(reply->elements);
+    for (size_t i = 0; i < reply->elements; ++i) {
+      copy(out.elements[i], reply->element[i]);
+    }
+  }
+}
+
+HIREDIS_HAPP_API sync_client::sync_client() : mode_(mode_t::NONE), running_(false), closing_(false) {}
+
+HIREDIS_HAPP_API sync_client::~sync_client() { stop(); }
+
+HIREDIS_HAPP_API int sync_client::init_cluster(const std::string &ip, uint16_t port) {
+  if (mode_t::NONE != mode_) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  int res = loop_.init();
+  if (error_code::REDIS_HAPP_OK != res) {
+    return res;
+  }
+
+  cluster_.reset(new cluster());
+  res = cluster_->init(ip, port);
+  if (error_code::REDIS_HAPP_OK != res) {
+    cluster_.reset();
+    return res;
+  }
+
+  mode_ = mode_t::CLUSTER;
+  return loop_.bind(*cluster_);
+}
+
+HIREDIS_HAPP_API int sync_client::init_raw(const std::string &ip, uint16_t port) {
+  if (mode_t::NONE != mode_) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  int res = loop_.init();
+  if (error_code::REDIS_HAPP_OK != res) {
+    return res;
+  }
+
+  raw_.reset(new raw());
+  res = raw_->init(ip, port);
+  if (error_code::REDIS_HAPP_OK != res) {
+    raw_.reset();
+    return res;
+  }
+
+  mode_ = mode_t::RAW;
+  return loop_.bind(*raw_);
+}
+
+HIREDIS_HAPP_API sync_client::mode_t::type sync_client::get_mode() const { return mode_; }
+
+HIREDIS_HAPP_API cluster *sync_client::get_cluster() { return cluster_.get(); }
+
+HIREDIS_HAPP_API raw *sync_client::get_raw() { return raw_.get(); }
+
+HIREDIS_HAPP_API int sync_client::start() {
+  if (mode_t::NONE == mode_) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  if (running_.exchange(true)) {
+    return error_code::REDIS_HAPP_PARAM;
+  }
+
+  // nothing runs in the loop yet, so start it in this thread
+  closing_ = false;
+  int res = mode_t::CLUSTER == mode_ ? cluster_->start() : raw_->start();
+  if (error_code::REDIS_HAPP_OK == res) {
+    res = loop_.start_thread();
+  }
+
+  if (error_code::REDIS_HAPP_OK != res) {
+    running_.store(false, std::memory_order_release);
+  }
+  return res;
+}
+
+HIREDIS_HAPP_API void sync_client::stop() {
+  {
+    // wait for producers which have seen running_, so nothing is posted after the queue is drained below
+    std::unique_lock<std::shared_mutex> guard(post_lock_);
+    if (!running_.exchange(false)) {
+      return;
+    }
+  }
+
+  submit_queue *queue = get_submit_queue();
+  stop_task_t task;
+  task.owner = this;
+  if (nullptr == queue || error_code::REDIS_HAPP_OK != queue->post(task)) {
+    loop_.stop();
+  }
+  loop_.join();
+
+  // requests posted before running_ is cleared but not run by the loop fail here
+  closing_ = true;
+  if (nullptr != queue) {
+    queue->drain();
+  }
+  fail_pending(error_code::REDIS_HAPP_CONNECTION);
+}
+
+HIREDIS_HAPP_API bool sync_client::is_running() const { return running_.load(std::memory_order_acquire); }
+
+HIREDIS_HAPP_API std::future<sync_reply> sync_client::exec_async(const std::string &key, const args_t &args) {
+  std::vector<request_t> requests;
+  requests.resize(1);
+  requests[0].key = key;
+  requests[0].args = args;
+
+  std::vector<std::future<sync_reply> > futures;
+  post_requests(requests, futures);
+  return std::move(futures[0]);
+}
+
+HIREDIS_HAPP_API sync_reply sync_client::exec(const std::string &key, const args_t &args, time_t timeout_ms) {
+  std::future<sync_reply> future = exec_async(key, args);
+  if (timeout_ms > 0 && std::future_status::ready != future.wait_for(std::chrono::milliseconds(timeout_ms))) {
+    sync_reply ret;
+    ret.result = error_code::REDIS_HAPP_TIMEOUT;
+    return ret;
+  }
+
+  return future.get();
+}
+
+HIREDIS_HAPP_API std::vector<sync_reply> sync_client::exec_batch(const std::vector<request_t> &requests,
+                                                                 time_t timeout_ms) {
+  std::vector<std::future<sync_reply> > futures;
+  post_requests(requests, futures);
+
+  std::chrono::steady_clock::time_point deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms > 0 ? timeout_ms : 0);
+  std::vector<sync_reply> ret;
+  ret.resize(futures.size());
+  for (size_t i = 0; i < futures.size(); ++i) {
+    if (timeout_ms > 0 && std::future_status::ready != futures[i].wait_until(deadline)) {
+      ret[i].result = error_code::REDIS_HAPP_TIMEOUT;
+      continue;
+    }
+
+    ret[i] = futures[i].get();
+  }
+
+  return ret;
+}
+
+int sync_client::post_requests(const std::vector<request_t> &requests,
+                               std::vector<std::future<sync_reply> > &futures) {
+  exec_task_t task;
+  task.owner = this;
+  task.requests = requests;
+  task.states.reserve(requests.size());
+  futures.reserve(futures.size() + requests.size());
+  for (size_t i = 0; i < requests.size(); ++i) {
+    std::shared_ptr<state_t> state = std::make_shared<state_t>();
+    futures.push_back(state->promise.get_future());
+    task.states.push_back(state);
+  }
+
+  submit_queue *queue = get_submit_queue();
+  if (nullptr == queue) {
+    for (size_t i = 0; i < task.states.size(); ++i) {
+      task.states[i]->set(error_code::REDIS_HAPP_CREATE, nullptr);
+    }
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  // checking running_ and posting can not be interleaved with stop(), or the task may be posted after draining
+  std::shared_lock<std::shared_mutex> guard(post_lock_);
+  int res = error_code::REDIS_HAPP_CONNECTION;
+  if (running_.load(std::memory_order_acquire)) {
+    // keep states to fail them if posting fails, the task is moved into the queue
+    std::vector<std::shared_ptr<state_t> > states = task.states;
+    res = queue->post(std::move(task));
+    if (error_code::REDIS_HAPP_OK != res) {
+      for (size_t i = 0; i < states.size(); ++i) {
+        states[i]->set(res, nullptr);
+      }
+    }
+  } else {
+    for (size_t i = 0; i < task.states.size(); ++i) {
+      task.states[i]->set(res, nullptr);
+    }
+  }
+
+  return res;
+}
+
+void sync_client::exec_in_loop(const request_t &request, const std::shared_ptr<state_t> &state) {
+  if (closing_) {
+    state->set(error_code::REDIS_HAPP_CONNECTION, nullptr);
+    return;
+  }
+
+  if (request.args.empty()) {
+    state->set(error_code::REDIS_HAPP_PARAM, nullptr);
+    return;
+  }
+
+  std::vector<const char *> argv;
+  std::vector<size_t> argvlen;
+  argv.reserve(request.args.size());
+  argvlen.reserve(request.args.size());
+  for (size_t i = 0; i < request.args.size(); ++i) {
+    argv.push_back(request.args[i].c_str());
+    argvlen.push_back(request.args[i].size());
+  }
+
+  callback_t cbk;
+  cbk.owner = this;
+  cbk.state = state;
+
+  int argc = static_cast<int>(argv.size());
+  cmd_exec *cmd;
+  if (mode_t::CLUSTER == mode_) {
+    cmd = cluster_->exec(request.key.empty() ? nullptr : request.key.c_str(), request.key.size(), cbk, argc, &argv[0],
+                         &argvlen[0]);
+  } else {
+    cmd = raw_->exec(cbk, argc, &argv[0], &argvlen[0]);
+  }
+
+  // the callback is not called if the cmd can not be created
+  if (nullptr == cmd) {
+    state->set(error_code::REDIS_HAPP_CREATE, nullptr);
+  } else if (!state->done) {
+    // SUBSCRIBE, UNSUBSCRIBE and MONITOR cmds are destroyed without calling back, so keep the state here
+    pending_.insert(state);
+  }
+}
+
+void sync_client::fail_pending(int result) {
+  for (std::unordered_set<std::shared_ptr<state_t> >::iterator iter = pending_.begin(); iter != pending_.end();
+       ++iter) {
+    (*iter)->set(result, nullptr);
+  }
+  pending_.clear();
+}
+
+submit_queue *sync_client::get_submit_queue() {
+  switch (mode_) {
+    case mode_t::CLUSTER:
+      return &cluster_->get_submit_queue();
+    case mode_t::RAW:
+      return &raw_->get_submit_queue();
+    default:
+      return nullptr;
+  }
+}
+}  // namespace happ
+}  // namespace hiredis
+
+#endif
@@ -0,0 +1,291 @@
+// Copyright 2026 owent
+
+#include "detail/happ_timer.h"
+
+#include <cassert>
+#include <cstring>
+
+#if defined(_MSC_VER)
+#  include <intrin.h>
+#endif
+
+namespace hiredis {
+namespace happ {
+namespace detail {
+static inline uint32_t timer_ctz64(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<uint32_t>(__builtin_ctzll(v));
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+  unsigned long ret;
+  _BitScanForward64(&ret, v);
+  return static_cast<uint32_t>(ret);
+#else
+  uint32_t ret = 0;
+  while (0 == (v & 1)) {
+    v >>= 1;
+    ++ret;
+  }
+  return ret;
+#endif
+}
+}  // namespace detail
+
+HIREDIS_HAPP_API timer_wheel::timer_wheel() : next_tick_(0), size_(0), pending_(0) {
+  memset(near_bitmap_, 0, sizeof(near_bitmap_));
+  for (uint32_t i = 0; i <= SLOT_COUNT; ++i) {
+    list_init(&slots_[i]);
+  }
+}
+
+HIREDIS_HAPP_API timer_wheel::~timer_wheel() {
+  // detach all nodes, so owners can still call remove(node) safely after the wheel is destroyed
+  for (uint32_t i = 0; i <= SLOT_COUNT; ++i) {
+    timer_node *head = &slots_[i];
+    while (!list_empty(head)) {
+      timer_node *node = head->next;
+      head->next = node->next;
+      node->prev = nullptr;
+      node->next = nullptr;
+      node->owner = nullptr;
+    }
+    list_init(head);
+  }
+
+  size_ = 0;
+  pending_ = 0;
+}
+
+HIREDIS_HAPP_API void timer_wheel::add(timer_node *node, tick_t expire, void *data) {
+  if (nullptr == node) {
+    return;
+  }
+
+  remove(node);
+
+  node->expire = expire;
+  node->data = data;
+  node->owner = this;
+  ++size_;
+  insert(node);
+}
+
+HIREDIS_HAPP_API bool timer_wheel::remove(timer_node *node) {
+  if (!is_scheduled(node)) {
+    return false;
+  }
+
+  node->owner->unlink(node);
+  return true;
+}
+
+HIREDIS_HAPP_API bool timer_wheel::is_scheduled(const timer_node *node) {
+  return nullptr != node && nullptr != node->owner;
+}
+
+HIREDIS_HAPP_API size_t timer_wheel::advance(tick_t now) {
+  size_t ret = 0;
+  while (next_tick_ <= now) {
+    // nothing left in wheel, jump to now directly
+    if (0 == pending_) {
+      next_tick_ = now + 1;
+      break;
+    }
+
+    uint32_t index = static_cast<uint32_t>(next_tick_ & (NEAR_SIZE - 1));
+    if (0 == index) {
+      // cascade upper levels when level 0 turns around
+      for (uint32_t level = 0; level < LEVEL_COUNT; ++level) {
+        uint32_t level_index =
+            static_cast<uint32_t>((next_tick_ >> (NEAR_BITS + level * LEVEL_BITS)) & (LEVEL_SIZE - 1));
+        cascade(level, level_index);
+        if (0 != level_index) {
+          break;
+        }
+      }
+    }
+
+    uint32_t next_index = find_near(index);
+    tick_t block_begin = next_tick_ - index;
+    if (next_index >= NEAR_SIZE) {
+      // skip empty slots to the end of this round
+      tick_t block_end = block_begin + NEAR_SIZE;
+      next_tick_ = block_end <= now ? block_end : now + 1;
+      continue;
+    }
+
+    if (block_begin + next_index > now) {
+      next_tick_ = now + 1;
+      break;
+    }
+
+    ret += move_to_expired(next_index);
+    next_tick_ = block_begin + next_index + 1;
+  }
+
+  return ret;
+}
+
+HIREDIS_HAPP_API size_t timer_wheel::flush() {
+  size_t ret = 0;
+  for (uint32_t i = 0; i < SLOT_COUNT; ++i) {
+    ret += move_to_expired(i);
+  }
+
+  return ret;
+}
+
+HIREDIS_HAPP_API timer_node *timer_wheel::pop_expired() {
+  timer_node *head = &slots_[EXPIRED_SLOT];
+  if (list_empty(head)) {
+    return nullptr;
+  }
+
+  timer_node *ret = head->next;
+  unlink(ret);
+  return ret;
+}
+
+HIREDIS_HAPP_API size_t timer_wheel::size() const { return size_; }
+
+HIREDIS_HAPP_API bool timer_wheel::empty() const { return 0 == size_; }
+
+HIREDIS_HAPP_API timer_wheel::tick_t timer_wheel::get_next_tick() const { return next_tick_; }
+
+HIREDIS_HAPP_API timer_wheel::tick_t timer_wheel::make_tick(time_t sec, time_t usec) {
+  return static_cast<tick_t>(sec) * 1000 + static_cast<tick_t>(usec / 1000);
+}
+
+void timer_wheel::insert(timer_node *node) {
+  tick_t expire = node->expire;
+  // timers in the past will be processed at the next tick
+  if (expire < next_tick_) {
+    expire = next_tick_;
+  }
+
+  tick_t delta = expire - next_tick_;
+  uint32_t slot;
+  if (delta < static_cast<tick_t>(NEAR_SIZE)) {
+    slot = static_cast<uint32_t>(expire & (NEAR_SIZE - 1));
+    near_bitmap_[slot >> 6] |= static_cast<uint64_t>(1) << (slot & 63);
+  } else {
+    uint32_t level = 0;
+    while (level + 1 < LEVEL_COUNT && delta >= (static_cast<tick_t>(1) << (NEAR_BITS + (level + 1) * LEVEL_BITS))) {
+      ++level;
+    }
+
+    // too far away, put it into the last slot it can reach. node->expire is kept, so cascade() will insert it
+    // again with the real expire tick and it never expires before that
+    tick_t max_delta = (static_cast<tick_t>(1) << (NEAR_BITS + LEVEL_COUNT * LEVEL_BITS)) - 1;
+    if (delta > max_delta) {
+      expire = next_tick_ + max_delta;
+    }
+
+    slot = NEAR_SIZE + level * LEVEL_SIZE +
+           static_cast<uint32_t>((expire >> (NEAR_BITS + level * LEVEL_BITS)) & (LEVEL_SIZE - 1));
+  }
+
+  timer_node *head = &slots_[slot];
+  node->slot = slot;
+  node->prev = head->prev;
+  node->next = head;
+  head->prev->next = node;
+  head->prev = node;
+  ++pending_;
+}
+
+void timer_wheel::unlink(timer_node *node) {
+  assert(node->owner == this);
+
+  node->prev->next = node->next;
+  node->next->prev = node->prev;
+  if (node->slot < SLOT_COUNT) {
+    --pending_;
+    if (node->slot < NEAR_SIZE && list_empty(&slots_[node->slot])) {
+      near_bitmap_[node->slot >> 6] &= ~(static_cast<uint64_t>(1) << (node->slot & 63));
+    }
+  }
+
+  node->prev = nullptr;
+  node->next = nullptr;
+  node->owner = nullptr;
+  --size_;
+}
+
+size_t timer_wheel::move_to_expired(uint32_t slot) {
+  timer_node *head = &slots_[slot];
+  if (slot < NEAR_SIZE) {
+    near_bitmap_[slot >> 6] &= ~(static_cast<uint64_t>(1) << (slot & 63));
+  }
+
+  if (list_empty(head)) {
+    return 0;
+  }
+
+  size_t ret = 0;
+  for (timer_node *node = head->next; node != head; node = node->next) {
+    node->slot = EXPIRED_SLOT;
+    ++ret;
+  }
+
+  // splice the whole list to the tail of expired list
+  timer_node *expired = &slots_[EXPIRED_SLOT];
+  head->next->prev = expired->prev;
+  expired->prev->next = head->next;
+  head->prev->next = expired;
+  expired->prev = head->prev;
+  list_init(head);
+
+  pending_ -= ret;
+  return ret;
+}
+
+void timer_wheel::cascade(uint32_t level, uint32_t index) {
+  timer_node *head = &slots_[NEAR_SIZE + level * LEVEL_SIZE + index];
+  if (list_empty(head)) {
+    return;
+  }
+
+  timer_node list;
+  list.next = head->next;
+  list.prev = head->prev;
+  list.next->prev = &list;
+  list.prev->next = &list;
+  list_init(head);
+
+  while (list.next != &list) {
+    timer_node *node = list.next;
+    list.next = node->next;
+    node->next->prev = &list;
+
+    --pending_;
+    insert(node);
+  }
+}
+
+uint32_t timer_wheel::find_near(uint32_t start) const {
+  uint32_t word = start >> 6;
+  uint64_t bits = near_bitmap_[word] & (~static_cast<uint64_t>(0) << (start & 63));
+  while (true) {
+    if (0 != bits) {
+      return (word << 6) + detail::timer_ctz64(bits);
+    }
+
+    if (++word >= NEAR_SIZE / 64) {
+      return NEAR_SIZE;
+    }
+    bits = near_bitmap_[word];
+  }
+}
+
+void timer_wheel::list_init(timer_node *head) {
+  head->prev = head;
+  head->next = head;
+  head->owner = nullptr;
+  head->slot = 0;
+  head->expire = 0;
+  head->data = nullptr;
+}
+
+bool timer_wheel::list_empty(const timer_node *head) { return head->next == head; }
+}  // namespace happ
+}  // namespace hiredis
@@ -0,0 +1,309 @@
+// Copyright 2026 owent
+
+#include "happ_uring_poller.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+
+#  include <linux/io_uring.h>
+#  include <linux/time_types.h>
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+
+#  include <cerrno>
+#  include <cstring>
+
+namespace hiredis {
+namespace happ {
+struct uring_poller::sqe_t : public io_uring_sqe {};
+
+namespace detail {
+static inline unsigned uring_load_acquire(const unsigned *p) {
+  return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+
+static inline void uring_store_release(unsigned *p, unsigned v) { __atomic_store_n(p, v, __ATOMIC_RELEASE); }
+
+// the kernel reads poll32_events as two swapped 16-bit halves on big-endian, just like liburing does
+static inline uint32_t uring_poll_mask(uint32_t events) {
+#  if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  return (events << 16) | (events >> 16);
+#  else
+  return events;
+#  endif
+}
+}  // namespace detail
+
+uring_poller::uring_poller()
+    : ring_fd_(-1),
+      features_(0),
+      sq_entries_(0),
+      pending_(0),
+      sq_ring_(nullptr),
+      sq_ring_size_(0),
+      cq_ring_(nullptr),
+      cq_ring_size_(0),
+      sqes_(nullptr),
+      sqes_size_(0),
+      sq_head_(nullptr),
+      sq_tail_(nullptr),
+      sq_mask_(nullptr),
+      sq_array_(nullptr),
+      cq_head_(nullptr),
+      cq_tail_(nullptr),
+      cq_mask_(nullptr),
+      cqes_(nullptr),
+      wait_count_(0),
+      submit_count_(0) {
+  timeout_spec_[0] = 0;
+  timeout_spec_[1] = 0;
+}
+
+uring_poller::~uring_poller() { close(); }
+
+int uring_poller::init(unsigned entries) {
+  if (ring_fd_ >= 0) {
+    return error_code::REDIS_HAPP_OK;
+  }
+
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  params.flags = IORING_SETUP_CQSIZE;
+  params.cq_entries = entries * 8;
+
+  int fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+  if (fd < 0) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  ring_fd_ = fd;
+  features_ = params.features;
+  sq_entries_ = params.sq_entries;
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  if (features_ & IORING_FEAT_SINGLE_MMAP) {
+    if (cq_ring_size_ > sq_ring_size_) {
+      sq_ring_size_ = cq_ring_size_;
+    }
+    cq_ring_size_ = sq_ring_size_;
+  }
+
+  sq_ring_ = mmap(nullptr, sq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  if (MAP_FAILED == sq_ring_) {
+    sq_ring_ = nullptr;
+    close();
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  if (features_ & IORING_FEAT_SINGLE_MMAP) {
+    cq_ring_ = sq_ring_;
+  } else {
+    cq_ring_ = mmap(nullptr, cq_ring_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (MAP_FAILED == cq_ring_) {
+      cq_ring_ = nullptr;
+      close();
+      return error_code::REDIS_HAPP_CREATE;
+    }
+  }
+
+  sqes_size_ = params.sq_entries * sizeof(struct io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (MAP_FAILED == sqes_) {
+    sqes_ = nullptr;
+    close();
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  char *sq = reinterpret_cast<char *>(sq_ring_);
+  sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+
+  char *cq = reinterpret_cast<char *>(cq_ring_);
+  cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  cqes_ = cq + params.cq_off.cqes;
+
+  return error_code::REDIS_HAPP_OK;
+}
+
+void uring_poller::close() {
+  if (nullptr != sqes_) {
+    munmap(sqes_, sqes_size_);
+    sqes_ = nullptr;
+  }
+
+  if (nullptr != cq_ring_ && cq_ring_ != sq_ring_) {
+    munmap(cq_ring_, cq_ring_size_);
+  }
+  cq_ring_ = nullptr;
+
+  if (nullptr != sq_ring_) {
+    munmap(sq_ring_, sq_ring_size_);
+    sq_ring_ = nullptr;
+  }
+
+  if (ring_fd_ >= 0) {
+    ::close(ring_fd_);
+    ring_fd_ = -1;
+  }
+
+  pending_ = 0;
+}
+
+bool uring_poller::is_available() const { return ring_fd_ >= 0; }
+
+int uring_poller::poll_add(int fd, uint32_t events, uint64_t user_data) {
+  sqe_t *sqe = get_sqe();
+  if (nullptr == sqe) {
+    return error_code::REDIS_HAPP_UNKNOWD;
+  }
+
+  sqe->opcode = IORING_OP_POLL_ADD;
+  sqe->fd = fd;
+  sqe->poll32_events = detail::uring_poll_mask(events);
+  sqe->user_data = user_data;
+  return error_code::REDIS_HAPP_OK;
+}
+
+int uring_poller::poll_remove(uint64_t target_user_data) {
+  sqe_t *sqe = get_sqe();
+  if (nullptr == sqe) {
+    return error_code::REDIS_HAPP_UNKNOWD;
+  }
+
+  sqe->opcode = IORING_OP_POLL_REMOVE;
+  sqe->fd = -1;
+  sqe->addr = target_user_data;
+  sqe->user_data = 0;
+  return error_code::REDIS_HAPP_OK;
+}
+
+int uring_poller::submit() {
+  if (0 == pending_) {
+    return error_code::REDIS_HAPP_OK;
+  }
+
+  ++submit_count_;
+  return enter(0, 0);
+}
+
+int uring_poller::submit_and_wait(int timeout_ms) {
+  if (0 == timeout_ms) {
+    return submit();
+  }
+
+  ++wait_count_;
+  return enter(1, timeout_ms);
+}
+
+size_t uring_poller::reap(completion_t *out, size_t max_count) {
+  if (ring_fd_ < 0) {
+    return 0;
+  }
+
+  unsigned head = *cq_head_;
+  unsigned tail = detail::uring_load_acquire(cq_tail_);
+  unsigned mask = *cq_mask_;
+  struct io_uring_cqe *cqes = reinterpret_cast<struct io_uring_cqe *>(cqes_);
+
+  size_t ret = 0;
+  while (head != tail && ret < max_count) {
+    const struct io_uring_cqe &cqe = cqes[head & mask];
+    out[ret].user_data = cqe.user_data;
+    out[ret].res = cqe.res;
+    ++ret;
+    ++head;
+  }
+
+  detail::uring_store_release(cq_head_, head);
+  return ret;
+}
+
+uring_poller::sqe_t *uring_poller::get_sqe() {
+  if (ring_fd_ < 0) {
+    return nullptr;
+  }
+
+  unsigned tail = *sq_tail_;
+  // the submission queue is full, submit queued requests at once
+  if (tail - detail::uring_load_acquire(sq_head_) >= sq_entries_) {
+    submit();
+    if (tail - detail::uring_load_acquire(sq_head_) >= sq_entries_) {
+      return nullptr;
+    }
+  }
+
+  unsigned index = tail & *sq_mask_;
+  sqe_t *sqe = reinterpret_cast<sqe_t *>(reinterpret_cast<struct io_uring_sqe *>(sqes_) + index);
+  memset(sqe, 0, sizeof(struct io_uring_sqe));
+  sq_array_[index] = index;
+  detail::uring_store_release(sq_tail_, tail + 1);
+  ++pending_;
+  return sqe;
+}
+
+int uring_poller::enter(unsigned min_complete, int timeout_ms) {
+  if (ring_fd_ < 0) {
+    return error_code::REDIS_HAPP_CREATE;
+  }
+
+  unsigned flags = 0;
+  void *arg = nullptr;
+  size_t arg_size = 0;
+
+#  if defined(IORING_FEAT_EXT_ARG)
+  struct __kernel_timespec ts;
+  struct io_uring_getevents_arg ext_arg;
+#  endif
+  if (min_complete > 0) {
+    flags |= IORING_ENTER_GETEVENTS;
+  }
+
+  if (min_complete > 0 && timeout_ms > 0) {
+#  if defined(IORING_FEAT_EXT_ARG)
+    if (features_ & IORING_FEAT_EXT_ARG) {
+      ts.tv_sec = timeout_ms / 1000;
+      ts.tv_nsec = static_cast<long long>(timeout_ms % 1000) * 1000000;
+      memset(&ext_arg, 0, sizeof(ext_arg));
+      ext_arg.ts = reinterpret_cast<uint64_t>(&ts);
+      flags |= IORING_ENTER_EXT_ARG;
+      arg = &ext_arg;
+      arg_size = sizeof(ext_arg);
+    } else
+#  endif
+    {
+      // older kernels, the timeout completes when any other request completes or it expires
+      timeout_spec_[0] = timeout_ms / 1000;
+      timeout_spec_[1] = static_cast<int64_t>(timeout_ms % 1000) * 1000000;
+      sqe_t *sqe = get_sqe();
+      if (nullptr != sqe) {
+        sqe->opcode = IORING_OP_TIMEOUT;
+        sqe->fd = -1;
+        sqe->addr = reinterpret_cast<uint64_t>(timeout_spec_);
+        sqe->len = 1;
+        sqe->off = 1;
+        sqe->user_data = 0;
+      }
+    }
+  }
+
+  int res = static_cast<int>(syscall(__NR_io_uring_enter, ring_fd_, pending_, min_complete, flags, arg, arg_size));
+  if (res < 0) {
+    if (EINTR == errno || ETIME == errno || EAGAIN == errno || EBUSY == errno) {
+      return error_code::REDIS_HAPP_OK;
+    }
+
+    return error_code::REDIS_HAPP_UNKNOWD;
+  }
+
+  pending_ = static_cast<unsigned>(res) >= pending_ ? 0 : pending_ - static_cast<unsigned>(res);
+  return error_code::REDIS_HAPP_OK;
+}
+}  // namespace happ
+}  // namespace hiredis
+
+#endif
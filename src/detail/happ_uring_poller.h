@@ -0,0 +1,111 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_HIREDIS_HAPP_URING_POLLER_H
+#define HIREDIS_HAPP_HIREDIS_HAPP_URING_POLLER_H
+
+#pragma once
+
+#include "detail/hiredis_happ_config.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_IO_URING)
+
+#  include <stdint.h>
+#  include <cstddef>
+
+namespace hiredis {
+namespace happ {
+
+/**
+ * @brief readiness poller based on io_uring, used by epoll_loop
+ * @note it only uses one-shot IORING_OP_POLL_ADD, so hiredis still reads and writes sockets by itself. Polls added
+ *       and removed in one loop iteration are queued and submitted by one io_uring_enter together with waiting.
+ * @note it's not thread-safe, and io_uring syscalls are called directly, so liburing is not required
+ */
+class uring_poller {
+ public:
+  struct completion_t {
+    uint64_t user_data;
+    int32_t res;
+  };
+
+  uring_poller();
+  ~uring_poller();
+
+  /**
+   * @brief create the ring
+   * @param entries size of the submission queue
+   * @return 0, or REDIS_HAPP_CREATE if io_uring is not available(old kernel, seccomp and so on)
+   */
+  int init(unsigned entries);
+
+  // close the ring, all polls in kernel are cancelled without completions
+  void close();
+
+  bool is_available() const;
+
+  // queue a one-shot poll of events(EPOLLIN, EPOLLOUT and so on)
+  int poll_add(int fd, uint32_t events, uint64_t user_data);
+
+  // queue removing a poll, its completion is reported with -ECANCELED, user_data 0 is reserved and ignored
+  int poll_remove(uint64_t target_user_data);
+
+  // submit queued requests without waiting
+  int submit();
+
+  /**
+   * @brief submit queued requests and wait for at least one completion
+   * @param timeout_ms max time to wait, -1 to wait until any completion and 0 to never wait
+   * @return 0 or error code
+   */
+  int submit_and_wait(int timeout_ms);
+
+  // move completions to out, @return count of completions
+  size_t reap(completion_t *out, size_t max_count);
+
+  // count of io_uring_enter called to wait, and only to submit
+  inline uint64_t get_wait_count() const { return wait_count_; }
+  inline uint64_t get_submit_count() const { return submit_count_; }
+
+ private:
+  uring_poller(const uring_poller &);
+  uring_poller &operator=(const uring_poller &);
+
+  struct sqe_t;
+  sqe_t *get_sqe();
+  int enter(unsigned min_complete, int timeout_ms);
+
+ private:
+  int ring_fd_;
+  uint32_t features_;
+  unsigned sq_entries_;
+  unsigned pending_;  // queued but not submitted
+
+  void *sq_ring_;
+  size_t sq_ring_size_;
+  void *cq_ring_;
+  size_t cq_ring_size_;
+  void *sqes_;
+  size_t sqes_size_;
+
+  unsigned *sq_head_;
+  unsigned *sq_tail_;
+  unsigned *sq_mask_;
+  unsigned *sq_array_;
+  unsigned *cq_head_;
+  unsigned *cq_tail_;
+  unsigned *cq_mask_;
+  void *cqes_;
+
+  int64_t timeout_spec_[2];  // kept until it's submitted when IORING_FEAT_EXT_ARG is not supported
+
+  uint64_t wait_count_;
+  uint64_t submit_count_;
+};
+}  // namespace happ
+}  // namespace hiredis
+
+#endif
+
+#endif  // HIREDIS_HAPP_HIREDIS_HAPP_URING_POLLER_H
@@ -0,0 +1,502 @@
+// Micro benchmarks of hot paths, each one runs in isolation without any network, results are printed as JSON
+// Usage: hiredis-happ-bench [name prefix|all] [iterations] [reply queue depth] [masters]
+// pop_reply_middle_* and pop_reply_tail_* reply a cmd in the middle or at the tail of a queue of at least 1024 cmds
+// Every result has name, iterations, ns_per_op, ops_per_sec and a checksum which keeps the work from being optimized
+// out. Compare ns_per_op of the same name between releases to find regressions.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "detail/crc16.h"
+#include "hiredis_happ.h"
+
+#if defined(HIREDIS_HAPP_UNIT_TEST_HACK)
+namespace hiredis {
+namespace happ {
+// the same access helpers as unit tests, private hot paths are measured by them
+struct cluster_unit_test_access {
+  static void on_reply_update_slot(cmd_exec *cmd, redisAsyncContext *ctx, void *reply) {
+    cluster::on_reply_update_slot(cmd, ctx, reply, nullptr);
+  }
+};
+
+struct connection_unit_test_access {
+  static void push_reply(connection &conn, cmd_exec *cmd) { conn.reply_list_.push_back(cmd); }
+};
+}  // namespace happ
+}  // namespace hiredis
+#endif
+
+namespace {
+struct bench_result_t {
+  std::string name;
+  size_t iterations;
+  double cost_sec;
+  long long checksum;
+};
+
+struct bench_context_t {
+  std::string filter;
+  size_t iterations;
+  size_t queue_depth;
+  size_t masters;
+  std::vector<bench_result_t> results;
+
+  bool match(const std::string &name) const {
+    return "all" == filter || 0 == name.compare(0, filter.size(), filter);
+  }
+};
+
+// measure from construction to add()
+struct bench_timer_t {
+  std::chrono::steady_clock::time_point begin;
+
+  bench_timer_t() : begin(std::chrono::steady_clock::now()) {}
+
+  void add(bench_context_t &ctx, const std::string &name, size_t iterations, long long checksum) const {
+    bench_result_t result;
+    result.name = name;
+    result.iterations = iterations;
+    result.cost_sec = std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::steady_clock::now() -
+                                                                                   begin)
+                          .count();
+    result.checksum = checksum;
+    if (result.cost_sec <= 0.0) {
+      result.cost_sec = 1e-9;
+    }
+    ctx.results.push_back(result);
+  }
+};
+
+void print_json(const bench_context_t &ctx) {
+  printf("{\n");
+  printf("  \"benchmark\": \"hiredis-happ-bench\",\n");
+  printf("  \"config\": {\"iterations\": %zu, \"queue_depth\": %zu, \"masters\": %zu},\n", ctx.iterations,
+         ctx.queue_depth, ctx.masters);
+  printf("  \"results\": [");
+  for (size_t i = 0; i < ctx.results.size(); ++i) {
+    const bench_result_t &result = ctx.results[i];
+    printf("%s\n    {\"name\": \"%s\", \"iterations\": %zu, \"ns_per_op\": %.2f, \"ops_per_sec\": %.0f, "
+           "\"checksum\": %lld}",
+           0 == i ? "" : ",", result.name.c_str(), result.iterations,
+           result.cost_sec * 1000000000.0 / static_cast<double>(result.iterations),
+           static_cast<double>(result.iterations) / result.cost_sec, result.checksum);
+  }
+  printf("\n  ]\n}\n");
+}
+
+redisReply *make_reply(int type) {
+  redisReply *ret = reinterpret_cast<redisReply *>(calloc(1, sizeof(redisReply)));
+  ret->type = type;
+  return ret;
+}
+
+redisReply *make_integer_reply(long long value) {
+  redisReply *ret = make_reply(REDIS_REPLY_INTEGER);
+  ret->integer = value;
+  return ret;
+}
+
+redisReply *make_string_reply(const std::string &value) {
+  redisReply *ret = make_reply(REDIS_REPLY_STRING);
+  ret->len = value.size();
+  ret->str = reinterpret_cast<char *>(malloc(value.size() + 1));
+  memcpy(ret->str, value.c_str(), value.size() + 1);
+  return ret;
+}
+
+redisReply *make_array_reply(size_t elements) {
+  redisReply *ret = make_reply(REDIS_REPLY_ARRAY);
+  ret->elements = elements;
+  ret->element = reinterpret_cast<redisReply **>(calloc(elements, sizeof(redisReply *)));
+  return ret;
+}
+
+// replies are built by hand, so they are not freed by freeReplyObject of hiredis
+void free_reply(redisReply *reply) {
+  if (nullptr == reply) {
+    return;
+  }
+
+  for (size_t i = 0; nullptr != reply->element && i < reply->elements; ++i) {
+    free_reply(reply->element[i]);
+  }
+  free(reply->element);
+  free(reply->str);
+  free(reply);
+}
+
+// CLUSTER SLOTS reply of masters with one replica each, every master owns a continuous range
+redisReply *make_cluster_slots_reply(size_t masters) {
+  redisReply *ret = make_array_reply(masters);
+  for (size_t i = 0; i < masters; ++i) {
+    long long start = static_cast<long long>(i * HIREDIS_HAPP_SLOT_NUMBER / masters);
+    long long end = static_cast<long long>((i + 1) * HIREDIS_HAPP_SLOT_NUMBER / masters) - 1;
+
+    char ip[32];
+    snprintf(ip, sizeof(ip), "10.0.%d.%d", static_cast<int>(i / 250), static_cast<int>(i % 250 + 1));
+
+    redisReply *range = make_array_reply(4);
+    range->element[0] = make_integer_reply(start);
+    range->element[1] = make_integer_reply(end);
+    for (size_t j = 0; j < 2; ++j) {
+      redisReply *addr = make_array_reply(2);
+      addr->element[0] = make_string_reply(ip);
+      addr->element[1] = make_integer_reply(static_cast<long long>(7000 + j));
+      range->element[2 + j] = addr;
+    }
+    ret->element[i] = range;
+  }
+
+  return ret;
+}
+
+void bench_hash_slot(bench_context_t &ctx) {
+  const char *key = "user:1000:profile";
+  const char *tagged_key = "{user:1000}.following";
+  size_t key_len = strlen(key);
+  size_t tagged_key_len = strlen(tagged_key);
+
+  if (ctx.match("crc16")) {
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      checksum += hiredis::happ::crc16(key, key_len - (i & 1));
+    }
+    timer.add(ctx, "crc16", ctx.iterations, checksum);
+  }
+
+  if (ctx.match("hash_slot")) {
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      checksum += hiredis::happ::hash_slot(key, key_len - (i & 1));
+    }
+    timer.add(ctx, "hash_slot", ctx.iterations, checksum);
+  }
+
+  if (ctx.match("hash_slot_tag")) {
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      checksum += hiredis::happ::hash_slot(tagged_key, tagged_key_len - (i & 1));
+    }
+    timer.add(ctx, "hash_slot_tag", ctx.iterations, checksum);
+  }
+}
+
+void bench_cmd_create(bench_context_t &ctx) {
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+
+  if (ctx.match("cmd_create_destroy")) {
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+      checksum += nullptr == cmd ? 0 : 1;
+      hiredis::happ::cmd_exec::destroy(cmd);
+    }
+    timer.add(ctx, "cmd_create_destroy", ctx.iterations, checksum);
+  }
+
+  if (ctx.match("cmd_create_destroy_pool")) {
+    hiredis::happ::cmd_pool *pool = hiredis::happ::cmd_pool::create();
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(pool, h, nullptr, nullptr, 0);
+      checksum += nullptr == cmd ? 0 : 1;
+      hiredis::happ::cmd_exec::destroy(cmd);
+    }
+    timer.add(ctx, "cmd_create_destroy_pool", ctx.iterations, checksum);
+    hiredis::happ::cmd_pool::release(pool);
+  }
+}
+
+void bench_vformat(bench_context_t &ctx) {
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  if (nullptr == cmd) {
+    return;
+  }
+
+  const char *key = "user:1000";
+  const char *field = "profile";
+  std::string value(16, 'v');
+  std::string large_value(HIREDIS_HAPP_CMD_REFERENCE_SIZE, 'v');
+
+  if (ctx.match("vformat_fmt")) {
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      checksum += cmd->format("HSET %s %s %b", key, field, value.c_str(), value.size());
+    }
+    timer.add(ctx, "vformat_fmt", ctx.iterations, checksum);
+  }
+
+  const char *argv[] = {"HSET", key, field, value.c_str()};
+  size_t argvlen[] = {4, strlen(key), strlen(field), value.size()};
+  if (ctx.match("vformat_argv")) {
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      checksum += cmd->vformat(4, argv, argvlen);
+    }
+    timer.add(ctx, "vformat_argv", ctx.iterations, checksum);
+  }
+
+  if (ctx.match("vformat_sds")) {
+    sds src = nullptr;
+    redisFormatSdsCommandArgv(&src, 4, argv, argvlen);
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      checksum += cmd->vformat(&src);
+    }
+    timer.add(ctx, "vformat_sds", ctx.iterations, checksum);
+    sdsfree(src);
+  }
+
+  if (ctx.match("vformat_reference")) {
+    const char *large_argv[] = {"HSET", key, field, large_value.c_str()};
+    size_t large_argvlen[] = {4, strlen(key), strlen(field), large_value.size()};
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      checksum += cmd->vformat_reference(4, large_argv, large_argvlen, nullptr, nullptr);
+    }
+    timer.add(ctx, "vformat_reference", ctx.iterations, checksum);
+  }
+
+  if (ctx.match("vformat_typed")) {
+    static constexpr hiredis::happ::cmd_literal hset("HSET");
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      checksum += cmd->format_args(hset, std::string_view(key), std::string_view(field), value);
+    }
+    timer.add(ctx, "vformat_typed", ctx.iterations, checksum);
+  }
+
+  if (ctx.match("vformat_prepared")) {
+    hiredis::happ::prepared_cmd hset;
+    const char *prepared_argv[] = {"HSET", key, field, nullptr};
+    hset.init(4, prepared_argv, nullptr);
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      checksum += cmd->format_args(hset, value);
+    }
+    timer.add(ctx, "vformat_prepared", ctx.iterations, checksum);
+  }
+
+  if (ctx.match("pick_argument")) {
+    cmd->format("HSET %s %s %b", key, field, value.c_str(), value.size());
+    long long checksum = 0;
+    bench_timer_t timer;
+    for (size_t i = 0; i < ctx.iterations; ++i) {
+      const char *str = nullptr;
+      size_t len = 0;
+      const char *next = cmd->pick_cmd(&str, &len);
+      while (nullptr != next && nullptr != str) {
+        checksum += static_cast<long long>(len);
+        str = nullptr;
+        next = cmd->pick_argument(next, &str, &len);
+      }
+    }
+    timer.add(ctx, "pick_argument", ctx.iterations, checksum);
+  }
+
+  hiredis::happ::cmd_exec::destroy(cmd);
+}
+
+#if defined(HIREDIS_HAPP_UNIT_TEST_HACK)
+void bench_pop_reply(bench_context_t &ctx) {
+  char name[64];
+  snprintf(name, sizeof(name), "pop_reply_depth_%zu", ctx.queue_depth);
+  if (!ctx.match(name)) {
+    return;
+  }
+
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+  hiredis::happ::connection conn;
+  conn.init(h, "127.0.0.1", 6379);
+
+  std::vector<hiredis::happ::cmd_exec *> cmds;
+  cmds.resize(ctx.queue_depth, nullptr);
+  for (size_t i = 0; i < cmds.size(); ++i) {
+    cmds[i] = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+    hiredis::happ::connection_unit_test_access::push_reply(conn, cmds[i]);
+  }
+
+  // replies come in order, so the replied cmd is always the oldest one, and a new cmd is sent after every reply
+  long long checksum = 0;
+  bench_timer_t timer;
+  for (size_t i = 0; i < ctx.iterations; ++i) {
+    hiredis::happ::cmd_exec *cmd = conn.pop_reply(cmds[i % cmds.size()]);
+    checksum += nullptr == cmd ? 0 : 1;
+    hiredis::happ::connection_unit_test_access::push_reply(conn, cmd);
+  }
+  timer.add(ctx, name, ctx.iterations, checksum);
+
+  for (hiredis::happ::cmd_exec *cmd = conn.pop_reply(nullptr); nullptr != cmd; cmd = conn.pop_reply(nullptr)) {
+    hiredis::happ::cmd_exec::destroy(cmd);
+  }
+}
+
+// the replied cmd is not the oldest one, so pop_reply searches the queue and expires all cmds in front of it,
+// expired cmds are replaced by new ones to keep the depth, and the cost of that is counted too
+void bench_pop_reply_at(bench_context_t &ctx, const char *position, size_t depth, size_t index) {
+  char name[64];
+  snprintf(name, sizeof(name), "pop_reply_%s_depth_%zu", position, depth);
+  if (!ctx.match(name)) {
+    return;
+  }
+
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+  hiredis::happ::connection conn;
+  conn.init(h, "127.0.0.1", 6379);
+
+  // same order as the pending queue of conn
+  std::deque<hiredis::happ::cmd_exec *> cmds;
+  for (size_t i = 0; i < depth; ++i) {
+    cmds.push_back(hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0));
+    hiredis::happ::connection_unit_test_access::push_reply(conn, cmds.back());
+  }
+
+  // every iteration walks the queue, so run less of them
+  size_t iterations = ctx.iterations / depth;
+  if (iterations < 16) {
+    iterations = 16;
+  }
+
+  long long checksum = 0;
+  bench_timer_t timer;
+  for (size_t i = 0; i < iterations; ++i) {
+    hiredis::happ::cmd_exec *cmd = conn.pop_reply(cmds[index]);
+    checksum += nullptr == cmd ? 0 : 1;
+    cmds.erase(cmds.begin(), cmds.begin() + static_cast<std::ptrdiff_t>(index + 1));
+
+    cmds.push_back(cmd);
+    hiredis::happ::connection_unit_test_access::push_reply(conn, cmd);
+    while (cmds.size() < depth) {
+      cmds.push_back(hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0));
+      hiredis::happ::connection_unit_test_access::push_reply(conn, cmds.back());
+    }
+  }
+  timer.add(ctx, name, iterations, checksum);
+
+  for (hiredis::happ::cmd_exec *cmd = conn.pop_reply(nullptr); nullptr != cmd; cmd = conn.pop_reply(nullptr)) {
+    hiredis::happ::cmd_exec::destroy(cmd);
+  }
+}
+
+void bench_pop_reply_deep(bench_context_t &ctx) {
+  size_t depth = ctx.queue_depth < 1024 ? 1024 : ctx.queue_depth;
+  bench_pop_reply_at(ctx, "middle", depth, depth / 2);
+  bench_pop_reply_at(ctx, "tail", depth, depth - 1);
+}
+
+void bench_update_slot(bench_context_t &ctx) {
+  char name[64];
+  snprintf(name, sizeof(name), "update_slot_%zu_masters", ctx.masters);
+  if (!ctx.match(name)) {
+    return;
+  }
+
+  hiredis::happ::cluster clu;
+  clu.init("127.0.0.1", 7000);
+
+  hiredis::happ::holder_t h;
+  h.clu = &clu;
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+
+  redisAsyncContext vir_context;
+  memset(&vir_context, 0, sizeof(vir_context));
+  vir_context.c.connection_type = REDIS_CONN_TCP;
+  vir_context.c.tcp.host = const_cast<char *>("127.0.0.1");
+
+  redisReply *reply = make_cluster_slots_reply(ctx.masters);
+
+  // every update rewrites all 16384 slots, so it runs fewer times
+  size_t iterations = ctx.iterations / 10000;
+  if (iterations < 10) {
+    iterations = 10;
+  }
+  long long checksum = 0;
+  bench_timer_t timer;
+  for (size_t i = 0; i < iterations; ++i) {
+    hiredis::happ::cluster_unit_test_access::on_reply_update_slot(cmd, &vir_context, reply);
+    checksum += static_cast<long long>(clu.get_slot_master(static_cast<int>(i % HIREDIS_HAPP_SLOT_NUMBER))->port);
+  }
+  timer.add(ctx, name, iterations, checksum);
+
+  free_reply(reply);
+  hiredis::happ::cmd_exec::destroy(cmd);
+  clu.reset();
+}
+#endif
+
+void bench_parse_moved(bench_context_t &ctx) {
+  if (!ctx.match("parse_moved")) {
+    return;
+  }
+
+  const char *reply = "MOVED 3999 127.0.0.1:6381";
+  long long checksum = 0;
+  bench_timer_t timer;
+  for (size_t i = 0; i < ctx.iterations; ++i) {
+    int slot_index = 0;
+    std::string ip;
+    uint16_t port = 0;
+    if (0 == HIREDIS_HAPP_STRNCASE_CMP("MOVED", reply, 5) &&
+        hiredis::happ::cluster::parse_redirect(reply + 6, slot_index, ip, port)) {
+      checksum += slot_index + port + static_cast<long long>(ip.size());
+    }
+  }
+  timer.add(ctx, "parse_moved", ctx.iterations, checksum);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  bench_context_t ctx;
+  ctx.filter = argc > 1 ? argv[1] : "all";
+  ctx.iterations = argc > 2 ? static_cast<size_t>(strtoull(argv[2], nullptr, 10)) : 1000000;
+  ctx.queue_depth = argc > 3 ? static_cast<size_t>(strtoull(argv[3], nullptr, 10)) : 4096;
+  ctx.masters = argc > 4 ? static_cast<size_t>(strtoull(argv[4], nullptr, 10)) : 256;
+  if (0 == ctx.iterations) {
+    ctx.iterations = 1;
+  }
+  if (0 == ctx.queue_depth) {
+    ctx.queue_depth = 1;
+  }
+  if (0 == ctx.masters) {
+    ctx.masters = 1;
+  }
+  if (ctx.masters > HIREDIS_HAPP_SLOT_NUMBER) {
+    ctx.masters = HIREDIS_HAPP_SLOT_NUMBER;
+  }
+
+  bench_hash_slot(ctx);
+  bench_cmd_create(ctx);
+  bench_vformat(ctx);
+#if defined(HIREDIS_HAPP_UNIT_TEST_HACK)
+  bench_pop_reply(ctx);
+  bench_pop_reply_deep(ctx);
+  bench_update_slot(ctx);
+#endif
+  bench_parse_moved(ctx);
+
+  print_json(ctx);
+  return 0;
+}
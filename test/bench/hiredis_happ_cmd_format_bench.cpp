@@ -0,0 +1,127 @@
+// Compare the cost of encoding the same command by format string, argv, typed arguments and prepared command
+// Usage: hiredis-happ-bench-cmd-format [fmt|argv|typed|prepared|all] [iterations] [value size]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "hiredis_happ.h"
+
+namespace {
+// HSET key field [integer] [double] [value]
+const char *g_bench_key = "user:1000";
+const char *g_bench_field = "profile";
+const int64_t g_bench_integer = 1234567890;
+const double g_bench_double = 3.14;
+
+void report(const char *name, size_t iterations, size_t value_size, std::chrono::steady_clock::time_point begin,
+            int64_t total_len) {
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double cost_sec = std::chrono::duration_cast<std::chrono::duration<double> >(end - begin).count();
+  if (cost_sec <= 0.0) {
+    cost_sec = 1e-9;
+  }
+
+  printf("%-8s iterations: %zu, value size: %zu, cost: %.3fs, %.1f ns/cmd, %.0f ops/s, checksum: %lld\n", name,
+         iterations, value_size, cost_sec, cost_sec * 1000000000.0 / static_cast<double>(iterations),
+         static_cast<double>(iterations) / cost_sec, static_cast<long long>(total_len));
+}
+
+void run_fmt(hiredis::happ::cmd_exec *cmd, size_t iterations, const std::string &value) {
+  int64_t total_len = 0;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    total_len += cmd->format("HSET %s %s %lld %f %b", g_bench_key, g_bench_field,
+                             static_cast<long long>(g_bench_integer), g_bench_double, value.c_str(), value.size());
+  }
+  report("fmt", iterations, value.size(), begin, total_len);
+}
+
+void run_argv(hiredis::happ::cmd_exec *cmd, size_t iterations, const std::string &value) {
+  int64_t total_len = 0;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    // numbers must be converted by caller
+    char integer_buf[32];
+    char double_buf[32];
+    int integer_len = snprintf(integer_buf, sizeof(integer_buf), "%lld", static_cast<long long>(g_bench_integer));
+    int double_len = snprintf(double_buf, sizeof(double_buf), "%.15g", g_bench_double);
+
+    const char *argv[] = {"HSET", g_bench_key, g_bench_field, integer_buf, double_buf, value.c_str()};
+    size_t argvlen[] = {4,
+                        strlen(g_bench_key),
+                        strlen(g_bench_field),
+                        static_cast<size_t>(integer_len),
+                        static_cast<size_t>(double_len),
+                        value.size()};
+    total_len += cmd->vformat(6, argv, argvlen);
+  }
+  report("argv", iterations, value.size(), begin, total_len);
+}
+
+void run_typed(hiredis::happ::cmd_exec *cmd, size_t iterations, const std::string &value) {
+  static constexpr hiredis::happ::cmd_literal hset("HSET");
+
+  int64_t total_len = 0;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    total_len += cmd->format_args(hset, std::string_view(g_bench_key), std::string_view(g_bench_field),
+                                  g_bench_integer, g_bench_double, value);
+  }
+  report("typed", iterations, value.size(), begin, total_len);
+}
+
+void run_prepared(hiredis::happ::cmd_exec *cmd, size_t iterations, const std::string &value) {
+  // key and field are constant parts of the command shape
+  hiredis::happ::prepared_cmd hset;
+  const char *argv[] = {"HSET", g_bench_key, g_bench_field, nullptr, nullptr, nullptr};
+  hset.init(6, argv, nullptr);
+
+  int64_t total_len = 0;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    total_len += cmd->format_args(hset, g_bench_integer, g_bench_double, value);
+  }
+  report("prepared", iterations, value.size(), begin, total_len);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const char *mode = argc > 1 ? argv[1] : "all";
+  size_t iterations = argc > 2 ? static_cast<size_t>(strtoull(argv[2], nullptr, 10)) : 1000000;
+  size_t value_size = argc > 3 ? static_cast<size_t>(strtoull(argv[3], nullptr, 10)) : 16;
+  if (0 == iterations) {
+    iterations = 1;
+  }
+
+  std::string value(value_size, 'v');
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  if (nullptr == cmd) {
+    fprintf(stderr, "create cmd failed\n");
+    return 1;
+  }
+
+  if (0 == strcmp("fmt", mode) || 0 == strcmp("all", mode)) {
+    run_fmt(cmd, iterations, value);
+  }
+
+  if (0 == strcmp("argv", mode) || 0 == strcmp("all", mode)) {
+    run_argv(cmd, iterations, value);
+  }
+
+  if (0 == strcmp("typed", mode) || 0 == strcmp("all", mode)) {
+    run_typed(cmd, iterations, value);
+  }
+
+  if (0 == strcmp("prepared", mode) || 0 == strcmp("all", mode)) {
+    run_prepared(cmd, iterations, value);
+  }
+
+  hiredis::happ::cmd_exec::destroy(cmd);
+  return 0;
+}
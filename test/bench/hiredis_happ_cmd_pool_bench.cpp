@@ -0,0 +1,95 @@
+// Compare create/destroy throughput and RSS of cmd_exec between plain malloc and cmd_pool
+// Usage: hiredis-happ-bench-cmd-pool [malloc|pool|all] [iterations] [in flight cmds] [cmd buffer size]
+// RSS is process wide, run malloc and pool in separate processes to compare it.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__linux__)
+#  include <unistd.h>
+#endif
+
+#include "hiredis_happ.h"
+
+namespace {
+size_t get_rss_bytes() {
+#if defined(__linux__)
+  FILE *f = fopen("/proc/self/statm", "r");
+  if (nullptr == f) {
+    return 0;
+  }
+
+  unsigned long pages_total = 0;
+  unsigned long pages_resident = 0;
+  if (2 != fscanf(f, "%lu %lu", &pages_total, &pages_resident)) {
+    pages_resident = 0;
+  }
+  fclose(f);
+  return static_cast<size_t>(pages_resident) * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+  return 0;
+#endif
+}
+
+void run_bench(const char *name, hiredis::happ::cmd_pool *pool, size_t iterations, size_t in_flight,
+               size_t buffer_size) {
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+
+  std::vector<hiredis::happ::cmd_exec *> cmds;
+  cmds.resize(in_flight, nullptr);
+
+  size_t rss_before = get_rss_bytes();
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+  // keep in_flight cmds alive, and replace them in a rotating order just like a pipeline
+  for (size_t i = 0; i < iterations; ++i) {
+    size_t idx = i % in_flight;
+    if (nullptr != cmds[idx]) {
+      hiredis::happ::cmd_exec::destroy(cmds[idx]);
+    }
+    cmds[idx] = hiredis::happ::cmd_exec::create(pool, h, nullptr, nullptr, buffer_size);
+  }
+
+  size_t rss_peak = get_rss_bytes();
+  for (size_t i = 0; i < in_flight; ++i) {
+    hiredis::happ::cmd_exec::destroy(cmds[i]);
+    cmds[i] = nullptr;
+  }
+
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double cost_sec = std::chrono::duration_cast<std::chrono::duration<double> >(end - begin).count();
+  if (cost_sec <= 0.0) {
+    cost_sec = 1e-9;
+  }
+
+  printf("%-8s iterations: %zu, in flight: %zu, buffer: %zu, cost: %.3fs, %.0f ops/s, rss: %zu KB -> %zu KB\n", name,
+         iterations, in_flight, buffer_size, cost_sec, static_cast<double>(iterations) / cost_sec, rss_before / 1024,
+         rss_peak / 1024);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const char *mode = argc > 1 ? argv[1] : "all";
+  size_t iterations = argc > 2 ? static_cast<size_t>(strtoull(argv[2], nullptr, 10)) : 10000000;
+  size_t in_flight = argc > 3 ? static_cast<size_t>(strtoull(argv[3], nullptr, 10)) : 1024;
+  size_t buffer_size = argc > 4 ? static_cast<size_t>(strtoull(argv[4], nullptr, 10)) : 0;
+  if (0 == in_flight) {
+    in_flight = 1;
+  }
+
+  if (0 == strcmp("malloc", mode) || 0 == strcmp("all", mode)) {
+    run_bench("malloc", nullptr, iterations, in_flight, buffer_size);
+  }
+
+  if (0 == strcmp("pool", mode) || 0 == strcmp("all", mode)) {
+    hiredis::happ::cmd_pool *pool = hiredis::happ::cmd_pool::create();
+    run_bench("pool", pool, iterations, in_flight, buffer_size);
+    hiredis::happ::cmd_pool::release(pool);
+  }
+
+  return 0;
+}
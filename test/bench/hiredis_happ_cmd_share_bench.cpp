@@ -0,0 +1,111 @@
+// Compare memory and cost of fanning out one command to many nodes, by formatting every cmd or sharing the content
+// Usage: hiredis-happ-bench-cmd-share [copy|shared|all] [iterations] [nodes] [value size]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "hiredis_happ.h"
+
+namespace {
+// bytes of command content allocated out of cmd_exec, every buffer is counted once
+size_t get_content_bytes(const std::vector<hiredis::happ::cmd_exec *> &cmds) {
+  std::set<const void *> buffers;
+  size_t ret = 0;
+  for (size_t i = 0; i < cmds.size(); ++i) {
+    hiredis::happ::cmd_content content = cmds[i]->get_cmd_raw_content();
+    switch (content.kind) {
+      case hiredis::happ::cmd_content::storage::SDS:
+        if (nullptr != content.content.redis_sds && buffers.insert(content.content.redis_sds).second) {
+          ret += sdslen(content.content.redis_sds);
+        }
+        break;
+      case hiredis::happ::cmd_content::storage::INLINE:
+        break;
+      case hiredis::happ::cmd_content::storage::SCATTER:
+        if (nullptr != content.content.scatter && buffers.insert(content.content.scatter).second) {
+          ret += content.content.scatter->total_len;
+        }
+        break;
+      default:
+        if (nullptr != content.content.raw && buffers.insert(content.content.raw).second) {
+          ret += content.raw_len;
+        }
+        break;
+    }
+  }
+
+  return ret;
+}
+
+void run_bench(const char *name, bool shared, size_t iterations, size_t nodes, const std::string &value) {
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+
+  std::vector<hiredis::happ::cmd_exec *> cmds;
+  cmds.resize(nodes, nullptr);
+  const char *argv[] = {"SCRIPT", "LOAD", value.c_str()};
+  size_t argvlen[] = {6, 4, value.size()};
+
+  size_t content_bytes = 0;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i) {
+    for (size_t j = 0; j < nodes; ++j) {
+      cmds[j] = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+      if (shared && j > 0) {
+        cmds[j]->share_content(cmds[0]);
+      } else {
+        cmds[j]->vformat(3, argv, argvlen);
+      }
+    }
+
+    if (0 == i) {
+      content_bytes = get_content_bytes(cmds);
+    }
+
+    for (size_t j = 0; j < nodes; ++j) {
+      hiredis::happ::cmd_exec::destroy(cmds[j]);
+      cmds[j] = nullptr;
+    }
+  }
+
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double cost_sec = std::chrono::duration_cast<std::chrono::duration<double> >(end - begin).count();
+  if (cost_sec <= 0.0) {
+    cost_sec = 1e-9;
+  }
+
+  printf("%-8s iterations: %zu, nodes: %zu, value size: %zu, cost: %.3fs, %.1f us/broadcast, content: %zu bytes\n",
+         name, iterations, nodes, value.size(), cost_sec, cost_sec * 1000000.0 / static_cast<double>(iterations),
+         content_bytes);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const char *mode = argc > 1 ? argv[1] : "all";
+  size_t iterations = argc > 2 ? static_cast<size_t>(strtoull(argv[2], nullptr, 10)) : 10000;
+  size_t nodes = argc > 3 ? static_cast<size_t>(strtoull(argv[3], nullptr, 10)) : 100;
+  size_t value_size = argc > 4 ? static_cast<size_t>(strtoull(argv[4], nullptr, 10)) : 4096;
+  if (0 == iterations) {
+    iterations = 1;
+  }
+  if (0 == nodes) {
+    nodes = 1;
+  }
+
+  std::string value(value_size, 'v');
+
+  if (0 == strcmp("copy", mode) || 0 == strcmp("all", mode)) {
+    run_bench("copy", false, iterations, nodes, value);
+  }
+
+  if (0 == strcmp("shared", mode) || 0 == strcmp("all", mode)) {
+    run_bench("shared", true, iterations, nodes, value);
+  }
+
+  return 0;
+}
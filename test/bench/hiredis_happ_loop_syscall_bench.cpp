@@ -0,0 +1,258 @@
+// Syscalls per command of the libevent adapter and the built-in loop with epoll and io_uring, against a live Redis
+// Cluster. Reads and writes are taken from /proc/self/io, polling syscalls of the built-in loop from its stats.
+// Run it by "strace -f -c" to see all syscalls of every mode.
+// Usage: hiredis-happ-bench-loop-syscall <ip> <port> [libevent|epoll|io_uring|all] [pipeline] [seconds]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+
+#include "hiredis_happ.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_LIBEVENT)
+#  include "hiredis/adapters/libevent.h"
+#endif
+
+namespace {
+struct bench_state_t {
+  hiredis::happ::cluster *clu;
+  uint64_t key_seq;
+  uint64_t done;
+  uint64_t failed;
+  bool running;
+};
+
+// read-like and write-like syscalls of this process
+bool read_io_syscalls(unsigned long long &reads, unsigned long long &writes) {
+  FILE *f = fopen("/proc/self/io", "r");
+  if (nullptr == f) {
+    return false;
+  }
+
+  reads = 0;
+  writes = 0;
+  char line[128];
+  while (nullptr != fgets(line, sizeof(line), f)) {
+    if (0 == strncmp(line, "syscr:", 6)) {
+      reads = strtoull(line + 6, nullptr, 10);
+    } else if (0 == strncmp(line, "syscw:", 6)) {
+      writes = strtoull(line + 6, nullptr, 10);
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+void send_one(bench_state_t *state);
+
+void on_reply(hiredis::happ::cmd_exec *c, struct redisAsyncContext *, void *, void *privdata) {
+  bench_state_t *state = reinterpret_cast<bench_state_t *>(privdata);
+  if (hiredis::happ::error_code::REDIS_HAPP_OK == c->result()) {
+    ++state->done;
+  } else {
+    ++state->failed;
+  }
+
+  if (state->running) {
+    send_one(state);
+  }
+}
+
+void send_one(bench_state_t *state) {
+  char key[64];
+  int key_len = snprintf(key, sizeof(key), "bench:loop:%llu", static_cast<unsigned long long>(++state->key_seq));
+  state->clu->exec(key, static_cast<size_t>(key_len), on_reply, state, "SET %b %llu", key,
+                   static_cast<size_t>(key_len), static_cast<unsigned long long>(state->key_seq));
+}
+
+struct measure_t {
+  std::chrono::steady_clock::time_point begin;
+  uint64_t begin_done;
+  unsigned long long begin_reads;
+  unsigned long long begin_writes;
+
+  void start(const bench_state_t &state) {
+    begin = std::chrono::steady_clock::now();
+    begin_done = state.done;
+    read_io_syscalls(begin_reads, begin_writes);
+  }
+
+  void report(const char *name, const bench_state_t &state, unsigned long long wait_count,
+              unsigned long long control_count) {
+    double cost_sec =
+        std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::steady_clock::now() - begin).count();
+    unsigned long long reads = 0;
+    unsigned long long writes = 0;
+    read_io_syscalls(reads, writes);
+
+    uint64_t ops = state.done - begin_done;
+    double per_op = ops > 0 ? 1.0 / static_cast<double>(ops) : 0.0;
+    printf("%-8s ops: %llu, failed: %llu, %.0f ops/s, read: %.3f/op, write: %.3f/op", name,
+           static_cast<unsigned long long>(ops), static_cast<unsigned long long>(state.failed),
+           static_cast<double>(ops) / cost_sec, static_cast<double>(reads - begin_reads) * per_op,
+           static_cast<double>(writes - begin_writes) * per_op);
+    if (wait_count > 0 || control_count > 0) {
+      printf(", wait: %.3f/op, control: %.3f/op", static_cast<double>(wait_count) * per_op,
+             static_cast<double>(control_count) * per_op);
+    }
+    puts("");
+  }
+};
+
+#if defined(HIREDIS_HAPP_ENABLE_LIBEVENT)
+event_base *g_libevent_base = nullptr;
+
+void on_libevent_connect(hiredis::happ::cluster *, hiredis::happ::connection *conn) {
+  redisLibeventAttach(conn->get_context(), g_libevent_base);
+}
+
+void on_libevent_timer(evutil_socket_t, short, void *arg) {
+  hiredis::happ::cluster *clu = reinterpret_cast<hiredis::happ::cluster *>(arg);
+  std::chrono::microseconds now =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch());
+  clu->proc(static_cast<time_t>(now.count() / 1000000), static_cast<time_t>(now.count() % 1000000));
+}
+
+void run_libevent(const char *ip, uint16_t port, size_t pipeline, int seconds) {
+  event_base *base = event_base_new();
+  g_libevent_base = base;
+  hiredis::happ::cluster clu;
+  clu.init(ip, port);
+  clu.set_on_connect(on_libevent_connect);
+  clu.set_timeout(5);
+
+  struct event *timer = event_new(base, -1, EV_PERSIST, on_libevent_timer, &clu);
+  struct timeval tv;
+  tv.tv_sec = 0;
+  tv.tv_usec = HIREDIS_HAPP_LOOP_TICK_USEC;
+  evtimer_add(timer, &tv);
+
+  bench_state_t state;
+  state.clu = &clu;
+  state.key_seq = 0;
+  state.done = 0;
+  state.failed = 0;
+  state.running = true;
+  clu.start();
+  for (size_t i = 0; i < pipeline; ++i) {
+    send_one(&state);
+  }
+
+  // skip slot loading and connecting
+  std::chrono::steady_clock::time_point warm_end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (std::chrono::steady_clock::now() < warm_end) {
+    event_base_loop(base, EVLOOP_ONCE);
+  }
+
+  measure_t measure;
+  measure.start(state);
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+  while (std::chrono::steady_clock::now() < end) {
+    event_base_loop(base, EVLOOP_ONCE);
+  }
+  measure.report("libevent", state, 0, 0);
+
+  state.running = false;
+  clu.reset();
+  event_free(timer);
+  event_base_free(base);
+  g_libevent_base = nullptr;
+}
+#endif
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+void run_builtin(const char *ip, uint16_t port, hiredis::happ::epoll_loop::backend_t::type backend, size_t pipeline,
+                 int seconds) {
+  const char *name = hiredis::happ::epoll_loop::backend_t::IO_URING == backend ? "io_uring" : "epoll";
+  hiredis::happ::epoll_loop loop;
+  if (hiredis::happ::error_code::REDIS_HAPP_OK != loop.init(HIREDIS_HAPP_LOOP_TICK_USEC, backend)) {
+    printf("%-8s not available\n", name);
+    return;
+  }
+
+  hiredis::happ::cluster clu;
+  clu.init(ip, port);
+  clu.set_timeout(5);
+  loop.bind(clu);
+
+  bench_state_t state;
+  state.clu = &clu;
+  state.key_seq = 0;
+  state.done = 0;
+  state.failed = 0;
+  state.running = true;
+  clu.start();
+  for (size_t i = 0; i < pipeline; ++i) {
+    send_one(&state);
+  }
+
+  std::chrono::steady_clock::time_point warm_end = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+  while (std::chrono::steady_clock::now() < warm_end) {
+    loop.run_once(10);
+  }
+
+  measure_t measure;
+  hiredis::happ::epoll_loop::stats_t begin_stats = loop.get_stats();
+  measure.start(state);
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+  while (std::chrono::steady_clock::now() < end) {
+    loop.run_once(10);
+  }
+  hiredis::happ::epoll_loop::stats_t end_stats = loop.get_stats();
+  measure.report(name, state, static_cast<unsigned long long>(end_stats.wait_count - begin_stats.wait_count),
+                 static_cast<unsigned long long>(end_stats.control_count - begin_stats.control_count));
+
+  state.running = false;
+  clu.reset();
+  for (int i = 0; i < 10; ++i) {
+    loop.run_once(0);
+  }
+}
+#endif
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    printf("usage: %s <ip> <port> [libevent|epoll|io_uring|all] [pipeline] [seconds]\n", argv[0]);
+    return 0;
+  }
+
+  const char *ip = argv[1];
+  uint16_t port = static_cast<uint16_t>(strtol(argv[2], nullptr, 10));
+  std::string mode = argc > 3 ? argv[3] : "all";
+  size_t pipeline = argc > 4 ? static_cast<size_t>(strtoull(argv[4], nullptr, 10)) : 64;
+  int seconds = argc > 5 ? static_cast<int>(strtol(argv[5], nullptr, 10)) : 5;
+  if (0 == pipeline) {
+    pipeline = 1;
+  }
+  if (seconds <= 0) {
+    seconds = 1;
+  }
+
+  if ("all" == mode || "libevent" == mode) {
+#if defined(HIREDIS_HAPP_ENABLE_LIBEVENT)
+    run_libevent(ip, port, pipeline, seconds);
+#else
+    puts("libevent not available");
+#endif
+  }
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+  if ("all" == mode || "epoll" == mode) {
+    run_builtin(ip, port, hiredis::happ::epoll_loop::backend_t::EPOLL, pipeline, seconds);
+  }
+
+  if ("all" == mode || "io_uring" == mode) {
+    run_builtin(ip, port, hiredis::happ::epoll_loop::backend_t::IO_URING, pipeline, seconds);
+  }
+#else
+  if ("all" == mode || "epoll" == mode || "io_uring" == mode) {
+    puts("built-in loop is only available on linux");
+  }
+#endif
+
+  return 0;
+}
@@ -0,0 +1,178 @@
+// GET pipelines against the in-process fake cluster while it keeps redirecting commands. It shows the throughput,
+// the extra commands sent per request and the CLUSTER SLOTS reloads of a redirect storm.
+// baseline: no fault, moved: slots are moved to the next node every tick, ask: every node replies ASK,
+// tryagain: every node replies TRYAGAIN.
+// The fake cluster shares the process, so compare the modes with each other but not with a real Redis Cluster.
+// Usage: hiredis-happ-bench-redirect [baseline|moved|ask|tryagain|all] [nodes] [pipeline] [seconds]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "hiredis_happ.h"
+
+#include "../case/test_fake_cluster.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+namespace {
+struct bench_state_t {
+  hiredis::happ::cluster *clu;
+  uint64_t key_seq;
+  uint64_t done;
+  uint64_t failed;
+  bool running;
+};
+
+void send_one(bench_state_t *state);
+
+void on_reply(hiredis::happ::cmd_exec *c, struct redisAsyncContext *, void *, void *privdata) {
+  bench_state_t *state = reinterpret_cast<bench_state_t *>(privdata);
+  if (hiredis::happ::error_code::REDIS_HAPP_OK == c->result()) {
+    ++state->done;
+  } else {
+    ++state->failed;
+  }
+
+  if (state->running) {
+    send_one(state);
+  }
+}
+
+void send_one(bench_state_t *state) {
+  char key[64];
+  int key_len =
+      snprintf(key, sizeof(key), "bench:redirect:%llu", static_cast<unsigned long long>(++state->key_seq % 10000));
+  state->clu->exec(key, static_cast<size_t>(key_len), on_reply, state, "GET %b", key, static_cast<size_t>(key_len));
+}
+
+// faults of one tick
+void make_storm(hiredis_happ_test::fake_cluster &server, const std::string &mode, size_t pipeline, size_t tick) {
+  size_t nodes = server.get_node_count();
+  if ("moved" == mode) {
+    // move 1/16 of all slots to the next node, like a resharding in progress
+    int step = HIREDIS_HAPP_SLOT_NUMBER / 16;
+    int start = static_cast<int>(tick % 16) * step;
+    server.assign_slots(start, start + step - 1, (server.get_slot_owner(start) + 1) % nodes);
+  } else if ("ask" == mode) {
+    for (size_t i = 0; i < nodes; ++i) {
+      server.inject_fault(i, hiredis_happ_test::fake_cluster::fault_t::ASK, pipeline, (i + 1) % nodes);
+    }
+  } else if ("tryagain" == mode) {
+    for (size_t i = 0; i < nodes; ++i) {
+      server.inject_fault(i, hiredis_happ_test::fake_cluster::fault_t::TRYAGAIN, pipeline / 2 + 1);
+    }
+  }
+}
+
+size_t total_commands(const hiredis_happ_test::fake_cluster &server) {
+  size_t ret = 0;
+  for (size_t i = 0; i < server.get_node_count(); ++i) {
+    ret += server.get_command_count(i);
+  }
+  return ret;
+}
+
+void run_mode(const std::string &mode, size_t nodes, size_t pipeline, int seconds) {
+  hiredis_happ_test::fake_cluster server(nodes);
+  if (!server.is_ready()) {
+    printf("%-8s fake cluster not available\n", mode.c_str());
+    return;
+  }
+
+  hiredis::happ::epoll_loop loop;
+  loop.init();
+  hiredis::happ::cluster clu;
+  clu.init("127.0.0.1", server.get_port(0));
+  clu.set_timeout(5);
+  loop.bind(clu);
+
+  bench_state_t state;
+  state.clu = &clu;
+  state.key_seq = 0;
+  state.done = 0;
+  state.failed = 0;
+  state.running = true;
+  clu.start();
+  for (size_t i = 0; i < pipeline; ++i) {
+    send_one(&state);
+  }
+
+  // skip slot loading and connecting
+  std::chrono::steady_clock::time_point warm_end = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+  while (std::chrono::steady_clock::now() < warm_end) {
+    loop.run_once(10);
+  }
+
+  uint64_t begin_done = state.done;
+  uint64_t begin_failed = state.failed;
+  size_t begin_commands = total_commands(server);
+  size_t begin_reloads = server.get_cluster_slots_count();
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  std::chrono::steady_clock::time_point end = begin + std::chrono::seconds(seconds);
+  std::chrono::steady_clock::time_point next_tick = begin;
+  size_t tick = 0;
+  while (true) {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (now >= end) {
+      break;
+    }
+    if (now >= next_tick) {
+      make_storm(server, mode, pipeline, tick++);
+      next_tick = now + std::chrono::milliseconds(10);
+    }
+    loop.run_once(1);
+  }
+
+  double cost_sec =
+      std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::steady_clock::now() - begin).count();
+  uint64_t ops = state.done - begin_done;
+  double per_op = ops > 0 ? 1.0 / static_cast<double>(ops) : 0.0;
+  printf("%-8s ops: %llu, failed: %llu, %.0f ops/s, server commands: %.3f/op, slot reloads: %llu\n", mode.c_str(),
+         static_cast<unsigned long long>(ops), static_cast<unsigned long long>(state.failed - begin_failed),
+         static_cast<double>(ops) / cost_sec, static_cast<double>(total_commands(server) - begin_commands) * per_op,
+         static_cast<unsigned long long>(server.get_cluster_slots_count() - begin_reloads));
+
+  state.running = false;
+  clu.reset();
+  for (int i = 0; i < 10; ++i) {
+    loop.run_once(0);
+  }
+}
+}  // namespace
+#endif
+
+int main(int argc, char *argv[]) {
+  std::string mode = argc > 1 ? argv[1] : "all";
+  size_t nodes = argc > 2 ? static_cast<size_t>(strtoull(argv[2], nullptr, 10)) : 3;
+  size_t pipeline = argc > 3 ? static_cast<size_t>(strtoull(argv[3], nullptr, 10)) : 64;
+  int seconds = argc > 4 ? static_cast<int>(strtol(argv[4], nullptr, 10)) : 3;
+  if (0 == nodes) {
+    nodes = 1;
+  }
+  if (0 == pipeline) {
+    pipeline = 1;
+  }
+  if (seconds <= 0) {
+    seconds = 1;
+  }
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+  const char *modes[] = {"baseline", "moved", "ask", "tryagain"};
+  bool found = false;
+  for (size_t i = 0; i < sizeof(modes) / sizeof(modes[0]); ++i) {
+    if ("all" == mode || mode == modes[i]) {
+      found = true;
+      run_mode(modes[i], nodes, pipeline, seconds);
+    }
+  }
+  if (!found) {
+    printf("usage: %s [baseline|moved|ask|tryagain|all] [nodes] [pipeline] [seconds]\n", argv[0]);
+  }
+#else
+  puts("fake cluster is only available on linux");
+#endif
+
+  return 0;
+}
@@ -0,0 +1,128 @@
+// Compare allocation count and latency of building large array replies between hiredis's default reply functions
+// and reply_arena
+// Usage: hiredis-happ-bench-reply-arena [default|arena|all] [iterations] [array elements] [element size]
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "hiredis_happ.h"
+
+namespace {
+size_t g_alloc_count = 0;
+
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+void *counting_malloc(size_t size) {
+  ++g_alloc_count;
+  return malloc(size);
+}
+
+void *counting_calloc(size_t nmemb, size_t size) {
+  ++g_alloc_count;
+  return calloc(nmemb, size);
+}
+
+void *counting_realloc(void *ptr, size_t size) {
+  ++g_alloc_count;
+  return realloc(ptr, size);
+}
+
+char *counting_strdup(const char *str) {
+  ++g_alloc_count;
+  return strdup(str);
+}
+
+void counting_free(void *ptr) { free(ptr); }
+#endif
+
+// reply of HGETALL or LRANGE
+std::string make_array_reply(size_t elements, size_t element_size) {
+  std::string value(element_size, 'v');
+  std::string ret = "*" + std::to_string(elements) + "\r\n";
+  for (size_t i = 0; i < elements; ++i) {
+    ret += "$" + std::to_string(value.size()) + "\r\n" + value + "\r\n";
+  }
+  return ret;
+}
+
+void run_bench(const char *name, hiredis::happ::reply_arena *arena, const std::string &data, size_t iterations) {
+  redisReader *reader = nullptr == arena
+                            ? redisReaderCreate()
+                            : redisReaderCreateWithFunctions(hiredis::happ::reply_arena::get_reply_functions());
+  if (nullptr == reader) {
+    printf("%-8s create reader failed\n", name);
+    return;
+  }
+  reader->privdata = arena;
+
+  size_t arena_alloc_before = nullptr == arena ? 0 : arena->get_stats().system_allocations;
+  size_t hiredis_alloc_before = g_alloc_count;
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < iterations; ++i) {
+    void *reply = nullptr;
+    if (REDIS_OK != redisReaderFeed(reader, data.c_str(), data.size()) ||
+        REDIS_OK != redisReaderGetReply(reader, &reply) || nullptr == reply) {
+      printf("%-8s parse reply failed\n", name);
+      break;
+    }
+
+    // just like hiredis does after the callback returns
+    reader->fn->freeObject(reply);
+  }
+
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double cost_sec = std::chrono::duration_cast<std::chrono::duration<double> >(end - begin).count();
+  if (cost_sec <= 0.0) {
+    cost_sec = 1e-9;
+  }
+
+  size_t alloc_count = g_alloc_count - hiredis_alloc_before;
+  if (nullptr != arena) {
+    alloc_count += arena->get_stats().system_allocations - arena_alloc_before;
+  }
+
+  printf("%-8s iterations: %zu, reply size: %zu, cost: %.3fs, %.1f us/reply, allocations: %.1f/reply\n", name,
+         iterations, data.size(), cost_sec, cost_sec * 1000000.0 / static_cast<double>(iterations),
+         static_cast<double>(alloc_count) / static_cast<double>(iterations));
+
+  redisReaderFree(reader);
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const char *mode = argc > 1 ? argv[1] : "all";
+  size_t iterations = argc > 2 ? static_cast<size_t>(strtoull(argv[2], nullptr, 10)) : 10000;
+  size_t elements = argc > 3 ? static_cast<size_t>(strtoull(argv[3], nullptr, 10)) : 2000;
+  size_t element_size = argc > 4 ? static_cast<size_t>(strtoull(argv[4], nullptr, 10)) : 16;
+  if (0 == iterations) {
+    iterations = 1;
+  }
+
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+  hiredisAllocFuncs counting_allocators = {counting_malloc, counting_calloc, counting_realloc, counting_strdup,
+                                           counting_free};
+  hiredisSetAllocators(&counting_allocators);
+#else
+  printf("allocations of hiredis are not counted, hiredis 1.0 or upper is required\n");
+#endif
+
+  std::string data = make_array_reply(elements, element_size);
+
+  if (0 == strcmp("default", mode) || 0 == strcmp("all", mode)) {
+    run_bench("default", nullptr, data, iterations);
+  }
+
+  if (0 == strcmp("arena", mode) || 0 == strcmp("all", mode)) {
+    hiredis::happ::reply_arena *arena = hiredis::happ::reply_arena::create(HIREDIS_HAPP_REPLY_ARENA_CHUNK_SIZE);
+    run_bench("arena", arena, data, iterations);
+    hiredis::happ::reply_arena::release(arena);
+  }
+
+#if defined(HIREDIS_MAJOR) && HIREDIS_MAJOR >= 1
+  hiredisResetAllocators();
+#endif
+  return 0;
+}
@@ -0,0 +1,224 @@
+// Throughput of sharded_cluster against a live Redis Cluster, with 1 to max_threads loop threads
+// Usage: hiredis-happ-bench-sharded-cluster <ip> <port> [max threads] [pipeline per thread] [seconds]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "hiredis_happ.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_LIBEVENT)
+#  include "hiredis/adapters/libevent.h"
+
+namespace {
+struct shard_loop_t {
+  event_base *base;
+  struct event *wakeup;
+  hiredis::happ::cluster *shard;
+  hiredis::happ::sharded_cluster *owner;
+  size_t index;
+  uint64_t key_seq;
+  std::atomic<uint64_t> done;
+  std::atomic<uint64_t> failed;
+  std::atomic<bool> ready;
+};
+
+std::vector<shard_loop_t *> g_loops;
+
+void send_one(shard_loop_t *loop);
+
+void on_reply(hiredis::happ::cmd_exec *c, struct redisAsyncContext *, void *, void *privdata) {
+  shard_loop_t *loop = reinterpret_cast<shard_loop_t *>(privdata);
+  if (hiredis::happ::error_code::REDIS_HAPP_OK == c->result()) {
+    loop->done.fetch_add(1, std::memory_order_relaxed);
+  } else {
+    loop->failed.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (loop->owner->is_running()) {
+    send_one(loop);
+  }
+}
+
+// keep keys of a shard on the nodes owned by it
+void send_one(shard_loop_t *loop) {
+  char key[64];
+  int key_len = 0;
+  for (int i = 0; i < 64; ++i) {
+    key_len = snprintf(key, sizeof(key), "bench:sharded:%llu", static_cast<unsigned long long>(++loop->key_seq));
+    if (loop->owner->get_shard_index(key, static_cast<size_t>(key_len)) == loop->index) {
+      break;
+    }
+  }
+
+  loop->shard->exec(key, static_cast<size_t>(key_len), on_reply, loop, "SET %b %llu", key,
+                    static_cast<size_t>(key_len), static_cast<unsigned long long>(loop->key_seq));
+}
+
+void on_connect(hiredis::happ::cluster *clu, hiredis::happ::connection *conn) {
+  for (size_t i = 0; i < g_loops.size(); ++i) {
+    if (g_loops[i]->shard == clu) {
+      redisLibeventAttach(conn->get_context(), g_loops[i]->base);
+      return;
+    }
+  }
+}
+
+void on_wakeup(evutil_socket_t, short, void *arg) {
+  shard_loop_t *loop = reinterpret_cast<shard_loop_t *>(arg);
+  loop->shard->get_submit_queue().on_wakeup();
+
+  if (!loop->owner->is_running()) {
+    event_base_loopbreak(loop->base);
+  }
+}
+
+void on_timer(evutil_socket_t, short, void *arg) {
+  shard_loop_t *loop = reinterpret_cast<shard_loop_t *>(arg);
+  std::chrono::microseconds now =
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch());
+  loop->shard->proc(static_cast<time_t>(now.count() / 1000000), static_cast<time_t>(now.count() % 1000000));
+
+  if (!loop->owner->is_running()) {
+    event_base_loopbreak(loop->base);
+  }
+}
+
+struct shard_loop_fn {
+  size_t pipeline;
+
+  void operator()(size_t index, hiredis::happ::cluster &shard) {
+    shard_loop_t *loop = g_loops[index];
+    loop->shard = &shard;
+
+    // tasks posted by other shards wake up this loop by the eventfd, or are run by proc() in the timer
+    int wakeup_fd = shard.get_submit_queue().enable_eventfd();
+    if (wakeup_fd >= 0) {
+      loop->wakeup = event_new(loop->base, wakeup_fd, EV_READ | EV_PERSIST, on_wakeup, loop);
+      event_add(loop->wakeup, nullptr);
+    }
+
+    struct event *timer = event_new(loop->base, -1, EV_PERSIST, on_timer, loop);
+    struct timeval tv;
+    tv.tv_sec = 0;
+    tv.tv_usec = 10000;
+    evtimer_add(timer, &tv);
+
+    shard.set_on_connect(on_connect);
+    shard.set_timeout(5);
+    shard.start();
+    for (size_t i = 0; i < pipeline; ++i) {
+      send_one(loop);
+    }
+    loop->ready.store(true, std::memory_order_release);
+
+    event_base_dispatch(loop->base);
+
+    event_free(timer);
+  }
+};
+
+void run(const char *ip, uint16_t port, size_t threads, size_t pipeline, int seconds) {
+  hiredis::happ::sharded_cluster clu;
+  clu.init(ip, port, threads);
+
+  g_loops.clear();
+  for (size_t i = 0; i < threads; ++i) {
+    shard_loop_t *loop = new shard_loop_t();
+    loop->base = event_base_new();
+    loop->wakeup = nullptr;
+    loop->shard = clu.get_shard(i);
+    loop->owner = &clu;
+    loop->index = i;
+    loop->key_seq = static_cast<uint64_t>(i) << 40;
+    loop->done.store(0);
+    loop->failed.store(0);
+    loop->ready.store(false);
+    g_loops.push_back(loop);
+  }
+
+  shard_loop_fn fn;
+  fn.pipeline = pipeline;
+  clu.start(fn);
+  for (size_t i = 0; i < threads; ++i) {
+    while (!g_loops[i]->ready.load(std::memory_order_acquire)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  // skip slot loading and connecting
+  std::this_thread::sleep_for(std::chrono::seconds(1));
+  uint64_t begin_done = 0;
+  for (size_t i = 0; i < threads; ++i) {
+    begin_done += g_loops[i]->done.load(std::memory_order_relaxed);
+  }
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+  std::this_thread::sleep_for(std::chrono::seconds(seconds));
+
+  uint64_t end_done = 0;
+  uint64_t failed = 0;
+  for (size_t i = 0; i < threads; ++i) {
+    end_done += g_loops[i]->done.load(std::memory_order_relaxed);
+    failed += g_loops[i]->failed.load(std::memory_order_relaxed);
+  }
+  double cost_sec =
+      std::chrono::duration_cast<std::chrono::duration<double> >(std::chrono::steady_clock::now() - begin).count();
+
+  clu.stop();
+  for (size_t i = 0; i < g_loops.size(); ++i) {
+    if (nullptr != g_loops[i]->wakeup) {
+      event_free(g_loops[i]->wakeup);
+    }
+    event_base_free(g_loops[i]->base);
+    delete g_loops[i];
+  }
+  g_loops.clear();
+
+  double qps = static_cast<double>(end_done - begin_done) / cost_sec;
+  printf("threads: %2zu, pipeline: %zu, topology version: %llu, ops: %llu, failed: %llu, %.0f ops/s, %.0f ops/s/thread\n",
+         threads, pipeline, static_cast<unsigned long long>(clu.get_topology_version()),
+         static_cast<unsigned long long>(end_done - begin_done), static_cast<unsigned long long>(failed), qps,
+         qps / static_cast<double>(threads));
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  if (argc < 3) {
+    printf("usage: %s <ip> <port> [max threads] [pipeline per thread] [seconds]\n", argv[0]);
+    return 0;
+  }
+
+  const char *ip = argv[1];
+  uint16_t port = static_cast<uint16_t>(strtol(argv[2], nullptr, 10));
+  size_t max_threads = argc > 3 ? static_cast<size_t>(strtoull(argv[3], nullptr, 10)) : 16;
+  size_t pipeline = argc > 4 ? static_cast<size_t>(strtoull(argv[4], nullptr, 10)) : 64;
+  int seconds = argc > 5 ? static_cast<int>(strtol(argv[5], nullptr, 10)) : 5;
+  if (0 == max_threads) {
+    max_threads = 1;
+  }
+  if (0 == pipeline) {
+    pipeline = 1;
+  }
+  if (seconds <= 0) {
+    seconds = 1;
+  }
+
+  for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+    run(ip, port, threads, pipeline, seconds);
+  }
+
+  return 0;
+}
+
+#else
+int main() {
+  puts("hiredis-happ-bench-sharded-cluster requires libevent");
+  return 0;
+}
+#endif
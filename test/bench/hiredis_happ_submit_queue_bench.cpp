@@ -0,0 +1,148 @@
+// Compare handing tasks from worker threads to the loop thread by a mutex protected queue and by submit_queue
+// Usage: hiredis-happ-bench-submit-queue [mutex|queue|all] [producers] [tasks per producer]
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#  include <poll.h>
+#endif
+
+#include "hiredis_happ.h"
+
+namespace {
+void report(const char *name, size_t producers, size_t tasks, std::chrono::steady_clock::time_point begin,
+            size_t wakeups) {
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  double cost_sec = std::chrono::duration_cast<std::chrono::duration<double> >(end - begin).count();
+  if (cost_sec <= 0.0) {
+    cost_sec = 1e-9;
+  }
+
+  size_t total = producers * tasks;
+  printf("%-6s producers: %zu, tasks: %zu, cost: %.3fs, %.1f ns/task, %.0f tasks/s, wakeups: %zu\n", name, producers,
+         total, cost_sec, cost_sec * 1000000000.0 / static_cast<double>(total), static_cast<double>(total) / cost_sec,
+         wakeups);
+}
+
+// what worker threads do without submit_queue: a mutex, a deque and a condition variable
+void run_mutex(size_t producers, size_t tasks) {
+  std::mutex lock;
+  std::condition_variable cond;
+  std::deque<std::function<void()> > queue;
+  size_t counter = 0;
+  size_t wakeups = 0;
+
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < producers; ++i) {
+    threads.push_back(std::thread([&lock, &cond, &queue, &counter, tasks]() {
+      for (size_t j = 0; j < tasks; ++j) {
+        bool notify;
+        {
+          std::lock_guard<std::mutex> guard(lock);
+          notify = queue.empty();
+          queue.push_back([&counter]() { ++counter; });
+        }
+        if (notify) {
+          cond.notify_one();
+        }
+      }
+    }));
+  }
+
+  std::deque<std::function<void()> > batch;
+  while (counter < producers * tasks) {
+    {
+      std::unique_lock<std::mutex> guard(lock);
+      if (queue.empty()) {
+        cond.wait_for(guard, std::chrono::milliseconds(1));
+        ++wakeups;
+      }
+      batch.swap(queue);
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+      batch[i]();
+    }
+    batch.clear();
+  }
+
+  report("mutex", producers, tasks, begin, wakeups);
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+}
+
+void run_queue(size_t producers, size_t tasks) {
+  hiredis::happ::submit_queue queue;
+  size_t counter = 0;
+  size_t wakeups = 0;
+  int fd = queue.enable_eventfd();
+
+  std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < producers; ++i) {
+    threads.push_back(std::thread([&queue, &counter, tasks]() {
+      for (size_t j = 0; j < tasks; ++j) {
+        queue.post([&counter]() { ++counter; });
+      }
+    }));
+  }
+
+  while (counter < producers * tasks) {
+#if defined(__linux__)
+    // the event loop watches the eventfd
+    if (fd >= 0 && queue.empty()) {
+      struct pollfd pfd;
+      pfd.fd = fd;
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      poll(&pfd, 1, 1);
+      ++wakeups;
+    }
+#else
+    (void)fd;
+#endif
+    if (0 == queue.on_wakeup()) {
+      std::this_thread::yield();
+    }
+  }
+
+  report("queue", producers, tasks, begin, wakeups);
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+}
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  const char *mode = argc > 1 ? argv[1] : "all";
+  size_t producers = argc > 2 ? static_cast<size_t>(strtoull(argv[2], nullptr, 10)) : 4;
+  size_t tasks = argc > 3 ? static_cast<size_t>(strtoull(argv[3], nullptr, 10)) : 1000000;
+  if (0 == producers) {
+    producers = 1;
+  }
+  if (0 == tasks) {
+    tasks = 1;
+  }
+
+  if (0 == strcmp("mutex", mode) || 0 == strcmp("all", mode)) {
+    run_mutex(producers, tasks);
+  }
+
+  if (0 == strcmp("queue", mode) || 0 == strcmp("all", mode)) {
+    run_queue(producers, tasks);
+  }
+
+  return 0;
+}
@@ -0,0 +1,111 @@
+#include <detail/happ_circuit_breaker.h>
+#include <cstdio>
+#include <cstring>
+
+#include "frame/test_macros.h"
+
+static hiredis::happ::circuit_breaker::config_t happ_circuit_breaker_make_config() {
+  hiredis::happ::circuit_breaker::config_t conf;
+  conf.error_rate_percent = 50;
+  conf.min_requests = 4;
+  conf.window_msec = 1000;
+  conf.open_msec = 500;
+  conf.half_open_probes = 2;
+  return conf;
+}
+
+CASE_TEST(happ_circuit_breaker, open_when_error_rate_is_high) {
+  hiredis::happ::circuit_breaker breaker;
+  hiredis::happ::circuit_breaker::config_t conf = happ_circuit_breaker_make_config();
+
+  // not enough requests
+  CASE_EXPECT_TRUE(breaker.allow(100, conf));
+  breaker.on_failure(100, conf, false);
+  breaker.on_failure(100, conf, false);
+  breaker.on_failure(100, conf, false);
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::CLOSED, breaker.get_state());
+
+  // old window is dropped
+  breaker.on_failure(1100, conf, false);
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::CLOSED, breaker.get_state());
+  CASE_EXPECT_EQ(static_cast<uint32_t>(1), breaker.get_requests());
+
+  breaker.on_success(1200, conf, false);
+  breaker.on_success(1200, conf, false);
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::CLOSED, breaker.get_state());
+  breaker.on_failure(1300, conf, false);
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::OPEN, breaker.get_state());
+
+  CASE_EXPECT_FALSE(breaker.allow(1300, conf));
+  CASE_EXPECT_FALSE(breaker.allow(1799, conf));
+}
+
+CASE_TEST(happ_circuit_breaker, half_open_probes) {
+  hiredis::happ::circuit_breaker breaker;
+  hiredis::happ::circuit_breaker::config_t conf = happ_circuit_breaker_make_config();
+
+  for (int i = 0; i < 4; ++i) {
+    breaker.on_failure(100, conf, false);
+  }
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::OPEN, breaker.get_state());
+
+  // only half_open_probes requests are allowed
+  CASE_EXPECT_TRUE(breaker.allow(600, conf));
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::HALF_OPEN, breaker.get_state());
+  CASE_EXPECT_TRUE(breaker.allow(600, conf));
+  CASE_EXPECT_FALSE(breaker.allow(600, conf));
+
+  // failures of requests sent before the breaker opened are stale
+  breaker.on_failure(605, conf, false);
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::HALF_OPEN, breaker.get_state());
+
+  // any failure of probes opens the breaker again
+  breaker.on_failure(610, conf, true);
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::OPEN, breaker.get_state());
+  CASE_EXPECT_FALSE(breaker.allow(1000, conf));
+
+  bool is_probe = false;
+  CASE_EXPECT_TRUE(breaker.allow(1110, conf, &is_probe));
+  CASE_EXPECT_TRUE(is_probe);
+  CASE_EXPECT_TRUE(breaker.allow(1110, conf));
+
+  // replies of requests sent before the breaker opened are not probes
+  breaker.on_success(1115, conf, false);
+  breaker.on_success(1115, conf, false);
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::HALF_OPEN, breaker.get_state());
+
+  breaker.on_success(1120, conf, true);
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::HALF_OPEN, breaker.get_state());
+  breaker.on_success(1130, conf, true);
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::CLOSED, breaker.get_state());
+  CASE_EXPECT_TRUE(breaker.allow(1130, conf, &is_probe));
+  CASE_EXPECT_FALSE(is_probe);
+}
+
+CASE_TEST(happ_circuit_breaker, lost_probes_and_disable) {
+  hiredis::happ::circuit_breaker breaker;
+  hiredis::happ::circuit_breaker::config_t conf = happ_circuit_breaker_make_config();
+
+  for (int i = 0; i < 4; ++i) {
+    breaker.on_failure(100, conf, false);
+  }
+
+  CASE_EXPECT_TRUE(breaker.allow(600, conf));
+  CASE_EXPECT_TRUE(breaker.allow(600, conf));
+  breaker.on_success(700, conf, true);
+  CASE_EXPECT_FALSE(breaker.allow(1099, conf));
+
+  // the other probe is lost, allow another one after open_msec
+  CASE_EXPECT_TRUE(breaker.allow(1100, conf));
+  CASE_EXPECT_FALSE(breaker.allow(1100, conf));
+  breaker.on_success(1200, conf, true);
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::CLOSED, breaker.get_state());
+
+  // 0 == half_open_probes means disabled
+  conf.half_open_probes = 0;
+  for (int i = 0; i < 8; ++i) {
+    breaker.on_failure(1300, conf, false);
+  }
+  CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::CLOSED, breaker.get_state());
+  CASE_EXPECT_TRUE(breaker.allow(1300, conf));
+}
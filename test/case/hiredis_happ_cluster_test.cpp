@@ -5,6 +5,7 @@
 #include <ctime>
 #include <iostream>
 #include <set>
+#include <string>
 
 #include "frame/test_macros.h"
 #include "hiredis_happ.h"
@@ -18,7 +19,7 @@ struct cluster_unit_test_access {
   static size_t slot_host_count(const cluster &clu, int index) { return clu.slots_[index].hosts.size(); }
 
   static const connection::key_t &slot_host(const cluster &clu, int index, size_t host_index) {
-    return clu.slots_[index].hosts[host_index];
+    return *clu.nodes_.get(clu.slots_[index].hosts[host_index]);
   }
 
   static void on_reply_update_slot(cmd_exec *cmd, redisAsyncContext *ctx, void *reply) {
@@ -75,8 +76,12 @@ CASE_TEST(happ_cluster, connection_callback) {
   clu.set_timeout(57);
   clu.start();
   CASE_EXPECT_EQ(static_cast<size_t>(1), clu.get_timer_actions().timer_conns.size());
-  CASE_EXPECT_TRUE("127.0.0.1:6370" == clu.get_timer_actions().timer_conns.front().name);
-  CASE_EXPECT_EQ(static_cast<time_t>(58), clu.get_timer_actions().timer_conns.front().timeout);
+  const hiredis::happ::connection *conn = clu.get_connection("127.0.0.1:6370");
+  CASE_EXPECT_NE(nullptr, conn);
+  if (nullptr != conn) {
+    CASE_EXPECT_TRUE(hiredis::happ::timer_wheel::is_scheduled(&conn->get_connect_timer()));
+    CASE_EXPECT_EQ(static_cast<uint64_t>(58000), conn->get_connect_timer().expire);
+  }
   CASE_EXPECT_EQ(2, happ_cluster_f);
 
   clu.proc(57, 0);
@@ -215,3 +220,407 @@ CASE_TEST(happ_cluster, slot_reply_unknown_endpoint_skips_slot_host) {
 
   hiredis::happ::cmd_exec::destroy(cmd);
 }
+
+static int happ_cluster_hedge_cbk_count = 0;
+static void on_hedge_cbk(hiredis::happ::cmd_exec *cmd, struct redisAsyncContext *, void *, void *privdata) {
+  CASE_EXPECT_EQ(&happ_cluster_hedge_cbk_count, privdata);
+  CASE_EXPECT_EQ(privdata, cmd->private_data());
+  ++happ_cluster_hedge_cbk_count;
+}
+
+CASE_TEST(happ_cluster, hedged_read_to_replica) {
+  hiredis::happ::cluster clu;
+  clu.init("127.0.0.1", 7000);
+  clu.set_timeout(30);
+  clu.set_hedge_delay(1000, 1000);
+  CASE_EXPECT_EQ(static_cast<time_t>(1000), clu.get_hedge_delay());
+  clu.proc(1, 0);
+
+  hiredis::happ::holder_t h;
+  h.clu = &clu;
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  CASE_EXPECT_NE(nullptr, cmd);
+
+  redisAsyncContext vir_context;
+  memset(&vir_context, 0, sizeof(vir_context));
+  vir_context.c.connection_type = REDIS_CONN_TCP;
+  vir_context.c.tcp.host = const_cast<char *>("127.0.0.1");
+
+  hiredis_happ_test::redis_reply_ptr reply =
+      hiredis_happ_test::adopt_reply(hiredis_happ_test::make_array_reply({hiredis_happ_test::make_array_reply(
+          {hiredis_happ_test::make_integer_reply(0),
+           hiredis_happ_test::make_integer_reply(HIREDIS_HAPP_SLOT_NUMBER - 1),
+           hiredis_happ_test::make_array_reply(
+               {hiredis_happ_test::make_string_reply("127.0.0.1"), hiredis_happ_test::make_integer_reply(7000)}),
+           hiredis_happ_test::make_array_reply(
+               {hiredis_happ_test::make_string_reply("127.0.0.2"), hiredis_happ_test::make_integer_reply(7001)})})}));
+  hiredis::happ::cluster_unit_test_access::on_reply_update_slot(cmd, &vir_context, reply.get());
+  hiredis::happ::cmd_exec::destroy(cmd);
+  CASE_EXPECT_TRUE(hiredis::happ::cluster_unit_test_access::is_slot_ok(clu));
+
+  happ_cluster_hedge_cbk_count = 0;
+  CASE_EXPECT_NE(nullptr, clu.exec_hedged("a", 1, on_hedge_cbk, &happ_cluster_hedge_cbk_count, "GET %s", "a"));
+  CASE_EXPECT_EQ(static_cast<uint64_t>(1), clu.get_hedge_stats().requests);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), clu.get_timer_actions().timer_hedges.size());
+  CASE_EXPECT_NE(nullptr, clu.get_connection("127.0.0.1:7000"));
+  CASE_EXPECT_EQ(nullptr, clu.get_connection("127.0.0.2:7001"));
+
+  // hedge is sent to replica after delay
+  clu.proc(1, 1000);
+  CASE_EXPECT_EQ(static_cast<uint64_t>(1), clu.get_hedge_stats().hedge_sent);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), clu.get_timer_actions().timer_hedges.size());
+  CASE_EXPECT_NE(nullptr, clu.get_connection("127.0.0.2:7001"));
+  CASE_EXPECT_EQ(0, happ_cluster_hedge_cbk_count);
+
+  // callable callbacks can not be copied into a hedge cmd, so it's sent without hedging
+  int callable_count = 0;
+  hiredis::happ::cmd_exec *callable_cmd = hiredis::happ::cmd_exec::create_callable(
+      nullptr, h, [&callable_count](hiredis::happ::cmd_exec *, redisAsyncContext *, void *) { ++callable_count; });
+  CASE_EXPECT_NE(nullptr, callable_cmd);
+  CASE_EXPECT_LT(0, callable_cmd->format("GET %s", "a"));
+  CASE_EXPECT_EQ(callable_cmd, clu.exec_hedged("a", 1, callable_cmd));
+  CASE_EXPECT_EQ(static_cast<uint64_t>(1), clu.get_hedge_stats().requests);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), clu.get_timer_actions().timer_hedges.size());
+
+  // both connections timeout, callback is called only once
+  clu.proc(31, 0);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), clu.get_connection_size());
+  CASE_EXPECT_EQ(1, happ_cluster_hedge_cbk_count);
+  CASE_EXPECT_EQ(1, callable_count);
+  CASE_EXPECT_EQ(static_cast<uint64_t>(0), clu.get_hedge_stats().primary_wins);
+  CASE_EXPECT_EQ(static_cast<uint64_t>(0), clu.get_hedge_stats().hedge_wins);
+  CASE_EXPECT_EQ(static_cast<uint64_t>(0), clu.get_hedge_stats().discarded);
+
+  clu.reset();
+}
+
+static int happ_cluster_breaker_last_error = 0;
+static int happ_cluster_breaker_cbk_count = 0;
+static void on_breaker_cbk(hiredis::happ::cmd_exec *cmd, struct redisAsyncContext *, void *, void *) {
+  happ_cluster_breaker_last_error = cmd->result();
+  ++happ_cluster_breaker_cbk_count;
+}
+
+CASE_TEST(happ_cluster, circuit_breaker_fail_fast) {
+  hiredis::happ::cluster clu;
+  clu.init("127.0.0.1", 7000);
+  clu.set_timeout(30);
+
+  hiredis::happ::circuit_breaker::config_t breaker_conf = clu.get_circuit_breaker_config();
+  breaker_conf.min_requests = 1;
+  breaker_conf.open_msec = 5000;
+  breaker_conf.half_open_probes = 1;
+  clu.set_circuit_breaker(breaker_conf);
+  clu.proc(1, 0);
+
+  hiredis::happ::holder_t h;
+  h.clu = &clu;
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  CASE_EXPECT_NE(nullptr, cmd);
+
+  redisAsyncContext vir_context;
+  memset(&vir_context, 0, sizeof(vir_context));
+  vir_context.c.connection_type = REDIS_CONN_TCP;
+  vir_context.c.tcp.host = const_cast<char *>("127.0.0.1");
+
+  hiredis_happ_test::redis_reply_ptr reply =
+      hiredis_happ_test::adopt_reply(hiredis_happ_test::make_array_reply({hiredis_happ_test::make_array_reply(
+          {hiredis_happ_test::make_integer_reply(0),
+           hiredis_happ_test::make_integer_reply(HIREDIS_HAPP_SLOT_NUMBER - 1),
+           hiredis_happ_test::make_array_reply(
+               {hiredis_happ_test::make_string_reply("127.0.0.1"), hiredis_happ_test::make_integer_reply(7000)})})}));
+  hiredis::happ::cluster_unit_test_access::on_reply_update_slot(cmd, &vir_context, reply.get());
+  hiredis::happ::cmd_exec::destroy(cmd);
+
+  happ_cluster_breaker_cbk_count = 0;
+  CASE_EXPECT_NE(nullptr, clu.exec("a", 1, on_breaker_cbk, nullptr, "GET %s", "a"));
+  CASE_EXPECT_EQ(0, happ_cluster_breaker_cbk_count);
+
+  // connect timeout opens the breaker
+  clu.proc(31, 0);
+  CASE_EXPECT_EQ(1, happ_cluster_breaker_cbk_count);
+  const hiredis::happ::circuit_breaker *breaker = clu.get_circuit_breaker("127.0.0.1:7000");
+  CASE_EXPECT_NE(nullptr, breaker);
+  if (nullptr != breaker) {
+    CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::OPEN, breaker->get_state());
+  }
+
+  // fail fast without retry
+  CASE_EXPECT_EQ(nullptr, clu.exec("a", 1, on_breaker_cbk, nullptr, "GET %s", "a"));
+  CASE_EXPECT_EQ(2, happ_cluster_breaker_cbk_count);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_CIRCUIT_OPEN, happ_cluster_breaker_last_error);
+
+  // half open, only one probe is allowed
+  clu.proc(36, 0);
+  CASE_EXPECT_NE(nullptr, clu.exec("a", 1, on_breaker_cbk, nullptr, "GET %s", "a"));
+  CASE_EXPECT_EQ(2, happ_cluster_breaker_cbk_count);
+  CASE_EXPECT_EQ(nullptr, clu.exec("a", 1, on_breaker_cbk, nullptr, "GET %s", "a"));
+  CASE_EXPECT_EQ(3, happ_cluster_breaker_cbk_count);
+  if (nullptr != breaker) {
+    CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::HALF_OPEN, breaker->get_state());
+  }
+
+  clu.proc(66, 0);
+  clu.reset();
+}
+
+struct happ_cluster_broadcast_state {
+  int count;
+  size_t max_ref_count;
+  std::set<std::string> payloads;
+};
+
+static void on_broadcast_cbk(hiredis::happ::cmd_exec *cmd, struct redisAsyncContext *, void *, void *privdata) {
+  happ_cluster_broadcast_state *state = reinterpret_cast<happ_cluster_broadcast_state *>(privdata);
+  ++state->count;
+  if (cmd->get_content_ref_count() > state->max_ref_count) {
+    state->max_ref_count = cmd->get_content_ref_count();
+  }
+
+  hiredis::happ::cmd_content content = cmd->get_cmd_raw_content();
+  state->payloads.insert(std::string(content.content.raw, content.raw_len));
+}
+
+CASE_TEST(happ_cluster, broadcast_shares_content) {
+  hiredis::happ::cluster clu;
+  clu.init("127.0.0.1", 7000);
+  clu.set_timeout(30);
+  clu.proc(1, 0);
+
+  // slots are not available
+  happ_cluster_broadcast_state state;
+  state.count = 0;
+  state.max_ref_count = 0;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_SLOT_UNAVAILABLE,
+                 clu.exec_broadcast(on_broadcast_cbk, &state, "PING"));
+  CASE_EXPECT_EQ(1, state.count);
+
+  hiredis::happ::holder_t h;
+  h.clu = &clu;
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  CASE_EXPECT_NE(nullptr, cmd);
+
+  redisAsyncContext vir_context;
+  memset(&vir_context, 0, sizeof(vir_context));
+  vir_context.c.connection_type = REDIS_CONN_TCP;
+  vir_context.c.tcp.host = const_cast<char *>("127.0.0.1");
+
+  hiredis_happ_test::redis_reply_ptr reply = hiredis_happ_test::adopt_reply(hiredis_happ_test::make_array_reply(
+      {hiredis_happ_test::make_array_reply(
+           {hiredis_happ_test::make_integer_reply(0), hiredis_happ_test::make_integer_reply(5460),
+            hiredis_happ_test::make_array_reply(
+                {hiredis_happ_test::make_string_reply("127.0.0.1"), hiredis_happ_test::make_integer_reply(7000)})}),
+       hiredis_happ_test::make_array_reply(
+           {hiredis_happ_test::make_integer_reply(5461), hiredis_happ_test::make_integer_reply(10922),
+            hiredis_happ_test::make_array_reply(
+                {hiredis_happ_test::make_string_reply("127.0.0.2"), hiredis_happ_test::make_integer_reply(7001)})}),
+       hiredis_happ_test::make_array_reply(
+           {hiredis_happ_test::make_integer_reply(10923),
+            hiredis_happ_test::make_integer_reply(HIREDIS_HAPP_SLOT_NUMBER - 1),
+            hiredis_happ_test::make_array_reply(
+                {hiredis_happ_test::make_string_reply("127.0.0.1"), hiredis_happ_test::make_integer_reply(7000)})})}));
+  hiredis::happ::cluster_unit_test_access::on_reply_update_slot(cmd, &vir_context, reply.get());
+  hiredis::happ::cmd_exec::destroy(cmd);
+  CASE_EXPECT_TRUE(hiredis::happ::cluster_unit_test_access::is_slot_ok(clu));
+
+  // one cmd for every master, all of them share the same content
+  state.count = 0;
+  state.payloads.clear();
+  std::string script(hiredis::happ::cmd_exec::get_inline_capacity() + 1, 's');
+  const char *argv[] = {"SCRIPT", "LOAD", script.c_str()};
+  CASE_EXPECT_EQ(2, clu.exec_broadcast(on_broadcast_cbk, &state, 3, argv, nullptr));
+  CASE_EXPECT_NE(nullptr, clu.get_connection("127.0.0.1:7000"));
+  CASE_EXPECT_NE(nullptr, clu.get_connection("127.0.0.2:7001"));
+  CASE_EXPECT_EQ(0, state.count);
+
+  // connect timeout
+  clu.proc(31, 0);
+  CASE_EXPECT_EQ(2, state.count);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), state.max_ref_count);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), state.payloads.size());
+  if (1 == state.payloads.size()) {
+    CASE_EXPECT_EQ(0, state.payloads.begin()->compare(0, 27, "*3\r\n$6\r\nSCRIPT\r\n$4\r\nLOAD\r\n$"));
+  }
+
+  clu.reset();
+}
+
+CASE_TEST(happ_cluster, node_ids_are_stable) {
+  hiredis::happ::cluster clu;
+  clu.init("127.0.0.1", 7000);
+  clu.set_timeout(30);
+  clu.proc(1, 0);
+
+  // the init node is interned first
+  const hiredis::happ::node_registry &nodes = clu.get_node_registry();
+  CASE_EXPECT_EQ(static_cast<size_t>(1), nodes.size());
+  hiredis::happ::connection::node_id_t init_id = nodes.find("127.0.0.1:7000");
+  CASE_EXPECT_NE(static_cast<hiredis::happ::connection::node_id_t>(0), init_id);
+
+  hiredis::happ::holder_t h;
+  h.clu = &clu;
+  redisAsyncContext vir_context;
+  memset(&vir_context, 0, sizeof(vir_context));
+  vir_context.c.connection_type = REDIS_CONN_TCP;
+  vir_context.c.tcp.host = const_cast<char *>("127.0.0.1");
+
+  for (int i = 0; i < 2; ++i) {
+    // the order of masters changes in the second reply
+    const char *first_ip = 0 == i ? "127.0.0.1" : "127.0.0.2";
+    const char *second_ip = 0 == i ? "127.0.0.2" : "127.0.0.1";
+    hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+    CASE_EXPECT_NE(nullptr, cmd);
+
+    hiredis_happ_test::redis_reply_ptr reply = hiredis_happ_test::adopt_reply(hiredis_happ_test::make_array_reply(
+        {hiredis_happ_test::make_array_reply(
+             {hiredis_happ_test::make_integer_reply(0), hiredis_happ_test::make_integer_reply(8191),
+              hiredis_happ_test::make_array_reply({hiredis_happ_test::make_string_reply(first_ip),
+                                                   hiredis_happ_test::make_integer_reply(7000)})}),
+         hiredis_happ_test::make_array_reply(
+             {hiredis_happ_test::make_integer_reply(8192),
+              hiredis_happ_test::make_integer_reply(HIREDIS_HAPP_SLOT_NUMBER - 1),
+              hiredis_happ_test::make_array_reply({hiredis_happ_test::make_string_reply(second_ip),
+                                                   hiredis_happ_test::make_integer_reply(7000)})})}));
+    hiredis::happ::cluster_unit_test_access::on_reply_update_slot(cmd, &vir_context, reply.get());
+    hiredis::happ::cmd_exec::destroy(cmd);
+    CASE_EXPECT_TRUE(hiredis::happ::cluster_unit_test_access::is_slot_ok(clu));
+
+    // slots store ids, and every node is interned once
+    CASE_EXPECT_EQ(static_cast<size_t>(2), nodes.size());
+    CASE_EXPECT_EQ(init_id, hiredis::happ::cluster_unit_test_access::slot_host(clu, 0 == i ? 0 : 8192, 0).id);
+    hiredis::happ::connection::node_id_t other_id = nodes.find("127.0.0.2", 7000);
+    CASE_EXPECT_NE(init_id, other_id);
+    CASE_EXPECT_EQ(other_id, hiredis::happ::cluster_unit_test_access::slot_host(clu, 0 == i ? 8192 : 0, 0).id);
+    CASE_EXPECT_EQ(other_id, clu.get_slot_master(0 == i ? HIREDIS_HAPP_SLOT_NUMBER - 1 : 0)->id);
+    CASE_EXPECT_TRUE("127.0.0.2:7000" == nodes.get(other_id)->name);
+  }
+
+  // connections and public accessors by name use the same ids
+  CASE_EXPECT_EQ(2, clu.exec_broadcast(nullptr, nullptr, "PING"));
+  CASE_EXPECT_NE(nullptr, clu.get_connection("127.0.0.2:7000"));
+  if (nullptr != clu.get_connection("127.0.0.2:7000")) {
+    CASE_EXPECT_EQ(nodes.find("127.0.0.2:7000"), clu.get_connection("127.0.0.2:7000")->get_key().id);
+  }
+  CASE_EXPECT_EQ(clu.get_connection("127.0.0.1:7000"), clu.get_connection("127.0.0.1", 7000));
+  CASE_EXPECT_EQ(nullptr, clu.get_connection("127.0.0.3:7000"));
+
+  // ids are kept after reset
+  clu.proc(31, 0);
+  clu.reset();
+  CASE_EXPECT_EQ(static_cast<size_t>(2), nodes.size());
+  CASE_EXPECT_EQ(init_id, nodes.find("127.0.0.1:7000"));
+}
+
+CASE_TEST(happ_cluster, slot_ranges) {
+  hiredis::happ::cluster clu;
+  clu.init("127.0.0.1", 7000);
+
+  int updated_count = 0;
+  clu.set_on_slots_updated([&updated_count](hiredis::happ::cluster *) { ++updated_count; });
+
+  hiredis::happ::holder_t h;
+  h.clu = &clu;
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  CASE_EXPECT_NE(nullptr, cmd);
+
+  redisAsyncContext vir_context;
+  memset(&vir_context, 0, sizeof(vir_context));
+  vir_context.c.connection_type = REDIS_CONN_TCP;
+  vir_context.c.tcp.host = const_cast<char *>("127.0.0.1");
+
+  hiredis_happ_test::redis_reply_ptr reply = hiredis_happ_test::adopt_reply(hiredis_happ_test::make_array_reply(
+      {hiredis_happ_test::make_array_reply(
+           {hiredis_happ_test::make_integer_reply(0), hiredis_happ_test::make_integer_reply(99),
+            hiredis_happ_test::make_array_reply(
+                {hiredis_happ_test::make_string_reply("127.0.0.1"), hiredis_happ_test::make_integer_reply(7000)}),
+            hiredis_happ_test::make_array_reply(
+                {hiredis_happ_test::make_string_reply("127.0.0.1"), hiredis_happ_test::make_integer_reply(7003)})}),
+       hiredis_happ_test::make_array_reply(
+           {hiredis_happ_test::make_integer_reply(100), hiredis_happ_test::make_integer_reply(199),
+            hiredis_happ_test::make_array_reply(
+                {hiredis_happ_test::make_string_reply("127.0.0.1"), hiredis_happ_test::make_integer_reply(7000)}),
+            hiredis_happ_test::make_array_reply(
+                {hiredis_happ_test::make_string_reply("127.0.0.1"), hiredis_happ_test::make_integer_reply(7003)})}),
+       hiredis_happ_test::make_array_reply(
+           {hiredis_happ_test::make_integer_reply(300),
+            hiredis_happ_test::make_integer_reply(HIREDIS_HAPP_SLOT_NUMBER - 1),
+            hiredis_happ_test::make_array_reply(
+                {hiredis_happ_test::make_string_reply("127.0.0.2"), hiredis_happ_test::make_integer_reply(7001)})})}));
+  hiredis::happ::cluster_unit_test_access::on_reply_update_slot(cmd, &vir_context, reply.get());
+  hiredis::happ::cmd_exec::destroy(cmd);
+  CASE_EXPECT_EQ(1, updated_count);
+
+  // continuous slots of the same hosts are merged, and slots without hosts are skipped
+  std::vector<hiredis::happ::cluster::slot_range_t> ranges;
+  CASE_EXPECT_EQ(static_cast<size_t>(2), clu.get_slot_ranges(ranges));
+  CASE_EXPECT_EQ(static_cast<size_t>(2), ranges.size());
+  if (2 == ranges.size()) {
+    CASE_EXPECT_EQ(0, ranges[0].start);
+    CASE_EXPECT_EQ(199, ranges[0].end);
+    CASE_EXPECT_EQ(static_cast<size_t>(2), ranges[0].hosts.size());
+    CASE_EXPECT_TRUE("127.0.0.1:7000" == ranges[0].hosts[0].name);
+    CASE_EXPECT_TRUE("127.0.0.1:7003" == ranges[0].hosts[1].name);
+    CASE_EXPECT_EQ(300, ranges[1].start);
+    CASE_EXPECT_EQ(HIREDIS_HAPP_SLOT_NUMBER - 1, ranges[1].end);
+    CASE_EXPECT_TRUE("127.0.0.2:7001" == ranges[1].hosts[0].name);
+  }
+
+  // public slot info has addresses of hosts
+  const hiredis::happ::cluster::slot_t *slot_a = clu.get_slot_by_key("a", 1);
+  CASE_EXPECT_NE(nullptr, slot_a);
+  if (nullptr != slot_a) {
+    CASE_EXPECT_EQ(hiredis::happ::hash_slot("a", 1), slot_a->index);
+    CASE_EXPECT_EQ(static_cast<size_t>(1), slot_a->hosts.size());
+    if (!slot_a->hosts.empty()) {
+      CASE_EXPECT_TRUE("127.0.0.2:7001" == slot_a->hosts[0].name);
+      CASE_EXPECT_EQ(7001, slot_a->hosts[0].port);
+    }
+  }
+
+  // apply ranges to another cluster, which has its own node ids
+  hiredis::happ::cluster other;
+  other.init("127.0.0.3", 7002);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM,
+                 other.update_slots(std::vector<hiredis::happ::cluster::slot_range_t>()));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, other.update_slots(ranges));
+  CASE_EXPECT_TRUE(hiredis::happ::cluster_unit_test_access::is_slot_ok(other));
+  CASE_EXPECT_EQ(1, updated_count);
+  CASE_EXPECT_TRUE("127.0.0.1:7000" == other.get_slot_master(150)->name);
+  CASE_EXPECT_TRUE("127.0.0.2:7001" == other.get_slot_master(300)->name);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), hiredis::happ::cluster_unit_test_access::slot_host_count(other, 250));
+  CASE_EXPECT_EQ(other.get_node_registry().find("127.0.0.1:7003"),
+                 hiredis::happ::cluster_unit_test_access::slot_host(other, 0, 1).id);
+
+  std::vector<hiredis::happ::cluster::slot_range_t> other_ranges;
+  other.get_slot_ranges(other_ranges);
+  CASE_EXPECT_EQ(ranges.size(), other_ranges.size());
+}
+
+CASE_TEST(happ_cluster, parse_redirect) {
+  int slot_index = 0;
+  std::string ip;
+  uint16_t port = 0;
+
+  CASE_EXPECT_TRUE(hiredis::happ::cluster::parse_redirect("3999 127.0.0.1:6381", slot_index, ip, port));
+  CASE_EXPECT_EQ(3999, slot_index);
+  CASE_EXPECT_TRUE("127.0.0.1" == ip);
+  CASE_EXPECT_EQ(static_cast<uint16_t>(6381), port);
+
+  // the ip may be empty, and the caller uses the ip of the connection
+  CASE_EXPECT_TRUE(hiredis::happ::cluster::parse_redirect("12 :7000", slot_index, ip, port));
+  CASE_EXPECT_EQ(12, slot_index);
+  CASE_EXPECT_TRUE(ip.empty());
+  CASE_EXPECT_EQ(static_cast<uint16_t>(7000), port);
+
+  CASE_EXPECT_FALSE(hiredis::happ::cluster::parse_redirect("12", slot_index, ip, port));
+  CASE_EXPECT_FALSE(hiredis::happ::cluster::parse_redirect(nullptr, slot_index, ip, port));
+  CASE_EXPECT_FALSE(hiredis::happ::cluster::parse_redirect("abc 127.0.0.1:6381", slot_index, ip, port));
+
+  // long address is not truncated or overflowed
+  std::string long_host(1000, 'h');
+  std::string long_msg = "100 " + long_host + ":6379";
+  CASE_EXPECT_TRUE(hiredis::happ::cluster::parse_redirect(long_msg.c_str(), slot_index, ip, port));
+  CASE_EXPECT_EQ(100, slot_index);
+  CASE_EXPECT_TRUE(long_host == ip);
+  CASE_EXPECT_EQ(static_cast<uint16_t>(6379), port);
+}
@@ -0,0 +1,110 @@
+#include <detail/happ_cmd.h>
+#include <detail/happ_cmd_pool.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+CASE_TEST(happ_cmd_pool, recycle_and_size_class) {
+  hiredis::happ::cmd_pool *pool = hiredis::happ::cmd_pool::create();
+  CASE_EXPECT_NE(nullptr, pool);
+
+  void *a = pool->allocate(100);
+  void *b = pool->allocate(100);
+  CASE_EXPECT_NE(nullptr, a);
+  CASE_EXPECT_NE(nullptr, b);
+  CASE_EXPECT_NE(a, b);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), reinterpret_cast<size_t>(a) % alignof(std::max_align_t));
+  CASE_EXPECT_EQ(static_cast<size_t>(1), pool->get_stats().slab_count);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), pool->get_stats().block_in_use);
+  memset(a, 0x5a, 100);
+  memset(b, 0xa5, 100);
+
+  // freed block is reused by the same size class
+  pool->deallocate(a);
+  void *c = pool->allocate(90);
+  CASE_EXPECT_EQ(a, c);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), pool->get_stats().slab_count);
+
+  // another size class use another slab
+  void *d = pool->allocate(1000);
+  CASE_EXPECT_NE(nullptr, d);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), pool->get_stats().slab_count);
+
+  // too large for slab
+  void *e = pool->allocate(1024 * 1024);
+  CASE_EXPECT_NE(nullptr, e);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), pool->get_stats().malloc_in_use);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), pool->get_stats().slab_count);
+
+  pool->deallocate(b);
+  pool->deallocate(c);
+  pool->deallocate(d);
+  pool->deallocate(e);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), pool->get_stats().block_in_use);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), pool->get_stats().malloc_in_use);
+  CASE_EXPECT_EQ(pool->get_stats().slab_bytes, pool->get_stats().idle_slab_bytes);
+
+  CASE_EXPECT_LT(static_cast<size_t>(0), pool->trim());
+  CASE_EXPECT_EQ(static_cast<size_t>(0), pool->get_stats().slab_count);
+  hiredis::happ::cmd_pool::release(pool);
+}
+
+CASE_TEST(happ_cmd_pool, high_water_trim) {
+  hiredis::happ::cmd_pool *pool = hiredis::happ::cmd_pool::create();
+  pool->set_idle_high_water(0);
+
+  std::vector<void *> blocks;
+  for (int i = 0; i < 4096; ++i) {
+    blocks.push_back(pool->allocate(200));
+  }
+  size_t max_slab_count = pool->get_stats().slab_count;
+  CASE_EXPECT_LT(static_cast<size_t>(1), max_slab_count);
+
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    pool->deallocate(blocks[i]);
+  }
+
+  // all fully free slabs are released
+  CASE_EXPECT_EQ(static_cast<size_t>(0), pool->get_stats().slab_count);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), pool->get_stats().idle_slab_bytes);
+
+  // idle slabs under high water are kept
+  pool->set_idle_high_water(static_cast<size_t>(1) << 30);
+  blocks.clear();
+  for (int i = 0; i < 4096; ++i) {
+    blocks.push_back(pool->allocate(200));
+  }
+  for (size_t i = 0; i < blocks.size(); ++i) {
+    pool->deallocate(blocks[i]);
+  }
+  CASE_EXPECT_EQ(max_slab_count, pool->get_stats().slab_count);
+
+  pool->set_idle_high_water(0);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), pool->get_stats().slab_count);
+  hiredis::happ::cmd_pool::release(pool);
+}
+
+CASE_TEST(happ_cmd_pool, release_with_cmds_in_use) {
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+
+  hiredis::happ::cmd_pool *pool = hiredis::happ::cmd_pool::create();
+  hiredis::happ::cmd_exec *cmd1 = hiredis::happ::cmd_exec::create(pool, h, nullptr, nullptr, sizeof(int));
+  hiredis::happ::cmd_exec *cmd2 = hiredis::happ::cmd_exec::create(pool, h, nullptr, nullptr, 0);
+  CASE_EXPECT_NE(nullptr, cmd1);
+  CASE_EXPECT_NE(nullptr, cmd2);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), pool->get_stats().block_in_use);
+  CASE_EXPECT_LT(0, cmd1->format("GET %s", "HERO"));
+
+  // pool is destroyed after the last cmd is destroyed
+  hiredis::happ::cmd_pool::release(pool);
+  hiredis::happ::cmd_exec::destroy(cmd1);
+  hiredis::happ::cmd_exec::destroy(cmd2);
+
+  hiredis::happ::cluster clu;
+  CASE_EXPECT_NE(nullptr, clu.get_cmd_pool());
+  CASE_EXPECT_EQ(static_cast<size_t>(0), clu.get_cmd_pool()->get_stats().block_in_use);
+}
@@ -1,10 +1,14 @@
 #include <detail/happ_cmd.h>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <ctime>
 #include <iostream>
+#include <memory>
 #include <set>
 #include <sstream>
+#include <string>
+#include <string_view>
 
 
 #include "frame/test_macros.h"
@@ -38,6 +42,7 @@ CASE_TEST(happ_cmd, basic) {
 
   int len = cmd->format("GET %s", "HERO");
   CASE_EXPECT_EQ(static_cast<size_t>(len), cmd->get_cmd_raw_content().raw_len);
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::INLINE, cmd->get_cmd_raw_content().kind);
 
   std::string cmd_content_1, cmd_content_2;
   cmd_content_1.assign(cmd->get_cmd_raw_content().content.raw, cmd->get_cmd_raw_content().raw_len);
@@ -45,11 +50,12 @@ CASE_TEST(happ_cmd, basic) {
   const char *argv[] = {"GET", "HERO"};
   size_t argvlen[] = {strlen(argv[0]), strlen(argv[1])};
   len = cmd->vformat(2, argv, argvlen);
-  CASE_EXPECT_EQ(static_cast<size_t>(0), cmd->get_cmd_raw_content().raw_len);
+  CASE_EXPECT_EQ(static_cast<size_t>(len), cmd->get_cmd_raw_content().raw_len);
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::INLINE, cmd->get_cmd_raw_content().kind);
 
-  cmd_content_2.assign(cmd->get_cmd_raw_content().content.redis_sds, static_cast<size_t>(len));
-  CASE_EXPECT_EQ(static_cast<size_t>(len), sdslen(cmd->get_cmd_raw_content().content.redis_sds));
+  cmd_content_2.assign(cmd->get_cmd_raw_content().content.raw, static_cast<size_t>(len));
   CASE_EXPECT_EQ(cmd_content_1, cmd_content_2);
+  CASE_EXPECT_EQ(131313131, *reinterpret_cast<int *>(cmd->buffer()));
 
   int res = cmd->call_reply(hiredis::happ::error_code::REDIS_HAPP_TTL, &vir_ontext, &vir_ontext);
   CASE_EXPECT_EQ(res, hiredis::happ::error_code::REDIS_HAPP_OK);
@@ -116,3 +122,335 @@ CASE_TEST(happ_cmd, pick_argument_vformat_and_dump) {
 
   hiredis::happ::cmd_exec::destroy(cmd);
 }
+
+static std::string happ_cmd_hiredis_format(const char *fmt, ...) {
+  char *out = nullptr;
+  va_list ap;
+  va_start(ap, fmt);
+  int len = redisvFormatCommand(&out, fmt, ap);
+  va_end(ap);
+
+  std::string ret;
+  if (len > 0 && nullptr != out) {
+    ret.assign(out, static_cast<size_t>(len));
+  }
+  redisFreeCommand(out);
+  return ret;
+}
+
+static std::string happ_cmd_content(const hiredis::happ::cmd_exec *cmd) {
+  hiredis::happ::cmd_content content = cmd->get_cmd_raw_content();
+  if (hiredis::happ::cmd_content::storage::SDS == content.kind) {
+    return std::string(content.content.redis_sds, sdslen(content.content.redis_sds));
+  }
+  return std::string(content.content.raw, content.raw_len);
+}
+
+CASE_TEST(happ_cmd, inline_and_heap_storage) {
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, sizeof(int));
+  CASE_EXPECT_NE(nullptr, cmd);
+  CASE_EXPECT_LE(static_cast<size_t>(HIREDIS_HAPP_CMD_INLINE_SIZE), hiredis::happ::cmd_exec::get_inline_capacity());
+  *reinterpret_cast<int *>(cmd->buffer()) = 424242;
+
+  // fast formatter must produce the same bytes as hiredis
+  const char binary[] = {'a', '\0', 'b'};
+  CASE_EXPECT_LT(0, cmd->format("HSET  %s%%x f%sg %b ", "key", "", binary, sizeof(binary)));
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::INLINE, cmd->get_cmd_raw_content().kind);
+  CASE_EXPECT_TRUE(happ_cmd_hiredis_format("HSET  %s%%x f%sg %b ", "key", "", binary, sizeof(binary)) ==
+                   happ_cmd_content(cmd));
+
+  const char *str = nullptr;
+  size_t str_len = 0;
+  CASE_EXPECT_NE(nullptr, cmd->pick_cmd(&str, &str_len));
+  CASE_EXPECT_TRUE(std::string("HSET") == std::string(str, str_len));
+
+  // other conversions use hiredis
+  CASE_EXPECT_LT(0, cmd->format("EXPIRE %s %d", "key", 60));
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::HEAP, cmd->get_cmd_raw_content().kind);
+  CASE_EXPECT_TRUE(happ_cmd_hiredis_format("EXPIRE %s %d", "key", 60) == happ_cmd_content(cmd));
+
+  // large commands use heap
+  std::string large_value(hiredis::happ::cmd_exec::get_inline_capacity(), 'v');
+  CASE_EXPECT_LT(0, cmd->format("SET %s %s", "key", large_value.c_str()));
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::HEAP, cmd->get_cmd_raw_content().kind);
+  CASE_EXPECT_TRUE(happ_cmd_hiredis_format("SET %s %s", "key", large_value.c_str()) == happ_cmd_content(cmd));
+
+  const char *argv[] = {"SET", "key", large_value.c_str()};
+  CASE_EXPECT_LT(0, cmd->vformat(3, argv, nullptr));
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::SDS, cmd->get_cmd_raw_content().kind);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), cmd->get_cmd_raw_content().raw_len);
+  CASE_EXPECT_TRUE(happ_cmd_hiredis_format("SET %s %s", "key", large_value.c_str()) == happ_cmd_content(cmd));
+
+  // copy small sds into inline buffer
+  sds src = sdsnew("*1\r\n$4\r\nPING\r\n");
+  CASE_EXPECT_EQ(static_cast<int>(sdslen(src)), cmd->vformat(&src));
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::INLINE, cmd->get_cmd_raw_content().kind);
+  CASE_EXPECT_TRUE(std::string(src, sdslen(src)) == happ_cmd_content(cmd));
+  sdsfree(src);
+
+  CASE_EXPECT_EQ(424242, *reinterpret_cast<int *>(cmd->buffer()));
+  hiredis::happ::cmd_exec::destroy(cmd);
+}
+
+static void happ_cmd_count_release(void *data) { ++(*reinterpret_cast<int *>(data)); }
+
+CASE_TEST(happ_cmd, reference_large_argument) {
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  CASE_EXPECT_NE(nullptr, cmd);
+
+  std::string large_value(HIREDIS_HAPP_CMD_REFERENCE_SIZE + 3, 'v');
+  const char *argv[] = {"SET", "key", large_value.c_str(), "EX", large_value.c_str()};
+  size_t argvlen[] = {3, 3, large_value.size(), 2, large_value.size()};
+  int release_count = 0;
+
+  int64_t len = cmd->vformat_reference(5, argv, argvlen, happ_cmd_count_release, &release_count);
+  hiredis::happ::cmd_content content = cmd->get_cmd_raw_content();
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::SCATTER, content.kind);
+  CASE_EXPECT_EQ(0, release_count);
+
+  // large arguments are referenced, and all segments make the same command as hiredis
+  const char *argv_copy[] = {"SET", "key", large_value.c_str(), "EX", large_value.c_str()};
+  std::string expect = happ_cmd_hiredis_format("%s %s %b %s %b", argv_copy[0], argv_copy[1], argv_copy[2],
+                                               large_value.size(), argv_copy[3], argv_copy[4], large_value.size());
+  CASE_EXPECT_EQ(static_cast<int64_t>(expect.size()), len);
+  CASE_EXPECT_EQ(expect.size(), content.content.scatter->total_len);
+
+  std::string joined;
+  size_t referenced = 0;
+  for (size_t i = 0; i < content.content.scatter->segment_count; ++i) {
+    if (content.content.scatter->segments[i].data == large_value.c_str()) {
+      ++referenced;
+    }
+    joined.append(content.content.scatter->segments[i].data, content.content.scatter->segments[i].len);
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(2), referenced);
+  CASE_EXPECT_TRUE(expect == joined);
+
+  const char *str = nullptr;
+  size_t str_len = 0;
+  CASE_EXPECT_NE(nullptr, cmd->pick_cmd(&str, &str_len));
+  CASE_EXPECT_TRUE(std::string("SET") == std::string(str, str_len));
+
+  // format again release the old arguments, small arguments are copied and released immediately
+  const char *small_argv[] = {"GET", "key"};
+  size_t small_argvlen[] = {3, 3};
+  CASE_EXPECT_LT(0, cmd->vformat_reference(2, small_argv, small_argvlen, happ_cmd_count_release, &release_count));
+  CASE_EXPECT_EQ(2, release_count);
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::INLINE, cmd->get_cmd_raw_content().kind);
+
+  CASE_EXPECT_LT(0, cmd->vformat_reference(5, argv, argvlen, happ_cmd_count_release, &release_count));
+  CASE_EXPECT_EQ(2, release_count);
+  hiredis::happ::cmd_exec::destroy(cmd);
+  CASE_EXPECT_EQ(3, release_count);
+}
+
+CASE_TEST(happ_cmd, reference_pubsub_copied) {
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  CASE_EXPECT_NE(nullptr, cmd);
+
+  // hiredis only sees segments[0] of a scatter command, so channels of pub/sub commands are never referenced
+  std::string large_channel(HIREDIS_HAPP_CMD_REFERENCE_SIZE + 3, 'c');
+  const char *argv[] = {"subscribe", "small", large_channel.c_str()};
+  size_t argvlen[] = {9, 5, large_channel.size()};
+  int release_count = 0;
+
+  CASE_EXPECT_LT(0, cmd->vformat_reference(3, argv, argvlen, happ_cmd_count_release, &release_count));
+  CASE_EXPECT_EQ(1, release_count);
+  CASE_EXPECT_NE(hiredis::happ::cmd_content::storage::SCATTER, cmd->get_cmd_raw_content().kind);
+  std::string expect = happ_cmd_hiredis_format("%s %s %b", argv[0], argv[1], argv[2], large_channel.size());
+  CASE_EXPECT_TRUE(expect == happ_cmd_content(cmd));
+
+  argv[0] = "PUNSUBSCRIBE";
+  argvlen[0] = 12;
+  CASE_EXPECT_LT(0, cmd->vformat_reference(3, argv, argvlen, happ_cmd_count_release, &release_count));
+  CASE_EXPECT_EQ(2, release_count);
+  CASE_EXPECT_NE(hiredis::happ::cmd_content::storage::SCATTER, cmd->get_cmd_raw_content().kind);
+
+  hiredis::happ::cmd_exec::destroy(cmd);
+  CASE_EXPECT_EQ(2, release_count);
+}
+
+CASE_TEST(happ_cmd, callable_callback) {
+  hiredis::happ::holder_t h;
+  h.r = nullptr;
+  int call_count = 0;
+  std::shared_ptr<int> alive = std::make_shared<int>(1);
+
+  // small lambda with a move-only capture is stored in the cmd buffer
+  {
+    std::unique_ptr<int> value(new int(42));
+    auto fn = [&call_count, value = std::move(value), alive](hiredis::happ::cmd_exec *cmd, redisAsyncContext *,
+                                                             void *r) {
+      CASE_EXPECT_EQ(42, *value);
+      CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TIMEOUT, cmd->result());
+      CASE_EXPECT_EQ(nullptr, r);
+      ++call_count;
+    };
+    CASE_EXPECT_TRUE(hiredis::happ::detail::cmd_callable<decltype(fn)>::is_inline);
+
+    hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create_callable(nullptr, h, std::move(fn));
+    CASE_EXPECT_NE(nullptr, cmd);
+    CASE_EXPECT_EQ(nullptr, cmd->private_data());
+    CASE_EXPECT_EQ(2, alive.use_count());  // captures are moved into the cmd
+
+    cmd->call_reply(hiredis::happ::error_code::REDIS_HAPP_TIMEOUT, nullptr, nullptr);
+    CASE_EXPECT_EQ(1, call_count);
+    CASE_EXPECT_EQ(1, alive.use_count());  // captures are destroyed after called
+
+    // called only once
+    cmd->call_reply(hiredis::happ::error_code::REDIS_HAPP_TIMEOUT, nullptr, nullptr);
+    CASE_EXPECT_EQ(1, call_count);
+    hiredis::happ::cmd_exec::destroy(cmd);
+  }
+  CASE_EXPECT_EQ(1, alive.use_count());
+
+  // oversized lambda is allocated on heap
+  {
+    char payload[HIREDIS_HAPP_CMD_CALLABLE_INLINE_SIZE + 1];
+    memset(payload, 'p', sizeof(payload));
+    auto fn = [&call_count, payload, alive](hiredis::happ::cmd_exec *, redisAsyncContext *, void *) {
+      CASE_EXPECT_EQ('p', payload[HIREDIS_HAPP_CMD_CALLABLE_INLINE_SIZE]);
+      ++call_count;
+    };
+    CASE_EXPECT_FALSE(hiredis::happ::detail::cmd_callable<decltype(fn)>::is_inline);
+
+    hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create_callable(nullptr, h, fn);
+    CASE_EXPECT_NE(nullptr, cmd);
+    CASE_EXPECT_EQ(3, alive.use_count());
+    cmd->call_reply(hiredis::happ::error_code::REDIS_HAPP_OK, nullptr, nullptr);
+    CASE_EXPECT_EQ(2, call_count);
+    CASE_EXPECT_EQ(2, alive.use_count());
+    hiredis::happ::cmd_exec::destroy(cmd);
+  }
+  CASE_EXPECT_EQ(1, alive.use_count());
+
+  // callables which are never called, such as callbacks of SUBSCRIBE, are destroyed with cmd
+  {
+    auto fn = [alive](hiredis::happ::cmd_exec *, redisAsyncContext *, void *) {};
+    hiredis::happ::cmd_exec::destroy(hiredis::happ::cmd_exec::create_callable(nullptr, h, std::move(fn)));
+    CASE_EXPECT_EQ(1, alive.use_count());
+
+    char payload[HIREDIS_HAPP_CMD_CALLABLE_INLINE_SIZE + 1];
+    memset(payload, 'p', sizeof(payload));
+    auto large_fn = [payload, alive](hiredis::happ::cmd_exec *, redisAsyncContext *, void *) {
+      CASE_EXPECT_EQ('p', payload[0]);
+    };
+    hiredis::happ::cmd_exec::destroy(hiredis::happ::cmd_exec::create_callable(nullptr, h, large_fn));
+    CASE_EXPECT_EQ(2, alive.use_count());  // large_fn itself
+  }
+  CASE_EXPECT_EQ(1, alive.use_count());
+}
+
+CASE_TEST(happ_cmd, format_typed_arguments) {
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  CASE_EXPECT_NE(nullptr, cmd);
+
+  // prefix of command name is encoded at compile time
+  static constexpr hiredis::happ::cmd_literal hset("HSET");
+  static_assert(10 == hset.len, "cmd_literal must be encoded at compile time");
+  CASE_EXPECT_TRUE(std::string("$4\r\nHSET\r\n") == std::string(hset.data, hset.len));
+
+  std::string key = "key";
+  std::string_view field("field");
+  int64_t len = cmd->format_args(hset, key, field, 42, -7, 3.14, "");
+  std::string expect = happ_cmd_hiredis_format("HSET %s %s 42 -7 3.14 %s", key.c_str(), "field", "");
+  CASE_EXPECT_EQ(static_cast<int64_t>(expect.size()), len);
+  CASE_EXPECT_TRUE(expect == happ_cmd_content(cmd));
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::INLINE, cmd->get_cmd_raw_content().kind);
+
+  const char *str = nullptr;
+  size_t str_len = 0;
+  CASE_EXPECT_NE(nullptr, cmd->pick_cmd(&str, &str_len));
+  CASE_EXPECT_TRUE(std::string("HSET") == std::string(str, str_len));
+
+  // limits of integers, and doubles which need 17 digits
+  CASE_EXPECT_LT(0, cmd->format_args(hiredis::happ::cmd_literal("ZADD"), "key", 0.1 + 0.2,
+                                     static_cast<uint64_t>(18446744073709551615ULL), INT64_MIN));
+  CASE_EXPECT_TRUE(happ_cmd_hiredis_format("ZADD key 0.30000000000000004 18446744073709551615 -9223372036854775808") ==
+                   happ_cmd_content(cmd));
+
+  // large commands use sds
+  std::string large_value(hiredis::happ::cmd_exec::get_inline_capacity(), 'v');
+  CASE_EXPECT_LT(0, cmd->format_args(hiredis::happ::cmd_literal("SET"), "key", large_value));
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::SDS, cmd->get_cmd_raw_content().kind);
+  CASE_EXPECT_TRUE(happ_cmd_hiredis_format("SET key %s", large_value.c_str()) == happ_cmd_content(cmd));
+
+  // command without arguments
+  CASE_EXPECT_LT(0, cmd->format_args(hiredis::happ::cmd_literal("PING")));
+  CASE_EXPECT_TRUE(std::string("*1\r\n$4\r\nPING\r\n") == happ_cmd_content(cmd));
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::INLINE, cmd->get_cmd_raw_content().kind);
+
+  hiredis::happ::cmd_exec::destroy(cmd);
+}
+
+CASE_TEST(happ_cmd, share_content) {
+  hiredis::happ::holder_t h;
+  h.clu = nullptr;
+
+  hiredis::happ::cmd_exec *src = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  hiredis::happ::cmd_exec *dst1 = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  hiredis::happ::cmd_exec *dst2 = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), src->get_content_ref_count());
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, dst1->share_content(src));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, src->share_content(src));
+
+  // small commands are copied into inline buffer
+  CASE_EXPECT_LT(0, src->format("GET %s", "key"));
+  CASE_EXPECT_EQ(static_cast<int64_t>(src->get_cmd_raw_content().raw_len), dst1->share_content(src));
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::INLINE, dst1->get_cmd_raw_content().kind);
+  CASE_EXPECT_TRUE(happ_cmd_content(src) == happ_cmd_content(dst1));
+  CASE_EXPECT_EQ(static_cast<size_t>(1), src->get_content_ref_count());
+
+  // large commands are moved into one shared buffer
+  std::string large_value(hiredis::happ::cmd_exec::get_inline_capacity(), 'v');
+  CASE_EXPECT_LT(0, src->format("SET %s %s", "key", large_value.c_str()));
+  std::string expect = happ_cmd_content(src);
+  CASE_EXPECT_EQ(static_cast<int64_t>(expect.size()), dst1->share_content(src));
+  CASE_EXPECT_EQ(static_cast<int64_t>(expect.size()), dst2->share_content(dst1));
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::SHARED, src->get_cmd_raw_content().kind);
+  CASE_EXPECT_EQ(src->get_cmd_raw_content().content.raw, dst2->get_cmd_raw_content().content.raw);
+  CASE_EXPECT_EQ(static_cast<size_t>(3), src->get_content_ref_count());
+  CASE_EXPECT_TRUE(expect == happ_cmd_content(dst2));
+
+  const char *str = nullptr;
+  size_t str_len = 0;
+  CASE_EXPECT_NE(nullptr, dst2->pick_cmd(&str, &str_len));
+  CASE_EXPECT_TRUE(std::string("SET") == std::string(str, str_len));
+
+  // sharing again keeps the same buffer
+  CASE_EXPECT_LT(0, dst2->share_content(src));
+  CASE_EXPECT_EQ(static_cast<size_t>(3), dst2->get_content_ref_count());
+
+  // the buffer is alive until the last cmd releases it
+  hiredis::happ::cmd_exec::destroy(src);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), dst1->get_content_ref_count());
+  CASE_EXPECT_LT(0, dst1->format("GET %s", "key"));
+  CASE_EXPECT_EQ(static_cast<size_t>(1), dst2->get_content_ref_count());
+  CASE_EXPECT_TRUE(expect == happ_cmd_content(dst2));
+
+  // referenced arguments are released after moved into shared buffer
+  std::string ref_value(HIREDIS_HAPP_CMD_REFERENCE_SIZE, 'r');
+  const char *argv[] = {"SET", "key", ref_value.c_str()};
+  size_t argvlen[] = {3, 3, ref_value.size()};
+  int release_count = 0;
+  CASE_EXPECT_LT(0, dst1->vformat_reference(3, argv, argvlen, happ_cmd_count_release, &release_count));
+  CASE_EXPECT_LT(0, dst2->share_content(dst1));
+  CASE_EXPECT_EQ(1, release_count);
+  CASE_EXPECT_TRUE(happ_cmd_hiredis_format("SET key %s", ref_value.c_str()) == happ_cmd_content(dst1));
+  CASE_EXPECT_TRUE(happ_cmd_content(dst1) == happ_cmd_content(dst2));
+
+  hiredis::happ::cmd_exec::destroy(dst1);
+  hiredis::happ::cmd_exec::destroy(dst2);
+}
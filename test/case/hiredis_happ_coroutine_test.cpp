@@ -0,0 +1,211 @@
+#include <string>
+#include <vector>
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+#include "test_pong_server.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_COROUTINE) && defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+
+namespace {
+struct happ_coroutine_state {
+  std::vector<std::string> replies;
+  std::vector<int> results;
+  bool finished = false;
+};
+
+// send PINGs one by one, every step starts after the reply of the last one
+hiredis::happ::co_task happ_coroutine_ping_steps(hiredis::happ::raw &r, int steps, happ_coroutine_state &state) {
+  for (int i = 0; i < steps; ++i) {
+    hiredis::happ::co_reply reply = co_await hiredis::happ::co_exec(r, "PING");
+    state.results.push_back(reply.result());
+    if (!reply.is_ok()) {
+      break;
+    }
+
+    state.replies.push_back(std::string(reply.str()));
+  }
+
+  state.finished = true;
+}
+
+// decode replies into typed values
+hiredis::happ::co_task happ_coroutine_typed_steps(hiredis::happ::raw &r, happ_coroutine_state &state) {
+  hiredis::happ::co_result<std::string> value = co_await hiredis::happ::co_exec<std::string>(r, "PING");
+  state.results.push_back(value.result);
+  state.replies.push_back(value.value);
+
+  // +PONG is not an integer
+  hiredis::happ::co_result<long long> mismatch = co_await hiredis::happ::co_exec<long long>(r, "PING");
+  state.results.push_back(mismatch.result);
+  state.finished = true;
+}
+
+// the cmd of SUBSCRIBE is destroyed without calling back
+hiredis::happ::co_task happ_coroutine_subscribe(hiredis::happ::raw &r, happ_coroutine_state &state) {
+  hiredis::happ::co_reply reply = co_await hiredis::happ::co_exec(r, "SUBSCRIBE channel");
+  state.results.push_back(reply.result());
+  state.finished = true;
+}
+
+hiredis::happ::co_task happ_coroutine_cluster_get(hiredis::happ::cluster &clu, happ_coroutine_state &state) {
+  hiredis::happ::co_reply reply =
+      co_await hiredis::happ::co_exec(clu, "key", 3, hiredis::happ::cmd_literal("GET"), std::string("key"));
+  state.results.push_back(reply.result());
+  state.finished = true;
+}
+}  // namespace
+
+CASE_TEST(happ_coroutine, sequential_steps) {
+  hiredis_happ_test::pong_server server;
+
+  hiredis::happ::epoll_loop loop;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, loop.init(1000));
+
+  hiredis::happ::raw raw;
+  raw.init("127.0.0.1", server.get_port());
+  loop.bind(raw);
+  raw.start();
+
+  happ_coroutine_state state;
+  happ_coroutine_ping_steps(raw, 3, state);
+  // suspended at the first co_await
+  CASE_EXPECT_FALSE(state.finished);
+  CASE_EXPECT_TRUE(state.results.empty());
+
+  for (int i = 0; i < 500 && !state.finished; ++i) {
+    loop.run_once(10);
+  }
+
+  CASE_EXPECT_TRUE(state.finished);
+  CASE_EXPECT_EQ(static_cast<size_t>(3), state.replies.size());
+  for (size_t i = 0; i < state.replies.size(); ++i) {
+    CASE_EXPECT_TRUE("PONG" == state.replies[i]);
+    CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, state.results[i]);
+  }
+  CASE_EXPECT_EQ(3, server.get_ping_count());
+
+  // the frame goes back to the pool and is reused by the next coroutine
+  size_t cached = hiredis::happ::detail::co_frame_pool::get_cached_count();
+  CASE_EXPECT_LT(0, cached);
+
+  happ_coroutine_state next;
+  happ_coroutine_ping_steps(raw, 1, next);
+  CASE_EXPECT_EQ(cached - 1, hiredis::happ::detail::co_frame_pool::get_cached_count());
+  for (int i = 0; i < 500 && !next.finished; ++i) {
+    loop.run_once(10);
+  }
+  CASE_EXPECT_TRUE(next.finished);
+  CASE_EXPECT_EQ(cached, hiredis::happ::detail::co_frame_pool::get_cached_count());
+
+  raw.reset();
+}
+
+CASE_TEST(happ_coroutine, typed_result) {
+  hiredis_happ_test::pong_server server;
+
+  hiredis::happ::epoll_loop loop;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, loop.init(1000));
+
+  hiredis::happ::raw raw;
+  raw.init("127.0.0.1", server.get_port());
+  loop.bind(raw);
+  raw.start();
+
+  happ_coroutine_state state;
+  happ_coroutine_typed_steps(raw, state);
+  for (int i = 0; i < 500 && !state.finished; ++i) {
+    loop.run_once(10);
+  }
+
+  CASE_EXPECT_TRUE(state.finished);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), state.results.size());
+  if (2 == state.results.size()) {
+    CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, state.results[0]);
+    CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, state.results[1]);
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(1), state.replies.size());
+  if (!state.replies.empty()) {
+    CASE_EXPECT_TRUE("PONG" == state.replies[0]);
+  }
+
+  raw.reset();
+}
+
+CASE_TEST(happ_coroutine, error_result) {
+  // a port which is just closed
+  uint16_t port;
+  {
+    hiredis_happ_test::pong_server server;
+    port = server.get_port();
+  }
+
+  hiredis::happ::epoll_loop loop;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, loop.init(1000));
+
+  hiredis::happ::raw raw;
+  raw.init("127.0.0.1", port);
+  loop.bind(raw);
+  raw.start();
+
+  happ_coroutine_state state;
+  happ_coroutine_ping_steps(raw, 3, state);
+  for (int i = 0; i < 500 && !state.finished; ++i) {
+    loop.run_once(10);
+  }
+
+  // the coroutine is resumed with the error and stops at the first step
+  CASE_EXPECT_TRUE(state.finished);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), state.results.size());
+  CASE_EXPECT_TRUE(state.replies.empty());
+  if (!state.results.empty()) {
+    CASE_EXPECT_NE(hiredis::happ::error_code::REDIS_HAPP_OK, state.results[0]);
+  }
+
+  raw.reset();
+}
+
+CASE_TEST(happ_coroutine, cmd_without_callback) {
+  hiredis_happ_test::pong_server server;
+
+  hiredis::happ::epoll_loop loop;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, loop.init(1000));
+
+  hiredis::happ::raw raw;
+  raw.init("127.0.0.1", server.get_port());
+  loop.bind(raw);
+  raw.start();
+
+  size_t cached = hiredis::happ::detail::co_frame_pool::get_cached_count();
+  happ_coroutine_state state;
+  happ_coroutine_subscribe(raw, state);
+
+  // resumed with an error when the callback is destroyed, and the frame goes back to the pool
+  CASE_EXPECT_TRUE(state.finished);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), state.results.size());
+  if (!state.results.empty()) {
+    CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_CONNECTION, state.results[0]);
+  }
+  CASE_EXPECT_LE(cached, hiredis::happ::detail::co_frame_pool::get_cached_count());
+
+  raw.reset();
+}
+
+CASE_TEST(happ_coroutine, resumed_by_reset) {
+  hiredis::happ::cluster clu;
+  clu.init("127.0.0.1", 6379);
+
+  // slots are not loaded, the cmd waits in the pending list
+  happ_coroutine_state state;
+  happ_coroutine_cluster_get(clu, state);
+  CASE_EXPECT_FALSE(state.finished);
+
+  clu.reset();
+  CASE_EXPECT_TRUE(state.finished);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), state.results.size());
+  if (!state.results.empty()) {
+    CASE_EXPECT_NE(hiredis::happ::error_code::REDIS_HAPP_OK, state.results[0]);
+  }
+}
+#endif
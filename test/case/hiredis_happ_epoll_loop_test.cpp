@@ -0,0 +1,227 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+#include "test_pong_server.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+
+CASE_TEST(happ_epoll_loop, raw_round_trip) {
+  hiredis_happ_test::pong_server server;
+  CASE_EXPECT_NE(0, server.get_port());
+
+  hiredis::happ::epoll_loop loop;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_CREATE, loop.run_once(0));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, loop.init());
+
+  hiredis::happ::raw raw;
+  raw.init("127.0.0.1", server.get_port());
+  int connect_count = 0;
+  raw.set_on_connect([&connect_count](hiredis::happ::raw *, hiredis::happ::connection *) { ++connect_count; });
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, loop.bind(raw));
+  raw.start();
+
+  std::vector<std::string> replies;
+  for (int i = 0; i < 3; ++i) {
+    raw.exec(
+        [&replies](hiredis::happ::cmd_exec *c, redisAsyncContext *, void *r) {
+          redisReply *reply = reinterpret_cast<redisReply *>(r);
+          if (hiredis::happ::error_code::REDIS_HAPP_OK == c->result() && nullptr != reply &&
+              REDIS_REPLY_STATUS == reply->type) {
+            replies.push_back(std::string(reply->str, reply->len));
+          } else {
+            replies.push_back(std::string());
+          }
+        },
+        "PING");
+  }
+
+  // the connection is attached by the wrapped on_connect, and the original one is still called
+  CASE_EXPECT_EQ(1, connect_count);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), loop.get_attached_count());
+
+  for (int i = 0; i < 500 && replies.size() < 3; ++i) {
+    loop.run_once(10);
+  }
+
+  CASE_EXPECT_EQ(static_cast<size_t>(3), replies.size());
+  for (size_t i = 0; i < replies.size(); ++i) {
+    CASE_EXPECT_TRUE("PONG" == replies[i]);
+  }
+  CASE_EXPECT_EQ(3, server.get_ping_count());
+
+  raw.reset();
+  CASE_EXPECT_EQ(static_cast<size_t>(0), loop.get_attached_count());
+}
+
+CASE_TEST(happ_epoll_loop, connect_refused) {
+  // a port which is just closed
+  uint16_t port;
+  {
+    hiredis_happ_test::pong_server server;
+    port = server.get_port();
+  }
+
+  hiredis::happ::epoll_loop loop;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, loop.init(1000));
+
+  hiredis::happ::raw raw;
+  raw.init("127.0.0.1", port);
+  raw.set_timeout(3);
+  loop.bind(raw);
+  raw.start();
+
+  int result = hiredis::happ::error_code::REDIS_HAPP_OK;
+  bool called = false;
+  raw.exec(
+      [&result, &called](hiredis::happ::cmd_exec *c, redisAsyncContext *, void *) {
+        result = c->result();
+        called = true;
+      },
+      "PING");
+
+  // the failure is detected by epoll, without waiting for the connect timeout
+  for (int i = 0; i < 500 && !called; ++i) {
+    loop.run_once(10);
+  }
+
+  CASE_EXPECT_TRUE(called);
+  CASE_EXPECT_NE(hiredis::happ::error_code::REDIS_HAPP_OK, result);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), loop.get_attached_count());
+  raw.reset();
+}
+
+CASE_TEST(happ_epoll_loop, dedicated_thread) {
+  hiredis_happ_test::pong_server server;
+
+  hiredis::happ::epoll_loop loop;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, loop.init(1000));
+
+  hiredis::happ::raw raw;
+  raw.init("127.0.0.1", server.get_port());
+  loop.bind(raw);
+  raw.start();
+
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, loop.start_thread());
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, loop.start_thread());
+
+  // cmds are sent by tasks run in the loop thread
+  std::atomic<int> pong_count(0);
+  std::thread::id loop_thread;
+  for (int i = 0; i < 5; ++i) {
+    raw.post([&raw, &pong_count, &loop_thread]() {
+      loop_thread = std::this_thread::get_id();
+      raw.exec(
+          [&pong_count](hiredis::happ::cmd_exec *c, redisAsyncContext *, void *r) {
+            redisReply *reply = reinterpret_cast<redisReply *>(r);
+            if (hiredis::happ::error_code::REDIS_HAPP_OK == c->result() && nullptr != reply &&
+                REDIS_REPLY_STATUS == reply->type) {
+              ++pong_count;
+            }
+          },
+          "PING");
+    });
+  }
+
+  for (int i = 0; i < 500 && pong_count.load() < 5; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  loop.stop();
+  loop.join();
+  CASE_EXPECT_FALSE(loop.is_running());
+  CASE_EXPECT_EQ(5, pong_count.load());
+  CASE_EXPECT_TRUE(loop_thread != std::this_thread::get_id());
+
+  raw.reset();
+}
+
+CASE_TEST(happ_epoll_loop, monotonic_tick) {
+  hiredis::happ::epoll_loop loop;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, loop.init(1000));
+
+  hiredis::happ::raw raw;
+  raw.init("127.0.0.1", 6379);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, loop.bind(raw));
+
+  time_t begin_sec;
+  time_t begin_usec;
+  hiredis::happ::epoll_loop::get_monotonic_time(begin_sec, begin_usec);
+
+  // nothing is attached, only the timerfd wakes up the loop
+  for (int i = 0; i < 3; ++i) {
+    CASE_EXPECT_LT(0, loop.run_once(-1));
+  }
+
+  time_t end_sec;
+  time_t end_usec;
+  hiredis::happ::epoll_loop::get_monotonic_time(end_sec, end_usec);
+  int64_t passed_usec = static_cast<int64_t>(end_sec - begin_sec) * 1000000 + (end_usec - begin_usec);
+  CASE_EXPECT_GE(passed_usec, 2000);
+  CASE_EXPECT_EQ(0, loop.get_attached_count());
+
+  raw.reset();
+}
+
+CASE_TEST(happ_epoll_loop, backends) {
+  hiredis::happ::epoll_loop::backend_t::type backends[] = {hiredis::happ::epoll_loop::backend_t::EPOLL,
+                                                           hiredis::happ::epoll_loop::backend_t::IO_URING};
+  for (size_t i = 0; i < sizeof(backends) / sizeof(backends[0]); ++i) {
+    hiredis::happ::epoll_loop loop;
+    CASE_EXPECT_EQ(hiredis::happ::epoll_loop::backend_t::AUTO, loop.get_backend());
+    if (hiredis::happ::error_code::REDIS_HAPP_OK != loop.init(1000, backends[i])) {
+      // io_uring is not available, AUTO falls back to epoll
+      CASE_EXPECT_EQ(hiredis::happ::epoll_loop::backend_t::IO_URING, backends[i]);
+      hiredis::happ::epoll_loop fallback;
+      CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, fallback.init());
+      CASE_EXPECT_EQ(hiredis::happ::epoll_loop::backend_t::EPOLL, fallback.get_backend());
+      continue;
+    }
+    CASE_EXPECT_EQ(backends[i], loop.get_backend());
+
+    hiredis_happ_test::pong_server server;
+    hiredis::happ::raw raw;
+    raw.init("127.0.0.1", server.get_port());
+    loop.bind(raw);
+    raw.start();
+
+    int pong_count = 0;
+    for (int j = 0; j < 20; ++j) {
+      raw.exec(
+          [&pong_count](hiredis::happ::cmd_exec *c, redisAsyncContext *, void *) {
+            if (hiredis::happ::error_code::REDIS_HAPP_OK == c->result()) {
+              ++pong_count;
+            }
+          },
+          "PING");
+    }
+
+    for (int j = 0; j < 500 && pong_count < 20; ++j) {
+      loop.run_once(10);
+    }
+    CASE_EXPECT_EQ(20, pong_count);
+
+    hiredis::happ::epoll_loop::stats_t stats = loop.get_stats();
+    CASE_EXPECT_LT(0, stats.wait_count);
+    CASE_EXPECT_LT(0, stats.event_count);
+    if (hiredis::happ::epoll_loop::backend_t::IO_URING == backends[i]) {
+      // poll changes are submitted together with waiting
+      CASE_EXPECT_EQ(0, stats.control_count);
+    } else {
+      CASE_EXPECT_LT(0, stats.control_count);
+    }
+
+    raw.reset();
+    CASE_EXPECT_EQ(static_cast<size_t>(0), loop.get_attached_count());
+    for (int j = 0; j < 3; ++j) {
+      loop.run_once(0);
+    }
+  }
+}
+#endif
@@ -0,0 +1,299 @@
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame/test_macros.h"
+#include "detail/crc16.h"
+#include "hiredis_happ.h"
+
+#include "test_fake_cluster.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+
+namespace {
+struct happ_fake_cluster_reply {
+  bool done;
+  int result;
+  int type;
+  std::string str;
+  long long integer;
+};
+
+void happ_fake_cluster_on_reply(hiredis::happ::cmd_exec *c, redisAsyncContext *, void *r, void *privdata) {
+  happ_fake_cluster_reply *out = reinterpret_cast<happ_fake_cluster_reply *>(privdata);
+  redisReply *reply = reinterpret_cast<redisReply *>(r);
+  out->done = true;
+  out->result = c->result();
+  if (nullptr != reply) {
+    out->type = reply->type;
+    out->integer = reply->integer;
+    if (nullptr != reply->str) {
+      out->str.assign(reply->str, reply->len);
+    }
+  }
+}
+
+// cluster driven by an epoll_loop in the test thread
+struct happ_fake_cluster_client {
+  hiredis::happ::epoll_loop loop;
+  hiredis::happ::cluster clu;
+
+  explicit happ_fake_cluster_client(uint16_t port) {
+    loop.init();
+    clu.init("127.0.0.1", port);
+    clu.set_timeout(5);
+    loop.bind(clu);
+    clu.start();
+  }
+
+  ~happ_fake_cluster_client() { clu.reset(); }
+
+  happ_fake_cluster_reply exec(const std::string &cmd, const std::string &key, const char *value = nullptr) {
+    happ_fake_cluster_reply ret;
+    ret.done = false;
+    ret.result = hiredis::happ::error_code::REDIS_HAPP_UNKNOWD;
+    ret.type = 0;
+    ret.integer = 0;
+
+    const char *argv[3] = {cmd.c_str(), key.c_str(), value};
+    size_t argvlen[3] = {cmd.size(), key.size(), nullptr == value ? 0 : strlen(value)};
+    if (nullptr == clu.exec(key.c_str(), key.size(), happ_fake_cluster_on_reply, &ret, nullptr == value ? 2 : 3, argv,
+                            argvlen)) {
+      return ret;
+    }
+
+    wait(ret.done);
+    return ret;
+  }
+
+  void wait(const bool &done) {
+    for (int i = 0; i < 500 && !done; ++i) {
+      loop.run_once(10);
+    }
+  }
+
+  // let the pending slot reloading finish
+  void settle() {
+    for (int i = 0; i < 10; ++i) {
+      loop.run_once(10);
+    }
+  }
+};
+
+// keys served by every node of the fake cluster
+std::vector<std::string> happ_fake_cluster_keys(const hiredis_happ_test::fake_cluster &server) {
+  std::vector<std::string> ret;
+  ret.resize(server.get_node_count());
+  for (int i = 0; i < 10000; ++i) {
+    std::string key = "key:" + std::to_string(i);
+    size_t node = server.get_node_by_key(key);
+    if (ret[node].empty()) {
+      ret[node] = key;
+    }
+  }
+  return ret;
+}
+}  // namespace
+
+CASE_TEST(happ_fake_cluster, get_set) {
+  hiredis_happ_test::fake_cluster server(3);
+  CASE_EXPECT_TRUE(server.is_ready());
+
+  happ_fake_cluster_client client(server.get_port(0));
+  std::vector<std::string> keys = happ_fake_cluster_keys(server);
+  for (size_t i = 0; i < keys.size(); ++i) {
+    happ_fake_cluster_reply reply = client.exec("SET", keys[i], "value");
+    CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+    CASE_EXPECT_TRUE("OK" == reply.str);
+
+    reply = client.exec("GET", keys[i]);
+    CASE_EXPECT_EQ(REDIS_REPLY_STRING, reply.type);
+    CASE_EXPECT_TRUE("value" == reply.str);
+    CASE_EXPECT_TRUE(server.get_command_count(i) >= 2);
+  }
+
+  happ_fake_cluster_reply reply = client.exec("INCR", keys[1]);
+  CASE_EXPECT_EQ(REDIS_REPLY_ERROR, reply.type);
+  reply = client.exec("INCR", "counter");
+  CASE_EXPECT_EQ(REDIS_REPLY_INTEGER, reply.type);
+  CASE_EXPECT_EQ(1, reply.integer);
+  CASE_EXPECT_TRUE("1" == server.get_value("counter"));
+
+  // the client connects to every node
+  for (size_t i = 0; i < server.get_node_count(); ++i) {
+    CASE_EXPECT_EQ(static_cast<size_t>(1), server.get_connection_count(i));
+  }
+}
+
+CASE_TEST(happ_fake_cluster, moved) {
+  hiredis_happ_test::fake_cluster server(2);
+  happ_fake_cluster_client client(server.get_port(0));
+  std::vector<std::string> keys = happ_fake_cluster_keys(server);
+
+  happ_fake_cluster_reply reply = client.exec("SET", keys[0], "value");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+
+  // move the slot and the old owner replies MOVED
+  int slot = hiredis::happ::hash_slot(keys[0].c_str(), keys[0].size());
+  server.assign_slots(slot, slot, 1);
+  size_t reload_count = server.get_cluster_slots_count();
+  reply = client.exec("GET", keys[0]);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+  CASE_EXPECT_TRUE("value" == reply.str);
+
+  client.settle();
+  CASE_EXPECT_LT(reload_count, server.get_cluster_slots_count());
+  const hiredis::happ::connection::key_t *master = client.clu.get_slot_master(slot);
+  CASE_EXPECT_TRUE(nullptr != master);
+  if (nullptr != master) {
+    CASE_EXPECT_EQ(server.get_port(1), master->port);
+  }
+
+  // injected MOVED is followed even if the slot map is not changed
+  server.inject_fault(1, hiredis_happ_test::fake_cluster::fault_t::MOVED, 1, 0);
+  reply = client.exec("GET", keys[0]);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+  CASE_EXPECT_TRUE("value" == reply.str);
+}
+
+CASE_TEST(happ_fake_cluster, ask) {
+  hiredis_happ_test::fake_cluster server(2);
+  happ_fake_cluster_client client(server.get_port(0));
+  std::vector<std::string> keys = happ_fake_cluster_keys(server);
+
+  happ_fake_cluster_reply reply = client.exec("SET", keys[0], "value");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+  client.settle();
+  size_t reload_count = server.get_cluster_slots_count();
+
+  // node 1 does not own the slot, but accepts the command after ASKING
+  server.inject_fault(0, hiredis_happ_test::fake_cluster::fault_t::ASK, 1, 1);
+  size_t command_count = server.get_command_count(1);
+  reply = client.exec("GET", keys[0]);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+  CASE_EXPECT_TRUE("value" == reply.str);
+  CASE_EXPECT_EQ(command_count + 2, server.get_command_count(1));
+
+  // ASK does not change the slot map
+  client.settle();
+  CASE_EXPECT_EQ(reload_count, server.get_cluster_slots_count());
+  int slot = hiredis::happ::hash_slot(keys[0].c_str(), keys[0].size());
+  const hiredis::happ::connection::key_t *master = client.clu.get_slot_master(slot);
+  CASE_EXPECT_TRUE(nullptr != master);
+  if (nullptr != master) {
+    CASE_EXPECT_EQ(server.get_port(0), master->port);
+  }
+}
+
+CASE_TEST(happ_fake_cluster, tryagain_and_errors) {
+  hiredis_happ_test::fake_cluster server(1);
+  happ_fake_cluster_client client(server.get_port(0));
+
+  happ_fake_cluster_reply reply = client.exec("SET", "key", "value");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+
+  // TRYAGAIN is retried until the ttl is used up
+  server.inject_fault(0, hiredis_happ_test::fake_cluster::fault_t::TRYAGAIN, 2);
+  reply = client.exec("GET", "key");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+  CASE_EXPECT_TRUE("value" == reply.str);
+
+  server.inject_fault(0, hiredis_happ_test::fake_cluster::fault_t::ERROR, 1);
+  reply = client.exec("GET", "key");
+  CASE_EXPECT_EQ(REDIS_REPLY_ERROR, reply.type);
+  CASE_EXPECT_TRUE("ERR fake error" == reply.str);
+
+  server.inject_fault(0, hiredis_happ_test::fake_cluster::fault_t::CLUSTERDOWN, 1);
+  reply = client.exec("GET", "key");
+  CASE_EXPECT_TRUE(reply.done);
+  CASE_EXPECT_EQ(REDIS_REPLY_ERROR, reply.type);
+  CASE_EXPECT_EQ(0, reply.str.compare(0, 11, "CLUSTERDOWN"));
+}
+
+CASE_TEST(happ_fake_cluster, drop_connections) {
+  hiredis_happ_test::fake_cluster server(1);
+  happ_fake_cluster_client client(server.get_port(0));
+
+  happ_fake_cluster_reply reply = client.exec("SET", "key", "value");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), server.get_connection_count(0));
+
+  // the command in flight fails with the connection
+  server.inject_fault(0, hiredis_happ_test::fake_cluster::fault_t::DROP, 1);
+  reply = client.exec("GET", "key");
+  CASE_EXPECT_TRUE(reply.done);
+  CASE_EXPECT_NE(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+
+  server.drop_connections(0);
+  for (int i = 0; i < 100 && 0 != server.get_connection_count(0); ++i) {
+    client.loop.run_once(10);
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(0), server.get_connection_count(0));
+
+  // and the cluster reconnects later
+  for (int i = 0; i < 10; ++i) {
+    reply = client.exec("GET", "key");
+    if (hiredis::happ::error_code::REDIS_HAPP_OK == reply.result) {
+      break;
+    }
+  }
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+  CASE_EXPECT_TRUE("value" == reply.str);
+}
+
+CASE_TEST(happ_fake_cluster, circuit_breaker_on_disconnect) {
+  hiredis_happ_test::fake_cluster server(1);
+  happ_fake_cluster_client client(server.get_port(0));
+
+  // circuit breakers are disabled by default
+  CASE_EXPECT_EQ(static_cast<uint32_t>(0), client.clu.get_circuit_breaker_config().half_open_probes);
+  hiredis::happ::circuit_breaker::config_t breaker_conf;
+  hiredis::happ::circuit_breaker::default_config(breaker_conf);
+  breaker_conf.error_rate_percent = 10;
+  breaker_conf.min_requests = 1;
+  breaker_conf.open_msec = 5000;
+  breaker_conf.half_open_probes = 1;
+  client.clu.set_circuit_breaker(breaker_conf);
+  // circuit breakers work after the first tick of the loop
+  for (int i = 0; i < 100 && !client.clu.is_timer_active(); ++i) {
+    client.loop.run_once(10);
+  }
+
+  happ_fake_cluster_reply reply = client.exec("SET", "key", "value");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+
+  // an established connection is closed by the server
+  server.inject_fault(0, hiredis_happ_test::fake_cluster::fault_t::DROP, 1);
+  reply = client.exec("GET", "key");
+  CASE_EXPECT_TRUE(reply.done);
+  CASE_EXPECT_NE(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+
+  std::string name = "127.0.0.1:" + std::to_string(server.get_port(0));
+  const hiredis::happ::circuit_breaker *breaker = client.clu.get_circuit_breaker(name);
+  CASE_EXPECT_NE(nullptr, breaker);
+  if (nullptr != breaker) {
+    CASE_EXPECT_EQ(hiredis::happ::circuit_breaker::state::OPEN, breaker->get_state());
+  }
+
+  // and the node fails fast
+  reply = client.exec("GET", "key");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_CIRCUIT_OPEN, reply.result);
+}
+
+CASE_TEST(happ_fake_cluster, latency) {
+  hiredis_happ_test::fake_cluster server(1);
+  happ_fake_cluster_client client(server.get_port(0));
+
+  happ_fake_cluster_reply reply = client.exec("SET", "key", "value");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+
+  server.set_latency(0, std::chrono::milliseconds(30));
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  reply = client.exec("GET", "key");
+  long long cost_ms = static_cast<long long>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+  CASE_EXPECT_TRUE("value" == reply.str);
+  CASE_EXPECT_GE(cost_ms, 30);
+}
+#endif
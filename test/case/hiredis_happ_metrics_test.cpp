@@ -0,0 +1,260 @@
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame/test_macros.h"
+#include "detail/crc16.h"
+#include "hiredis_happ.h"
+
+#include "test_fake_cluster.h"
+
+CASE_TEST(happ_metrics, histogram_buckets) {
+  // small values are exact
+  for (uint64_t i = 0; i < 2 * hiredis::happ::latency_histogram::SUB_BUCKET_COUNT; ++i) {
+    size_t index = hiredis::happ::latency_histogram::get_bucket_index(i);
+    CASE_EXPECT_EQ(i, index);
+    CASE_EXPECT_EQ(i, hiredis::happ::latency_histogram::get_bucket_upper_bound(index));
+  }
+
+  // every value is not larger than the upper bound of its bucket, and the error is less than 1/8
+  uint64_t values[] = {16, 17, 100, 1000, 12345, 1000000, 999999999, 1ULL << 40};
+  for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+    size_t index = hiredis::happ::latency_histogram::get_bucket_index(values[i]);
+    CASE_EXPECT_LT(index, static_cast<size_t>(hiredis::happ::latency_histogram::BUCKET_COUNT));
+    uint64_t upper = hiredis::happ::latency_histogram::get_bucket_upper_bound(index);
+    CASE_EXPECT_GE(upper, values[i]);
+    CASE_EXPECT_LE(upper - values[i], values[i] / hiredis::happ::latency_histogram::SUB_BUCKET_COUNT);
+    CASE_EXPECT_LT(hiredis::happ::latency_histogram::get_bucket_upper_bound(index - 1), values[i]);
+  }
+
+  // too large values are put into the last bucket
+  CASE_EXPECT_EQ(static_cast<size_t>(hiredis::happ::latency_histogram::BUCKET_COUNT - 1),
+                 hiredis::happ::latency_histogram::get_bucket_index(UINT64_MAX));
+}
+
+CASE_TEST(happ_metrics, histogram_percentile) {
+  hiredis::happ::latency_histogram histogram;
+  CASE_EXPECT_EQ(0, histogram.get_percentile(50));
+
+  for (uint64_t i = 1; i <= 1000; ++i) {
+    histogram.add(i);
+  }
+  CASE_EXPECT_EQ(1000, histogram.get_count());
+  CASE_EXPECT_EQ(500500, histogram.get_sum_usec());
+  CASE_EXPECT_EQ(1000, histogram.get_max_usec());
+  CASE_EXPECT_EQ(1, histogram.get_percentile(0));
+  CASE_EXPECT_EQ(1000, histogram.get_percentile(100));
+
+  uint64_t p50 = histogram.get_percentile(50);
+  uint64_t p99 = histogram.get_percentile(99);
+  CASE_EXPECT_GE(p50, 500);
+  CASE_EXPECT_LE(p50, 500 + 500 / 8);
+  CASE_EXPECT_GE(p99, 990);
+  CASE_EXPECT_LE(p99, 1000);
+
+  hiredis::happ::latency_histogram other;
+  other.add(5000);
+  histogram.merge(other);
+  CASE_EXPECT_EQ(1001, histogram.get_count());
+  CASE_EXPECT_EQ(5000, histogram.get_max_usec());
+  CASE_EXPECT_EQ(5000, histogram.get_percentile(100));
+
+  histogram.reset();
+  CASE_EXPECT_EQ(0, histogram.get_count());
+  CASE_EXPECT_EQ(0, histogram.get_bucket(0));
+}
+
+CASE_TEST(happ_metrics, error_index) {
+  CASE_EXPECT_EQ(0, hiredis::happ::metrics::get_error_index(hiredis::happ::error_code::REDIS_HAPP_OK));
+  CASE_EXPECT_EQ(1, hiredis::happ::metrics::get_error_index(hiredis::happ::error_code::REDIS_HAPP_UNKNOWD));
+  CASE_EXPECT_EQ(3, hiredis::happ::metrics::get_error_index(hiredis::happ::error_code::REDIS_HAPP_TTL));
+  CASE_EXPECT_EQ(static_cast<size_t>(hiredis::happ::metrics::ERROR_CODE_COUNT - 1),
+                 hiredis::happ::metrics::get_error_index(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH));
+
+  // unknown codes
+  CASE_EXPECT_EQ(1, hiredis::happ::metrics::get_error_index(-1));
+  CASE_EXPECT_EQ(1, hiredis::happ::metrics::get_error_index(-2000));
+  CASE_EXPECT_EQ(1, hiredis::happ::metrics::get_error_index(hiredis::happ::error_code::REDIS_HAPP_ERROR_END));
+
+  hiredis::happ::metrics m;
+  m.add_cmd_finished(hiredis::happ::error_code::REDIS_HAPP_OK);
+  m.add_cmd_finished(hiredis::happ::error_code::REDIS_HAPP_TIMEOUT);
+  m.add_cmd_finished(hiredis::happ::error_code::REDIS_HAPP_TIMEOUT);
+  CASE_EXPECT_EQ(1, m.get_counters().cmd_succeeded);
+  CASE_EXPECT_EQ(2, m.get_counters().cmd_failed);
+  CASE_EXPECT_EQ(2, m.get_counters().cmd_finished_by_code[hiredis::happ::metrics::get_error_index(
+                        hiredis::happ::error_code::REDIS_HAPP_TIMEOUT)]);
+
+  m.reset();
+  CASE_EXPECT_EQ(0, m.get_counters().cmd_failed);
+}
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+
+namespace {
+struct happ_metrics_client {
+  hiredis::happ::epoll_loop loop;
+  hiredis::happ::cluster clu;
+  size_t pending;
+
+  explicit happ_metrics_client(uint16_t port) : pending(0) {
+    loop.init();
+    clu.init("127.0.0.1", port);
+    clu.set_timeout(5);
+    clu.set_latency_metrics(true);
+    loop.bind(clu);
+    clu.start();
+  }
+
+  ~happ_metrics_client() { clu.reset(); }
+
+  static void on_reply(hiredis::happ::cmd_exec *, redisAsyncContext *, void *, void *privdata) {
+    --reinterpret_cast<happ_metrics_client *>(privdata)->pending;
+  }
+
+  void send(const char *cmd, const std::string &key) {
+    const char *argv[3] = {cmd, key.c_str(), "value"};
+    size_t argvlen[3] = {strlen(cmd), key.size(), 5};
+    ++pending;
+    clu.exec(key.c_str(), key.size(), on_reply, this, 0 == strcmp(cmd, "SET") ? 3 : 2, argv, argvlen);
+  }
+
+  void wait() {
+    for (int i = 0; i < 500 && pending > 0; ++i) {
+      loop.run_once(10);
+    }
+  }
+
+  hiredis::happ::metrics::snapshot_t snapshot() const {
+    hiredis::happ::metrics::snapshot_t ret;
+    clu.snapshot_metrics(ret);
+    return ret;
+  }
+};
+
+std::string happ_metrics_key_of(const hiredis_happ_test::fake_cluster &server, size_t node) {
+  for (int i = 0; i < 10000; ++i) {
+    std::string key = "key:" + std::to_string(i);
+    if (server.get_node_by_key(key) == node) {
+      return key;
+    }
+  }
+  return std::string();
+}
+}  // namespace
+
+CASE_TEST(happ_metrics, cluster_counters) {
+  hiredis_happ_test::fake_cluster server(2);
+  happ_metrics_client client(server.get_port(0));
+  std::string key0 = happ_metrics_key_of(server, 0);
+  std::string key1 = happ_metrics_key_of(server, 1);
+
+  // cmds wait for slots at first
+  client.send("SET", key0);
+  client.send("SET", key1);
+  hiredis::happ::metrics::snapshot_t snapshot = client.snapshot();
+  CASE_EXPECT_EQ(static_cast<size_t>(2), snapshot.gauges.slot_pending);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), snapshot.gauges.in_flight);
+  CASE_EXPECT_EQ(1, snapshot.counters.slot_reloads);
+
+  client.wait();
+  snapshot = client.snapshot();
+  CASE_EXPECT_EQ(static_cast<size_t>(0), snapshot.gauges.slot_pending);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), snapshot.gauges.in_flight);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), snapshot.gauges.connections);
+  CASE_EXPECT_EQ(2, snapshot.counters.connects);
+  // CLUSTER SLOTS and two SET
+  CASE_EXPECT_EQ(3, snapshot.counters.cmd_sent);
+  CASE_EXPECT_EQ(3, snapshot.counters.cmd_succeeded);
+  CASE_EXPECT_EQ(0, snapshot.counters.cmd_failed);
+
+  // every node has its own latency
+  CASE_EXPECT_EQ(static_cast<size_t>(2), snapshot.nodes.size());
+  uint64_t replies = 0;
+  for (size_t i = 0; i < snapshot.nodes.size(); ++i) {
+    CASE_EXPECT_NE(0, snapshot.nodes[i].id);
+    CASE_EXPECT_FALSE(snapshot.nodes[i].name.empty());
+    CASE_EXPECT_EQ(snapshot.nodes[i].replies, snapshot.nodes[i].latency.get_count());
+    replies += snapshot.nodes[i].replies;
+  }
+  CASE_EXPECT_EQ(3, replies);
+
+  // redirections
+  int slot = hiredis::happ::hash_slot(key0.c_str(), key0.size());
+  server.assign_slots(slot, slot, 1);
+  client.send("GET", key0);
+  client.wait();
+  server.inject_fault(1, hiredis_happ_test::fake_cluster::fault_t::ASK, 1, 0);
+  client.send("GET", key1);
+  client.wait();
+  server.inject_fault(1, hiredis_happ_test::fake_cluster::fault_t::TRYAGAIN, 1);
+  client.send("GET", key1);
+  client.wait();
+  server.inject_fault(1, hiredis_happ_test::fake_cluster::fault_t::ERROR, 1);
+  client.send("GET", key1);
+  client.wait();
+
+  snapshot = client.snapshot();
+  CASE_EXPECT_EQ(1, snapshot.counters.moved);
+  CASE_EXPECT_EQ(1, snapshot.counters.ask);
+  CASE_EXPECT_EQ(1, snapshot.counters.tryagain);
+  CASE_EXPECT_EQ(3, snapshot.counters.retries);
+  CASE_EXPECT_LE(2, snapshot.counters.slot_reloads);
+  CASE_EXPECT_EQ(1, snapshot.counters.cmd_failed);
+  CASE_EXPECT_EQ(1, snapshot.counters.cmd_finished_by_code[hiredis::happ::metrics::get_error_index(
+                        hiredis::happ::error_code::REDIS_HAPP_HIREDIS)]);
+
+  client.clu.reset_metrics();
+  CASE_EXPECT_EQ(0, client.clu.get_metrics().get_counters().cmd_sent);
+  CASE_EXPECT_TRUE(nullptr == client.clu.get_metrics().get_node(1));
+}
+
+CASE_TEST(happ_metrics, cluster_failures) {
+  hiredis_happ_test::fake_cluster server(1);
+  happ_metrics_client client(server.get_port(0));
+  client.send("SET", "key");
+  client.wait();
+
+  // latency is opt-in
+  {
+    hiredis::happ::cluster clu;
+    CASE_EXPECT_FALSE(clu.is_latency_metrics_enabled());
+  }
+
+  // latency is not recorded after it's disabled
+  client.clu.set_latency_metrics(false);
+  CASE_EXPECT_FALSE(client.clu.is_latency_metrics_enabled());
+  client.clu.reset_metrics();
+  client.send("GET", "key");
+  client.wait();
+
+  hiredis::happ::metrics::snapshot_t snapshot = client.snapshot();
+  CASE_EXPECT_EQ(static_cast<size_t>(1), snapshot.nodes.size());
+  if (!snapshot.nodes.empty()) {
+    CASE_EXPECT_EQ(1, snapshot.nodes[0].replies);
+    CASE_EXPECT_EQ(0, snapshot.nodes[0].latency.get_count());
+  }
+
+  // the connection is closed by the server
+  server.inject_fault(0, hiredis_happ_test::fake_cluster::fault_t::DROP, 1);
+  client.send("GET", "key");
+  client.wait();
+  snapshot = client.snapshot();
+  CASE_EXPECT_LE(1, snapshot.counters.disconnects);
+  CASE_EXPECT_EQ(1, snapshot.counters.cmd_failed);
+
+  // busy replies are failures of the node
+  client.send("GET", "key");
+  client.wait();
+  server.inject_fault(0, hiredis_happ_test::fake_cluster::fault_t::CLUSTERDOWN, 1);
+  client.send("GET", "key");
+  client.wait();
+  snapshot = client.snapshot();
+  CASE_EXPECT_EQ(1, snapshot.counters.clusterdown);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), snapshot.nodes.size());
+  if (!snapshot.nodes.empty()) {
+    CASE_EXPECT_LE(1, snapshot.nodes[0].failures);
+  }
+}
+#endif
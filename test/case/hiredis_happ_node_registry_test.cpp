@@ -0,0 +1,63 @@
+#include <cstdint>
+#include <string>
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+CASE_TEST(happ_node_registry, intern) {
+  hiredis::happ::node_registry nodes;
+  CASE_EXPECT_EQ(static_cast<size_t>(0), nodes.size());
+  CASE_EXPECT_EQ(nullptr, nodes.get(0));
+  CASE_EXPECT_EQ(nullptr, nodes.get(1));
+
+  const hiredis::happ::connection::key_t *node1 = nodes.intern("127.0.0.1", 7000);
+  CASE_EXPECT_NE(nullptr, node1);
+  CASE_EXPECT_NE(static_cast<hiredis::happ::connection::node_id_t>(0), node1->id);
+  CASE_EXPECT_TRUE("127.0.0.1:7000" == node1->name);
+  CASE_EXPECT_TRUE("127.0.0.1" == node1->ip);
+  CASE_EXPECT_EQ(static_cast<uint16_t>(7000), node1->port);
+
+  // the same address always gets the same node
+  CASE_EXPECT_EQ(node1, nodes.intern("127.0.0.1", 7000));
+  CASE_EXPECT_EQ(static_cast<size_t>(1), nodes.size());
+
+  // keys are not moved when more nodes are added
+  hiredis::happ::connection::node_id_t id1 = node1->id;
+  for (uint16_t port = 7001; port < 8000; ++port) {
+    nodes.intern("127.0.0.1", port);
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(1000), nodes.size());
+  CASE_EXPECT_EQ(node1, nodes.get(id1));
+  CASE_EXPECT_EQ(id1, node1->id);
+
+  // ids are dense
+  const hiredis::happ::connection::key_t *last = nodes.intern("127.0.0.1", 7999);
+  CASE_EXPECT_EQ(static_cast<hiredis::happ::connection::node_id_t>(nodes.size()), last->id);
+}
+
+CASE_TEST(happ_node_registry, find) {
+  hiredis::happ::node_registry nodes;
+  const hiredis::happ::connection::key_t *node = nodes.intern("10.0.0.1", 6379);
+  CASE_EXPECT_NE(nullptr, node);
+
+  CASE_EXPECT_EQ(node->id, nodes.find("10.0.0.1:6379"));
+  CASE_EXPECT_EQ(node->id, nodes.find("10.0.0.1", 6379));
+  CASE_EXPECT_EQ(static_cast<hiredis::happ::connection::node_id_t>(0), nodes.find("10.0.0.1:6380"));
+  CASE_EXPECT_EQ(static_cast<hiredis::happ::connection::node_id_t>(0), nodes.find("10.0.0.2", 6379));
+
+  // keys made by set_key are interned by address, and keys of other registries are checked by name
+  hiredis::happ::connection::key_t key;
+  hiredis::happ::connection::set_key(key, "10.0.0.1", 6379);
+  CASE_EXPECT_EQ(static_cast<hiredis::happ::connection::node_id_t>(0), key.id);
+  CASE_EXPECT_EQ(node, nodes.intern(key));
+
+  hiredis::happ::node_registry other;
+  other.intern("10.0.0.9", 6379);
+  const hiredis::happ::connection::key_t *other_node = other.intern("10.0.0.2", 6379);
+  CASE_EXPECT_EQ(node->id, other.find("10.0.0.9:6379"));
+
+  const hiredis::happ::connection::key_t *copy = nodes.intern(*other_node);
+  CASE_EXPECT_NE(node, copy);
+  CASE_EXPECT_TRUE("10.0.0.2:6379" == copy->name);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), nodes.size());
+}
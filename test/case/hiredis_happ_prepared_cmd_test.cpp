@@ -0,0 +1,131 @@
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+static std::string happ_prepared_cmd_content(const hiredis::happ::cmd_exec *cmd) {
+  hiredis::happ::cmd_content content = cmd->get_cmd_raw_content();
+  if (hiredis::happ::cmd_content::storage::SDS == content.kind) {
+    return std::string(content.content.redis_sds, sdslen(content.content.redis_sds));
+  }
+
+  return std::string(content.content.raw, content.raw_len);
+}
+
+CASE_TEST(happ_prepared_cmd, init) {
+  hiredis::happ::prepared_cmd cmd;
+  CASE_EXPECT_TRUE(cmd.empty());
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, cmd.init(nullptr));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, cmd.init("   "));
+
+  // constant segments around placeholders
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, cmd.init("HINCRBY  ? counter 1"));
+  CASE_EXPECT_FALSE(cmd.empty());
+  CASE_EXPECT_EQ(static_cast<size_t>(4), cmd.get_argument_count());
+  CASE_EXPECT_EQ(static_cast<size_t>(1), cmd.get_placeholder_count());
+
+  size_t len = 0;
+  const char *segment = cmd.get_segment(0, &len);
+  CASE_EXPECT_TRUE(std::string("*4\r\n$7\r\nHINCRBY\r\n") == std::string(segment, len));
+  segment = cmd.get_segment(1, &len);
+  CASE_EXPECT_TRUE(std::string("$7\r\ncounter\r\n$1\r\n1\r\n") == std::string(segment, len));
+  CASE_EXPECT_EQ(nullptr, cmd.get_segment(2, &len));
+  CASE_EXPECT_EQ(static_cast<size_t>(0), len);
+
+  // placeholders at the end, and constant arguments with spaces
+  const char *argv[] = {"SET", nullptr, "a value", nullptr};
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, cmd.init(4, argv, nullptr));
+  CASE_EXPECT_EQ(static_cast<size_t>(2), cmd.get_placeholder_count());
+  segment = cmd.get_segment(2, &len);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), len);
+  CASE_EXPECT_EQ(cmd.get_constant_length(), static_cast<size_t>(segment - cmd.get_segment(0, &len)));
+
+  cmd.reset();
+  CASE_EXPECT_TRUE(cmd.empty());
+  CASE_EXPECT_EQ(static_cast<size_t>(0), cmd.get_placeholder_count());
+}
+
+CASE_TEST(happ_prepared_cmd, format) {
+  hiredis::happ::prepared_cmd hincrby;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hincrby.init("HINCRBY ? counter ?"));
+
+  hiredis::happ::holder_t h;
+  h.r = nullptr;
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(h, nullptr, nullptr, 0);
+  CASE_EXPECT_NE(nullptr, cmd);
+
+  // typed placeholder values
+  std::string key = "user:{1000}";
+  int64_t len = cmd->format_args(hincrby, key, -3);
+  std::string expect = "*4\r\n$7\r\nHINCRBY\r\n$11\r\nuser:{1000}\r\n$7\r\ncounter\r\n$2\r\n-3\r\n";
+  CASE_EXPECT_EQ(static_cast<int64_t>(expect.size()), len);
+  CASE_EXPECT_TRUE(expect == happ_prepared_cmd_content(cmd));
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::INLINE, cmd->get_cmd_raw_content().kind);
+
+  const char *str = nullptr;
+  size_t str_len = 0;
+  CASE_EXPECT_NE(nullptr, cmd->pick_cmd(&str, &str_len));
+  CASE_EXPECT_TRUE(std::string("HINCRBY") == std::string(str, str_len));
+
+  // argv placeholder values, and large commands use sds
+  std::string large_key(hiredis::happ::cmd_exec::get_inline_capacity(), 'k');
+  const char *argv[] = {large_key.c_str(), "1"};
+  len = cmd->format_prepared(hincrby, 2, argv, nullptr);
+  expect = "*4\r\n$7\r\nHINCRBY\r\n$" + std::to_string(large_key.size()) + "\r\n" + large_key +
+           "\r\n$7\r\ncounter\r\n$1\r\n1\r\n";
+  CASE_EXPECT_EQ(static_cast<int64_t>(expect.size()), len);
+  CASE_EXPECT_EQ(hiredis::happ::cmd_content::storage::SDS, cmd->get_cmd_raw_content().kind);
+  CASE_EXPECT_TRUE(expect == happ_prepared_cmd_content(cmd));
+
+  // count of placeholder values must match
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, cmd->format_args(hincrby, key));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, cmd->format_prepared(hincrby, 3, argv, nullptr));
+
+  // command without placeholders
+  hiredis::happ::prepared_cmd ping;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, ping.init("PING"));
+  CASE_EXPECT_LT(0, cmd->format_args(ping));
+  CASE_EXPECT_TRUE(std::string("*1\r\n$4\r\nPING\r\n") == happ_prepared_cmd_content(cmd));
+
+  hiredis::happ::cmd_exec::destroy(cmd);
+}
+
+CASE_TEST(happ_prepared_cmd, exec) {
+  hiredis::happ::prepared_cmd hincrby;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hincrby.init("HINCRBY ? counter 1"));
+
+  hiredis::happ::raw raw;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.init("127.0.0.1", 6380));
+  raw.set_timeout(3);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.start());
+  raw.proc(1, 0);
+
+  std::vector<int> results;
+  for (int i = 0; i < 3; ++i) {
+    hiredis::happ::cmd_exec *cmd =
+        raw.exec([&results](hiredis::happ::cmd_exec *c, redisAsyncContext *, void *) { results.push_back(c->result()); },
+                 hincrby, "user:" + std::to_string(i));
+    CASE_EXPECT_NE(nullptr, cmd);
+  }
+
+  // the last command is written into output buffer of hiredis
+  CASE_EXPECT_NE(nullptr, raw.get_connection());
+  if (nullptr != raw.get_connection()) {
+    sds obuf = raw.get_connection()->get_context()->c.obuf;
+    std::string expect = "*4\r\n$7\r\nHINCRBY\r\n$6\r\nuser:2\r\n$7\r\ncounter\r\n$1\r\n1\r\n";
+    CASE_EXPECT_GE(sdslen(obuf), expect.size());
+    CASE_EXPECT_TRUE(expect == std::string(obuf + sdslen(obuf) - expect.size(), expect.size()));
+  }
+
+  // wrong count of placeholder values
+  CASE_EXPECT_EQ(nullptr, raw.exec(nullptr, nullptr, hincrby, "user:0", 1));
+
+  // connect timeout
+  raw.proc(5, 0);
+  CASE_EXPECT_EQ(static_cast<size_t>(3), results.size());
+  raw.reset();
+}
@@ -2,6 +2,10 @@
 #include <cstring>
 #include <ctime>
 #include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "frame/test_macros.h"
 #include "hiredis_happ.h"
@@ -54,3 +58,102 @@ CASE_TEST(happ_raw, basic_config_and_timer) {
   CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.reset());
   CASE_EXPECT_FALSE(raw.is_timer_active());
 }
+
+static void happ_raw_count_release(void *data) { ++(*reinterpret_cast<int *>(data)); }
+
+CASE_TEST(happ_raw, exec_reference_large_argument) {
+  hiredis::happ::raw raw;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.init("127.0.0.1", 6380));
+  raw.set_timeout(3);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.start());
+  raw.proc(1, 0);
+
+  std::string large_value(HIREDIS_HAPP_CMD_REFERENCE_SIZE, 'v');
+  const char *argv[] = {"SET", "key", large_value.c_str()};
+  size_t argvlen[] = {3, 3, large_value.size()};
+  int release_count = 0;
+
+  hiredis::happ::cmd_exec *cmd =
+      raw.exec_reference(nullptr, nullptr, 3, argv, argvlen, happ_raw_count_release, &release_count);
+  CASE_EXPECT_NE(nullptr, cmd);
+  CASE_EXPECT_EQ(0, release_count);
+
+  // the whole command is written into output buffer of hiredis
+  CASE_EXPECT_NE(nullptr, raw.get_connection());
+  if (nullptr != raw.get_connection()) {
+    sds obuf = raw.get_connection()->get_context()->c.obuf;
+    std::string expect = std::string("*3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$") + std::to_string(large_value.size()) +
+                         "\r\n" + large_value + "\r\n";
+    CASE_EXPECT_GE(sdslen(obuf), expect.size());
+    CASE_EXPECT_TRUE(expect == std::string(obuf + sdslen(obuf) - expect.size(), expect.size()));
+  }
+
+  // connect timeout, the referenced argument is released with the cmd
+  raw.proc(5, 0);
+  CASE_EXPECT_EQ(1, release_count);
+  raw.reset();
+}
+
+CASE_TEST(happ_raw, exec_callable) {
+  hiredis::happ::raw raw;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.init("127.0.0.1", 6380));
+  raw.set_timeout(3);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.start());
+  raw.proc(1, 0);
+
+  std::vector<int> results;
+  std::unique_ptr<std::string> key(new std::string("key"));
+  const char *argv[] = {"GET", "key"};
+  size_t argvlen[] = {3, 3};
+
+  hiredis::happ::cmd_exec *cmd =
+      raw.exec([&results, key = std::move(key)](hiredis::happ::cmd_exec *c, redisAsyncContext *,
+                                                void *) { results.push_back(c->result()); },
+               2, argv, argvlen);
+  CASE_EXPECT_NE(nullptr, cmd);
+
+  cmd = raw.exec([&results](hiredis::happ::cmd_exec *c, redisAsyncContext *, void *) { results.push_back(c->result()); },
+                 "SET %s %d", "key", 1);
+  CASE_EXPECT_NE(nullptr, cmd);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), results.size());
+
+  // connect timeout, both callbacks are called once
+  raw.proc(5, 0);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    CASE_EXPECT_NE(hiredis::happ::error_code::REDIS_HAPP_OK, results[i]);
+  }
+  raw.reset();
+}
+
+CASE_TEST(happ_raw, exec_typed_arguments) {
+  hiredis::happ::raw raw;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.init("127.0.0.1", 6380));
+  raw.set_timeout(3);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.start());
+  raw.proc(1, 0);
+
+  std::vector<int> results;
+  std::string_view field("field");
+  hiredis::happ::cmd_exec *cmd =
+      raw.exec(nullptr, nullptr, hiredis::happ::cmd_literal("HSET"), "key", field, 42, 3.14);
+  CASE_EXPECT_NE(nullptr, cmd);
+
+  // the encoded command is written into output buffer of hiredis
+  CASE_EXPECT_NE(nullptr, raw.get_connection());
+  if (nullptr != raw.get_connection()) {
+    sds obuf = raw.get_connection()->get_context()->c.obuf;
+    std::string expect = "*5\r\n$4\r\nHSET\r\n$3\r\nkey\r\n$5\r\nfield\r\n$2\r\n42\r\n$4\r\n3.14\r\n";
+    CASE_EXPECT_GE(sdslen(obuf), expect.size());
+    CASE_EXPECT_TRUE(expect == std::string(obuf + sdslen(obuf) - expect.size(), expect.size()));
+  }
+
+  cmd = raw.exec([&results](hiredis::happ::cmd_exec *c, redisAsyncContext *, void *) { results.push_back(c->result()); },
+                 hiredis::happ::cmd_literal("INCRBY"), "key", -1);
+  CASE_EXPECT_NE(nullptr, cmd);
+
+  // connect timeout
+  raw.proc(5, 0);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), results.size());
+  raw.reset();
+}
@@ -0,0 +1,135 @@
+#include <detail/happ_reply_arena.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+static redisReader *happ_reply_arena_make_reader(hiredis::happ::reply_arena *arena) {
+  redisReader *reader = redisReaderCreateWithFunctions(hiredis::happ::reply_arena::get_reply_functions());
+  if (nullptr != reader) {
+    reader->privdata = arena;
+  }
+  return reader;
+}
+
+CASE_TEST(happ_reply_arena, build_and_reset) {
+  hiredis::happ::reply_arena *arena = hiredis::happ::reply_arena::create(4096);
+  CASE_EXPECT_NE(nullptr, arena);
+  redisReader *reader = happ_reply_arena_make_reader(arena);
+  CASE_EXPECT_NE(nullptr, reader);
+
+  const char resp[] = "*4\r\n$3\r\nfoo\r\n:42\r\n*2\r\n$-1\r\n+OK\r\n-ERR bad\r\n";
+  CASE_EXPECT_EQ(REDIS_OK, redisReaderFeed(reader, resp, sizeof(resp) - 1));
+
+  void *out = nullptr;
+  CASE_EXPECT_EQ(REDIS_OK, redisReaderGetReply(reader, &out));
+  redisReply *reply = reinterpret_cast<redisReply *>(out);
+  CASE_EXPECT_NE(nullptr, reply);
+  if (nullptr != reply) {
+    CASE_EXPECT_EQ(REDIS_REPLY_ARRAY, reply->type);
+    CASE_EXPECT_EQ(static_cast<size_t>(4), reply->elements);
+    CASE_EXPECT_EQ(REDIS_REPLY_STRING, reply->element[0]->type);
+    CASE_EXPECT_TRUE(std::string("foo") == std::string(reply->element[0]->str, reply->element[0]->len));
+    CASE_EXPECT_EQ(REDIS_REPLY_INTEGER, reply->element[1]->type);
+    CASE_EXPECT_EQ(42, reply->element[1]->integer);
+    CASE_EXPECT_EQ(REDIS_REPLY_ARRAY, reply->element[2]->type);
+    CASE_EXPECT_EQ(REDIS_REPLY_NIL, reply->element[2]->element[0]->type);
+    CASE_EXPECT_EQ(REDIS_REPLY_STATUS, reply->element[2]->element[1]->type);
+    CASE_EXPECT_EQ(0, strcmp("OK", reply->element[2]->element[1]->str));
+    CASE_EXPECT_EQ(REDIS_REPLY_ERROR, reply->element[3]->type);
+    CASE_EXPECT_EQ(0, strcmp("ERR bad", reply->element[3]->str));
+  }
+
+  // all objects come from one chunk
+  CASE_EXPECT_EQ(static_cast<size_t>(1), arena->get_stats().system_allocations);
+  CASE_EXPECT_LE(static_cast<size_t>(9), arena->get_stats().allocations);
+
+  // only freeing the root reply resets the arena
+  hiredis::happ::reply_arena::get_reply_functions()->freeObject(reply->element[0]);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), arena->get_stats().reset_count);
+  hiredis::happ::reply_arena::get_reply_functions()->freeObject(reply);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), arena->get_stats().reset_count);
+
+  // the chunk is reused by the next reply
+  CASE_EXPECT_EQ(REDIS_OK, redisReaderFeed(reader, ":7\r\n", 4));
+  CASE_EXPECT_EQ(REDIS_OK, redisReaderGetReply(reader, &out));
+  CASE_EXPECT_NE(nullptr, out);
+  if (nullptr != out) {
+    CASE_EXPECT_EQ(7, reinterpret_cast<redisReply *>(out)->integer);
+  }
+  hiredis::happ::reply_arena::get_reply_functions()->freeObject(out);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), arena->get_stats().system_allocations);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), arena->get_stats().reset_count);
+
+  redisReaderFree(reader);
+  hiredis::happ::reply_arena::release(arena);
+}
+
+CASE_TEST(happ_reply_arena, large_reply_merge_chunks) {
+  hiredis::happ::reply_arena *arena = hiredis::happ::reply_arena::create(1024);
+  redisReader *reader = happ_reply_arena_make_reader(arena);
+
+  // HGETALL with 1000 fields
+  std::string resp = "*2000\r\n";
+  for (int i = 0; i < 1000; ++i) {
+    char field[64];
+    snprintf(field, sizeof(field), "field-%d", i);
+    resp += "$" + std::to_string(strlen(field)) + "\r\n" + field + "\r\n";
+    resp += "$5\r\nvalue\r\n";
+  }
+
+  for (int round = 0; round < 2; ++round) {
+    size_t system_allocations = arena->get_stats().system_allocations;
+    CASE_EXPECT_EQ(REDIS_OK, redisReaderFeed(reader, resp.c_str(), resp.size()));
+    void *out = nullptr;
+    CASE_EXPECT_EQ(REDIS_OK, redisReaderGetReply(reader, &out));
+    redisReply *reply = reinterpret_cast<redisReply *>(out);
+    CASE_EXPECT_NE(nullptr, reply);
+    if (nullptr == reply) {
+      break;
+    }
+
+    CASE_EXPECT_EQ(static_cast<size_t>(2000), reply->elements);
+    CASE_EXPECT_EQ(0, strcmp("field-999", reply->element[1998]->str));
+    CASE_EXPECT_EQ(0, strcmp("value", reply->element[1999]->str));
+
+    if (0 == round) {
+      // chunks grow by doubling
+      CASE_EXPECT_LT(system_allocations + 1, arena->get_stats().system_allocations);
+      CASE_EXPECT_GT(static_cast<size_t>(16), arena->get_stats().system_allocations);
+    } else {
+      // chunks are merged after the first round
+      CASE_EXPECT_EQ(system_allocations, arena->get_stats().system_allocations);
+    }
+
+    hiredis::happ::reply_arena::get_reply_functions()->freeObject(reply);
+    CASE_EXPECT_EQ(static_cast<size_t>(1), arena->get_stats().chunk_count);
+  }
+
+  redisReaderFree(reader);
+  hiredis::happ::reply_arena::release(arena);
+}
+
+CASE_TEST(happ_reply_arena, attach_to_connection) {
+  hiredis::happ::raw raw;
+  CASE_EXPECT_EQ(static_cast<size_t>(0), raw.get_reply_arena_chunk_size());
+  raw.set_reply_arena_chunk_size(8192);
+  CASE_EXPECT_EQ(static_cast<size_t>(8192), raw.get_reply_arena_chunk_size());
+
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.init("127.0.0.1", 6380));
+  CASE_EXPECT_NE(nullptr, raw.make_connection());
+  if (nullptr != raw.get_connection()) {
+    redisAsyncContext *c = raw.get_connection()->get_context();
+    hiredis::happ::reply_arena *arena = hiredis::happ::reply_arena::get(c);
+    CASE_EXPECT_NE(nullptr, arena);
+    CASE_EXPECT_EQ(hiredis::happ::reply_arena::get_reply_functions(), c->c.reader->fn);
+
+    // attach again is not allowed
+    CASE_EXPECT_EQ(nullptr, hiredis::happ::reply_arena::attach(c, 8192));
+  }
+
+  // arena is released with the hiredis context
+  CASE_EXPECT_TRUE(raw.release_connection(true, hiredis::happ::error_code::REDIS_HAPP_OK));
+}
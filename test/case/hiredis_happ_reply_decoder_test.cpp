@@ -0,0 +1,194 @@
+#include <cstring>
+#include <map>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+static redisReply *happ_reply_decoder_parse(const std::string &resp) {
+  redisReader *reader = redisReaderCreate();
+  void *out = nullptr;
+  if (REDIS_OK != redisReaderFeed(reader, resp.c_str(), resp.size()) ||
+      REDIS_OK != redisReaderGetReply(reader, &out)) {
+    out = nullptr;
+  }
+  redisReaderFree(reader);
+  return reinterpret_cast<redisReply *>(out);
+}
+
+CASE_TEST(happ_reply_decoder, scalars) {
+  redisReply *reply = happ_reply_decoder_parse("$5\r\nhello\r\n");
+  CASE_EXPECT_NE(nullptr, reply);
+
+  // string views point to the reply
+  std::string_view view;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, view));
+  CASE_EXPECT_TRUE("hello" == view);
+  CASE_EXPECT_TRUE(reply->str == view.data());
+
+  std::string str;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, str));
+  CASE_EXPECT_EQ("hello", str);
+
+  int64_t i64 = 0;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, hiredis::happ::decode_reply(reply, i64));
+  freeReplyObject(reply);
+
+  // numbers in strings
+  reply = happ_reply_decoder_parse("$3\r\n-42\r\n");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, i64));
+  CASE_EXPECT_EQ(-42, i64);
+  uint32_t u32 = 0;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, hiredis::happ::decode_reply(reply, u32));
+  double dv = 0.0;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, dv));
+  CASE_EXPECT_EQ(-42.0, dv);
+  freeReplyObject(reply);
+
+  reply = happ_reply_decoder_parse("$4\r\n2.5x\r\n");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, hiredis::happ::decode_reply(reply, dv));
+  freeReplyObject(reply);
+
+  // integers out of range
+  reply = happ_reply_decoder_parse(":300\r\n");
+  uint8_t u8 = 0;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, hiredis::happ::decode_reply(reply, u8));
+  int16_t i16 = 0;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, i16));
+  CASE_EXPECT_EQ(300, i16);
+  bool bv = false;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, hiredis::happ::decode_reply(reply, bv));
+  freeReplyObject(reply);
+
+  reply = happ_reply_decoder_parse(":1\r\n");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, bv));
+  CASE_EXPECT_TRUE(bv);
+  freeReplyObject(reply);
+
+  // nil and errors
+  reply = happ_reply_decoder_parse("$-1\r\n");
+  std::optional<std::string_view> opt = std::string_view("x");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, opt));
+  CASE_EXPECT_FALSE(opt.has_value());
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, hiredis::happ::decode_reply(reply, view));
+  freeReplyObject(reply);
+
+  reply = happ_reply_decoder_parse("-ERR wrong type\r\n");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, hiredis::happ::decode_reply(reply, opt));
+  const redisReply *raw_reply = nullptr;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, raw_reply));
+  CASE_EXPECT_EQ(reply, raw_reply);
+  freeReplyObject(reply);
+
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, hiredis::happ::decode_reply(nullptr, view));
+}
+
+CASE_TEST(happ_reply_decoder, aggregates) {
+  // LRANGE
+  redisReply *reply = happ_reply_decoder_parse("*3\r\n$1\r\na\r\n$-1\r\n$1\r\nc\r\n");
+  std::vector<std::optional<std::string_view> > list;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, list));
+  CASE_EXPECT_EQ(static_cast<size_t>(3), list.size());
+  if (3 == list.size()) {
+    CASE_EXPECT_TRUE(list[0].has_value() && "a" == *list[0]);
+    CASE_EXPECT_FALSE(list[1].has_value());
+    CASE_EXPECT_TRUE(list[2].has_value() && "c" == *list[2]);
+  }
+
+  // nil element can not be decoded without optional
+  std::vector<std::string_view> views;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, hiredis::happ::decode_reply(reply, views));
+  freeReplyObject(reply);
+
+  // HGETALL
+  reply = happ_reply_decoder_parse("*4\r\n$2\r\nf1\r\n$1\r\n1\r\n$2\r\nf2\r\n$1\r\n2\r\n");
+  std::map<std::string_view, int> fields;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, fields));
+  CASE_EXPECT_EQ(static_cast<size_t>(2), fields.size());
+  CASE_EXPECT_EQ(1, fields["f1"]);
+  CASE_EXPECT_EQ(2, fields["f2"]);
+  freeReplyObject(reply);
+
+  // odd number of elements is not a map
+  reply = happ_reply_decoder_parse("*3\r\n$2\r\nf1\r\n$1\r\n1\r\n$2\r\nf2\r\n");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, hiredis::happ::decode_reply(reply, fields));
+  freeReplyObject(reply);
+
+  // ZRANGE WITHSCORES in RESP2 and RESP3
+  std::vector<std::pair<std::string_view, double> > scores;
+  reply = happ_reply_decoder_parse("*4\r\n$1\r\na\r\n$3\r\n1.5\r\n$1\r\nb\r\n$1\r\n2\r\n");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, scores));
+  CASE_EXPECT_TRUE(2 == scores.size() && "b" == scores[1].first && 2.0 == scores[1].second);
+  freeReplyObject(reply);
+
+  reply = happ_reply_decoder_parse("*2\r\n*2\r\n$1\r\na\r\n,1.5\r\n*2\r\n$1\r\nb\r\n,2\r\n");
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, scores));
+  CASE_EXPECT_TRUE(2 == scores.size() && "a" == scores[0].first && 1.5 == scores[0].second);
+
+  std::unordered_map<std::string, double> score_map;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, score_map));
+  CASE_EXPECT_EQ(1.5, score_map["a"]);
+  freeReplyObject(reply);
+
+  // SCAN
+  reply = happ_reply_decoder_parse("*2\r\n$2\r\n17\r\n*2\r\n$1\r\nx\r\n$1\r\ny\r\n");
+  std::pair<uint64_t, std::vector<std::string_view> > scan;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, hiredis::happ::decode_reply(reply, scan));
+  CASE_EXPECT_EQ(17, scan.first);
+  CASE_EXPECT_TRUE(2 == scan.second.size() && "y" == scan.second[1]);
+
+  std::pair<uint64_t, std::string_view> bad_scan;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, hiredis::happ::decode_reply(reply, bad_scan));
+  freeReplyObject(reply);
+}
+
+struct happ_reply_decoder_callback_state {
+  int status;
+  std::vector<std::string> values;
+};
+
+static void happ_reply_decoder_on_list(hiredis::happ::cmd_exec *, int status, std::vector<std::string_view> &value,
+                                       void *private_data) {
+  happ_reply_decoder_callback_state *state = reinterpret_cast<happ_reply_decoder_callback_state *>(private_data);
+  state->status = status;
+  state->values.clear();
+  for (size_t i = 0; i < value.size(); ++i) {
+    state->values.push_back(std::string(value[i]));
+  }
+}
+
+CASE_TEST(happ_reply_decoder, typed_callback) {
+  happ_reply_decoder_callback_state state;
+  hiredis::happ::holder_t holder;
+  holder.r = nullptr;
+
+  // decoded
+  hiredis::happ::cmd_exec *cmd = hiredis::happ::cmd_exec::create(
+      holder, hiredis::happ::typed_callback<happ_reply_decoder_on_list>, &state, 0);
+  redisReply *reply = happ_reply_decoder_parse("*2\r\n$1\r\na\r\n$1\r\nb\r\n");
+  cmd->call_reply(hiredis::happ::error_code::REDIS_HAPP_OK, nullptr, reply);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, state.status);
+  CASE_EXPECT_TRUE(2 == state.values.size() && "b" == state.values[1]);
+  freeReplyObject(reply);
+  hiredis::happ::cmd_exec::destroy(cmd);
+
+  // type mismatch
+  cmd = hiredis::happ::cmd_exec::create(holder, hiredis::happ::typed_callback<happ_reply_decoder_on_list>, &state, 0);
+  reply = happ_reply_decoder_parse("*2\r\n$1\r\na\r\n:1\r\n");
+  cmd->call_reply(hiredis::happ::error_code::REDIS_HAPP_OK, nullptr, reply);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TYPE_MISMATCH, state.status);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), state.values.size());
+  freeReplyObject(reply);
+  hiredis::happ::cmd_exec::destroy(cmd);
+
+  // the error of cmd is passed through
+  cmd = hiredis::happ::cmd_exec::create(holder, hiredis::happ::typed_callback<happ_reply_decoder_on_list>, &state, 0);
+  cmd->call_reply(hiredis::happ::error_code::REDIS_HAPP_TIMEOUT, nullptr, nullptr);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TIMEOUT, state.status);
+  hiredis::happ::cmd_exec::destroy(cmd);
+}
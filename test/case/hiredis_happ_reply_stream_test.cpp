@@ -0,0 +1,234 @@
+#include <detail/happ_reply_stream.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+struct happ_reply_stream_test_state {
+  std::vector<std::string> values;
+  std::vector<size_t> indexes;
+  std::vector<int> types;
+  size_t max_live_objects;
+  hiredis::happ::reply_stream *stream;
+};
+
+static void happ_reply_stream_test_cmd_fn(redisAsyncContext *, void *, void *) {}
+
+static void happ_reply_stream_test_visitor(hiredis::happ::cmd_exec *, const redisReply *element, size_t index,
+                                           void *private_data) {
+  happ_reply_stream_test_state *state = reinterpret_cast<happ_reply_stream_test_state *>(private_data);
+  state->indexes.push_back(index);
+  state->types.push_back(element->type);
+  if (REDIS_REPLY_ARRAY == element->type) {
+    std::string value;
+    for (size_t i = 0; i < element->elements; ++i) {
+      value += std::string(element->element[i]->str, element->element[i]->len) + ";";
+    }
+    state->values.push_back(value);
+  } else if (nullptr != element->str) {
+    state->values.push_back(std::string(element->str, element->len));
+  } else {
+    state->values.push_back(std::string());
+  }
+
+  if (state->stream->get_stats().live_objects > state->max_live_objects) {
+    state->max_live_objects = state->stream->get_stats().live_objects;
+  }
+}
+
+// a hiredis context whose first callback belongs to cmd
+struct happ_reply_stream_test_context {
+  redisAsyncContext context;
+  redisCallback callback;
+  hiredis::happ::cmd_exec *cmd;
+  hiredis::happ::reply_stream *stream;
+  redisReader *reader;
+
+  explicit happ_reply_stream_test_context(happ_reply_stream_test_state *state) {
+    memset(&context, 0, sizeof(context));
+    memset(&callback, 0, sizeof(callback));
+
+    hiredis::happ::holder_t holder;
+    holder.r = nullptr;
+    cmd = hiredis::happ::cmd_exec::create(holder, nullptr, state, 0);
+    callback.fn = happ_reply_stream_test_cmd_fn;
+    callback.privdata = cmd;
+    context.replies.head = &callback;
+    context.replies.tail = &callback;
+
+    stream = hiredis::happ::reply_stream::create(happ_reply_stream_test_cmd_fn);
+    stream->set_context(&context);
+    state->stream = stream;
+
+    reader = redisReaderCreateWithFunctions(hiredis::happ::reply_stream::get_reply_functions());
+    reader->privdata = stream;
+  }
+
+  ~happ_reply_stream_test_context() {
+    redisReaderFree(reader);
+    hiredis::happ::reply_stream::release(stream);
+    hiredis::happ::cmd_exec::destroy(cmd);
+  }
+
+  redisReply *parse(const std::string &resp) {
+    if (REDIS_OK != redisReaderFeed(reader, resp.c_str(), resp.size())) {
+      return nullptr;
+    }
+
+    void *out = nullptr;
+    if (REDIS_OK != redisReaderGetReply(reader, &out)) {
+      return nullptr;
+    }
+    return reinterpret_cast<redisReply *>(out);
+  }
+};
+
+CASE_TEST(happ_reply_stream, stream_hgetall) {
+  happ_reply_stream_test_state state;
+  state.max_live_objects = 0;
+  happ_reply_stream_test_context ctx(&state);
+  ctx.cmd->set_stream_visitor(happ_reply_stream_test_visitor);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), ctx.cmd->get_stream_depth());
+
+  // HGETALL with 1000 fields
+  std::string resp = "*2000\r\n";
+  for (int i = 0; i < 1000; ++i) {
+    char field[64];
+    snprintf(field, sizeof(field), "field-%d", i);
+    resp += "$" + std::to_string(strlen(field)) + "\r\n" + field + "\r\n";
+    resp += "$5\r\nvalue\r\n";
+  }
+
+  redisReply *reply = ctx.parse(resp);
+  CASE_EXPECT_NE(nullptr, reply);
+  if (nullptr == reply) {
+    return;
+  }
+
+  // the final reply keeps only the count
+  CASE_EXPECT_EQ(REDIS_REPLY_ARRAY, reply->type);
+  CASE_EXPECT_EQ(static_cast<size_t>(2000), reply->elements);
+  CASE_EXPECT_EQ(nullptr, reply->element);
+
+  CASE_EXPECT_EQ(static_cast<size_t>(2000), state.values.size());
+  CASE_EXPECT_TRUE(state.values.size() == 2000 && "field-999" == state.values[1998] && "value" == state.values[1999]);
+  CASE_EXPECT_TRUE(state.indexes.size() == 2000 && 1998 == state.indexes[1998]);
+
+  // only the root and the element being delivered are alive
+  CASE_EXPECT_EQ(static_cast<size_t>(2), state.max_live_objects);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), ctx.stream->get_stats().peak_live_objects);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), ctx.stream->get_stats().streamed_replies);
+  CASE_EXPECT_EQ(static_cast<size_t>(2000), ctx.stream->get_stats().streamed_elements);
+
+  hiredis::happ::reply_stream::get_reply_functions()->freeObject(reply);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), ctx.stream->get_stats().live_objects);
+}
+
+CASE_TEST(happ_reply_stream, stream_nested_elements) {
+  happ_reply_stream_test_state state;
+  state.max_live_objects = 0;
+  happ_reply_stream_test_context ctx(&state);
+
+  // SCAN: the key list in the second element is streamed
+  ctx.cmd->set_stream_visitor(happ_reply_stream_test_visitor, 2);
+  redisReply *reply = ctx.parse("*2\r\n$2\r\n17\r\n*3\r\n$1\r\na\r\n$1\r\nb\r\n$1\r\nc\r\n");
+  CASE_EXPECT_NE(nullptr, reply);
+  if (nullptr != reply) {
+    CASE_EXPECT_EQ(static_cast<size_t>(2), reply->elements);
+    CASE_EXPECT_EQ(0, strcmp("17", reply->element[0]->str));
+    CASE_EXPECT_EQ(static_cast<size_t>(3), reply->element[1]->elements);
+    CASE_EXPECT_EQ(nullptr, reply->element[1]->element);
+    hiredis::happ::reply_stream::get_reply_functions()->freeObject(reply);
+  }
+
+  CASE_EXPECT_EQ(static_cast<size_t>(3), state.values.size());
+  CASE_EXPECT_TRUE(state.values.size() == 3 && "a" == state.values[0] && "c" == state.values[2]);
+  CASE_EXPECT_TRUE(state.indexes.size() == 3 && 2 == state.indexes[2]);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), ctx.stream->get_stats().live_objects);
+
+  // aggregate elements are delivered when they are complete, empty and nil elements are delivered immediately
+  state.values.clear();
+  state.indexes.clear();
+  state.types.clear();
+  ctx.cmd->set_stream_visitor(happ_reply_stream_test_visitor, 1);
+  reply = ctx.parse("*4\r\n*2\r\n$1\r\nx\r\n$3\r\n1.5\r\n*0\r\n$-1\r\n*2\r\n$1\r\ny\r\n$1\r\n2\r\n");
+  CASE_EXPECT_NE(nullptr, reply);
+  if (nullptr != reply) {
+    CASE_EXPECT_EQ(static_cast<size_t>(4), reply->elements);
+    hiredis::happ::reply_stream::get_reply_functions()->freeObject(reply);
+  }
+
+  CASE_EXPECT_EQ(static_cast<size_t>(4), state.values.size());
+  if (4 == state.values.size()) {
+    CASE_EXPECT_EQ("x;1.5;", state.values[0]);
+    CASE_EXPECT_EQ("", state.values[1]);
+    CASE_EXPECT_EQ(REDIS_REPLY_NIL, state.types[2]);
+    CASE_EXPECT_EQ("y;2;", state.values[3]);
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(0), ctx.stream->get_stats().live_objects);
+}
+
+CASE_TEST(happ_reply_stream, build_whole_reply_without_visitor) {
+  happ_reply_stream_test_state state;
+  state.max_live_objects = 0;
+  happ_reply_stream_test_context ctx(&state);
+
+  // cmd without visitor
+  redisReply *reply = ctx.parse("*2\r\n$1\r\na\r\n:3\r\n");
+  CASE_EXPECT_NE(nullptr, reply);
+  if (nullptr != reply) {
+    CASE_EXPECT_EQ(static_cast<size_t>(2), reply->elements);
+    CASE_EXPECT_EQ(0, strcmp("a", reply->element[0]->str));
+    CASE_EXPECT_EQ(3, reply->element[1]->integer);
+    hiredis::happ::reply_stream::get_reply_functions()->freeObject(reply);
+  }
+
+  // callbacks not sent by cluster or raw
+  ctx.cmd->set_stream_visitor(happ_reply_stream_test_visitor);
+  ctx.callback.fn = nullptr;
+  reply = ctx.parse("*1\r\n$1\r\na\r\n");
+  CASE_EXPECT_NE(nullptr, reply);
+  if (nullptr != reply) {
+    CASE_EXPECT_EQ(0, strcmp("a", reply->element[0]->str));
+    hiredis::happ::reply_stream::get_reply_functions()->freeObject(reply);
+  }
+
+  // pub/sub mode
+  ctx.callback.fn = happ_reply_stream_test_cmd_fn;
+  ctx.context.c.flags |= REDIS_SUBSCRIBED;
+  reply = ctx.parse("*1\r\n$1\r\na\r\n");
+  CASE_EXPECT_NE(nullptr, reply);
+  if (nullptr != reply) {
+    CASE_EXPECT_EQ(0, strcmp("a", reply->element[0]->str));
+    hiredis::happ::reply_stream::get_reply_functions()->freeObject(reply);
+  }
+
+  CASE_EXPECT_EQ(static_cast<size_t>(0), state.values.size());
+  CASE_EXPECT_EQ(static_cast<size_t>(0), ctx.stream->get_stats().streamed_replies);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), ctx.stream->get_stats().live_objects);
+}
+
+CASE_TEST(happ_reply_stream, attach_to_connection) {
+  hiredis::happ::raw raw;
+  CASE_EXPECT_FALSE(raw.is_reply_stream_enabled());
+  raw.set_reply_stream(true);
+  raw.set_reply_arena_chunk_size(8192);
+  CASE_EXPECT_TRUE(raw.is_reply_stream_enabled());
+
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.init("127.0.0.1", 6380));
+  CASE_EXPECT_NE(nullptr, raw.make_connection());
+  if (nullptr != raw.get_connection()) {
+    redisAsyncContext *c = raw.get_connection()->get_context();
+    CASE_EXPECT_NE(nullptr, hiredis::happ::reply_stream::get(c));
+    CASE_EXPECT_EQ(hiredis::happ::reply_stream::get_reply_functions(), c->c.reader->fn);
+
+    // reply arena can not be used together with it
+    CASE_EXPECT_EQ(nullptr, hiredis::happ::reply_arena::get(c));
+    CASE_EXPECT_EQ(nullptr, hiredis::happ::reply_arena::attach(c, 8192));
+  }
+
+  CASE_EXPECT_TRUE(raw.release_connection(true, hiredis::happ::error_code::REDIS_HAPP_OK));
+}
@@ -0,0 +1,154 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+#include "test_slot_ranges.h"
+
+// what CLUSTER SLOTS does in a shard
+static void happ_sharded_load_slots(hiredis::happ::cluster *shard,
+                                    const std::vector<hiredis::happ::cluster::slot_range_t> &ranges) {
+  shard->update_slots(ranges);
+  hiredis::happ::cluster::onslotsupdated_fn_t fn = shard->set_on_slots_updated(nullptr);
+  shard->set_on_slots_updated(fn);
+  CASE_EXPECT_TRUE(!!fn);
+  if (fn) {
+    fn(shard);
+  }
+}
+
+CASE_TEST(happ_sharded_cluster, route_and_share_topology) {
+  hiredis::happ::sharded_cluster clu;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, clu.init("127.0.0.1", 7000, 0));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, clu.init("127.0.0.1", 7000, 4));
+  CASE_EXPECT_EQ(static_cast<size_t>(4), clu.get_shard_count());
+  CASE_EXPECT_EQ(nullptr, clu.get_shard(4));
+  CASE_EXPECT_EQ(static_cast<uint64_t>(0), clu.get_topology_version());
+  CASE_EXPECT_EQ(nullptr, clu.get_topology().get());
+
+  // slots are split into ranges before the topology is loaded
+  CASE_EXPECT_EQ(static_cast<size_t>(0), clu.get_shard_index(0));
+  CASE_EXPECT_EQ(static_cast<size_t>(3), clu.get_shard_index(HIREDIS_HAPP_SLOT_NUMBER - 1));
+  CASE_EXPECT_NE(clu.get_shard_index(-1), clu.get_shard_index(-1));
+
+  // 8 masters are split into 4 shards
+  std::vector<hiredis::happ::cluster::slot_range_t> ranges = hiredis_happ_test::make_slot_ranges(7000, 8);
+  happ_sharded_load_slots(clu.get_shard(1), ranges);
+  CASE_EXPECT_EQ(static_cast<uint64_t>(1), clu.get_topology_version());
+  CASE_EXPECT_NE(nullptr, clu.get_topology().get());
+  if (nullptr != clu.get_topology().get()) {
+    CASE_EXPECT_EQ(static_cast<size_t>(8), clu.get_topology()->size());
+  }
+
+  std::vector<size_t> master_count(4, 0);
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    size_t shard_index = clu.get_shard_index(ranges[i].start);
+    CASE_EXPECT_LT(shard_index, static_cast<size_t>(4));
+    if (shard_index < master_count.size()) {
+      ++master_count[shard_index];
+    }
+
+    // all slots of a master go to the same shard
+    CASE_EXPECT_EQ(shard_index, clu.get_shard_index(ranges[i].end));
+  }
+  for (size_t i = 0; i < master_count.size(); ++i) {
+    CASE_EXPECT_EQ(static_cast<size_t>(2), master_count[i]);
+  }
+
+  // other shards apply the topology in their own loops
+  CASE_EXPECT_TRUE(clu.get_shard(0)->get_slot_by_key("a", 1)->hosts.empty());
+  CASE_EXPECT_FALSE(clu.get_shard(1)->get_slot_by_key("a", 1)->hosts.empty());
+  for (size_t i = 0; i < clu.get_shard_count(); ++i) {
+    CASE_EXPECT_EQ(1 == i ? static_cast<size_t>(0) : static_cast<size_t>(1),
+                   clu.get_shard(i)->get_submit_queue().drain());
+    CASE_EXPECT_TRUE("127.0.0.1:7000" == clu.get_shard(i)->get_slot_master(0)->name);
+    CASE_EXPECT_TRUE("127.0.0.1:7007" == clu.get_shard(i)->get_slot_master(HIREDIS_HAPP_SLOT_NUMBER - 1)->name);
+  }
+
+  // shards never connect to masters of other shards, cmds of their slots fail at once
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    size_t other = (clu.get_shard_index(ranges[i].start) + 1) % clu.get_shard_count();
+    CASE_EXPECT_EQ(nullptr, clu.get_shard(other)->make_connection(ranges[i].hosts[0]));
+  }
+
+  size_t key_owner = clu.get_shard_index("a", 1);
+  int result = hiredis::happ::error_code::REDIS_HAPP_OK;
+  CASE_EXPECT_EQ(nullptr, clu.get_shard((key_owner + 1) % clu.get_shard_count())
+                              ->exec("a", 1,
+                                     [&result](hiredis::happ::cmd_exec *cmd, redisAsyncContext *, void *) {
+                                       result = cmd->result();
+                                     },
+                                     "GET %s", "a"));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_SLOT_UNAVAILABLE, result);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), clu.get_shard((key_owner + 1) % clu.get_shard_count())->get_connection_size());
+
+  // masters keep their shards after the topology changed, and stale topologies are skipped
+  size_t first_shard = clu.get_shard_index(0);
+  std::vector<hiredis::happ::cluster::slot_range_t> moved = ranges;
+  moved[1].hosts = moved[0].hosts;
+  happ_sharded_load_slots(clu.get_shard(2), ranges);
+  happ_sharded_load_slots(clu.get_shard(3), moved);
+  CASE_EXPECT_EQ(static_cast<uint64_t>(3), clu.get_topology_version());
+  CASE_EXPECT_EQ(first_shard, clu.get_shard_index(0));
+  CASE_EXPECT_EQ(first_shard, clu.get_shard_index(ranges[1].start));
+  for (size_t i = 0; i < clu.get_shard_count(); ++i) {
+    clu.get_shard(i)->get_submit_queue().drain();
+    CASE_EXPECT_TRUE("127.0.0.1:7000" == clu.get_shard(i)->get_slot_master(ranges[1].start)->name);
+  }
+}
+
+CASE_TEST(happ_sharded_cluster, loop_threads) {
+  hiredis::happ::sharded_cluster clu;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, clu.init("127.0.0.1", 7000, 3));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, clu.start(hiredis::happ::sharded_cluster::loop_fn_t()));
+
+  std::vector<std::thread::id> loop_threads(clu.get_shard_count());
+  std::atomic<size_t> started(0);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK,
+                 clu.start([&clu, &loop_threads, &started](size_t index, hiredis::happ::cluster &shard) {
+                   loop_threads[index] = std::this_thread::get_id();
+                   ++started;
+                   while (clu.is_running()) {
+                     if (0 == shard.get_submit_queue().on_wakeup()) {
+                       std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                     }
+                   }
+                 }));
+  CASE_EXPECT_TRUE(clu.is_running());
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM,
+                 clu.start([](size_t, hiredis::happ::cluster &) {}));
+
+  while (started.load() < clu.get_shard_count()) {
+    std::this_thread::yield();
+  }
+
+  // tasks of a key run in the loop thread of its shard
+  const char *keys[] = {"a", "b", "c", "user:{1000}", "user:{1000}:profile"};
+  std::vector<std::thread::id> run_threads(sizeof(keys) / sizeof(keys[0]));
+  std::atomic<size_t> run_count(0);
+  for (size_t i = 0; i < run_threads.size(); ++i) {
+    CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK,
+                   clu.post(keys[i], strlen(keys[i]), [&run_threads, &run_count, i](hiredis::happ::cluster *) {
+                     run_threads[i] = std::this_thread::get_id();
+                     ++run_count;
+                   }));
+  }
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, clu.post(3, [](hiredis::happ::cluster *) {}));
+
+  while (run_count.load() < run_threads.size()) {
+    std::this_thread::yield();
+  }
+
+  for (size_t i = 0; i < run_threads.size(); ++i) {
+    CASE_EXPECT_TRUE(loop_threads[clu.get_shard_index(keys[i], strlen(keys[i]))] == run_threads[i]);
+  }
+  CASE_EXPECT_TRUE(run_threads[3] == run_threads[4]);
+
+  clu.stop();
+  CASE_EXPECT_FALSE(clu.is_running());
+}
@@ -0,0 +1,114 @@
+#include <atomic>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+#include "test_slot_ranges.h"
+
+CASE_TEST(happ_slot_map, snapshot) {
+  hiredis::happ::cluster clu;
+  clu.init("127.0.0.1", 7000);
+  CASE_EXPECT_FALSE(!!clu.get_slot_map());
+
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK,
+                 clu.update_slots(hiredis_happ_test::make_slot_ranges(7000, 3, true)));
+  hiredis::happ::slot_map_ref first = clu.get_slot_map();
+  CASE_EXPECT_TRUE(!!first);
+  if (!first) {
+    return;
+  }
+
+  CASE_EXPECT_EQ(static_cast<size_t>(HIREDIS_HAPP_SLOT_NUMBER), first->get_slot_count());
+  CASE_EXPECT_EQ(static_cast<size_t>(2), first->get_host_count(0));
+  CASE_EXPECT_TRUE("127.0.0.1:7000" == first->get_master(0)->name);
+  CASE_EXPECT_TRUE("127.0.0.2:7000" == first->get_host(0, 1)->name);
+  CASE_EXPECT_EQ(nullptr, first->get_host(0, 2));
+  CASE_EXPECT_TRUE("127.0.0.1:7002" == first->get_master(HIREDIS_HAPP_SLOT_NUMBER - 1)->name);
+  CASE_EXPECT_EQ(nullptr, first->get_master(-1));
+  CASE_EXPECT_EQ(nullptr, first->get_master(HIREDIS_HAPP_SLOT_NUMBER));
+  CASE_EXPECT_EQ(static_cast<size_t>(0), first->get_host_count(HIREDIS_HAPP_SLOT_NUMBER));
+
+  // the snapshot routes keys just like the loop thread
+  const char *keys[] = {"a", "user:{1000}", "hello world"};
+  for (size_t i = 0; i < sizeof(keys) / sizeof(keys[0]); ++i) {
+    size_t ks = strlen(keys[i]);
+    CASE_EXPECT_TRUE(first->get_master(keys[i], ks)->name ==
+                     clu.get_slot_master(clu.get_slot_by_key(keys[i], ks)->index)->name);
+  }
+
+  // proc does not publish if slots are not changed
+  uint64_t version = first->get_version();
+  clu.proc(1, 0);
+  CASE_EXPECT_EQ(version, clu.get_slot_map()->get_version());
+
+  // old snapshots are not changed by updates, and are kept until they are released
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK,
+                 clu.update_slots(hiredis_happ_test::make_slot_ranges(8000, 2, true)));
+  hiredis::happ::slot_map_ref second = clu.get_slot_map();
+  CASE_EXPECT_EQ(version + 1, second->get_version());
+  CASE_EXPECT_TRUE("127.0.0.1:7000" == first->get_master(0)->name);
+  CASE_EXPECT_TRUE("127.0.0.1:8000" == second->get_master(0)->name);
+  CASE_EXPECT_TRUE("127.0.0.1:8001" == second->get_master(HIREDIS_HAPP_SLOT_NUMBER - 1)->name);
+
+  hiredis::happ::slot_map_ref copy = first;
+  hiredis::happ::slot_map_ref moved = std::move(copy);
+  CASE_EXPECT_FALSE(!!copy);
+  CASE_EXPECT_EQ(first.get(), moved.get());
+  first.reset();
+  moved.reset();
+  clu.proc(2, 0);
+
+  // reset publishes an empty snapshot
+  clu.reset();
+  hiredis::happ::slot_map_ref empty = clu.get_slot_map();
+  CASE_EXPECT_TRUE(!!empty);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), empty->get_slot_count());
+  CASE_EXPECT_EQ(nullptr, empty->get_master(0));
+}
+
+CASE_TEST(happ_slot_map, concurrent_readers) {
+  hiredis::happ::cluster clu;
+  clu.init("127.0.0.1", 7000);
+
+  std::vector<std::vector<hiredis::happ::cluster::slot_range_t> > topologies;
+  topologies.push_back(hiredis_happ_test::make_slot_ranges(7000, 3, true));
+  topologies.push_back(hiredis_happ_test::make_slot_ranges(8000, 5, true));
+  clu.update_slots(topologies[0]);
+
+  // readers check every snapshot is consistent while the loop thread keeps publishing
+  std::atomic<bool> running(true);
+  std::atomic<size_t> bad_count(0);
+  std::atomic<size_t> read_count(0);
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 3; ++i) {
+    readers.push_back(std::thread([&clu, &running, &bad_count, &read_count]() {
+      while (running.load()) {
+        hiredis::happ::slot_map_ref snapshot = clu.get_slot_map();
+        const hiredis::happ::connection::key_t *first = snapshot->get_master(0);
+        const hiredis::happ::connection::key_t *last = snapshot->get_master(HIREDIS_HAPP_SLOT_NUMBER - 1);
+        if (nullptr == first || nullptr == last || first->port / 1000 != last->port / 1000 ||
+            HIREDIS_HAPP_SLOT_NUMBER != static_cast<int>(snapshot->get_slot_count())) {
+          ++bad_count;
+        }
+        ++read_count;
+      }
+    }));
+  }
+
+  for (int i = 0; i < 2000; ++i) {
+    clu.update_slots(topologies[i % 2]);
+    clu.proc(1, 0);
+  }
+
+  running.store(false);
+  for (size_t i = 0; i < readers.size(); ++i) {
+    readers[i].join();
+  }
+
+  CASE_EXPECT_EQ(static_cast<size_t>(0), bad_count.load());
+  CASE_EXPECT_GT(read_count.load(), static_cast<size_t>(0));
+}
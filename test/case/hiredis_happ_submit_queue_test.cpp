@@ -0,0 +1,178 @@
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#  include <poll.h>
+#endif
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+CASE_TEST(happ_submit_queue, post_and_drain) {
+  hiredis::happ::submit_queue queue;
+  CASE_EXPECT_TRUE(queue.empty());
+  CASE_EXPECT_EQ(static_cast<size_t>(0), queue.drain());
+
+  int wakeup_count = 0;
+  queue.set_wakeup_fn([&wakeup_count]() { ++wakeup_count; });
+
+  std::vector<int> order;
+  for (int i = 0; i < 5; ++i) {
+    CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, queue.post([&order, i]() { order.push_back(i); }));
+  }
+  CASE_EXPECT_FALSE(queue.empty());
+
+  // only the first task wakes up the loop thread
+  CASE_EXPECT_EQ(1, wakeup_count);
+
+  // tasks are run in posting order, in batches
+  CASE_EXPECT_EQ(static_cast<size_t>(2), queue.drain(2));
+  CASE_EXPECT_EQ(static_cast<size_t>(2), order.size());
+  CASE_EXPECT_EQ(static_cast<size_t>(3), queue.drain());
+  CASE_EXPECT_EQ(static_cast<size_t>(5), order.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    CASE_EXPECT_EQ(static_cast<int>(i), order[i]);
+  }
+  CASE_EXPECT_TRUE(queue.empty());
+
+  // move-only tasks, and tasks posted by a running task are run by the next drain
+  std::unique_ptr<std::string> value(new std::string("moved"));
+  std::string result;
+  queue.post([&queue, &result, value = std::move(value)]() {
+    result = *value;
+    queue.post([&result]() { result += " again"; });
+  });
+  CASE_EXPECT_EQ(2, wakeup_count);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), queue.drain());
+  CASE_EXPECT_TRUE("moved" == result);
+  CASE_EXPECT_EQ(3, wakeup_count);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), queue.drain());
+  CASE_EXPECT_TRUE("moved again" == result);
+
+  // tasks not run are destroyed with the queue
+  std::shared_ptr<int> ref = std::make_shared<int>(0);
+  {
+    hiredis::happ::submit_queue other;
+    other.post([ref]() { ++*ref; });
+    CASE_EXPECT_EQ(2, static_cast<int>(ref.use_count()));
+  }
+  CASE_EXPECT_EQ(1, static_cast<int>(ref.use_count()));
+  CASE_EXPECT_EQ(0, *ref);
+}
+
+CASE_TEST(happ_submit_queue, multi_producer) {
+  hiredis::happ::submit_queue queue;
+  std::atomic<int> wakeup_count(0);
+  queue.set_wakeup_fn([&wakeup_count]() { ++wakeup_count; });
+
+  const int thread_count = 4;
+  const int task_count = 10000;
+  std::vector<int> last_seq(thread_count, -1);
+  int run_count = 0;
+  bool ordered = true;
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_count; ++i) {
+    threads.push_back(std::thread([&, i]() {
+      for (int j = 0; j < task_count; ++j) {
+        // run in the consumer thread, tasks of one producer keep their order
+        queue.post([&, i, j]() {
+          ordered = ordered && last_seq[i] + 1 == j;
+          last_seq[i] = j;
+          ++run_count;
+        });
+      }
+    }));
+  }
+
+  while (run_count < thread_count * task_count) {
+    if (0 == queue.drain(128)) {
+      std::this_thread::yield();
+    }
+  }
+
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  CASE_EXPECT_EQ(thread_count * task_count, run_count);
+  CASE_EXPECT_TRUE(ordered);
+  CASE_EXPECT_TRUE(queue.empty());
+  CASE_EXPECT_GT(wakeup_count.load(), 0);
+  CASE_EXPECT_LE(wakeup_count.load(), thread_count * task_count);
+}
+
+#if defined(__linux__)
+CASE_TEST(happ_submit_queue, eventfd) {
+  hiredis::happ::submit_queue queue;
+  CASE_EXPECT_EQ(-1, queue.get_wakeup_fd());
+  int fd = queue.enable_eventfd();
+  CASE_EXPECT_GE(fd, 0);
+  CASE_EXPECT_EQ(fd, queue.get_wakeup_fd());
+  CASE_EXPECT_EQ(fd, queue.enable_eventfd());
+
+  int value = 0;
+  std::thread producer([&queue, &value]() {
+    for (int i = 0; i < 3; ++i) {
+      queue.post([&value]() { ++value; });
+    }
+  });
+  producer.join();
+
+  struct pollfd pfd;
+  pfd.fd = fd;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
+  CASE_EXPECT_EQ(1, poll(&pfd, 1, 1000));
+
+  CASE_EXPECT_EQ(static_cast<size_t>(3), queue.on_wakeup());
+  CASE_EXPECT_EQ(3, value);
+
+  // eventfd is consumed
+  pfd.revents = 0;
+  CASE_EXPECT_EQ(0, poll(&pfd, 1, 0));
+}
+#endif
+
+CASE_TEST(happ_submit_queue, raw_post_and_reply_back) {
+  hiredis::happ::raw raw;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.init("127.0.0.1", 6380));
+  raw.set_timeout(3);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, raw.start());
+  raw.proc(1, 0);
+
+  // the worker owns a queue, and replies are posted back to it
+  hiredis::happ::submit_queue worker_queue;
+  std::vector<int> results;
+  std::thread worker([&raw, &worker_queue, &results]() {
+    for (int i = 0; i < 3; ++i) {
+      raw.post([&raw, &worker_queue, &results]() {
+        raw.exec(
+            [&worker_queue, &results](hiredis::happ::cmd_exec *c, redisAsyncContext *, void *) {
+              int res = c->result();
+              worker_queue.post([&results, res]() { results.push_back(res); });
+            },
+            "PING");
+      });
+    }
+  });
+  worker.join();
+  CASE_EXPECT_FALSE(raw.get_submit_queue().empty());
+
+  // tasks are run in the loop thread by proc
+  raw.proc(2, 0);
+  CASE_EXPECT_TRUE(raw.get_submit_queue().empty());
+  CASE_EXPECT_TRUE(worker_queue.empty());
+
+  // connect timeout
+  raw.proc(5, 0);
+  CASE_EXPECT_EQ(static_cast<size_t>(3), worker_queue.drain());
+  CASE_EXPECT_EQ(static_cast<size_t>(3), results.size());
+  for (size_t i = 0; i < results.size(); ++i) {
+    CASE_EXPECT_NE(hiredis::happ::error_code::REDIS_HAPP_OK, results[i]);
+  }
+  raw.reset();
+}
@@ -0,0 +1,229 @@
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "frame/test_macros.h"
+#include "hiredis_happ.h"
+
+#include "test_pong_server.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+
+namespace {
+hiredis::happ::sync_client::args_t happ_sync_client_args(const char *cmd, const char *arg = nullptr) {
+  hiredis::happ::sync_client::args_t ret;
+  ret.push_back(cmd);
+  if (nullptr != arg) {
+    ret.push_back(arg);
+  }
+  return ret;
+}
+
+struct happ_sync_client_batch_runner {
+  hiredis::happ::sync_client *client;
+  size_t count;
+  size_t ok_count;
+
+  void operator()() {
+    std::vector<hiredis::happ::sync_client::request_t> requests;
+    requests.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      requests[i].args = happ_sync_client_args("PING");
+    }
+
+    std::vector<hiredis::happ::sync_reply> replies = client->exec_batch(requests, 5000);
+    for (size_t i = 0; i < replies.size(); ++i) {
+      if (replies[i].is_ok() && "PONG" == replies[i].str) {
+        ++ok_count;
+      }
+    }
+  }
+};
+}  // namespace
+
+CASE_TEST(happ_sync_client, exec) {
+  hiredis_happ_test::pong_server server;
+
+  hiredis::happ::sync_client client;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.init_raw("127.0.0.1", server.get_port()));
+  CASE_EXPECT_EQ(hiredis::happ::sync_client::mode_t::RAW, client.get_mode());
+  CASE_EXPECT_TRUE(nullptr != client.get_raw());
+  CASE_EXPECT_TRUE(nullptr == client.get_cluster());
+
+  // not started yet
+  hiredis::happ::sync_reply reply = client.exec("", happ_sync_client_args("PING"));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_CONNECTION, reply.result);
+
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.start());
+  CASE_EXPECT_TRUE(client.is_running());
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, client.start());
+
+  reply = client.exec("", happ_sync_client_args("PING"), 5000);
+  CASE_EXPECT_TRUE(reply.is_ok());
+  CASE_EXPECT_EQ(REDIS_REPLY_STATUS, reply.type);
+  CASE_EXPECT_TRUE("PONG" == reply.str);
+
+  std::future<hiredis::happ::sync_reply> future = client.exec_async("", happ_sync_client_args("PING"));
+  reply = future.get();
+  CASE_EXPECT_TRUE(reply.is_ok());
+  CASE_EXPECT_TRUE("PONG" == reply.str);
+
+  // empty command fails in the loop thread
+  reply = client.exec("", hiredis::happ::sync_client::args_t(), 5000);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, reply.result);
+
+  client.stop();
+  CASE_EXPECT_FALSE(client.is_running());
+  CASE_EXPECT_EQ(2, server.get_ping_count());
+
+  // stopped
+  reply = client.exec("", happ_sync_client_args("PING"), 5000);
+  CASE_EXPECT_FALSE(reply.is_ok());
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_CONNECTION, reply.result);
+}
+
+CASE_TEST(happ_sync_client, batch_from_threads) {
+  hiredis_happ_test::pong_server server;
+
+  hiredis::happ::sync_client client;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.init_raw("127.0.0.1", server.get_port()));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.start());
+
+  std::vector<happ_sync_client_batch_runner> runners;
+  runners.resize(4);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < runners.size(); ++i) {
+    runners[i].client = &client;
+    runners[i].count = 8;
+    runners[i].ok_count = 0;
+  }
+  for (size_t i = 0; i < runners.size(); ++i) {
+    threads.push_back(std::thread(std::ref(runners[i])));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  for (size_t i = 0; i < runners.size(); ++i) {
+    CASE_EXPECT_EQ(runners[i].count, runners[i].ok_count);
+  }
+  CASE_EXPECT_EQ(32, server.get_ping_count());
+
+  client.stop();
+}
+
+CASE_TEST(happ_sync_client, timeout_and_stop) {
+  hiredis_happ_test::pong_server server;
+
+  hiredis::happ::sync_client client;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.init_raw("127.0.0.1", server.get_port()));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.start());
+
+  // the server only replies PING, so GET never gets its reply
+  hiredis::happ::sync_reply reply = client.exec("", happ_sync_client_args("GET", "key"), 50);
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_TIMEOUT, reply.result);
+
+  std::future<hiredis::happ::sync_reply> future = client.exec_async("", happ_sync_client_args("GET", "key"));
+  CASE_EXPECT_TRUE(std::future_status::timeout == future.wait_for(std::chrono::milliseconds(50)));
+
+  // pending requests fail when the client stops
+  client.stop();
+  CASE_EXPECT_TRUE(std::future_status::ready == future.wait_for(std::chrono::milliseconds(0)));
+  reply = future.get();
+  CASE_EXPECT_NE(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+  CASE_EXPECT_FALSE(reply.is_ok());
+}
+
+CASE_TEST(happ_sync_client, subscribe_and_stop) {
+  hiredis_happ_test::pong_server server;
+
+  hiredis::happ::sync_client client;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.init_raw("127.0.0.1", server.get_port()));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.start());
+
+  // the cmd of SUBSCRIBE is destroyed without calling back, its request still fails when the client stops
+  std::future<hiredis::happ::sync_reply> future = client.exec_async("", happ_sync_client_args("SUBSCRIBE", "channel"));
+  CASE_EXPECT_TRUE(std::future_status::timeout == future.wait_for(std::chrono::milliseconds(50)));
+
+  client.stop();
+  CASE_EXPECT_TRUE(std::future_status::ready == future.wait_for(std::chrono::milliseconds(0)));
+  hiredis::happ::sync_reply reply = future.get();
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_CONNECTION, reply.result);
+  CASE_EXPECT_FALSE(reply.is_ok());
+}
+
+CASE_TEST(happ_sync_client, stop_while_posting) {
+  hiredis_happ_test::pong_server server;
+
+  hiredis::happ::sync_client client;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.init_raw("127.0.0.1", server.get_port()));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.start());
+
+  // requests posted while stopping are either sent or failed, their futures never hang or break
+  std::vector<std::vector<std::future<hiredis::happ::sync_reply> > > futures;
+  futures.resize(4);
+  std::atomic<bool> started(false);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < futures.size(); ++i) {
+    std::vector<std::future<hiredis::happ::sync_reply> > *out = &futures[i];
+    threads.push_back(std::thread([&client, &started, out]() {
+      for (int j = 0; j < 256; ++j) {
+        out->push_back(client.exec_async("", happ_sync_client_args("PING")));
+        started.store(true);
+      }
+    }));
+  }
+
+  while (!started.load()) {
+    std::this_thread::yield();
+  }
+  client.stop();
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  for (size_t i = 0; i < futures.size(); ++i) {
+    for (size_t j = 0; j < futures[i].size(); ++j) {
+      CASE_EXPECT_TRUE(std::future_status::ready == futures[i][j].wait_for(std::chrono::milliseconds(0)));
+      hiredis::happ::sync_reply reply = futures[i][j].get();
+      CASE_EXPECT_NE(hiredis::happ::error_code::REDIS_HAPP_UNKNOWD, reply.result);
+    }
+  }
+}
+
+CASE_TEST(happ_sync_client, closed_port) {
+  // a port which is just closed
+  uint16_t port;
+  {
+    hiredis_happ_test::pong_server server;
+    port = server.get_port();
+  }
+
+  hiredis::happ::sync_client client;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.init_raw("127.0.0.1", port));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.start());
+
+  hiredis::happ::sync_reply reply = client.exec("", happ_sync_client_args("PING"), 5000);
+  CASE_EXPECT_NE(hiredis::happ::error_code::REDIS_HAPP_OK, reply.result);
+  CASE_EXPECT_NE(hiredis::happ::error_code::REDIS_HAPP_TIMEOUT, reply.result);
+
+  client.stop();
+}
+
+CASE_TEST(happ_sync_client, cluster_mode) {
+  hiredis::happ::sync_client client;
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.init_cluster("127.0.0.1", 6379));
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_PARAM, client.init_raw("127.0.0.1", 6379));
+  CASE_EXPECT_EQ(hiredis::happ::sync_client::mode_t::CLUSTER, client.get_mode());
+  CASE_EXPECT_TRUE(nullptr != client.get_cluster());
+  CASE_EXPECT_EQ(hiredis::happ::error_code::REDIS_HAPP_OK, client.start());
+
+  // slots may never be loaded, the request waits until it's failed by stop()
+  std::future<hiredis::happ::sync_reply> future = client.exec_async("key", happ_sync_client_args("GET", "key"));
+  client.stop();
+  CASE_EXPECT_TRUE(std::future_status::ready == future.wait_for(std::chrono::milliseconds(0)));
+}
+#endif
@@ -0,0 +1,153 @@
+#include <detail/happ_timer.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "frame/test_macros.h"
+
+static std::vector<uint64_t> happ_timer_pop_all(hiredis::happ::timer_wheel &wheel) {
+  std::vector<uint64_t> ret;
+  for (hiredis::happ::timer_node *node = wheel.pop_expired(); nullptr != node; node = wheel.pop_expired()) {
+    CASE_EXPECT_FALSE(hiredis::happ::timer_wheel::is_scheduled(node));
+    ret.push_back(node->expire);
+  }
+  return ret;
+}
+
+CASE_TEST(happ_timer, add_advance_and_remove) {
+  hiredis::happ::timer_wheel wheel;
+  hiredis::happ::timer_node nodes[4];
+  memset(nodes, 0, sizeof(nodes));
+
+  wheel.advance(1000);
+  CASE_EXPECT_EQ(static_cast<uint64_t>(1001), wheel.get_next_tick());
+
+  // mixed intervals, not ordered by insertion
+  wheel.add(&nodes[0], 1300, &nodes[0]);
+  wheel.add(&nodes[1], 1100, &nodes[1]);
+  wheel.add(&nodes[2], 1200, &nodes[2]);
+  wheel.add(&nodes[3], 1050, &nodes[3]);
+  CASE_EXPECT_EQ(static_cast<size_t>(4), wheel.size());
+
+  CASE_EXPECT_TRUE(hiredis::happ::timer_wheel::remove(&nodes[2]));
+  CASE_EXPECT_FALSE(hiredis::happ::timer_wheel::remove(&nodes[2]));
+  CASE_EXPECT_EQ(static_cast<size_t>(3), wheel.size());
+
+  CASE_EXPECT_EQ(static_cast<size_t>(0), wheel.advance(1049));
+  CASE_EXPECT_EQ(static_cast<size_t>(2), wheel.advance(1100));
+  std::vector<uint64_t> expired = happ_timer_pop_all(wheel);
+  CASE_EXPECT_EQ(static_cast<size_t>(2), expired.size());
+  if (2 == expired.size()) {
+    CASE_EXPECT_EQ(static_cast<uint64_t>(1050), expired[0]);
+    CASE_EXPECT_EQ(static_cast<uint64_t>(1100), expired[1]);
+  }
+
+  // timers in the past will expire at the next advance
+  wheel.add(&nodes[1], 900, &nodes[1]);
+  CASE_EXPECT_EQ(static_cast<size_t>(0), wheel.advance(1100));
+  CASE_EXPECT_EQ(static_cast<size_t>(1), wheel.advance(1101));
+  CASE_EXPECT_EQ(static_cast<size_t>(1), happ_timer_pop_all(wheel).size());
+
+  CASE_EXPECT_EQ(static_cast<size_t>(1), wheel.advance(5000));
+  expired = happ_timer_pop_all(wheel);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), expired.size());
+  if (1 == expired.size()) {
+    CASE_EXPECT_EQ(static_cast<uint64_t>(1300), expired[0]);
+  }
+  CASE_EXPECT_TRUE(wheel.empty());
+}
+
+CASE_TEST(happ_timer, cascade_and_flush) {
+  hiredis::happ::timer_wheel wheel;
+  const size_t node_count = 4096;
+  std::vector<hiredis::happ::timer_node> nodes;
+  nodes.resize(node_count);
+  memset(&nodes[0], 0, sizeof(hiredis::happ::timer_node) * node_count);
+
+  uint64_t now = hiredis::happ::timer_wheel::make_tick(100, 500000);
+  CASE_EXPECT_EQ(static_cast<uint64_t>(100500), now);
+  wheel.advance(now);
+
+  // deadlines cover all levels
+  for (size_t i = 0; i < node_count; ++i) {
+    uint64_t delay = (static_cast<uint64_t>(i) * 7919) % (static_cast<uint64_t>(1) << (i % 28));
+    wheel.add(&nodes[i], now + 1 + delay, nullptr);
+  }
+  CASE_EXPECT_EQ(node_count, wheel.size());
+
+  size_t expired_count = 0;
+  uint64_t last_expire = 0;
+  bool ordered = true;
+  uint64_t step = 1;
+  while (!wheel.empty() && now < (static_cast<uint64_t>(1) << 30)) {
+    now += step;
+    step = step * 2 > 65536 ? 65536 : step * 2;
+    wheel.advance(now);
+
+    for (hiredis::happ::timer_node *node = wheel.pop_expired(); nullptr != node; node = wheel.pop_expired()) {
+      if (node->expire > now) {
+        ordered = false;
+      }
+      if (node->expire < last_expire) {
+        ordered = false;
+      }
+      ++expired_count;
+    }
+
+    last_expire = now;
+  }
+  CASE_EXPECT_TRUE(ordered);
+  CASE_EXPECT_EQ(node_count, expired_count);
+
+  // flush all timers whatever their expire ticks are
+  for (size_t i = 0; i < 16; ++i) {
+    wheel.add(&nodes[i], now + (static_cast<uint64_t>(1) << (i * 2)), nullptr);
+  }
+  CASE_EXPECT_EQ(static_cast<size_t>(16), wheel.flush());
+  CASE_EXPECT_EQ(static_cast<size_t>(16), happ_timer_pop_all(wheel).size());
+  CASE_EXPECT_TRUE(wheel.empty());
+}
+
+CASE_TEST(happ_timer, out_of_range) {
+  hiredis::happ::timer_wheel wheel;
+  hiredis::happ::timer_node nodes[2];
+  memset(nodes, 0, sizeof(nodes));
+
+  wheel.advance(1000);
+  uint64_t max_expire = wheel.get_next_tick() + (static_cast<uint64_t>(1) << 32) - 1;
+
+  // the farthest timer in range and one beyond it, which must not expire at max_expire
+  wheel.add(&nodes[0], max_expire, nullptr);
+  wheel.add(&nodes[1], max_expire + 5000, nullptr);
+
+  CASE_EXPECT_EQ(static_cast<size_t>(0), wheel.advance(max_expire - 1));
+  CASE_EXPECT_EQ(static_cast<size_t>(1), wheel.advance(max_expire));
+  std::vector<uint64_t> expired = happ_timer_pop_all(wheel);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), expired.size());
+  if (1 == expired.size()) {
+    CASE_EXPECT_EQ(max_expire, expired[0]);
+  }
+
+  CASE_EXPECT_EQ(static_cast<size_t>(0), wheel.advance(max_expire + 4999));
+  CASE_EXPECT_EQ(static_cast<size_t>(1), wheel.advance(max_expire + 5000));
+  expired = happ_timer_pop_all(wheel);
+  CASE_EXPECT_EQ(static_cast<size_t>(1), expired.size());
+  if (1 == expired.size()) {
+    CASE_EXPECT_EQ(max_expire + 5000, expired[0]);
+  }
+  CASE_EXPECT_TRUE(wheel.empty());
+}
+
+CASE_TEST(happ_timer, destroy_with_pending_nodes) {
+  hiredis::happ::timer_node node;
+  memset(&node, 0, sizeof(node));
+
+  {
+    hiredis::happ::timer_wheel wheel;
+    wheel.add(&node, 100000, nullptr);
+    CASE_EXPECT_TRUE(hiredis::happ::timer_wheel::is_scheduled(&node));
+  }
+
+  CASE_EXPECT_FALSE(hiredis::happ::timer_wheel::is_scheduled(&node));
+  CASE_EXPECT_FALSE(hiredis::happ::timer_wheel::remove(&node));
+}
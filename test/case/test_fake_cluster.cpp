@@ -0,0 +1,575 @@
+#include "test_fake_cluster.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+#  include <arpa/inet.h>
+#  include <fcntl.h>
+#  include <netinet/in.h>
+#  include <poll.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+
+#  include <algorithm>
+#  include <cerrno>
+#  include <cstdio>
+#  include <cstdlib>
+#  include <cstring>
+
+#  include "detail/crc16.h"
+
+namespace hiredis_happ_test {
+namespace {
+void set_nonblock(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags >= 0) {
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+  }
+}
+
+void append_bulk(std::string &out, const std::string &value) {
+  char head[32];
+  snprintf(head, sizeof(head), "$%zu\r\n", value.size());
+  out += head;
+  out += value;
+  out += "\r\n";
+}
+
+void append_integer(std::string &out, long long value) {
+  char line[32];
+  snprintf(line, sizeof(line), ":%lld\r\n", value);
+  out += line;
+}
+
+void append_redirect(std::string &out, const char *type, int slot, uint16_t port) {
+  char line[96];
+  snprintf(line, sizeof(line), "-%s %d 127.0.0.1:%u\r\n", type, slot, static_cast<unsigned>(port));
+  out += line;
+}
+
+std::string to_upper(const std::string &in) {
+  std::string ret = in;
+  for (size_t i = 0; i < ret.size(); ++i) {
+    if (ret[i] >= 'a' && ret[i] <= 'z') {
+      ret[i] = static_cast<char>(ret[i] - 'a' + 'A');
+    }
+  }
+  return ret;
+}
+
+// parse one RESP array of bulk strings or one inline command, return bytes used, 0 if it's not complete
+size_t parse_command(const std::string &input, std::vector<std::string> &args) {
+  args.clear();
+  if (input.empty()) {
+    return 0;
+  }
+
+  if ('*' != input[0]) {
+    size_t end = input.find("\r\n");
+    if (std::string::npos == end) {
+      return 0;
+    }
+
+    size_t pos = 0;
+    while (pos < end) {
+      size_t next = input.find(' ', pos);
+      if (std::string::npos == next || next > end) {
+        next = end;
+      }
+      if (next > pos) {
+        args.push_back(input.substr(pos, next - pos));
+      }
+      pos = next + 1;
+    }
+    return end + 2;
+  }
+
+  size_t end = input.find("\r\n");
+  if (std::string::npos == end) {
+    return 0;
+  }
+  long count = strtol(input.c_str() + 1, nullptr, 10);
+  size_t pos = end + 2;
+  for (long i = 0; i < count; ++i) {
+    end = input.find("\r\n", pos);
+    if (std::string::npos == end || '$' != input[pos]) {
+      return 0;
+    }
+    size_t len = static_cast<size_t>(strtoul(input.c_str() + pos + 1, nullptr, 10));
+    pos = end + 2;
+    if (input.size() < pos + len + 2) {
+      return 0;
+    }
+    args.push_back(input.substr(pos, len));
+    pos += len + 2;
+  }
+  return pos;
+}
+}  // namespace
+
+fake_cluster::fake_cluster(size_t node_count)
+    : slots_(HIREDIS_HAPP_SLOT_NUMBER, 0), cluster_slots_count_(0), ready_(false), running_(true) {
+  wakeup_fds_[0] = -1;
+  wakeup_fds_[1] = -1;
+  if (0 == node_count) {
+    node_count = 1;
+  }
+
+  nodes_.resize(node_count);
+  bool ok = 0 == pipe(wakeup_fds_);
+  if (ok) {
+    set_nonblock(wakeup_fds_[0]);
+    set_nonblock(wakeup_fds_[1]);
+  }
+
+  for (size_t i = 0; i < node_count; ++i) {
+    node_t &node = nodes_[i];
+    node.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    node.port = 0;
+    node.latency = std::chrono::microseconds(0);
+    node.command_count = 0;
+    node.drop = false;
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if (node.listen_fd < 0 || 0 != bind(node.listen_fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ||
+        0 != listen(node.listen_fd, 64) ||
+        0 != getsockname(node.listen_fd, reinterpret_cast<sockaddr *>(&addr), &len)) {
+      ok = false;
+      continue;
+    }
+    set_nonblock(node.listen_fd);
+    node.port = ntohs(addr.sin_port);
+  }
+
+  for (int i = 0; i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
+    slots_[i] = static_cast<size_t>(i) * node_count / HIREDIS_HAPP_SLOT_NUMBER;
+  }
+
+  ready_ = ok;
+  if (ok) {
+    thread_ = std::thread(&fake_cluster::serve, this);
+  }
+}
+
+fake_cluster::~fake_cluster() {
+  running_.store(false);
+  if (wakeup_fds_[1] >= 0) {
+    char c = 0;
+    (void)write(wakeup_fds_[1], &c, 1);
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  for (size_t i = 0; i < clients_.size(); ++i) {
+    close(clients_[i].fd);
+  }
+  for (size_t i = 0; i < nodes_.size(); ++i) {
+    if (nodes_[i].listen_fd >= 0) {
+      close(nodes_[i].listen_fd);
+    }
+  }
+  for (int i = 0; i < 2; ++i) {
+    if (wakeup_fds_[i] >= 0) {
+      close(wakeup_fds_[i]);
+    }
+  }
+}
+
+uint16_t fake_cluster::get_port(size_t node) const { return node < nodes_.size() ? nodes_[node].port : 0; }
+
+size_t fake_cluster::get_node_by_key(const std::string &key) const {
+  return get_slot_owner(hiredis::happ::hash_slot(key.c_str(), key.size()));
+}
+
+size_t fake_cluster::get_slot_owner(int slot) const {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (slot < 0 || slot >= HIREDIS_HAPP_SLOT_NUMBER) {
+    return 0;
+  }
+  return slots_[static_cast<size_t>(slot)];
+}
+
+void fake_cluster::assign_slots(int start, int end, size_t node) {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (node >= nodes_.size()) {
+    return;
+  }
+  for (int i = std::max(start, 0); i <= end && i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
+    slots_[static_cast<size_t>(i)] = node;
+  }
+}
+
+void fake_cluster::inject_fault(size_t node, fault_t::type type, size_t count, size_t target_node) {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (node >= nodes_.size() || 0 == count || fault_t::NONE == type) {
+    return;
+  }
+
+  fault_item_t fault;
+  fault.type = type;
+  fault.count = count;
+  fault.target_node = target_node < nodes_.size() ? target_node : 0;
+  nodes_[node].faults.push_back(fault);
+}
+
+void fake_cluster::set_latency(size_t node, std::chrono::microseconds latency) {
+  std::lock_guard<std::mutex> guard(lock_);
+  if (node < nodes_.size()) {
+    nodes_[node].latency = latency;
+  }
+}
+
+void fake_cluster::drop_connections(size_t node) {
+  {
+    std::lock_guard<std::mutex> guard(lock_);
+    if (node >= nodes_.size()) {
+      return;
+    }
+    nodes_[node].drop = true;
+  }
+
+  char c = 0;
+  (void)write(wakeup_fds_[1], &c, 1);
+}
+
+size_t fake_cluster::get_command_count(size_t node) const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return node < nodes_.size() ? nodes_[node].command_count : 0;
+}
+
+size_t fake_cluster::get_cluster_slots_count() const {
+  std::lock_guard<std::mutex> guard(lock_);
+  return cluster_slots_count_;
+}
+
+size_t fake_cluster::get_connection_count(size_t node) const {
+  std::lock_guard<std::mutex> guard(lock_);
+  size_t ret = 0;
+  for (size_t i = 0; i < clients_.size(); ++i) {
+    if (clients_[i].node == node && !clients_[i].closing) {
+      ++ret;
+    }
+  }
+  return ret;
+}
+
+std::string fake_cluster::get_value(const std::string &key) const {
+  std::lock_guard<std::mutex> guard(lock_);
+  std::map<std::string, std::string>::const_iterator iter = data_.find(key);
+  return iter == data_.end() ? std::string() : iter->second;
+}
+
+void fake_cluster::serve() {
+  std::vector<pollfd> fds;
+  while (running_.load()) {
+    int timeout_ms = 10;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      fds.clear();
+      pollfd pfd;
+      pfd.fd = wakeup_fds_[0];
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      fds.push_back(pfd);
+      for (size_t i = 0; i < nodes_.size(); ++i) {
+        pfd.fd = nodes_[i].listen_fd;
+        fds.push_back(pfd);
+      }
+
+      std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < clients_.size(); ++i) {
+        pfd.fd = clients_[i].fd;
+        pfd.events = static_cast<short>(POLLIN | (clients_[i].output.empty() ? 0 : POLLOUT));
+        fds.push_back(pfd);
+
+        if (!clients_[i].delayed.empty()) {
+          long long wait_ms = static_cast<long long>(
+              std::chrono::duration_cast<std::chrono::milliseconds>(clients_[i].delayed.front().first - now).count());
+          if (wait_ms < timeout_ms) {
+            timeout_ms = wait_ms > 0 ? static_cast<int>(wait_ms) : 0;
+          }
+        }
+      }
+    }
+
+    int res = poll(&fds[0], fds.size(), timeout_ms);
+    if (res < 0 && EINTR != errno) {
+      break;
+    }
+
+    std::lock_guard<std::mutex> guard(lock_);
+    if (fds[0].revents & POLLIN) {
+      char buf[64];
+      while (read(wakeup_fds_[0], buf, sizeof(buf)) > 0) {
+      }
+    }
+
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      if (!nodes_[i].drop) {
+        continue;
+      }
+      nodes_[i].drop = false;
+      for (size_t j = 0; j < clients_.size(); ++j) {
+        if (clients_[j].node == i) {
+          clients_[j].closing = true;
+        }
+      }
+    }
+
+    // clients accepted in this round are not in fds yet
+    size_t client_count = clients_.size();
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < client_count; ++i) {
+      client_t &client = clients_[i];
+      if (client.closing) {
+        continue;
+      }
+
+      short revents = fds[1 + nodes_.size() + i].revents;
+      if ((revents & (POLLIN | POLLHUP | POLLERR)) && (!read_client(client) || !process_input(client))) {
+        client.closing = true;
+        continue;
+      }
+
+      flush_delayed(client, now);
+      if (!client.output.empty() && !write_client(client)) {
+        client.closing = true;
+      }
+    }
+
+    for (size_t i = 0; i < nodes_.size(); ++i) {
+      if (fds[1 + i].revents & POLLIN) {
+        accept_clients(i);
+      }
+    }
+
+    for (size_t i = 0; i < clients_.size();) {
+      if (clients_[i].closing) {
+        close(clients_[i].fd);
+        clients_.erase(clients_.begin() + static_cast<std::ptrdiff_t>(i));
+      } else {
+        ++i;
+      }
+    }
+  }
+}
+
+void fake_cluster::accept_clients(size_t node) {
+  while (true) {
+    int fd = accept(nodes_[node].listen_fd, nullptr, nullptr);
+    if (fd < 0) {
+      return;
+    }
+
+    set_nonblock(fd);
+    client_t client;
+    client.fd = fd;
+    client.node = node;
+    client.asking = false;
+    client.closing = false;
+    clients_.push_back(client);
+  }
+}
+
+bool fake_cluster::read_client(client_t &client) {
+  char buf[16384];
+  while (true) {
+    ssize_t len = read(client.fd, buf, sizeof(buf));
+    if (len > 0) {
+      client.input.append(buf, static_cast<size_t>(len));
+      continue;
+    }
+    if (0 == len) {
+      return false;
+    }
+    return EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno;
+  }
+}
+
+bool fake_cluster::write_client(client_t &client) {
+  while (!client.output.empty()) {
+    ssize_t len = write(client.fd, client.output.data(), client.output.size());
+    if (len > 0) {
+      client.output.erase(0, static_cast<size_t>(len));
+      continue;
+    }
+    return len < 0 && (EAGAIN == errno || EWOULDBLOCK == errno || EINTR == errno);
+  }
+  return true;
+}
+
+void fake_cluster::flush_delayed(client_t &client, std::chrono::steady_clock::time_point now) {
+  while (!client.delayed.empty() && client.delayed.front().first <= now) {
+    client.output += client.delayed.front().second;
+    client.delayed.pop_front();
+  }
+}
+
+bool fake_cluster::process_input(client_t &client) {
+  std::vector<std::string> args;
+  while (true) {
+    size_t used = parse_command(client.input, args);
+    if (0 == used) {
+      return true;
+    }
+    client.input.erase(0, used);
+    if (args.empty()) {
+      continue;
+    }
+
+    std::string reply;
+    if (!run_command(client, args, reply)) {
+      return false;
+    }
+
+    // keep replies in order, even if the latency is changed
+    node_t &node = nodes_[client.node];
+    if (node.latency.count() > 0 || !client.delayed.empty()) {
+      std::chrono::steady_clock::time_point due = std::chrono::steady_clock::now() + node.latency;
+      if (!client.delayed.empty() && client.delayed.back().first > due) {
+        due = client.delayed.back().first;
+      }
+      client.delayed.push_back(std::make_pair(due, reply));
+    } else {
+      client.output += reply;
+    }
+  }
+}
+
+bool fake_cluster::run_command(client_t &client, const std::vector<std::string> &args, std::string &reply) {
+  node_t &node = nodes_[client.node];
+  ++node.command_count;
+
+  std::string cmd = to_upper(args[0]);
+  if ("CLUSTER" == cmd && args.size() > 1 && "SLOTS" == to_upper(args[1])) {
+    ++cluster_slots_count_;
+    reply_cluster_slots(reply);
+    return true;
+  }
+  if ("ASKING" == cmd) {
+    client.asking = true;
+    reply = "+OK\r\n";
+    return true;
+  }
+  if ("AUTH" == cmd || "READONLY" == cmd) {
+    reply = "+OK\r\n";
+    return true;
+  }
+  if ("PING" == cmd) {
+    reply = "+PONG\r\n";
+    return true;
+  }
+
+  bool is_key_cmd = ("GET" == cmd || "SET" == cmd || "DEL" == cmd || "INCR" == cmd);
+  if (!is_key_cmd) {
+    reply = "-ERR unknown command '" + args[0] + "'\r\n";
+    return true;
+  }
+  if (args.size() < 2 || ("SET" == cmd && args.size() < 3)) {
+    reply = "-ERR wrong number of arguments for '" + args[0] + "' command\r\n";
+    return true;
+  }
+
+  // ASKING only works for the next command
+  bool asking = client.asking;
+  client.asking = false;
+
+  const std::string &key = args[1];
+  int slot = hiredis::happ::hash_slot(key.c_str(), key.size());
+  if (!node.faults.empty()) {
+    fault_item_t fault = node.faults.front();
+    if (0 == --node.faults.front().count) {
+      node.faults.pop_front();
+    }
+
+    switch (fault.type) {
+      case fault_t::MOVED:
+        append_redirect(reply, "MOVED", slot, nodes_[fault.target_node].port);
+        return true;
+      case fault_t::ASK:
+        append_redirect(reply, "ASK", slot, nodes_[fault.target_node].port);
+        return true;
+      case fault_t::TRYAGAIN:
+        reply = "-TRYAGAIN Multiple keys request during rehashing of slot\r\n";
+        return true;
+      case fault_t::CLUSTERDOWN:
+        reply = "-CLUSTERDOWN The cluster is down\r\n";
+        return true;
+      case fault_t::ERROR:
+        reply = "-ERR fake error\r\n";
+        return true;
+      case fault_t::DROP:
+        return false;
+      default:
+        break;
+    }
+  }
+
+  size_t owner = slots_[static_cast<size_t>(slot)];
+  if (owner != client.node && !asking) {
+    append_redirect(reply, "MOVED", slot, nodes_[owner].port);
+    return true;
+  }
+
+  if ("GET" == cmd) {
+    std::map<std::string, std::string>::const_iterator iter = data_.find(key);
+    if (iter == data_.end()) {
+      reply = "$-1\r\n";
+    } else {
+      append_bulk(reply, iter->second);
+    }
+  } else if ("SET" == cmd) {
+    data_[key] = args[2];
+    reply = "+OK\r\n";
+  } else if ("DEL" == cmd) {
+    long long count = 0;
+    for (size_t i = 1; i < args.size(); ++i) {
+      count += static_cast<long long>(data_.erase(args[i]));
+    }
+    append_integer(reply, count);
+  } else {
+    std::string &value = data_[key];
+    char *end = nullptr;
+    long long v = value.empty() ? 0 : strtoll(value.c_str(), &end, 10);
+    if (nullptr != end && 0 != *end) {
+      reply = "-ERR value is not an integer or out of range\r\n";
+      return true;
+    }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%lld", v + 1);
+    value = buf;
+    append_integer(reply, v + 1);
+  }
+  return true;
+}
+
+void fake_cluster::reply_cluster_slots(std::string &reply) const {
+  // slots of the same node are merged into ranges
+  std::vector<std::pair<int, int> > ranges;
+  for (int i = 0; i < HIREDIS_HAPP_SLOT_NUMBER; ++i) {
+    if (ranges.empty() || slots_[static_cast<size_t>(i)] != slots_[static_cast<size_t>(ranges.back().second)]) {
+      ranges.push_back(std::make_pair(i, i));
+    } else {
+      ranges.back().second = i;
+    }
+  }
+
+  char head[32];
+  snprintf(head, sizeof(head), "*%zu\r\n", ranges.size());
+  reply += head;
+  for (size_t i = 0; i < ranges.size(); ++i) {
+    reply += "*3\r\n";
+    append_integer(reply, ranges[i].first);
+    append_integer(reply, ranges[i].second);
+    reply += "*2\r\n";
+    append_bulk(reply, "127.0.0.1");
+    append_integer(reply, nodes_[slots_[static_cast<size_t>(ranges[i].first)]].port);
+  }
+}
+}  // namespace hiredis_happ_test
+
+#endif
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "hiredis_happ_config.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+#  include <stdint.h>
+
+#  include <atomic>
+#  include <chrono>
+#  include <deque>
+#  include <map>
+#  include <mutex>
+#  include <string>
+#  include <thread>
+#  include <vector>
+
+namespace hiredis_happ_test {
+/**
+ * @brief in-process Redis Cluster on loopback, every node listens on its own port and all nodes are served by one
+ *        thread
+ * @note it supports CLUSTER SLOTS, ASKING, AUTH, PING, GET, SET, DEL and INCR. Keys are stored in one map shared by
+ *       all nodes, and key commands sent to a node which does not own the slot get MOVED, just like redis.
+ * @note all methods are thread safe, scripted faults take effect on the next command received
+ */
+class fake_cluster {
+ public:
+  struct fault_t {
+    enum type { NONE = 0, MOVED, ASK, TRYAGAIN, CLUSTERDOWN, ERROR, DROP };
+  };
+
+  // start serving node_count nodes, slots are split evenly
+  explicit fake_cluster(size_t node_count);
+  ~fake_cluster();
+
+  fake_cluster(const fake_cluster &) = delete;
+  fake_cluster &operator=(const fake_cluster &) = delete;
+
+  bool is_ready() const { return ready_; }
+  size_t get_node_count() const { return nodes_.size(); }
+  uint16_t get_port(size_t node) const;
+
+  // the node owning the slot of key
+  size_t get_node_by_key(const std::string &key) const;
+  size_t get_slot_owner(int slot) const;
+
+  // move slots [start, end] to node, CLUSTER SLOTS returns the new map and old owners reply MOVED
+  void assign_slots(int start, int end, size_t node);
+
+  /**
+   * @brief reply the next count key commands received by node with a fault
+   * @param type MOVED and ASK point to target_node, ASK is accepted by target_node after ASKING even if it does not
+   *        own the slot. ERROR replies "-ERR fake error". DROP closes the connection without replying.
+   */
+  void inject_fault(size_t node, fault_t::type type, size_t count, size_t target_node = 0);
+
+  // delay every reply of node
+  void set_latency(size_t node, std::chrono::microseconds latency);
+
+  // close all connections of node at once, pending replies are lost
+  void drop_connections(size_t node);
+
+  // count of all commands received by node, including CLUSTER SLOTS and ASKING
+  size_t get_command_count(size_t node) const;
+  size_t get_cluster_slots_count() const;
+  size_t get_connection_count(size_t node) const;
+
+  // value of a key, empty if it's not set
+  std::string get_value(const std::string &key) const;
+
+ private:
+  struct fault_item_t {
+    fault_t::type type;
+    size_t count;
+    size_t target_node;
+  };
+
+  struct node_t {
+    int listen_fd;
+    uint16_t port;
+    std::chrono::microseconds latency;
+    std::deque<fault_item_t> faults;
+    size_t command_count;
+    bool drop;
+  };
+
+  struct client_t {
+    int fd;
+    size_t node;
+    bool asking;
+    bool closing;
+    std::string input;
+    std::string output;
+    // replies waiting for latency of node, in the order of commands
+    std::deque<std::pair<std::chrono::steady_clock::time_point, std::string> > delayed;
+  };
+
+  void serve();
+  void accept_clients(size_t node);
+  bool read_client(client_t &client);
+  bool write_client(client_t &client);
+  void flush_delayed(client_t &client, std::chrono::steady_clock::time_point now);
+
+  // parse and run all complete commands in input, return false if the connection should be closed
+  bool process_input(client_t &client);
+  bool run_command(client_t &client, const std::vector<std::string> &args, std::string &reply);
+  void reply_cluster_slots(std::string &reply) const;
+
+ private:
+  mutable std::mutex lock_;
+  std::vector<node_t> nodes_;
+  std::vector<size_t> slots_;
+  std::map<std::string, std::string> data_;
+  std::vector<client_t> clients_;
+  size_t cluster_slots_count_;
+
+  bool ready_;
+  std::atomic<bool> running_;
+  int wakeup_fds_[2];
+  std::thread thread_;
+};
+}  // namespace hiredis_happ_test
+
+#endif
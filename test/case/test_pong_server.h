@@ -0,0 +1,97 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_TEST_PONG_SERVER_H
+#define HIREDIS_HAPP_TEST_PONG_SERVER_H
+
+#pragma once
+
+#include "hiredis_happ_config.h"
+
+#if defined(HIREDIS_HAPP_ENABLE_EPOLL_LOOP)
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+
+#  include <atomic>
+#  include <cstring>
+#  include <string>
+#  include <thread>
+
+namespace hiredis_happ_test {
+// replies +PONG to every PING of one client
+class pong_server {
+ public:
+  pong_server() : listen_fd_(-1), client_fd_(-1), port_(0), ping_count_(0) {
+    listen_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if (listen_fd_ < 0 || 0 != bind(listen_fd_, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) ||
+        0 != listen(listen_fd_, 1) || 0 != getsockname(listen_fd_, reinterpret_cast<sockaddr *>(&addr), &len)) {
+      return;
+    }
+
+    port_ = ntohs(addr.sin_port);
+    thread_ = std::thread([this]() { serve(); });
+  }
+
+  ~pong_server() {
+    // the client may still wait for replies
+    int client_fd = client_fd_.load();
+    if (client_fd >= 0) {
+      shutdown(client_fd, SHUT_RDWR);
+    }
+    if (listen_fd_ >= 0) {
+      shutdown(listen_fd_, SHUT_RDWR);
+      close(listen_fd_);
+    }
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  uint16_t get_port() const { return port_; }
+  int get_ping_count() const { return ping_count_.load(); }
+
+ private:
+  void serve() {
+    int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      return;
+    }
+    client_fd_.store(fd);
+
+    std::string buffer;
+    char data[1024];
+    ssize_t len;
+    while ((len = read(fd, data, sizeof(data))) > 0) {
+      buffer.append(data, static_cast<size_t>(len));
+      size_t pos;
+      while ((pos = buffer.find("PING\r\n")) != std::string::npos) {
+        buffer.erase(0, pos + 6);
+        ++ping_count_;
+        if (write(fd, "+PONG\r\n", 7) != 7) {
+          break;
+        }
+      }
+    }
+    close(fd);
+  }
+
+  int listen_fd_;
+  std::atomic<int> client_fd_;
+  uint16_t port_;
+  std::atomic<int> ping_count_;
+  std::thread thread_;
+};
+}  // namespace hiredis_happ_test
+
+#endif
+
+#endif  // HIREDIS_HAPP_TEST_PONG_SERVER_H
@@ -0,0 +1,37 @@
+// Copyright 2026 owent
+// Created by owent on 2026/10/19.
+//
+
+#ifndef HIREDIS_HAPP_TEST_SLOT_RANGES_H
+#define HIREDIS_HAPP_TEST_SLOT_RANGES_H
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "hiredis_happ.h"
+
+namespace hiredis_happ_test {
+// split all slots evenly to masters at 127.0.0.1:first_port+i, every master has a replica at 127.0.0.2 if asked
+inline std::vector<hiredis::happ::cluster::slot_range_t> make_slot_ranges(uint16_t first_port, int master_count,
+                                                                          bool with_replicas = false) {
+  std::vector<hiredis::happ::cluster::slot_range_t> ret;
+  for (int i = 0; i < master_count; ++i) {
+    ret.push_back(hiredis::happ::cluster::slot_range_t());
+    ret.back().start = i * HIREDIS_HAPP_SLOT_NUMBER / master_count;
+    ret.back().end = (i + 1) * HIREDIS_HAPP_SLOT_NUMBER / master_count - 1;
+    ret.back().hosts.push_back(hiredis::happ::connection::key_t());
+    hiredis::happ::connection::set_key(ret.back().hosts.back(), "127.0.0.1", static_cast<uint16_t>(first_port + i));
+
+    if (with_replicas) {
+      ret.back().hosts.push_back(hiredis::happ::connection::key_t());
+      hiredis::happ::connection::set_key(ret.back().hosts.back(), "127.0.0.2", static_cast<uint16_t>(first_port + i));
+    }
+  }
+  return ret;
+}
+}  // namespace hiredis_happ_test
+
+#endif  // HIREDIS_HAPP_TEST_SLOT_RANGES_H